@@ -0,0 +1,118 @@
+/// \file
+/// \brief Heap traffic of building and destroying big modules.
+#include "MIR.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+
+using namespace wyrm;
+
+namespace {
+struct HeapCounters {
+  std::size_t Allocations;
+  std::size_t Deallocations;
+  std::size_t Bytes;
+};
+HeapCounters Heap{};
+} // namespace
+
+void *operator new(std::size_t Size) {
+  ++Heap.Allocations;
+  Heap.Bytes += Size;
+  if (void *Memory = std::malloc(Size ? Size : 1))
+    return Memory;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *Memory) noexcept {
+  Heap.Deallocations += Memory != nullptr;
+  std::free(Memory);
+}
+
+void operator delete(void *Memory, std::size_t) noexcept {
+  operator delete(Memory);
+}
+
+/// \brief Build \p NumFunctions functions of \p NumBlocks blocks of
+/// \p BlockSize instructions each. A block starts with a phi, ends with a
+/// branch and has a call among arithmetic on fresh registers.
+static std::unique_ptr<Module> buildModule(std::size_t NumFunctions,
+                                           std::size_t NumBlocks,
+                                           std::size_t BlockSize) {
+  auto TheModule = std::make_unique<Module>("bench");
+  MIRBuilder Builder{*TheModule};
+  for (std::size_t FI = 0; FI < NumFunctions; ++FI) {
+    auto &F = *Builder.createFunction("f" + std::to_string(FI));
+    std::vector<BasicBlock *> Blocks;
+    for (std::size_t BI = 0; BI < NumBlocks; ++BI)
+      Blocks.push_back(&Builder.createBasicBlock(F));
+    Builder.setBasicBlock(*Blocks[0]);
+    SymReg *Last =
+        &get<ReceiveInst>(Builder.createReceiveInst()).outRegister();
+    for (std::size_t BI = 0; BI < NumBlocks; ++BI) {
+      auto &BB = *Blocks[BI];
+      Builder.setBasicBlock(BB);
+      std::size_t Size = BB.size();
+      auto &Phi = get<PhiInst>(
+          Builder.createPhiInst(Builder.createRegister(F)));
+      Phi.addIncoming(*Last, *Blocks[BI ? BI - 1 : 0]);
+      Phi.addIncoming(0, *Blocks[(BI + 1) % NumBlocks]);
+      Last = &Phi.outRegister();
+      Builder.createCallInst(true, F, {*Last, 1});
+      while (++Size + 3 < BlockSize)
+        Last = &get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Add, *Last,
+                                                       static_cast<Imm>(Size)))
+                    .outRegister();
+      if (BI + 1 == NumBlocks)
+        Builder.createRetInst(*Last);
+      else
+        Builder.createBrInst(*Last, *Blocks[BI + 1], *Blocks[0]);
+    }
+  }
+  return TheModule;
+}
+
+static void measure(std::size_t NumFunctions, std::size_t NumBlocks,
+                    std::size_t BlockSize) {
+  auto Start = std::chrono::steady_clock::now();
+  HeapCounters Before = Heap;
+  auto TheModule = buildModule(NumFunctions, NumBlocks, BlockSize);
+  HeapCounters Built = Heap;
+  std::chrono::duration<double> BuildTime =
+      std::chrono::steady_clock::now() - Start;
+  std::size_t NumInstructions{};
+  std::size_t Chunks = TheModule->arena().numChunks();
+  std::size_t Reserved = TheModule->arena().reservedBytes();
+  for (auto &F : *TheModule) {
+    for (auto &BB : F)
+      NumInstructions += BB.size();
+    Chunks += F.arena().numChunks();
+    Reserved += F.arena().reservedBytes();
+  }
+  Start = std::chrono::steady_clock::now();
+  TheModule.reset();
+  std::chrono::duration<double> DestroyTime =
+      std::chrono::steady_clock::now() - Start;
+  std::cout << NumFunctions << " x " << NumBlocks << " x " << BlockSize
+            << ": " << NumInstructions << " instructions\n"
+            << "  build:   " << std::setw(9)
+            << Built.Allocations - Before.Allocations << " allocations "
+            << std::setw(11) << Built.Bytes - Before.Bytes << " bytes "
+            << std::fixed << std::setprecision(3) << BuildTime.count()
+            << " s\n"
+            << "  destroy: " << std::setw(9)
+            << Heap.Deallocations - Built.Deallocations << " deallocations "
+            << DestroyTime.count() << " s\n"
+            << "  arena:   " << std::setw(9) << Chunks << " chunks "
+            << std::setw(11) << Reserved << " bytes\n";
+}
+
+int main() {
+  measure(1, 1000, 1000);
+  measure(100, 100, 100);
+  measure(10000, 10, 10);
+  return 0;
+}
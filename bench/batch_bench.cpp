@@ -0,0 +1,61 @@
+/// \file
+/// \brief Throughput of batch evaluation compared to the interpreter.
+#include "ExecutionEngine/batch.h"
+#include "ExecutionEngine/interpreter.h"
+#include "programs.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+using namespace wyrm;
+using namespace wyrm::bench;
+
+static void measure(const char *Name, const Module &M, const Function &F,
+                    const std::vector<Imm> &Inputs) {
+  auto Start = std::chrono::steady_clock::now();
+  Interpreter Engine{M};
+  Imm ScalarSum{};
+  for (Imm Input : Inputs)
+    ScalarSum += Engine.run(F, {Input}).ReturnValue;
+  std::chrono::duration<double> Scalar =
+      std::chrono::steady_clock::now() - Start;
+
+  Start = std::chrono::steady_clock::now();
+  BatchEvaluator Evaluator{M};
+  auto Results = Evaluator.run(F, Inputs.size(), {Inputs});
+  std::chrono::duration<double> Batch =
+      std::chrono::steady_clock::now() - Start;
+  Imm BatchSum{};
+  for (auto &Result : Results)
+    BatchSum += Result.ReturnValue;
+
+  std::cout << std::left << std::setw(28) << Name << std::right << std::fixed
+            << std::setprecision(2) << " scalar "
+            << Inputs.size() / Scalar.count() / 1e6 << " M evals/s, batch "
+            << Inputs.size() / Batch.count() / 1e6 << " M evals/s, speedup "
+            << std::setprecision(1) << Scalar.count() / Batch.count() << "x"
+            << (ScalarSum == BatchSum ? "" : ", RESULTS DIFFER") << "\n";
+}
+
+int main() {
+  Module TheModule{"bench"};
+  MIRBuilder Builder{TheModule};
+  std::mt19937 Gen{1};
+  auto *Arithmetic = Builder.createFunction("arithmetic");
+  buildArithmeticLoop(Gen, Builder, *Arithmetic, 64);
+  auto *Fib = Builder.createFunction("fib");
+  buildFib(Builder, *Fib);
+
+  const std::size_t NumInputs = 1 << 20;
+  std::vector<Imm> Uniform(NumInputs, 4), Divergent, Small;
+  std::uniform_int_distribution<Imm> Trips(0, 7), Numbers(0, 10);
+  for (std::size_t I = 0; I < NumInputs; ++I) {
+    Divergent.push_back(Trips(Gen));
+    Small.push_back(Numbers(Gen));
+  }
+  measure("arithmetic, 4 iterations", TheModule, *Arithmetic, Uniform);
+  measure("arithmetic, 0-7 iterations", TheModule, *Arithmetic, Divergent);
+  Small.resize(NumInputs / 8);
+  measure("fib(0-10)", TheModule, *Fib, Small);
+  return 0;
+}
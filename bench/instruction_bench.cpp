@@ -0,0 +1,86 @@
+/// \file
+/// \brief Memory footprint of instructions and speed of scanning blocks.
+#include "MIR.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using namespace wyrm;
+
+/// \brief Fill \p Blocks with \p BlockSize random operations on \p Regs.
+static void buildBlocks(MIRBuilder &Builder, std::mt19937 &Gen,
+                        const std::vector<BasicBlock *> &Blocks,
+                        std::size_t BlockSize,
+                        const std::vector<SymReg *> &Regs) {
+  const std::size_t NumBlocks = Blocks.size(), NumRegs = Regs.size();
+  std::uniform_int_distribution<std::size_t> Reg(0, NumRegs - 1);
+  std::uniform_int_distribution<int> Kind(0, 12), Constant(-100, 100);
+  for (std::size_t BI = 0; BI < NumBlocks; ++BI) {
+    Builder.setBasicBlock(*Blocks[BI]);
+    for (std::size_t I = 0; I + 1 < BlockSize; ++I) {
+      Value RHS = I % 2 ? Value{*Regs[Reg(Gen)]} : Value{Constant(Gen)};
+      if (I % 5 == 4)
+        Builder.createUnOpInst(UnOpKind::Neg, RHS, *Regs[Reg(Gen)]);
+      else
+        Builder.createBinOpInst(static_cast<BinOpKind>(Kind(Gen)),
+                                *Regs[Reg(Gen)], RHS, *Regs[Reg(Gen)]);
+    }
+    if (BI + 1 == NumBlocks)
+      Builder.createRetInst(*Regs[0]);
+    else
+      Builder.createBrInst(*Regs[Reg(Gen)], *Blocks[BI + 1], *Blocks[0]);
+  }
+}
+
+/// \brief Count register operands and binary operations of \p F.
+static std::size_t scan(const Function &F) {
+  std::size_t Result{};
+  for (const BasicBlock &BB : F)
+    for (const Instruction &Inst : BB) {
+      forEachOperand(Inst, [&Result](Value V) {
+        if (auto *Reg = get<SymReg>(&V))
+          Result += Reg->index();
+      });
+      Result += get<BinOpInst>(&Inst) != nullptr;
+    }
+  return Result;
+}
+
+static void measure(std::size_t NumBlocks, std::size_t BlockSize) {
+  Module TheModule{"bench"};
+  MIRBuilder Builder{TheModule};
+  std::mt19937 Gen{1};
+  auto &F = *Builder.createFunction("f");
+  std::vector<BasicBlock *> Blocks;
+  for (std::size_t BI = 0; BI < NumBlocks; ++BI)
+    Blocks.push_back(&Builder.createBasicBlock(F));
+  std::vector<SymReg *> Regs;
+  for (int R = 0; R < 64; ++R)
+    Regs.push_back(&Builder.createRegister(F));
+  // Only the memory taken by filling the blocks is counted.
+  std::size_t Before = F.arena().allocatedBytes();
+  buildBlocks(Builder, Gen, Blocks, BlockSize, Regs);
+  double Bytes = F.arena().allocatedBytes() - Before;
+  std::size_t NumInstructions = NumBlocks * BlockSize;
+  const int Scans = 20;
+  std::size_t Checksum{};
+  auto Start = std::chrono::steady_clock::now();
+  for (int I = 0; I < Scans; ++I)
+    Checksum += scan(F);
+  std::chrono::duration<double> Time = std::chrono::steady_clock::now() - Start;
+  std::cout << std::setw(6) << NumBlocks << " x " << std::setw(5)
+            << BlockSize << ": " << std::fixed << std::setprecision(1)
+            << std::setw(6) << Bytes / NumInstructions
+            << " bytes/instruction, scan " << std::setprecision(2)
+            << std::setw(6)
+            << Time.count() / Scans / NumInstructions * 1e9
+            << " ns/instruction (checksum " << Checksum << ")\n";
+}
+
+int main() {
+  measure(1, 1000000);
+  measure(10000, 100);
+  measure(200000, 5);
+  return 0;
+}
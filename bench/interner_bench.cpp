@@ -0,0 +1,126 @@
+/// \file
+/// \brief Interning identifiers with StringInterner compared to a locked
+/// std::unordered_set of strings.
+#include "interner.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace wyrm;
+
+namespace {
+std::size_t Allocations{};
+
+/// \brief Interner which keeps every string in a node of its own.
+class SetInterner {
+public:
+  string_view intern(std::string &&String) {
+    std::lock_guard<std::mutex> Guard{Lock};
+    return *std::get<0>(Strings.insert(std::move(String)));
+  }
+
+private:
+  std::mutex Lock;
+  std::unordered_set<std::string> Strings;
+};
+} // namespace
+
+void *operator new(std::size_t Size) {
+  __atomic_fetch_add(&Allocations, 1, __ATOMIC_RELAXED);
+  if (void *Memory = std::malloc(Size ? Size : 1))
+    return Memory;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *Memory) noexcept { std::free(Memory); }
+
+void operator delete(void *Memory, std::size_t) noexcept {
+  operator delete(Memory);
+}
+
+/// \brief \p Size identifiers with \p NumDistinct different names like the
+/// ones of a big program: short prefixes with numeric suffixes.
+static std::vector<std::string> identifiers(std::size_t Size,
+                                            std::size_t NumDistinct) {
+  static const char *Prefixes[] = {"tmp", "i", "sum", "value", "loop.header",
+                                   "x", "arg", "result.addr"};
+  std::mt19937 Gen{1};
+  std::uniform_int_distribution<std::size_t> Name(0, NumDistinct - 1);
+  std::vector<std::string> Result;
+  Result.reserve(Size);
+  for (std::size_t I = 0; I < Size; ++I) {
+    std::size_t N = Name(Gen);
+    Result.push_back(std::string{Prefixes[N % 8]} + "." + std::to_string(N));
+  }
+  return Result;
+}
+
+/// \brief Intern \p Names by \p NumThreads threads, each taking a slice.
+/// \return Seconds spent.
+template <typename FnT>
+static double run(const std::vector<std::string> &Names, unsigned NumThreads,
+                  FnT Intern) {
+  auto Start = std::chrono::steady_clock::now();
+  std::vector<std::thread> Threads;
+  const std::size_t Slice = Names.size() / NumThreads;
+  for (unsigned T = 0; T < NumThreads; ++T)
+    Threads.emplace_back([&, T] {
+      std::size_t Begin = T * Slice;
+      std::size_t End = T + 1 == NumThreads ? Names.size() : Begin + Slice;
+      for (std::size_t I = Begin; I < End; ++I)
+        Intern(Names[I]);
+    });
+  for (auto &Thread : Threads)
+    Thread.join();
+  std::chrono::duration<double> Time = std::chrono::steady_clock::now() - Start;
+  return Time.count();
+}
+
+static void measure(const std::vector<std::string> &Names,
+                    unsigned NumThreads) {
+  std::size_t Before = Allocations;
+  double SetTime;
+  {
+    SetInterner Set;
+    // The set owns its strings, so a name kept elsewhere is copied first.
+    SetTime = run(Names, NumThreads, [&Set](const std::string &Name) {
+      Set.intern(std::string{Name});
+    });
+  }
+  std::size_t SetAllocations = Allocations - Before;
+  Before = Allocations;
+  double InternerTime;
+  {
+    StringInterner Interner;
+    InternerTime = run(Names, NumThreads, [&Interner](const std::string &Name) {
+      Interner.intern(Name);
+    });
+  }
+  std::size_t InternerAllocations = Allocations - Before;
+  std::cout << std::setw(2) << NumThreads << " threads: unordered_set "
+            << std::fixed << std::setprecision(1) << std::setw(6)
+            << SetTime / Names.size() * 1e9 << " ns/name " << std::setw(8)
+            << SetAllocations << " allocations, interner " << std::setw(6)
+            << InternerTime / Names.size() * 1e9 << " ns/name "
+            << std::setw(8) << InternerAllocations << " allocations, speedup "
+            << SetTime / InternerTime << "x\n";
+}
+
+int main() {
+  for (std::size_t NumDistinct : {100000, 1000000, 4000000}) {
+    auto Names = identifiers(4000000, NumDistinct);
+    std::cout << Names.size() << " identifiers, " << NumDistinct
+              << " names at most\n";
+    for (unsigned NumThreads : {1, 2, 4})
+      measure(Names, NumThreads);
+  }
+  return 0;
+}
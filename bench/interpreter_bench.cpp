@@ -0,0 +1,43 @@
+/// \file
+/// \brief Throughput of the interpreter on generated programs.
+#include "ExecutionEngine/interpreter.h"
+#include "programs.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+using namespace wyrm;
+using namespace wyrm::bench;
+
+static void measure(const char *Name, Interpreter &Engine, const Function &F,
+                    Imm Argument) {
+  auto Before = Engine.executedInstructions();
+  auto Start = std::chrono::steady_clock::now();
+  auto Result = Engine.run(F, {Argument});
+  std::chrono::duration<double> Time = std::chrono::steady_clock::now() - Start;
+  auto Count = Engine.executedInstructions() - Before;
+  std::cout << std::left << std::setw(24) << Name << std::right
+            << std::setw(12) << Count << " instructions " << std::fixed
+            << std::setprecision(3) << std::setw(8) << Time.count() << " s "
+            << std::setw(8) << std::setprecision(1)
+            << Count / Time.count() / 1e6 << " M instructions/s, result "
+            << Result.ReturnValue << "\n";
+}
+
+int main() {
+  Module TheModule{"bench"};
+  MIRBuilder Builder{TheModule};
+  auto *Fib = Builder.createFunction("fib");
+  buildFib(Builder, *Fib);
+  std::mt19937 Gen{1};
+  auto *Arithmetic = Builder.createFunction("arithmetic");
+  buildArithmeticLoop(Gen, Builder, *Arithmetic, 64);
+  auto *Nested = Builder.createFunction("nested");
+  buildNestedLoops(Builder, *Nested);
+
+  Interpreter Engine{TheModule};
+  measure("fib(30)", Engine, *Fib, 30);
+  measure("arithmetic loop 500000", Engine, *Arithmetic, 500000);
+  measure("nested loops 3000", Engine, *Nested, 3000);
+  return 0;
+}
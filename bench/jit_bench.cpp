@@ -0,0 +1,70 @@
+/// \file
+/// \brief Speedup of JIT-compiled code over the interpreter.
+#include "ExecutionEngine/interpreter.h"
+#include "ExecutionEngine/jit.h"
+#include "programs.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+using namespace wyrm;
+using namespace wyrm::bench;
+
+/// \brief Shortest time of \p Runs calls of \p Fn, which is less noisy than
+/// a single one.
+template <typename FnT> static double seconds(FnT &&Fn, int Runs = 5) {
+  double Best = std::numeric_limits<double>::max();
+  for (int Run = 0; Run < Runs; ++Run) {
+    auto Start = std::chrono::steady_clock::now();
+    Fn();
+    std::chrono::duration<double> Time =
+        std::chrono::steady_clock::now() - Start;
+    Best = std::min(Best, Time.count());
+  }
+  return Best;
+}
+
+static void measure(const char *Name, Interpreter &Engine, JITCompiler &JIT,
+                    const Function &F, Imm Argument) {
+  Imm Expected{}, Result{};
+  double Interpreted =
+      seconds([&] { Expected = Engine.run(F, {Argument}).ReturnValue; });
+  JITCompiler::NativeFunction<Imm> Native{};
+  // Compiled functions are cached, so only the first compilation counts.
+  double Compilation = seconds([&] { Native = JIT.compile<Imm>(F); }, 1);
+  if (!Native) {
+    std::cout << Name << ": no memory for the code\n";
+    return;
+  }
+  double Executed = seconds([&] { Result = Native(Argument); });
+  std::cout << std::left << std::setw(24) << Name << std::right << std::fixed
+            << std::setprecision(4) << " interpreter " << Interpreted
+            << " s, JIT " << Executed << " s + " << Compilation
+            << " s compilation, speedup " << std::setprecision(1)
+            << Interpreted / Executed << "x"
+            << (Expected == Result ? "" : ", RESULTS DIFFER") << "\n";
+}
+
+int main() {
+  if (!JITCompiler::IsSupported) {
+    std::cout << "The JIT doesn't support the host\n";
+    return 0;
+  }
+  Module TheModule{"bench"};
+  MIRBuilder Builder{TheModule};
+  auto *Fib = Builder.createFunction("fib");
+  buildFib(Builder, *Fib);
+  std::mt19937 Gen{1};
+  auto *Arithmetic = Builder.createFunction("arithmetic");
+  buildArithmeticLoop(Gen, Builder, *Arithmetic, 64);
+  auto *Nested = Builder.createFunction("nested");
+  buildNestedLoops(Builder, *Nested);
+
+  Interpreter Engine{TheModule};
+  JITCompiler JIT{TheModule};
+  measure("fib(30)", Engine, JIT, *Fib, 30);
+  measure("arithmetic loop 500000", Engine, JIT, *Arithmetic, 500000);
+  measure("nested loops 3000", Engine, JIT, *Nested, 3000);
+  return 0;
+}
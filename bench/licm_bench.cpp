@@ -0,0 +1,75 @@
+/// \file
+/// \brief Instructions executed by the interpreter before and after
+/// loop-invariant code motion.
+#include "ExecutionEngine/interpreter.h"
+#include "Transforms/licm.h"
+#include "Transforms/ssa.h"
+#include "programs.h"
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <tuple>
+
+using namespace wyrm;
+using namespace wyrm::bench;
+
+using ProgramBuilder = std::function<void(MIRBuilder &, Function &)>;
+
+/// \brief Build the program in SSA form, optionally hoist loop invariants,
+/// and leave SSA form.
+static Function &compile(Module &M, const ProgramBuilder &Build, bool Hoist) {
+  MIRBuilder Builder{M};
+  auto &F = *Builder.createFunction("f");
+  Build(Builder, F);
+  constructSSA(Builder, F);
+  if (Hoist)
+    hoistLoopInvariants(Builder, F);
+  destructSSA(Builder, F);
+  return F;
+}
+
+/// \brief Run \p F on \p Args with a fresh interpreter.
+/// \return Result, number of executed instructions and seconds spent.
+static std::tuple<ExecutionResult, std::uint64_t, double>
+execute(const Module &M, const Function &F, const std::vector<Imm> &Args) {
+  Interpreter Engine{M};
+  auto Start = std::chrono::steady_clock::now();
+  auto Result = Engine.run(F, Args);
+  std::chrono::duration<double> Time = std::chrono::steady_clock::now() - Start;
+  return {Result, Engine.executedInstructions(), Time.count()};
+}
+
+static void measure(const char *Name, const ProgramBuilder &Build,
+                    const std::vector<Imm> &Args) {
+  Module Original{"original"}, Hoisted{"hoisted"};
+  auto [Before, BeforeCount, BeforeTime] =
+      execute(Original, compile(Original, Build, false), Args);
+  auto [After, AfterCount, AfterTime] =
+      execute(Hoisted, compile(Hoisted, Build, true), Args);
+  std::cout << std::left << std::setw(24) << Name << std::right
+            << std::setw(12) << BeforeCount << " -> " << std::setw(12)
+            << AfterCount << " instructions (" << std::fixed
+            << std::setprecision(1)
+            << 100.0 * (1.0 - static_cast<double>(AfterCount) /
+                                  static_cast<double>(BeforeCount))
+            << "% fewer), " << std::setprecision(3) << BeforeTime << " -> "
+            << AfterTime << " s"
+            << (Before.Status == After.Status &&
+                        Before.ReturnValue == After.ReturnValue
+                    ? ""
+                    : ", RESULT DIFFERS")
+            << "\n";
+}
+
+int main() {
+  measure("invariant loops 3000", buildInvariantLoops, {3000, 12});
+  measure("nested loops 3000", buildNestedLoops, {3000});
+  measure("arithmetic loop 500000",
+          [](MIRBuilder &Builder, Function &F) {
+            std::mt19937 Gen{1};
+            buildArithmeticLoop(Gen, Builder, F, 64);
+          },
+          {500000});
+  return 0;
+}
@@ -0,0 +1,91 @@
+/// \file
+/// \brief Cost of finding the loops of large CFGs compared to the dominator
+/// tree they are based on.
+#include "Analysis/dominance.h"
+#include "Analysis/dominator_tree.h"
+#include "Analysis/loop_info.h"
+#include "csr_graph.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace wyrm;
+
+/// \brief Chain of \p Size nodes with loops nested \p Size / 2 deep.
+static CSRGraph nestedLoops(std::size_t Size) {
+  std::vector<Arc> Arcs;
+  for (std::size_t Node = 0; Node + 1 < Size; ++Node)
+    Arcs.push_back({Node, Node + 1});
+  for (std::size_t Depth = 1; Depth < Size / 2; ++Depth)
+    Arcs.push_back({Size - 1 - Depth, Depth});
+  return CSRGraph{Size, std::move(Arcs)};
+}
+
+/// \brief Sequence of loops of up to 60 nodes nested up to 4 deep with random
+/// forward jumps, some of which enter loops past their headers.
+static CSRGraph structuredLoops(std::mt19937 &Gen, std::size_t Size) {
+  std::vector<Arc> Arcs;
+  std::uniform_int_distribution<std::size_t> Length(2, 60), Jump(1, 8);
+  for (std::size_t Node = 0; Node + 1 < Size; ++Node) {
+    Arcs.push_back({Node, Node + 1});
+    if (Node && Node + 10 < Size && Gen() % 4 == 0)
+      Arcs.push_back({Node, Node + Jump(Gen)});
+  }
+  for (std::size_t Start = 1; Start + 60 < Size; Start += Length(Gen))
+    for (std::size_t Level = 0, End = Start + Length(Gen); Level < Gen() % 4;
+         ++Level, End -= 1)
+      if (End > Start + Level + 1)
+        Arcs.push_back({End, Start + Level});
+  return CSRGraph{Size, std::move(Arcs)};
+}
+
+/// \brief Chain of \p Size nodes with random arcs in both directions.
+static CSRGraph randomArcs(std::mt19937 &Gen, std::size_t Size) {
+  std::vector<Arc> Arcs;
+  std::uniform_int_distribution<std::size_t> Node(0, Size - 1), To(1, Size - 1);
+  for (std::size_t I = 1; I < Size; ++I)
+    Arcs.push_back({I - 1, I});
+  for (std::size_t I = 0; I < Size / 2; ++I)
+    Arcs.push_back({Node(Gen), To(Gen)});
+  return CSRGraph{Size, std::move(Arcs)};
+}
+
+template <typename FuncT> static double seconds(FuncT Func) {
+  auto Start = std::chrono::steady_clock::now();
+  const int Rounds = 10;
+  for (int Round = 0; Round < Rounds; ++Round)
+    Func();
+  std::chrono::duration<double> Time = std::chrono::steady_clock::now() - Start;
+  return Time.count() / Rounds;
+}
+
+static void measure(const std::string &Name, const CSRGraph &CFG) {
+  DominatorTree DT{immediateDominators(CFG)};
+  LoopInfo Loops{CFG, DT, true};
+  unsigned MaxDepth = 0;
+  for (CSRGraph::NodeId Node = 0; Node < CFG.size(); ++Node)
+    MaxDepth = std::max(MaxDepth, Loops.depth(Node));
+  const double DTTime =
+      seconds([&] { DominatorTree{immediateDominators(CFG)}; });
+  const double LoopTime = seconds([&] { LoopInfo{CFG, DT}; });
+  const double HavlakTime = seconds([&] { LoopInfo{CFG, DT, true}; });
+  std::cout << std::setw(10) << Name << ": " << CFG.size() << " nodes, "
+            << Loops.size() << " loops, depth " << MaxDepth
+            << (Loops.hasIrreducibleRegions() ? ", irreducible" : "")
+            << "\n  dominator tree " << std::fixed << std::setprecision(2)
+            << DTTime * 1e3 << " ms, loops " << LoopTime * 1e3
+            << " ms, loops with irreducible regions " << HavlakTime * 1e3
+            << " ms\n";
+}
+
+int main() {
+  const std::size_t Size = 50000;
+  std::mt19937 Gen{1};
+  measure("nested", nestedLoops(Size));
+  measure("structured", structuredLoops(Gen, Size));
+  measure("random", randomArcs(Gen, Size));
+  return 0;
+}
@@ -0,0 +1,119 @@
+/// \file
+/// \brief Scaling of an optimization pipeline with the number of workers of
+/// the pass manager.
+#include "MIR.h"
+#include "Transforms/gvn.h"
+#include "Transforms/pass_manager.h"
+#include "Transforms/sccp.h"
+#include "Transforms/ssa.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using namespace wyrm;
+
+/// \brief Build a function of \p NumBlocks random blocks assigning a few
+/// variables, with sizes of blocks varying a lot.
+static void buildFunction(std::mt19937 &Gen, MIRBuilder &Builder, Function &F,
+                          std::size_t NumBlocks) {
+  std::vector<BasicBlock *> Blocks;
+  for (std::size_t I = 0; I < NumBlocks; ++I)
+    Blocks.push_back(&Builder.createBasicBlock(F));
+  std::vector<SymReg *> Vars;
+  for (const char *Name : {"a", "b", "c", "d", "e", "f", "g", "h"})
+    Vars.push_back(&Builder.createRegister(F, Name));
+  std::uniform_int_distribution<std::size_t> Var(0, Vars.size() - 1),
+      Block(1, NumBlocks - 1), Count(0, 12), Kind(0, 9);
+  std::uniform_int_distribution<int> Op(0, 12);
+  auto Operand = [&]() -> Value {
+    if (Kind(Gen) < 3)
+      return static_cast<Imm>(Kind(Gen));
+    return *Vars[Var(Gen)];
+  };
+  Builder.setBasicBlock(*Blocks[0]);
+  for (auto *Var : Vars)
+    Builder.createUnOpInst(UnOpKind::Assign, Operand(), *Var);
+  for (auto *BB : Blocks) {
+    Builder.setBasicBlock(*BB);
+    for (std::size_t I = 0, E = Count(Gen); I < E; ++I)
+      Builder.createBinOpInst(static_cast<BinOpKind>(Op(Gen)), Operand(),
+                              Operand(), *Vars[Var(Gen)]);
+    auto Terminator = Kind(Gen);
+    if (Terminator < 1 && BB != Blocks[0])
+      Builder.createRetInst(Operand());
+    else if (Terminator < 4)
+      Builder.createGoToInst(*Blocks[Block(Gen)]);
+    else
+      Builder.createBrInst(Operand(), *Blocks[Block(Gen)],
+                           *Blocks[Block(Gen)]);
+  }
+}
+
+/// \brief Module of \p NumFunctions functions of 10 to 300 blocks.
+static std::unique_ptr<Module> buildModule(std::size_t NumFunctions) {
+  auto TheModule = std::make_unique<Module>("bench");
+  MIRBuilder Builder{*TheModule};
+  std::mt19937 Gen{1};
+  std::uniform_int_distribution<std::size_t> NumBlocks(10, 300);
+  for (std::size_t I = 0; I < NumFunctions; ++I)
+    buildFunction(Gen, Builder,
+                  *Builder.createFunction("f" + std::to_string(I)),
+                  NumBlocks(Gen));
+  return TheModule;
+}
+
+/// \brief Optimize a module with \p NumWorkers workers.
+/// \return Seconds spent and the printed result.
+static std::pair<double, std::string> optimize(std::size_t NumFunctions,
+                                               unsigned NumWorkers) {
+  auto TheModule = buildModule(NumFunctions);
+  PassManager Passes{NumWorkers};
+  Passes.addFunctionPass(
+      [](MIRBuilder &Builder, Function &F, AnalysisCache &Analyses) {
+        constructSSA(Builder, F, Analyses);
+        return true;
+      },
+      PreservedAnalyses::controlFlow());
+  Passes.addFunctionPass(
+      [](MIRBuilder &Builder, Function &F, AnalysisCache &Analyses) {
+        return propagateConstants(Builder, F, Analyses);
+      });
+  Passes.addFunctionPass(
+      [](MIRBuilder &Builder, Function &F, AnalysisCache &Analyses) {
+        return eliminateRedundancies(Builder, F, Analyses);
+      },
+      PreservedAnalyses::controlFlow());
+  Passes.addFunctionPass([](MIRBuilder &Builder, Function &F, AnalysisCache &) {
+    destructSSA(Builder, F);
+    return true;
+  });
+  auto Start = std::chrono::steady_clock::now();
+  Passes.run(*TheModule);
+  std::chrono::duration<double> Time = std::chrono::steady_clock::now() - Start;
+  std::stringstream Stream;
+  Stream << *TheModule;
+  return {Time.count(), Stream.str()};
+}
+
+int main() {
+  const std::size_t NumFunctions = 200;
+  const unsigned NumCores = std::max(1u, std::thread::hardware_concurrency());
+  std::cout << NumFunctions << " functions, " << NumCores
+            << " hardware threads\n";
+  auto [Serial, Expected] = optimize(NumFunctions, 1);
+  for (unsigned NumWorkers : {1, 2, 4, 8, 16}) {
+    auto [Time, Result] =
+        NumWorkers == 1 ? std::make_pair(Serial, Expected)
+                        : optimize(NumFunctions, NumWorkers);
+    std::cout << std::setw(2) << NumWorkers << " workers: " << std::fixed
+              << std::setprecision(3) << Time << " s, speedup "
+              << std::setprecision(2) << Serial / Time << "x"
+              << (Result == Expected ? "" : ", RESULT DIFFERS") << "\n";
+  }
+  return 0;
+}
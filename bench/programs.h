@@ -0,0 +1,191 @@
+/// \file
+/// \brief Generators of MIR programs for benchmarks.
+#ifndef BENCH_PROGRAMS_H
+#define BENCH_PROGRAMS_H
+#include "MIR.h"
+#include <random>
+
+namespace wyrm {
+namespace bench {
+
+/// \brief Build fib(n) computed with two recursive calls.
+inline void buildFib(MIRBuilder &Builder, Function &F) {
+  auto &Entry = Builder.createBasicBlock(F);
+  auto &Small = Builder.createBasicBlock(F);
+  auto &Large = Builder.createBasicBlock(F);
+  Builder.setBasicBlock(Entry);
+  auto &N = get<ReceiveInst>(Builder.createReceiveInst("n")).outRegister();
+  auto &C = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Less, N, 2, "c"))
+                .outRegister();
+  Builder.createBrInst(C, Small, Large);
+  Builder.setBasicBlock(Small);
+  Builder.createRetInst(N);
+  Builder.setBasicBlock(Large);
+  auto &N1 = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Sub, N, 1, "n1"))
+                 .outRegister();
+  auto &N2 = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Sub, N, 2, "n2"))
+                 .outRegister();
+  auto &A = *get<CallInst>(Builder.createCallInst(true, F, {N1}, "a"))
+                 .outRegister();
+  auto &B = *get<CallInst>(Builder.createCallInst(true, F, {N2}, "b"))
+                 .outRegister();
+  auto &S = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Add, A, B, "s"))
+                .outRegister();
+  Builder.createRetInst(S);
+}
+
+/// \brief Build a loop running n times a body of \p Size random arithmetic
+/// operations on four variables, which returns their combination.
+inline void buildArithmeticLoop(std::mt19937 &Gen, MIRBuilder &Builder,
+                                Function &F, std::size_t Size) {
+  auto &Entry = Builder.createBasicBlock(F);
+  auto &Header = Builder.createBasicBlock(F);
+  auto &Body = Builder.createBasicBlock(F);
+  auto &Exit = Builder.createBasicBlock(F);
+  Builder.setBasicBlock(Entry);
+  auto &N = get<ReceiveInst>(Builder.createReceiveInst("n")).outRegister();
+  auto &I = get<UnOpInst>(Builder.createUnOpInst(UnOpKind::Assign, 0, "i"))
+                .outRegister();
+  SymReg *Vars[4];
+  for (int V = 0; V < 4; ++V)
+    Vars[V] = &get<UnOpInst>(Builder.createUnOpInst(
+                                 UnOpKind::Assign, V + 1,
+                                 std::string(1, static_cast<char>('a' + V))))
+                   .outRegister();
+  Builder.createGoToInst(Header);
+  Builder.setBasicBlock(Header);
+  // Unlike "c", the name doesn't clash with the third variable.
+  auto &C = get<BinOpInst>(
+                Builder.createBinOpInst(BinOpKind::Less, I, N, "cond"))
+                .outRegister();
+  Builder.createBrInst(C, Body, Exit);
+  Builder.setBasicBlock(Body);
+  const BinOpKind Kinds[] = {BinOpKind::Add, BinOpKind::Sub, BinOpKind::Mul,
+                             BinOpKind::Xor, BinOpKind::And, BinOpKind::Or,
+                             BinOpKind::Shl, BinOpKind::Shr, BinOpKind::Min,
+                             BinOpKind::Max};
+  std::uniform_int_distribution<int> Var(0, 3), Kind(0, 9), Constant(1, 9);
+  for (std::size_t Op = 0; Op < Size; ++Op) {
+    // Mixing in the counter keeps the values changing.
+    Value RHS = Op % 7 == 0 ? Value{I}
+                : Op % 3    ? Value{*Vars[Var(Gen)]}
+                            : Value{Constant(Gen)};
+    Builder.createBinOpInst(Kinds[Kind(Gen)], *Vars[Var(Gen)], RHS,
+                            *Vars[Var(Gen)]);
+  }
+  Builder.createBinOpInst(BinOpKind::Add, I, 1, I);
+  Builder.createGoToInst(Header);
+  Builder.setBasicBlock(Exit);
+  auto &R = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Xor, *Vars[0],
+                                                   *Vars[1], "r"))
+                .outRegister();
+  Builder.createBinOpInst(BinOpKind::Xor, R, *Vars[2], R);
+  Builder.createBinOpInst(BinOpKind::Xor, R, *Vars[3], R);
+  Builder.createRetInst(R);
+}
+
+/// \brief Build a nested loop summing (i * j) % 7 for i, j from 0 to n - 1.
+inline void buildNestedLoops(MIRBuilder &Builder, Function &F) {
+  auto &Entry = Builder.createBasicBlock(F);
+  auto &Outer = Builder.createBasicBlock(F);
+  auto &InnerEntry = Builder.createBasicBlock(F);
+  auto &Inner = Builder.createBasicBlock(F);
+  auto &Body = Builder.createBasicBlock(F);
+  auto &Latch = Builder.createBasicBlock(F);
+  auto &Exit = Builder.createBasicBlock(F);
+  Builder.setBasicBlock(Entry);
+  auto &N = get<ReceiveInst>(Builder.createReceiveInst("n")).outRegister();
+  auto &I = get<UnOpInst>(Builder.createUnOpInst(UnOpKind::Assign, 0, "i"))
+                .outRegister();
+  auto &S = get<UnOpInst>(Builder.createUnOpInst(UnOpKind::Assign, 0, "s"))
+                .outRegister();
+  Builder.createGoToInst(Outer);
+  Builder.setBasicBlock(Outer);
+  auto &C = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Less, I, N, "c"))
+                .outRegister();
+  Builder.createBrInst(C, InnerEntry, Exit);
+  Builder.setBasicBlock(InnerEntry);
+  auto &J = get<UnOpInst>(Builder.createUnOpInst(UnOpKind::Assign, 0, "j"))
+                .outRegister();
+  Builder.createGoToInst(Inner);
+  Builder.setBasicBlock(Inner);
+  auto &D = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Less, J, N, "d"))
+                .outRegister();
+  Builder.createBrInst(D, Body, Latch);
+  Builder.setBasicBlock(Body);
+  auto &P = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Mul, I, J, "p"))
+                .outRegister();
+  Builder.createBinOpInst(BinOpKind::Mod, P, 7, P);
+  Builder.createBinOpInst(BinOpKind::Add, S, P, S);
+  Builder.createBinOpInst(BinOpKind::Add, J, 1, J);
+  Builder.createGoToInst(Inner);
+  Builder.setBasicBlock(Latch);
+  Builder.createBinOpInst(BinOpKind::Add, I, 1, I);
+  Builder.createGoToInst(Outer);
+  Builder.setBasicBlock(Exit);
+  Builder.createRetInst(S);
+}
+
+/// \brief Build a nested loop summing (i * (a * a + 7) + j) ^ (n / (a | 1))
+/// for i, j from 0 to n - 1, where n and a are the arguments. Most of the
+/// inner body is invariant in one or both loops.
+inline void buildInvariantLoops(MIRBuilder &Builder, Function &F) {
+  auto &Entry = Builder.createBasicBlock(F);
+  auto &Outer = Builder.createBasicBlock(F);
+  auto &InnerEntry = Builder.createBasicBlock(F);
+  auto &Inner = Builder.createBasicBlock(F);
+  auto &Body = Builder.createBasicBlock(F);
+  auto &Latch = Builder.createBasicBlock(F);
+  auto &Exit = Builder.createBasicBlock(F);
+  Builder.setBasicBlock(Entry);
+  auto &N = get<ReceiveInst>(Builder.createReceiveInst("n")).outRegister();
+  auto &A = get<ReceiveInst>(Builder.createReceiveInst("a")).outRegister();
+  auto &I = get<UnOpInst>(Builder.createUnOpInst(UnOpKind::Assign, 0, "i"))
+                .outRegister();
+  auto &S = get<UnOpInst>(Builder.createUnOpInst(UnOpKind::Assign, 0, "s"))
+                .outRegister();
+  auto &Den =
+      get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Or, A, 1, "den"))
+          .outRegister();
+  Builder.createGoToInst(Outer);
+  Builder.setBasicBlock(Outer);
+  auto &C = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Less, I, N, "c"))
+                .outRegister();
+  Builder.createBrInst(C, InnerEntry, Exit);
+  Builder.setBasicBlock(InnerEntry);
+  auto &J = get<UnOpInst>(Builder.createUnOpInst(UnOpKind::Assign, 0, "j"))
+                .outRegister();
+  Builder.createGoToInst(Inner);
+  Builder.setBasicBlock(Inner);
+  auto &H = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Div, N, Den, "h"))
+                .outRegister();
+  auto &D = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Less, J, N, "d"))
+                .outRegister();
+  Builder.createBrInst(D, Body, Latch);
+  Builder.setBasicBlock(Body);
+  auto &Sq = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Mul, A, A, "sq"))
+                 .outRegister();
+  auto &Sc =
+      get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Add, Sq, 7, "sc"))
+          .outRegister();
+  auto &Row =
+      get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Mul, I, Sc, "row"))
+          .outRegister();
+  auto &T = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Add, Row, J, "t"))
+                .outRegister();
+  auto &U = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Xor, T, H, "u"))
+                .outRegister();
+  Builder.createBinOpInst(BinOpKind::Add, S, U, S);
+  Builder.createBinOpInst(BinOpKind::Add, J, 1, J);
+  Builder.createGoToInst(Inner);
+  Builder.setBasicBlock(Latch);
+  Builder.createBinOpInst(BinOpKind::Add, I, 1, I);
+  Builder.createGoToInst(Outer);
+  Builder.setBasicBlock(Exit);
+  Builder.createRetInst(S);
+}
+
+} // namespace bench
+} // namespace wyrm
+
+#endif
@@ -0,0 +1,94 @@
+/// \file
+/// \brief Lazily computed analyses of a function kept between passes.
+#ifndef ANALYSIS_CACHE_H
+#define ANALYSIS_CACHE_H
+#include "Analysis/cfg.h"
+#include "Analysis/dominator_tree.h"
+#include "Analysis/liveness.h"
+#include "Analysis/loop_info.h"
+
+namespace wyrm {
+
+/// \brief Analyses kept by AnalysisCache.
+enum class AnalysisKind : unsigned { CFG, DominatorTree, Liveness, Loops };
+
+/// \brief Analyses which a pass keeps valid although it changes a function.
+class PreservedAnalyses {
+public:
+  static PreservedAnalyses none() { return PreservedAnalyses{0}; }
+  static PreservedAnalyses all() { return PreservedAnalyses{~0u}; }
+  /// \brief The analyses of the blocks and edges between them, which
+  /// survive changes of instructions other than terminators.
+  static PreservedAnalyses controlFlow() {
+    return none()
+        .preserve(AnalysisKind::CFG)
+        .preserve(AnalysisKind::DominatorTree)
+        .preserve(AnalysisKind::Loops);
+  }
+  PreservedAnalyses &preserve(AnalysisKind Kind) {
+    Bits |= bit(Kind);
+    return *this;
+  }
+  bool preserves(AnalysisKind Kind) const { return Bits & bit(Kind); }
+
+private:
+  explicit PreservedAnalyses(unsigned Bits) : Bits{Bits} {}
+  static unsigned bit(AnalysisKind Kind) {
+    return 1u << static_cast<unsigned>(Kind);
+  }
+  unsigned Bits;
+};
+
+/// \brief Analyses of a function computed on first request and reused until
+/// the function changes.
+/// A result is stamped with the version of the function it was computed at:
+/// the CFG, the dominator tree and the loops with Function::cfgVersion(), the
+/// others with Function::version(). A request for a result with an outdated
+/// stamp recomputes it. A pass changing the function without invalidating a
+/// result tells so to finishPass().
+/// References returned by the cache stay valid until the next request of
+/// the same analysis or of the CFG it's based on.
+class AnalysisCache {
+public:
+  explicit AnalysisCache(Function &F) : F{F} {}
+  AnalysisCache(const AnalysisCache &) = delete;
+  AnalysisCache &operator=(const AnalysisCache &) = delete;
+  Function &function() const { return F; }
+  /// \pre The entry block of the function has no predecessors.
+  const FunctionCFG &cfg();
+  /// \brief Dominator tree with the nodes of cfg().
+  const DominatorTree &dominatorTree();
+  /// \brief Loops with the nodes of cfg().
+  const LoopInfo &loops();
+  const Liveness &liveness();
+  /// \brief Note that a pass starts changing the function.
+  void startPass();
+  /// \brief Note that the pass started last is done and keeps the results
+  /// of \p Preserved valid. Those of them which were up to date when the
+  /// pass started or were computed by the pass are stamped with the current
+  /// version. The other outdated results are dropped, including the ones
+  /// based on a dropped CFG.
+  void finishPass(PreservedAnalyses Preserved);
+  /// \return If the result of \p Kind is computed and up to date.
+  bool isCached(AnalysisKind Kind) const;
+
+private:
+  /// \brief Drop the CFG and everything based on it.
+  void dropCFG();
+  Function &F;
+  /// Versions of the function when the last pass started.
+  std::size_t StartVersion{};
+  std::size_t StartCFGVersion{};
+  optional<FunctionCFG> CFG;
+  std::size_t CFGStamp{};
+  optional<DominatorTree> DT;
+  std::size_t DTStamp{};
+  optional<LoopInfo> Loops;
+  std::size_t LoopsStamp{};
+  optional<Liveness> Live;
+  std::size_t LiveStamp{};
+};
+
+} // namespace wyrm
+
+#endif
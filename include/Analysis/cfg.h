@@ -0,0 +1,100 @@
+#ifndef CFG_H
+#define CFG_H
+#include "Analysis/dominator_tree.h"
+#include "MIR.h"
+#include "csr_graph.h"
+#include "graph_traversal.h"
+#include <vector>
+
+namespace wyrm {
+
+/// \brief Successors of \p BB in the order of its terminator operands.
+/// A block which doesn't end with a terminator has no successors.
+std::vector<BasicBlock *> successors(BasicBlock &BB);
+
+/// \brief Control flow graph of a function.
+/// Basic blocks are numbered by their position in the function, so the entry
+/// block is the root of the graph.
+class FunctionCFG {
+public:
+  using NodeId = CSRGraph::NodeId;
+  /// \pre The entry block of \p F has no predecessors.
+  explicit FunctionCFG(Function &F);
+  const CSRGraph &graph() const { return Graph; }
+  std::size_t size() const { return Blocks.size(); }
+  BasicBlock &block(NodeId Node) const { return *Blocks[Node]; }
+  NodeId number(const BasicBlock &BB) const {
+    assert(BB.index() < Numbers.size() && Numbers[BB.index()] != NoNumber &&
+           "The block is not in the graph");
+    return Numbers[BB.index()];
+  }
+
+private:
+  static constexpr NodeId NoNumber = CSRGraph::NoNode;
+  std::vector<BasicBlock *> Blocks{};
+  /// Numbers of the blocks by their indices.
+  std::vector<NodeId> Numbers{};
+  CSRGraph Graph;
+};
+
+/// \brief Control flow graph of a function read from the successors and
+/// predecessors cached by its blocks.
+/// Unlike FunctionCFG the view copies nothing and follows the changes of the
+/// function. Nodes are block indices, so the entry block is the root and
+/// indices of erased blocks are nodes without arcs. A branch to the same
+/// block twice is a pair of parallel arcs.
+class FunctionGraph {
+public:
+  using NodeId = CSRGraph::NodeId;
+  using NodeRange = CSRGraph::NodeRange;
+  /// \pre The entry block of \p F has index 0 and no predecessors.
+  explicit FunctionGraph(const Function &F) : F{F} {}
+  const Function &function() const { return F; }
+  std::size_t size() const { return F.numBlockIndices(); }
+  /// \brief Successors of \p Node in the order of the terminator operands.
+  NodeRange successors(NodeId Node) const {
+    const BasicBlock *BB = F.blockAt(Node);
+    return BB ? range(BB->successorIndices()) : NodeRange{nullptr, nullptr};
+  }
+  /// \brief Predecessors of \p Node in no particular order.
+  NodeRange predecessors(NodeId Node) const {
+    const BasicBlock *BB = F.blockAt(Node);
+    return BB ? range(BB->predecessorIndices()) : NodeRange{nullptr, nullptr};
+  }
+  /// \brief Graph nodes reachable from the root listed in DFS order.
+  std::vector<NodeId> DFSOrder() const { return depthFirstOrder(*this); }
+  /// \brief Graph nodes reachable from the root listed in reverse postorder.
+  std::vector<NodeId> reversePostOrder() const {
+    return ::reversePostOrder(*this);
+  }
+
+  static constexpr NodeId Root = 0;
+  /// \brief Marker of a missing node.
+  static constexpr NodeId NoNode = CSRGraph::NoNode;
+
+private:
+  static NodeRange range(BlockIndexRange Indices) {
+    return {Indices.begin(), Indices.end()};
+  }
+  const Function &F;
+};
+
+/// \brief Find immediate dominators of the blocks of a function with
+/// Semi-NCA.
+/// \return Vector which maps a block index to the index of its immediate
+/// dominator. The root is mapped to itself, unreachable and erased blocks are
+/// mapped to CSRGraph::NoNode.
+std::vector<CSRGraph::NodeId> immediateDominators(const FunctionGraph &CFG);
+
+/// \brief Find the local registers defined by a single instruction which
+/// dominates every use, so every read sees the value it computes.
+/// A phi reads its operands at the end of the incoming blocks. Reads in
+/// unreachable blocks never happen and are ignored.
+/// \param DT Dominator tree of \p CFG.
+/// \return Flags of the registers by their indices.
+std::vector<bool> findDominatingDefinitions(const FunctionCFG &CFG,
+                                            const DominatorTree &DT);
+
+} // namespace wyrm
+
+#endif
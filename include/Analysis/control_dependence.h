@@ -0,0 +1,42 @@
+/// \file
+/// \brief Control dependences between the nodes of a CFG.
+#ifndef CONTROL_DEPENDENCE_H
+#define CONTROL_DEPENDENCE_H
+#include "Analysis/post_dominator_tree.h"
+#include "csr_graph.h"
+#include <vector>
+
+namespace wyrm {
+
+/// \brief Control dependence graph of a CFG.
+/// Node Y is control dependent on node X if X has a successor post-dominated
+/// by Y but Y doesn't strictly post-dominate X: the branch of X decides
+/// whether Y runs. As in Cytron et al., "Efficiently Computing Static Single
+/// Assignment Form and the Control Dependence Graph", 1991, these are the
+/// dominance frontiers of the reversed CFG, found with the runner method: for
+/// every arc X -> S the walk from S up the post-dominator tree to the
+/// immediate post-dominator of X visits the nodes dependent on X. The work is
+/// linear in the size of the CFG and the result.
+/// Dependences are kept as sorted ranges of one contiguous array.
+class ControlDependenceGraph {
+public:
+  using NodeId = CSRGraph::NodeId;
+  using NodeRange = CSRGraph::NodeRange;
+  /// \pre \p PDT is the post-dominator tree of \p CFG.
+  ControlDependenceGraph(const CSRGraph &CFG, const PostDominatorTree &PDT);
+  std::size_t size() const { return Offsets.size() - 1; }
+  /// \brief Nodes \p Node is control dependent on in ascending order.
+  NodeRange controllers(NodeId Node) const {
+    assert(Node < size() && "The node is not in the graph");
+    const NodeId *Data = Controllers.data();
+    return {Data + Offsets[Node], Data + Offsets[Node + 1]};
+  }
+
+private:
+  std::vector<NodeId> Offsets{};
+  std::vector<NodeId> Controllers{};
+};
+
+} // namespace wyrm
+
+#endif
@@ -0,0 +1,184 @@
+/// \file
+/// \brief Generic iterative dataflow solver over bit-vector lattices.
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+#include "bitvector.h"
+#include "csr_graph.h"
+#include <algorithm>
+#include <vector>
+
+namespace wyrm {
+
+enum class DataflowDirection { Forward, Backward };
+enum class MeetOperator { Union, Intersection };
+
+/// \brief Transfer function of a block: Out = Gen | (In & ~Kill), where In
+/// is the meet of the neighbours joined with MeetGen.
+/// MeetGen is a block-side contribution of the edges, e.g. phi operands
+/// which are used at the end of the predecessors.
+struct BlockSummary {
+  BitVector Gen;
+  BitVector Kill;
+  BitVector MeetGen;
+};
+
+/// \brief Worklist solver of a dataflow problem given by \p ProblemT.
+/// The problem must provide:
+/// - static constexpr DataflowDirection Direction;
+/// - static constexpr MeetOperator Meet;
+/// - static constexpr bool HasMeetGen; if false MeetGen is never read;
+/// - std::size_t numBits() const;
+/// - void summarize(CSRGraph::NodeId, BlockSummary &) const, which fills the
+///   zeroed summary of a block.
+/// Summaries are computed once and then blocks are iterated in reverse
+/// postorder for forward problems and in postorder for backward ones. A
+/// block is revisited only if the value of its neighbour changed. The
+/// boundary value (entry for forward, exits for backward problems) is empty
+/// and the other values start from the identity of the meet.
+/// All values and summaries are kept in contiguous word matrices and the
+/// word loops are instantiated for the direction and the meet, so the
+/// compiler is free to vectorize them.
+/// Blocks unreachable from the root are not analyzed and have empty values.
+template <typename ProblemT> class DataflowSolver {
+public:
+  using NodeId = CSRGraph::NodeId;
+  DataflowSolver(const CSRGraph &CFG, const ProblemT &Problem)
+      : CFG{CFG}, Problem{Problem} {}
+  void solve();
+  /// \brief Value on entry to \p Node.
+  BitVectorView in(NodeId Node) const {
+    return view(IsForward ? Incoming : Outgoing, Node);
+  }
+  /// \brief Value on exit from \p Node.
+  BitVectorView out(NodeId Node) const {
+    return view(IsForward ? Outgoing : Incoming, Node);
+  }
+
+private:
+  static constexpr bool IsForward =
+      ProblemT::Direction == DataflowDirection::Forward;
+  BitVectorView view(const std::vector<BitWord> &Matrix, NodeId Node) const {
+    return {Matrix.data() + Node * Words, Problem.numBits()};
+  }
+  /// \brief Recompute the value of \p Node.
+  /// \return true if the value propagated to the dependents changed.
+  bool update(NodeId Node);
+  const CSRGraph &CFG;
+  const ProblemT &Problem;
+  std::size_t Words{};
+  std::vector<BitWord> Gen{};
+  std::vector<BitWord> Kill{};
+  std::vector<BitWord> MeetGen{};
+  /// Meet of the neighbours, i.e. In for forward and Out for backward
+  /// problems.
+  std::vector<BitWord> Incoming{};
+  /// Result of the transfer function.
+  std::vector<BitWord> Outgoing{};
+};
+
+template <typename ProblemT> void DataflowSolver<ProblemT>::solve() {
+  const std::size_t N{CFG.size()}, Bits{Problem.numBits()};
+  Words = bitWords(Bits);
+  Gen.assign(N * Words, 0);
+  Kill.assign(N * Words, 0);
+  if constexpr (ProblemT::HasMeetGen)
+    MeetGen.assign(N * Words, 0);
+  Incoming.assign(N * Words, 0);
+  Outgoing.assign(N * Words, 0);
+
+  std::vector<NodeId> Order{CFG.reversePostOrder()};
+  if constexpr (!IsForward)
+    std::reverse(std::begin(Order), std::end(Order));
+  BlockSummary Summary;
+  for (auto Node : Order) {
+    Summary.Gen = BitVector(Bits);
+    Summary.Kill = BitVector(Bits);
+    if constexpr (ProblemT::HasMeetGen)
+      Summary.MeetGen = BitVector(Bits);
+    Problem.summarize(Node, Summary);
+    std::copy_n(Summary.Gen.words(), Words, Gen.data() + Node * Words);
+    std::copy_n(Summary.Kill.words(), Words, Kill.data() + Node * Words);
+    if constexpr (ProblemT::HasMeetGen)
+      std::copy_n(Summary.MeetGen.words(), Words,
+                  MeetGen.data() + Node * Words);
+  }
+  if constexpr (ProblemT::Meet == MeetOperator::Intersection) {
+    // Start from the top, which is the full set masked to the bit count.
+    // Unreachable neighbours keep the top, so they don't affect the meet.
+    BitVector Top(Bits, true);
+    for (NodeId Node = 0; Node < N; ++Node)
+      std::copy_n(Top.words(), Words, Outgoing.data() + Node * Words);
+  }
+
+  std::vector<NodeId> Position(N);
+  for (NodeId Pos = 0, E = Order.size(); Pos < E; ++Pos)
+    Position[Order[Pos]] = Pos;
+  std::vector<bool> Reachable(N);
+  for (auto Node : Order)
+    Reachable[Node] = true;
+  // The worklist is swept in iteration order, so a block waits for the
+  // updates of all earlier blocks of the sweep.
+  std::vector<bool> Pending(Order.size(), true);
+  for (bool Changed = true; Changed;) {
+    Changed = false;
+    for (NodeId Pos = 0, E = Order.size(); Pos < E; ++Pos) {
+      if (!Pending[Pos])
+        continue;
+      Pending[Pos] = false;
+      NodeId Node = Order[Pos];
+      if (!update(Node))
+        continue;
+      auto Dependents =
+          IsForward ? CFG.successors(Node) : CFG.predecessors(Node);
+      for (auto Dependent : Dependents) {
+        if (!Reachable[Dependent])
+          continue;
+        Pending[Position[Dependent]] = true;
+        Changed |= Position[Dependent] <= Pos;
+      }
+    }
+  }
+  // Unreachable blocks keep empty values.
+  for (NodeId Node = 0; Node < N; ++Node)
+    if (!Reachable[Node])
+      std::fill_n(Outgoing.data() + Node * Words, Words, 0);
+}
+
+template <typename ProblemT>
+bool DataflowSolver<ProblemT>::update(NodeId Node) {
+  constexpr bool IsUnion = ProblemT::Meet == MeetOperator::Union;
+  // A local copy of the word count can't alias the stored words, which keeps
+  // the loops countable and vectorizable.
+  const std::size_t NumWords{Words};
+  const std::size_t Offset{Node * NumWords};
+  BitWord *Input = Incoming.data() + Offset;
+  auto Neighbours = IsForward ? CFG.predecessors(Node) : CFG.successors(Node);
+  // The boundary block and blocks without neighbours get the empty set.
+  bool IsBoundary = Neighbours.empty() || (IsForward && Node == CFG.Root);
+  for (std::size_t I = 0; I < NumWords; ++I)
+    Input[I] = IsUnion || IsBoundary ? 0 : ~BitWord{};
+  if (!IsBoundary)
+    for (auto Neighbour : Neighbours) {
+      const BitWord *Value = Outgoing.data() + Neighbour * NumWords;
+      for (std::size_t I = 0; I < NumWords; ++I)
+        Input[I] = IsUnion ? Input[I] | Value[I] : Input[I] & Value[I];
+    }
+  if constexpr (ProblemT::HasMeetGen) {
+    const BitWord *Extra = MeetGen.data() + Offset;
+    for (std::size_t I = 0; I < NumWords; ++I)
+      Input[I] |= Extra[I];
+  }
+  const BitWord *G = Gen.data() + Offset, *K = Kill.data() + Offset;
+  BitWord *Output = Outgoing.data() + Offset;
+  BitWord Diff{};
+  for (std::size_t I = 0; I < NumWords; ++I) {
+    BitWord Result = G[I] | (Input[I] & ~K[I]);
+    Diff |= Result ^ Output[I];
+    Output[I] = Result;
+  }
+  return Diff != 0;
+}
+
+} // namespace wyrm
+
+#endif
@@ -1,18 +1,73 @@
 #ifndef DOMINANCE_H
 #define DOMINANCE_H
+#include "bitvector.h"
+#include "csr_graph.h"
 #include "graph.h"
+#include <limits>
 #include <unordered_map>
+#include <vector>
 
 namespace wyrm {
 
+/// \brief Marker of a node without immediate dominator.
+constexpr size_t NoNode = std::numeric_limits<size_t>::max();
+
 using DominatorMap = std::unordered_map<size_t, Graph::NodeSet>;
 /// \brief Implement straightforwad algorithm of dominators search in \par CFG.
 /// The algorithm is described in Muchnick 7.3 (p. 181).
 /// \return Hash table which maps a node to its dominators.
 DominatorMap dominators_slow(const Graph &CFG);
+DominatorMap dominators_slow(const CSRGraph &CFG);
+
+/// \brief Dominator sets of all nodes of a CFG kept as a dense bit matrix.
+/// Row \c B has bit \c A set if \c A dominates \c B. Rows of nodes
+/// unreachable from the root are empty.
+class DominatorMatrix {
+public:
+  /// \return If \p A dominates \p B.
+  bool dominates(size_t A, size_t B) const {
+    assert(A < Size && B < Size && "The vertex is not in the graph");
+    return row(B)[A / BitWordSize] >> (A % BitWordSize) & 1;
+  }
+  /// \brief Number of nodes in the CFG.
+  size_t size() const { return Size; }
+  /// \brief Convert to the representation of dominators_slow.
+  DominatorMap toDominatorMap() const;
+  friend DominatorMatrix dominators_dense(const CSRGraph &CFG);
+
+private:
+  DominatorMatrix(size_t Size)
+      : Size{Size}, RowWords{bitWords(Size)}, Bits(Size * RowWords) {}
+  BitWord *row(size_t Node) { return Bits.data() + Node * RowWords; }
+  const BitWord *row(size_t Node) const {
+    return Bits.data() + Node * RowWords;
+  }
+  size_t Size;
+  size_t RowWords;
+  std::vector<BitWord> Bits;
+};
+
+/// \brief Implement iterative dominators search on dense bit vectors.
+/// Nodes are visited in reverse postorder, so acyclic CFGs need only one
+/// iteration to converge. Rows are intersected word-parallel.
+DominatorMatrix dominators_dense(const CSRGraph &CFG);
+DominatorMatrix dominators_dense(const Graph &CFG);
+/// \brief Find immediate dominators with Semi-NCA algorithm.
+/// The algorithm is a simplification of Lengauer-Tarjan described in
+/// Georgiadis, "Linear-Time Algorithms for Dominators and Related Problems",
+/// 2005. Path compression is unbalanced and the NCA phase walks up the tree,
+/// so it runs in O(n^2) in the worst case, but near-linear on CFGs in
+/// practice, where it is faster than Lengauer-Tarjan.
+/// \return Vector which maps a node to its immediate dominator. The root is
+/// mapped to itself, nodes unreachable from the root are mapped to NoNode.
+std::vector<size_t> immediateDominators(const Graph &CFG);
+/// \brief Find immediate dominators of frozen \p CFG.
+/// Unreachable nodes are mapped to CSRGraph::NoNode.
+std::vector<CSRGraph::NodeId> immediateDominators(const CSRGraph &CFG);
 /// \brief Find immediete dominators.
 /// \return Dominator tree.
 Graph buildDominatorTree(const Graph &CFG);
+Graph buildDominatorTree(const CSRGraph &CFG);
 
 } // namespace wyrm
 
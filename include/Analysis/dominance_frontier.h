@@ -0,0 +1,63 @@
+#ifndef DOMINANCE_FRONTIER_H
+#define DOMINANCE_FRONTIER_H
+#include "Analysis/dominator_tree.h"
+#include "csr_graph.h"
+#include <vector>
+
+namespace wyrm {
+
+/// \brief Dominance frontiers of all nodes of a CFG.
+/// Computed with the runner method of Cooper, Harvey and Kennedy, "A Simple,
+/// Fast Dominance Algorithm", 2001: a join node belongs to the frontiers of
+/// its predecessors and their dominators up to its own immediate dominator.
+/// Frontiers are kept as sorted ranges of one contiguous array.
+class DominanceFrontier {
+public:
+  using NodeId = CSRGraph::NodeId;
+  using NodeRange = CSRGraph::NodeRange;
+  /// \pre \p DT is the dominator tree of \p CFG.
+  DominanceFrontier(const CSRGraph &CFG, const DominatorTree &DT);
+  /// \brief Dominance frontier of \p Node in ascending order.
+  NodeRange frontier(NodeId Node) const {
+    const NodeId *Data = Frontiers.data();
+    return {Data + Offsets[Node], Data + Offsets[Node + 1]};
+  }
+  std::size_t size() const { return Offsets.size() - 1; }
+
+private:
+  std::vector<NodeId> Offsets{};
+  std::vector<NodeId> Frontiers{};
+};
+
+/// \brief Iterated dominance frontier calculator.
+/// Implements the algorithm of Sreedhar and Gao, "A Linear Time Algorithm for
+/// Placing phi-nodes", 1995, on the DJ graph: definition nodes are processed
+/// deepest first and every join edge into a node not deeper than the current
+/// root adds the node to the frontier. A node enters the queue at most once,
+/// so a query is linear in the size of the visited part of the CFG. Scratch
+/// storage is shared between queries, so the calculator is meant to be
+/// reused for every variable of a function.
+class IDFCalculator {
+public:
+  using NodeId = CSRGraph::NodeId;
+  /// \pre \p DT is the dominator tree of \p CFG.
+  IDFCalculator(const CSRGraph &CFG, const DominatorTree &DT);
+  /// \return Iterated dominance frontier of \p DefNodes in ascending order.
+  /// Unreachable nodes in \p DefNodes are ignored.
+  std::vector<NodeId> calculate(const std::vector<NodeId> &DefNodes);
+
+private:
+  const CSRGraph &CFG;
+  const DominatorTree &DT;
+  /// Nodes given as definitions or added to the frontier.
+  std::vector<bool> InQueue;
+  std::vector<bool> InFrontier;
+  /// Nodes visited by the subtree walks.
+  std::vector<bool> Visited;
+  /// Queued nodes bucketed by depth.
+  std::vector<std::vector<NodeId>> Buckets;
+};
+
+} // namespace wyrm
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef DOMINATOR_TREE_H
+#define DOMINATOR_TREE_H
+#include "csr_graph.h"
+#include "graph.h"
+#include <cassert>
+#include <vector>
+
+namespace wyrm {
+
+/// \brief Dominator tree prepared for constant time queries.
+/// Nodes are numbered in DFS preorder of the tree, so a node dominates exactly
+/// the nodes numbered from its own number up to the number of its last
+/// descendant. The nearest common dominator is found with a range minimum
+/// query over node depths in preorder answered by a sparse table.
+/// Children of every node are kept in one contiguous array.
+class DominatorTree {
+public:
+  using NodeId = CSRGraph::NodeId;
+  using NodeRange = CSRGraph::NodeRange;
+
+  /// \brief Prepare \p Tree returned by buildDominatorTree.
+  explicit DominatorTree(const Graph &Tree);
+  /// \brief Prepare the tree given by immediateDominators of a CSRGraph.
+  explicit DominatorTree(const std::vector<NodeId> &IDoms);
+
+  /// \brief Number of node identifiers covered by the tree, including
+  /// unreachable nodes.
+  std::size_t size() const { return IDom.size(); }
+  /// \return If \p Node is reachable from the root.
+  bool contains(std::size_t Node) const {
+    return Node < size() && IDom[Node] != CSRGraph::NoNode;
+  }
+  /// \return Immediate dominator of \p Node or the root for the root.
+  NodeId idom(NodeId Node) const {
+    assert(contains(Node) && "The node is not in the tree");
+    return IDom[Node];
+  }
+  /// \return Depth of \p Node. The root has depth 0.
+  unsigned depth(NodeId Node) const {
+    assert(contains(Node) && "The node is not in the tree");
+    return Depth[Node];
+  }
+  /// \brief Children of \p Node in ascending order.
+  NodeRange children(NodeId Node) const {
+    assert(Node < size() && "The node is not in the tree");
+    const NodeId *Data = Children.data();
+    return {Data + ChildOffsets[Node], Data + ChildOffsets[Node + 1]};
+  }
+  /// \brief Reachable nodes in DFS preorder of the tree.
+  NodeRange preorder() const {
+    return {Order.data(), Order.data() + Order.size()};
+  }
+  /// \return If \p A dominates \p B. Unreachable nodes dominate nothing and
+  /// are dominated by nothing.
+  bool dominates(std::size_t A, std::size_t B) const {
+    if (!contains(A) || !contains(B))
+      return false;
+    return In[A] <= In[B] && In[B] <= Out[A];
+  }
+  /// \return If \p A dominates \p B and they are different nodes.
+  bool properlyDominates(std::size_t A, std::size_t B) const {
+    return A != B && dominates(A, B);
+  }
+  /// \return The deepest node which dominates both \p A and \p B.
+  /// \pre Both nodes are reachable.
+  NodeId nearestCommonDominator(NodeId A, NodeId B) const;
+
+  static constexpr NodeId Root = CSRGraph::Root;
+
+private:
+  void build();
+  /// \return Preorder number of the shallowest node among preorder numbers
+  /// [First, Last].
+  NodeId shallowest(NodeId First, NodeId Last) const;
+  std::vector<NodeId> IDom{};
+  std::vector<unsigned> Depth{};
+  std::vector<NodeId> ChildOffsets{};
+  std::vector<NodeId> Children{};
+  /// Nodes in preorder.
+  std::vector<NodeId> Order{};
+  /// Preorder number of a node.
+  std::vector<NodeId> In{};
+  /// Preorder number of the last descendant of a node.
+  std::vector<NodeId> Out{};
+  /// Level K keeps the preorder number of the shallowest node among 2^K nodes
+  /// starting from the position in preorder.
+  std::vector<std::vector<NodeId>> SparseTable{};
+};
+
+} // namespace wyrm
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef DYNAMIC_DOMINANCE_H
+#define DYNAMIC_DOMINANCE_H
+#include "Analysis/dominance.h"
+#include "graph.h"
+#include <vector>
+
+namespace wyrm {
+
+/// \brief Insertion or deletion of a CFG arc.
+struct CFGUpdate {
+  enum KindT { Insert, Delete };
+  KindT Kind;
+  Arc TheArc;
+};
+
+/// \brief Dominator tree which is repaired in place when its CFG changes.
+/// Arc insertions are handled by the depth-based search of Georgiadis et al.,
+/// "An Experimental Study of Dynamic Dominators", 2012, which continues the
+/// line of Ramalingam and Reps. An arc deletion rebuilds with Semi-NCA only
+/// the subtree of the nearest common dominator of the arc ends. In both cases
+/// only nodes whose dominators might change are visited.
+class DynamicDominatorTree {
+public:
+  /// \brief Build the dominator tree of \p CFG.
+  /// \pre \p CFG must be changed only through this object while it's alive.
+  explicit DynamicDominatorTree(Graph &CFG);
+  /// \brief Add \p A to the CFG and repair the tree.
+  void insertArc(Arc A);
+  /// \brief Remove \p A from the CFG and repair the tree.
+  void deleteArc(Arc A);
+  /// \brief Apply \p Updates in order.
+  /// If the batch is large compared to the CFG, the tree is recalculated from
+  /// scratch once after all the arcs are changed.
+  void applyUpdates(const std::vector<CFGUpdate> &Updates);
+  /// \return Immediate dominator of \p Node. The root is mapped to itself,
+  /// unreachable nodes are mapped to NoNode.
+  size_t idom(size_t Node) const {
+    return Node < IDom.size() ? IDom[Node] : NoNode;
+  }
+  /// \return Depth of reachable \p Node in the tree. The root has depth 0.
+  size_t depth(size_t Node) const { return Depth[Node]; }
+  bool isReachable(size_t Node) const { return idom(Node) != NoNode; }
+  /// \return If \p A dominates \p B. Unreachable nodes dominate nothing and
+  /// are dominated by nothing.
+  bool dominates(size_t A, size_t B) const;
+  /// \return The deepest node which dominates both \p A and \p B.
+  /// \pre Both nodes are reachable.
+  size_t nearestCommonDominator(size_t A, size_t B) const;
+  /// \brief Dominator tree in the form returned by buildDominatorTree.
+  Graph tree() const;
+  /// \brief Compare the tree with buildDominatorTree of the current CFG.
+  bool verify() const;
+  /// \brief Check the tree against full recalculation after every update.
+  /// A mismatch fails an assertion.
+  void setVerification(bool Enabled) { VerifyUpdates = Enabled; }
+  const Graph &graph() const { return CFG; }
+
+private:
+  void recalculate();
+  void grow(size_t Size);
+  /// \brief Change the CFG and predecessor lists without repairing the tree.
+  /// \return false if the CFG is unchanged.
+  bool addArc(Arc A);
+  bool removeArc(Arc A);
+  void insertReachable(size_t From, size_t To);
+  void insertUnreachable(size_t From, size_t To);
+  void deleteReachable(size_t From, size_t To);
+  void deleteUnreachable(size_t To);
+  bool hasProperSupport(size_t Node) const;
+  /// \brief Recalculate immediate dominators of the nodes dominated by \p Top
+  /// considering only paths from \p Top.
+  void rebuildSubtree(size_t Top);
+  void setIDom(size_t Node, size_t NewIDom);
+  /// \brief Set depths in the subtree of \p Top from the depth of \p Top.
+  void updateDepths(size_t Top);
+  /// \brief Nodes of the subtree of \p Top in preorder.
+  std::vector<size_t> subtree(size_t Top) const;
+  Graph &CFG;
+  std::vector<std::vector<size_t>> Preds{};
+  std::vector<size_t> IDom{};
+  std::vector<size_t> Depth{};
+  std::vector<std::vector<size_t>> Children{};
+  /// Scratch marks of visited nodes. Cleared after every use, so an update
+  /// doesn't pay for the nodes it doesn't touch.
+  std::vector<bool> Marked{};
+  bool VerifyUpdates{};
+};
+
+} // namespace wyrm
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef LIVENESS_H
+#define LIVENESS_H
+#include "Analysis/cfg.h"
+#include "Analysis/dataflow.h"
+
+namespace wyrm {
+
+/// \brief Local registers live at the boundaries of basic blocks.
+/// Bits are register indices within the function; global variables are not
+/// tracked. A phi operand is live at the end of the corresponding predecessor
+/// rather than at the beginning of the phi block.
+class Liveness {
+public:
+  /// \brief Backward union problem: Gen keeps upward exposed uses, Kill
+  /// keeps definitions, MeetGen keeps phi operands of the successors.
+  struct Problem {
+    static constexpr DataflowDirection Direction = DataflowDirection::Backward;
+    static constexpr MeetOperator Meet = MeetOperator::Union;
+    static constexpr bool HasMeetGen = true;
+    std::size_t numBits() const { return NumRegs; }
+    void summarize(CSRGraph::NodeId Node, BlockSummary &Summary) const;
+    const FunctionCFG &CFG;
+    std::size_t NumRegs;
+  };
+
+  /// \pre \p CFG outlives the analysis.
+  explicit Liveness(const FunctionCFG &CFG);
+  BitVectorView liveIn(const BasicBlock &BB) const {
+    return Solver.in(CFG.number(BB));
+  }
+  BitVectorView liveOut(const BasicBlock &BB) const {
+    return Solver.out(CFG.number(BB));
+  }
+  bool isLiveIn(const SymReg &Reg, const BasicBlock &BB) const {
+    return Reg.isLocal() && liveIn(BB).test(Reg.index());
+  }
+  bool isLiveOut(const SymReg &Reg, const BasicBlock &BB) const {
+    return Reg.isLocal() && liveOut(BB).test(Reg.index());
+  }
+
+private:
+  const FunctionCFG &CFG;
+  Problem TheProblem;
+  DataflowSolver<Problem> Solver;
+};
+
+} // namespace wyrm
+
+#endif
@@ -0,0 +1,146 @@
+/// \file
+/// \brief Natural loops of a CFG nested into a forest.
+#ifndef LOOP_INFO_H
+#define LOOP_INFO_H
+#include "Analysis/dominator_tree.h"
+#include "csr_graph.h"
+#include <cassert>
+#include <vector>
+
+namespace wyrm {
+
+/// \brief Natural loops of a CFG and their nesting.
+/// An arc is a back edge if its target dominates its source. All back edges
+/// into a header form one loop, which body is the header and the nodes
+/// reaching a back edge source without passing the header. Loops are found
+/// innermost first by walking the dominator tree bottom up: the backward
+/// walk from the back edge sources steps over an inner loop found earlier
+/// from its header, so every node is assigned to its innermost loop once and
+/// the cost is close to linear in the size of the CFG.
+/// Loops are numbered in preorder of the forest, so a loop comes before its
+/// subloops, and the nodes of a loop including its subloops are a contiguous
+/// range of one array starting with the header. Membership tests take
+/// constant time and the bodies take memory linear in the number of nodes.
+/// Optionally irreducible regions are flagged. As in Havlak, "Nesting of
+/// Reducible and Irreducible Loops", 1997, they are the cycles entered other
+/// than through a dominating header, which aren't natural loops and are left
+/// out of the forest. A CFG is reducible iff it's acyclic without the back
+/// edges, so the nodes of the nontrivial strongly connected components of
+/// the CFG without back edges are flagged. Unlike the collapsing of
+/// Havlak, which carries the entries of nested loops outwards, this takes
+/// linear time.
+class LoopInfo {
+public:
+  using NodeId = CSRGraph::NodeId;
+  using NodeRange = CSRGraph::NodeRange;
+  using LoopId = std::uint32_t;
+  /// \brief Marker of a missing loop.
+  static constexpr LoopId NoLoop = CSRGraph::NoNode;
+
+  /// \param FindIrreducible Flag irreducible regions.
+  /// \pre \p DT is the dominator tree of \p CFG.
+  LoopInfo(const CSRGraph &CFG, const DominatorTree &DT,
+           bool FindIrreducible = false);
+
+  /// \brief Number of loops.
+  std::size_t size() const { return Headers.size(); }
+  /// \brief Number of CFG nodes.
+  std::size_t numNodes() const { return InnermostLoop.size(); }
+  /// \return Innermost loop containing \p Node or NoLoop.
+  LoopId loopFor(NodeId Node) const {
+    assert(Node < numNodes() && "The node is not in the graph");
+    return InnermostLoop[Node];
+  }
+  /// \return Number of loops containing \p Node.
+  unsigned depth(NodeId Node) const {
+    LoopId Loop = loopFor(Node);
+    return Loop == NoLoop ? 0 : loopDepth(Loop);
+  }
+  /// \return Number of loops containing \p Loop including itself.
+  unsigned loopDepth(LoopId Loop) const { return Depths[checked(Loop)]; }
+  NodeId header(LoopId Loop) const { return Headers[checked(Loop)]; }
+  /// \return If \p Node is the header of a loop.
+  bool isHeader(NodeId Node) const {
+    LoopId Loop = loopFor(Node);
+    return Loop != NoLoop && Headers[Loop] == Node;
+  }
+  /// \return Loop immediately containing \p Loop or NoLoop.
+  LoopId parent(LoopId Loop) const { return Parents[checked(Loop)]; }
+  /// \brief Loops immediately contained in \p Loop in ascending order.
+  NodeRange subloops(LoopId Loop) const {
+    return range(SubloopOffsets, Subloops, checked(Loop));
+  }
+  /// \brief Loops contained in no other loop in ascending order.
+  NodeRange topLevelLoops() const {
+    return {TopLevel.data(), TopLevel.data() + TopLevel.size()};
+  }
+  /// \brief Nodes of \p Loop and its subloops. The header comes first,
+  /// followed by the other nodes of \p Loop itself and the nodes of the
+  /// subloops.
+  NodeRange blocks(LoopId Loop) const {
+    const NodeId *Data = Blocks.data();
+    return {Data + BlockBegin[checked(Loop)], Data + BlockEnd[Loop]};
+  }
+  /// \return If \p Node is in \p Loop or its subloops.
+  bool contains(LoopId Loop, NodeId Node) const {
+    return loopFor(Node) != NoLoop &&
+           BlockBegin[checked(Loop)] <= Position[Node] &&
+           Position[Node] < BlockEnd[Loop];
+  }
+  /// \return If \p Inner is \p Outer or nested in it.
+  bool encloses(LoopId Outer, LoopId Inner) const {
+    return Outer <= checked(Inner) && Inner < LoopEnd[checked(Outer)];
+  }
+  /// \brief Sources of the back edges of \p Loop in ascending order.
+  NodeRange latches(LoopId Loop) const {
+    return range(LatchOffsets, Latches, checked(Loop));
+  }
+  /// \brief Nodes outside \p Loop with a predecessor in it in ascending
+  /// order.
+  NodeRange exitBlocks(LoopId Loop) const {
+    return range(ExitOffsets, Exits, checked(Loop));
+  }
+  /// \return If irreducible regions were searched and \p Node is in one.
+  bool isIrreducible(NodeId Node) const {
+    return !Irreducible.empty() && Irreducible[Node];
+  }
+  /// \return If irreducible regions were searched and found.
+  bool hasIrreducibleRegions() const { return NumIrreducible; }
+
+private:
+  LoopId checked(LoopId Loop) const {
+    assert(Loop < size() && "No such loop");
+    return Loop;
+  }
+  static NodeRange range(const std::vector<NodeId> &Offsets,
+                         const std::vector<NodeId> &Nodes, LoopId Loop) {
+    const NodeId *Data = Nodes.data();
+    return {Data + Offsets[Loop], Data + Offsets[Loop + 1]};
+  }
+  void findIrreducible(const CSRGraph &CFG, const DominatorTree &DT);
+  void findExits(const CSRGraph &CFG);
+  std::vector<LoopId> InnermostLoop{};
+  /// Position of a node of a loop in Blocks.
+  std::vector<NodeId> Position{};
+  std::vector<NodeId> Headers{};
+  std::vector<LoopId> Parents{};
+  std::vector<unsigned> Depths{};
+  /// The loop after the last loop nested in a loop.
+  std::vector<LoopId> LoopEnd{};
+  std::vector<NodeId> Blocks{};
+  std::vector<NodeId> BlockBegin{};
+  std::vector<NodeId> BlockEnd{};
+  std::vector<LoopId> TopLevel{};
+  std::vector<NodeId> SubloopOffsets{};
+  std::vector<LoopId> Subloops{};
+  std::vector<NodeId> LatchOffsets{};
+  std::vector<NodeId> Latches{};
+  std::vector<NodeId> ExitOffsets{};
+  std::vector<NodeId> Exits{};
+  std::vector<bool> Irreducible{};
+  std::size_t NumIrreducible{};
+};
+
+} // namespace wyrm
+
+#endif
@@ -0,0 +1,61 @@
+/// \file
+/// \brief Post-dominators of a CFG.
+#ifndef POST_DOMINATOR_TREE_H
+#define POST_DOMINATOR_TREE_H
+#include "Analysis/dominator_tree.h"
+#include "csr_graph.h"
+#include <vector>
+
+namespace wyrm {
+
+/// \brief Post-dominator tree of a CFG.
+/// Node A post-dominates node B if every path from B to an exit passes
+/// through A. The tree is the dominator tree of the reversed CFG rooted at a
+/// virtual exit, which succeeds every node without successors. Nodes which
+/// reach no exit, like the ones of an infinite loop or unreachable from the
+/// root, would be left out, so the virtual exit also succeeds one node of
+/// every such region: the first one not reaching the exit yet in postorder
+/// of the CFG, which is the deepest one, followed by the unreachable nodes by
+/// their numbers. Every node of the CFG is in the tree.
+class PostDominatorTree {
+public:
+  using NodeId = CSRGraph::NodeId;
+  using NodeRange = CSRGraph::NodeRange;
+  explicit PostDominatorTree(const CSRGraph &CFG);
+
+  /// \brief Number of CFG nodes.
+  std::size_t size() const { return Tree.size() - 1; }
+  /// \return Immediate post-dominator of \p Node or NoNode if it's the
+  /// virtual exit.
+  NodeId ipdom(NodeId Node) const {
+    const NodeId Parent = Tree.idom(checked(Node) + 1);
+    return Parent == VirtualExit ? CSRGraph::NoNode : Parent - 1;
+  }
+  /// \return If \p A post-dominates \p B.
+  bool postDominates(NodeId A, NodeId B) const {
+    return Tree.dominates(checked(A) + 1, checked(B) + 1);
+  }
+  /// \return If \p A post-dominates \p B and they are different nodes.
+  bool strictlyPostDominates(NodeId A, NodeId B) const {
+    return A != B && postDominates(A, B);
+  }
+  /// \brief Nodes succeeded by the virtual exit in ascending order.
+  NodeRange exits() const {
+    return {Exits.data(), Exits.data() + Exits.size()};
+  }
+
+private:
+  /// Node of the reversed CFG standing for the virtual exit. CFG node N is
+  /// node N + 1 of the reversed CFG.
+  static constexpr NodeId VirtualExit = CSRGraph::Root;
+  NodeId checked(NodeId Node) const {
+    assert(Node < size() && "The node is not in the graph");
+    return Node;
+  }
+  std::vector<NodeId> Exits{};
+  DominatorTree Tree;
+};
+
+} // namespace wyrm
+
+#endif
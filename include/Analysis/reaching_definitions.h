@@ -0,0 +1,51 @@
+#ifndef REACHING_DEFINITIONS_H
+#define REACHING_DEFINITIONS_H
+#include "Analysis/cfg.h"
+#include "Analysis/dataflow.h"
+
+namespace wyrm {
+
+/// \brief Definitions of local registers reaching the boundaries of basic
+/// blocks.
+/// Definitions are instructions writing a local register. They are numbered
+/// in the order of blocks and then instructions, and bits are the numbers.
+class ReachingDefinitions {
+public:
+  /// \brief Forward union problem: Gen keeps the last definition of every
+  /// register in a block, Kill keeps all definitions of the registers defined
+  /// in the block.
+  struct Problem {
+    static constexpr DataflowDirection Direction = DataflowDirection::Forward;
+    static constexpr MeetOperator Meet = MeetOperator::Union;
+    static constexpr bool HasMeetGen = false;
+    std::size_t numBits() const { return Definitions.size(); }
+    void summarize(CSRGraph::NodeId Node, BlockSummary &Summary) const;
+    const FunctionCFG &CFG;
+    std::vector<Instruction *> Definitions{};
+    /// Number of the first definition of every block, plus the total number.
+    std::vector<std::size_t> BlockBegin{};
+    /// Definition numbers of every register.
+    std::vector<std::vector<std::size_t>> RegisterDefinitions{};
+  };
+
+  /// \pre \p CFG outlives the analysis.
+  explicit ReachingDefinitions(const FunctionCFG &CFG);
+  const std::vector<Instruction *> &definitions() const {
+    return TheProblem.Definitions;
+  }
+  BitVectorView reachingIn(const BasicBlock &BB) const {
+    return Solver.in(CFG.number(BB));
+  }
+  BitVectorView reachingOut(const BasicBlock &BB) const {
+    return Solver.out(CFG.number(BB));
+  }
+
+private:
+  const FunctionCFG &CFG;
+  Problem TheProblem;
+  DataflowSolver<Problem> Solver;
+};
+
+} // namespace wyrm
+
+#endif
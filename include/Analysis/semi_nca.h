@@ -0,0 +1,114 @@
+/// \file
+/// \brief Semi-NCA algorithm shared by the graph types dominators are found
+/// for.
+#ifndef SEMI_NCA_H
+#define SEMI_NCA_H
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace wyrm {
+namespace detail {
+/// \brief State of Semi-NCA algorithm. Nodes are identified by their DFS
+/// preorder numbers, the root has number 0.
+/// GraphT provides NodeId, Root, NoNode, size() and the ranges of
+/// successors() and predecessors() of a node.
+template <typename GraphT> class SemiNCA {
+public:
+  using NodeId = typename GraphT::NodeId;
+  SemiNCA(const GraphT &CFG) : CFG{CFG}, Number(CFG.size(), NoNode) {}
+  std::vector<NodeId> run();
+
+private:
+  static constexpr NodeId NoNode = GraphT::NoNode;
+  void runDFS();
+  NodeId eval(NodeId V, NodeId LastLinked);
+  const GraphT &CFG;
+  /// Preorder number of a node or NoNode if the node is unreachable.
+  std::vector<NodeId> Number;
+  /// Node by its preorder number.
+  std::vector<NodeId> Vertex{};
+  /// DFS tree parent. Compressed by eval.
+  std::vector<NodeId> Ancestor{};
+  std::vector<NodeId> Semi{};
+  std::vector<NodeId> Label{};
+  std::vector<NodeId> IDom{};
+  std::vector<NodeId> Stack{};
+};
+
+template <typename GraphT> void SemiNCA<GraphT>::runDFS() {
+  std::vector<std::pair<NodeId, NodeId>> Worklist{{GraphT::Root, 0}};
+  while (!Worklist.empty()) {
+    auto [Node, ParentNum] = Worklist.back();
+    Worklist.pop_back();
+    if (Number[Node] != NoNode)
+      continue;
+    Number[Node] = Vertex.size();
+    Vertex.push_back(Node);
+    Ancestor.push_back(ParentNum);
+    for (auto Succ : CFG.successors(Node))
+      if (Number[Succ] == NoNode)
+        Worklist.emplace_back(Succ, Number[Node]);
+  }
+}
+
+/// \return Node with minimal semidominator on the path from \p V to the root
+/// of its virtual tree. Nodes with numbers not less than \p LastLinked are
+/// linked to their DFS parents.
+template <typename GraphT>
+auto SemiNCA<GraphT>::eval(NodeId V, NodeId LastLinked) -> NodeId {
+  if (Ancestor[V] < LastLinked)
+    return Label[V];
+  // Collect path to the virtual tree root excluding the root itself.
+  do {
+    Stack.push_back(V);
+    V = Ancestor[V];
+  } while (Ancestor[V] >= LastLinked);
+  // Compress the path and propagate minimal semidominator labels down.
+  NodeId Parent = V;
+  NodeId ParentLabel = Label[Parent];
+  do {
+    V = Stack.back();
+    Stack.pop_back();
+    Ancestor[V] = Ancestor[Parent];
+    if (Semi[ParentLabel] < Semi[Label[V]])
+      Label[V] = ParentLabel;
+    else
+      ParentLabel = Label[V];
+    Parent = V;
+  } while (!Stack.empty());
+  return Label[V];
+}
+
+template <typename GraphT> auto SemiNCA<GraphT>::run() -> std::vector<NodeId> {
+  runDFS();
+  const NodeId N = Vertex.size();
+  IDom = Ancestor;
+  Semi.resize(N);
+  Label.resize(N);
+  for (NodeId Num = 0; Num < N; ++Num)
+    Semi[Num] = Label[Num] = Num;
+  // Semidominators.
+  for (NodeId Num = N - 1; Num > 0; --Num) {
+    Semi[Num] = Ancestor[Num];
+    for (auto Pred : CFG.predecessors(Vertex[Num]))
+      if (Number[Pred] != NoNode)
+        Semi[Num] = std::min(Semi[Num], Semi[eval(Number[Pred], Num + 1)]);
+  }
+  // Immediate dominator is the nearest common ancestor of the semidominator
+  // and the DFS parent.
+  for (NodeId Num = 1; Num < N; ++Num) {
+    NodeId Candidate = IDom[Num];
+    while (Candidate > Semi[Num])
+      Candidate = IDom[Candidate];
+    IDom[Num] = Candidate;
+  }
+  std::vector<NodeId> Result(CFG.size(), NoNode);
+  for (NodeId Num = 0; Num < N; ++Num)
+    Result[Vertex[Num]] = Vertex[IDom[Num]];
+  return Result;
+}
+} // namespace detail
+} // namespace wyrm
+
+#endif
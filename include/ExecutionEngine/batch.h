@@ -0,0 +1,68 @@
+/// \file
+/// \brief SPMD evaluation of a MIR function over many inputs at once.
+#ifndef BATCH_H
+#define BATCH_H
+#include "ExecutionEngine/interpreter.h"
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace wyrm {
+
+/// \brief Evaluator of a function over many argument tuples at once.
+/// Inputs are split into groups of GroupSize lanes. A group keeps every
+/// register as a row of lanes, so each instruction is executed by a SIMD
+/// kernel over the whole row. Lanes following different paths are handled
+/// with masks: every lane has its own current block, and a step executes the
+/// current block earliest in reverse postorder for the lanes in it. Lanes
+/// waiting at a later block are joined there, so lanes which diverged at a
+/// branch run together again after it. A call runs the callee as a group of
+/// the calling lanes.
+///
+/// Each lane behaves like a run of Interpreter: results and trapping
+/// divisions are the same, and so is a call depth limit. Calls don't use the
+/// native stack, but each call depth keeps a group of the callee on the heap
+/// with a row of GroupSize lanes for every register, so the default limit is
+/// lower. The instruction limit applies to each lane separately and is
+/// checked after every block.
+class BatchEvaluator {
+public:
+  static constexpr std::size_t GroupSize = 64;
+  /// \pre Evaluated functions belong to \p M and access no global variables.
+  explicit BatchEvaluator(const Module &M);
+  BatchEvaluator(const BatchEvaluator &) = delete;
+  BatchEvaluator &operator=(const BatchEvaluator &) = delete;
+  ~BatchEvaluator();
+  /// \brief Evaluate \p F for \p NumLanes argument tuples.
+  /// \param Args Arguments in structure-of-arrays form: Args[K][Lane] is the
+  /// K-th argument of lane Lane. Missing arguments are 0.
+  /// \return Results of the lanes.
+  /// \pre Every element of \p Args has \p NumLanes values.
+  std::vector<ExecutionResult>
+  run(const Function &F, std::size_t NumLanes,
+      const std::vector<std::vector<Imm>> &Args = {});
+  void setInstructionLimit(std::uint64_t Limit) { InstructionLimit = Limit; }
+  void setCallDepthLimit(std::size_t Limit) { CallDepthLimit = Limit; }
+  /// \brief Number of instructions executed by all lanes so far.
+  std::uint64_t executedInstructions() const { return Executed; }
+
+private:
+  struct LoweredFunction;
+  class Lowering;
+  class Group;
+  /// \return The lowered \p F. Lowers it if it's new.
+  const LoweredFunction &lowered(const Function &F);
+  const Module &TheModule;
+  /// Not initialized in the class: LoweredFunction is incomplete here.
+  std::unordered_map<const Function *, std::unique_ptr<LoweredFunction>>
+      Functions;
+  std::uint64_t Executed{};
+  std::uint64_t InstructionLimit{std::numeric_limits<std::uint64_t>::max()};
+  std::size_t CallDepthLimit{1 << 12};
+};
+
+} // namespace wyrm
+
+#endif
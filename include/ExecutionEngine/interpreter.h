@@ -0,0 +1,106 @@
+/// \file
+/// \brief Bytecode interpreter of MIR functions.
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+#include "MIR.h"
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace wyrm {
+
+/// \brief Outcome of running a function.
+struct ExecutionResult {
+  enum StatusKind {
+    /// The function returned ReturnValue.
+    Returned,
+    /// Division by zero or INT_MIN / -1.
+    Trapped,
+    /// Calls were nested deeper than the call depth limit.
+    StackOverflow,
+    /// More instructions were executed than the instruction limit.
+    LimitExceeded
+  };
+  StatusKind Status;
+  Imm ReturnValue{};
+  bool returned() const { return Status == Returned; }
+};
+
+/// \brief Interpreter of the functions of a module.
+/// A function is lowered on its first run together with the functions it
+/// calls. Lowering produces linear code of 32-bit cells: an operation
+/// followed by its operands, where registers and constants are slots of the
+/// frame and blocks are offsets in the code. Phis become copies on the
+/// incoming edges. Before the first execution the operations are replaced by
+/// offsets of their handlers, so each handler jumps straight to the next one
+/// with a computed goto. Frames live on a separate stack, so recursion depth
+/// isn't limited by the native stack.
+///
+/// Operations follow evaluate(). In addition:
+/// - the k-th ReceiveInst in layout order receives the k-th argument, missing
+///   arguments are 0;
+/// - registers read before being written are 0;
+/// - global variables start as 0 and keep their values between runs;
+/// - every block ends with a terminator, and a function without blocks
+///   returns 0.
+class Interpreter {
+public:
+  /// \pre Functions run by the interpreter belong to \p M.
+  explicit Interpreter(const Module &M) : TheModule{M} {}
+  ExecutionResult run(const Function &F, const std::vector<Imm> &Args = {});
+  /// \brief Stop runs after \p Limit executed instructions. Only branches
+  /// and calls check the limit, so a run might overshoot it by a block.
+  void setInstructionLimit(std::uint64_t Limit) { InstructionLimit = Limit; }
+  void setCallDepthLimit(std::size_t Limit) { CallDepthLimit = Limit; }
+  /// \brief Number of bytecode operations executed by all runs so far.
+  /// Every MIR instruction is one operation, and so are phi copies and
+  /// accesses to global variables.
+  std::uint64_t executedInstructions() const { return Executed; }
+  Imm global(const SymReg &Var) const;
+  void setGlobal(const SymReg &Var, Imm Number);
+
+private:
+  /// \brief Lowered function.
+  /// The frame keeps parameters, registers, scratch slots and constants in
+  /// this order.
+  struct CompiledFunction {
+    std::vector<std::int32_t> Code{};
+    /// Cells holding operations, which are threaded before execution.
+    std::vector<std::size_t> Operations{};
+    bool IsThreaded{};
+    std::vector<Imm> Constants{};
+    std::size_t NumParams{};
+    std::size_t NumRegisters{};
+    std::size_t FrameSize{};
+  };
+  class Lowering;
+  struct CallRecord {
+    const CompiledFunction *Caller;
+    const std::int32_t *ReturnAddress;
+    std::size_t Base;
+    std::int32_t Result;
+  };
+  /// \return Id of the lowered \p F. Lowers it if it's new.
+  std::int32_t functionId(const Function &F);
+  /// \brief Reserve a frame of \p Callee at \p Base of the stack and fill it
+  /// but the parameters.
+  /// \return Frame of \p Callee.
+  Imm *enterFrame(const CompiledFunction &Callee, std::size_t Base);
+  ExecutionResult execute(const CompiledFunction &Entry,
+                          const std::vector<Imm> &Args);
+  std::size_t globalSlot(const SymReg &Var);
+  const Module &TheModule;
+  std::vector<CompiledFunction> Functions{};
+  std::unordered_map<const Function *, std::int32_t> FunctionIds{};
+  std::vector<Imm> Globals{};
+  std::vector<Imm> Stack{};
+  std::vector<CallRecord> Calls{};
+  std::uint64_t Executed{};
+  std::uint64_t InstructionLimit{std::numeric_limits<std::uint64_t>::max()};
+  std::size_t CallDepthLimit{1 << 16};
+};
+
+} // namespace wyrm
+
+#endif
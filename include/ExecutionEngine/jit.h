@@ -0,0 +1,73 @@
+/// \file
+/// \brief Template JIT compiler of MIR functions to x86-64.
+#ifndef JIT_H
+#define JIT_H
+#include "MIR.h"
+#include <cassert>
+#include <deque>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace wyrm {
+
+/// \brief Compiler of MIR functions to native x86-64 code.
+/// Every instruction is translated by a fixed template. The most referenced
+/// registers of a function are cached in hardware registers: callee-saved
+/// ones and, in functions without calls, caller-saved ones too. The other
+/// registers are spilled to stack slots. A comparison used only by the
+/// branch right after it is fused with the branch.
+///
+/// Compiled functions follow the System V calling convention and take int
+/// arguments: the k-th ReceiveInst in layout order receives the k-th one.
+/// Semantics match Interpreter, except that trapping divisions raise SIGFPE
+/// and recursion depth is limited by the native stack.
+class JITCompiler {
+public:
+  /// \brief If the host runs the generated code.
+  static constexpr bool IsSupported =
+#if defined(__x86_64__) && defined(__linux__)
+      true;
+#else
+      false;
+#endif
+  template <typename... ArgTs> using NativeFunction = Imm (*)(ArgTs...);
+  /// \pre Compiled functions belong to \p M.
+  explicit JITCompiler(const Module &M) : TheModule{M} {}
+  JITCompiler(const JITCompiler &) = delete;
+  JITCompiler &operator=(const JITCompiler &) = delete;
+  ~JITCompiler();
+  /// \brief Compile \p F together with the functions it calls.
+  /// \return The native function or nullptr if the system refuses memory
+  /// for the code. Compiling can be retried then.
+  /// \pre IsSupported and \p F receives at most sizeof...(ArgTs) arguments.
+  /// \pre \p F has no phis, e.g. destructSSA has been run.
+  template <typename... ArgTs>
+  NativeFunction<ArgTs...> compile(const Function &F) {
+    static_assert((std::is_same_v<ArgTs, Imm> && ...),
+                  "Native functions take Imm arguments");
+    assert(numParameters(F) <= sizeof...(ArgTs) && "Too few arguments");
+    return reinterpret_cast<NativeFunction<ArgTs...>>(compileFunction(F));
+  }
+  /// \brief Number of ReceiveInst instructions of \p F.
+  static std::size_t numParameters(const Function &F);
+  Imm global(const SymReg &Var) const;
+  void setGlobal(const SymReg &Var, Imm Number) {
+    *globalAddress(Var) = Number;
+  }
+
+private:
+  class FunctionCompiler;
+  void *compileFunction(const Function &F);
+  /// \return Storage of \p Var, which never moves.
+  Imm *globalAddress(const SymReg &Var);
+  const Module &TheModule;
+  std::unordered_map<const Function *, void *> Entries{};
+  std::deque<Imm> Globals{};
+  /// Executable memory and its size.
+  std::vector<std::pair<void *, std::size_t>> Mappings{};
+};
+
+} // namespace wyrm
+
+#endif
@@ -8,36 +8,197 @@
 #ifndef MIR_H
 #define MIR_H
 
+#include "arena.h"
 #include "context.h"
 #include "wyrm_traits.h"
 
 #include <boost/container/stable_vector.hpp>
+#include <boost/iterator/indirect_iterator.hpp>
+#include <boost/iterator/transform_iterator.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <mutex>
 #include <set>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace wyrm {
 
 class BasicBlock;
 class Function;
+class Instruction;
 class Module;
+class SymReg;
+
+/// \brief Container of IR nodes with stable addresses in a module arena.
+template <typename T>
+using NodeList = boost::container::stable_vector<T, ArenaAllocator<T>>;
+/// \brief Vector keeping its elements in a module arena.
+template <typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+/// \brief Type of constants.
+/// \todo Add float point numbers and composites.
+using Imm = int;
+/// \brief Value is either constant or located in symbolic register.
+using Value = variant<SymReg &, Imm>;
+
+namespace detail {
+struct UseGroup;
+/// \brief Number of uses sharing a pointer to their instruction. Positions in
+/// a group fit into the bits of links which are zero due to alignment.
+constexpr std::size_t UsesPerGroup = alignof(void *);
+
+/// \brief Occurrence of a register as an operand of an instruction.
+/// Uses of a register form an intrusive doubly linked list which starts at
+/// the register. The previous link is the link pointing to the use, so a use
+/// is unlinked without knowing its register. It is tagged with the position
+/// of the use in its UseGroup, which leads to the instruction.
+struct Use {
+  Use *Next;
+  std::uintptr_t TaggedPrevious;
+  Use **previous() const {
+    return reinterpret_cast<Use **>(TaggedPrevious & ~(UsesPerGroup - 1));
+  }
+  void setPrevious(Use **Link) {
+    TaggedPrevious = reinterpret_cast<std::uintptr_t>(Link) | position();
+  }
+  std::size_t position() const { return TaggedPrevious & (UsesPerGroup - 1); }
+  const UseGroup &group() const;
+  void link(Use *&Head) {
+    Next = Head;
+    if (Next)
+      Next->setPrevious(&Next);
+    Head = this;
+    setPrevious(&Head);
+  }
+  void unlink() {
+    Use **Previous = previous();
+    if (!Previous)
+      return;
+    *Previous = Next;
+    if (Next)
+      Next->setPrevious(Previous);
+    setPrevious(nullptr);
+  }
+  /// \brief Put \p To in place of the use in its list.
+  /// \pre \p To isn't linked.
+  void moveTo(Use &To) {
+    Use **Previous = previous();
+    To.Next = Next;
+    To.setPrevious(Previous);
+    if (Previous) {
+      *Previous = &To;
+      if (Next)
+        Next->setPrevious(&To.Next);
+    }
+    setPrevious(nullptr);
+  }
+};
+
+/// \brief Uses of consecutive operands of an instruction. The last group of
+/// an instruction is allocated only up to its last use.
+struct UseGroup {
+  Instruction *User;
+  Use Uses[UsesPerGroup];
+  /// \return Use of operand \p Index of the instruction with \p Groups.
+  static Use &at(UseGroup *Groups, std::size_t Index) {
+    return Groups[Index / UsesPerGroup].Uses[Index % UsesPerGroup];
+  }
+};
+
+inline const UseGroup &Use::group() const {
+  return *reinterpret_cast<const UseGroup *>(
+      reinterpret_cast<const char *>(this - position()) -
+      offsetof(UseGroup, Uses));
+}
+} // namespace detail
 
 /// \brief Represent symbolic register (a variable in high level language).
 class SymReg {
+  template <bool IsConst> class UserIteratorImpl {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Instruction;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, const Instruction *,
+                                       Instruction *>;
+    using reference = std::conditional_t<IsConst, const Instruction &,
+                                         Instruction &>;
+    UserIteratorImpl() = default;
+    explicit UserIteratorImpl(const detail::Use *Current) : Current{Current} {}
+    reference operator*() const { return *Current->group().User; }
+    pointer operator->() const { return Current->group().User; }
+    UserIteratorImpl &operator++() {
+      Current = Current->Next;
+      return *this;
+    }
+    UserIteratorImpl operator++(int) {
+      UserIteratorImpl Result = *this;
+      ++*this;
+      return Result;
+    }
+    bool operator==(const UserIteratorImpl &Other) const {
+      return Current == Other.Current;
+    }
+    bool operator!=(const UserIteratorImpl &Other) const {
+      return Current != Other.Current;
+    }
+
+  private:
+    const detail::Use *Current{};
+  };
+
+  template <bool IsConst> class UserRange {
+  public:
+    UserRange(const detail::Use *First) : First{First} {}
+    UserIteratorImpl<IsConst> begin() const {
+      return UserIteratorImpl<IsConst>{First};
+    }
+    UserIteratorImpl<IsConst> end() const { return {}; }
+    bool empty() const { return !First; }
+
+  private:
+    const detail::Use *First;
+  };
+
 public:
   SymReg(Module &OwningModule) : OwningModule{&OwningModule} {}
   SymReg(Function &OwningFunction) : OwningFunction{&OwningFunction} {}
-  SymReg(Module &OwningModule, bool HasName)
-      : HasName{HasName}, OwningModule{&OwningModule} {}
-  SymReg(Function &OwningFunction, bool HasName)
-      : HasName{HasName}, OwningFunction{&OwningFunction} {}
+  SymReg(Module &OwningModule, NameId Name)
+      : Name{Name}, OwningModule{&OwningModule} {}
+  SymReg(Function &OwningFunction, NameId Name)
+      : Name{Name}, OwningFunction{&OwningFunction} {}
   SymReg(const SymReg &) = delete;
-  SymReg &operator=(SymReg) = delete;
-  SymReg(SymReg &&) = default;
-  SymReg &operator=(SymReg &&) = default;
-  bool hasName() const { return HasName; }
+  SymReg &operator=(const SymReg &) = delete;
+  SymReg(SymReg &&Other) { *this = std::move(Other); }
+  SymReg &operator=(SymReg &&Other) {
+    assert(!FirstUse && "The register is in use");
+    Name = Other.Name;
+    Index = Other.Index;
+    OwningModule = Other.OwningModule;
+    OwningFunction = Other.OwningFunction;
+    FirstUse = std::exchange(Other.FirstUse, nullptr);
+    if (FirstUse)
+      FirstUse->setPrevious(&FirstUse);
+    return *this;
+  }
+  bool hasName() const { return Name != EmptyName; }
+  /// \return Name of the register or an empty string if it has none.
+  string_view name() const;
+  /// \return If the register is local to a function rather than a global
+  /// variable.
+  bool isLocal() const { return OwningFunction; }
+  /// \brief Position of the register in the list of registers of the owning
+  /// function or in the list of global variables of the owning module.
+  std::size_t index() const { return Index; }
   template <typename T,
             typename = std::enable_if<is_one_of_v<T, Module, Function>>>
   const T &parent() const {
@@ -56,219 +217,808 @@ public:
   T &parent() {
     return const_cast<T &>(static_cast<const SymReg *>(this)->parent<T>());
   }
+  /// \brief Instructions reading the register. An instruction is visited
+  /// once per operand it reads the register in, most recent uses first.
+  UserRange<false> users() { return {FirstUse}; }
+  UserRange<true> users() const { return {FirstUse}; }
+  bool hasUses() const { return FirstUse; }
+  friend class Instruction;
+  friend class MIRBuilder;
   friend std::ostream &operator<<(std::ostream &stream, const SymReg &symReg);
+  friend void replaceAllUsesWith(SymReg &Register, Value V);
 
 private:
-  bool HasName{false};
+  NameId Name{EmptyName};
+  std::size_t Index{};
   Module *OwningModule{nullptr};
   Function *OwningFunction{nullptr};
+  detail::Use *FirstUse{};
 };
 
-/// \brief Type of constants.
-/// \todo Add float point numbers and composites.
-using Imm = int;
-/// \brief Value is either constant or located in symbolic register.
-using Value = variant<SymReg &, Imm>;
 
-namespace detail {
-/// \brief Base class for an instruction.
-/// Use Instruction class rather than InstBase for polymorphic code.
-class InstBase {
-public:
-  /// \return Owning basic block
-  /// \pre There must be non null owning basic block
-  BasicBlock &parent() {
-    assert(OwningBB);
-    return *OwningBB;
+enum class UnOpKind { Assign, Neg, Not };
+
+enum class BinOpKind {
+  Add,
+  Sub,
+  Mul,
+  Div,
+  Mod,
+  Min,
+  Max,
+  Shl,
+  Shr,
+  Shra,
+  And,
+  Or,
+  Xor,
+  Eq,
+  Neq,
+  Less,
+  Leq,
+  Greater,
+  Geq
+};
+
+/// \brief Evaluate op \p Operand with 32-bit two's complement semantics.
+/// Neg wraps around and Not is bitwise.
+inline Imm evaluate(UnOpKind Kind, Imm Operand) {
+  switch (Kind) {
+  case UnOpKind::Assign:
+    return Operand;
+  case UnOpKind::Neg:
+    return static_cast<Imm>(0u - static_cast<std::uint32_t>(Operand));
+  case UnOpKind::Not:
+    return ~Operand;
   }
-  InstBase(InstBase &&) = default;
-  InstBase(const InstBase &) = delete;
-  InstBase &operator=(InstBase) = delete;
+  assert(false && "Unknown operation");
+  return 0;
+}
 
-protected:
-  InstBase(BasicBlock &BB) : OwningBB{&BB} {}
+/// \brief Evaluate \p LHS op \p RHS with 32-bit two's complement semantics.
+/// Add, Sub and Mul wrap around. Div and Mod round toward zero. Shift amounts
+/// are taken modulo 32, Shr is logical and Shra is arithmetic shift.
+/// Comparisons are signed and give 1 or 0.
+/// \return Nothing if the operation traps: Div and Mod by zero or of the
+/// minimal value by -1.
+inline optional<Imm> evaluate(BinOpKind Kind, Imm LHS, Imm RHS) {
+  using UImm = std::uint32_t;
+  const UImm ULHS = LHS, URHS = RHS;
+  switch (Kind) {
+  case BinOpKind::Add:
+    return static_cast<Imm>(ULHS + URHS);
+  case BinOpKind::Sub:
+    return static_cast<Imm>(ULHS - URHS);
+  case BinOpKind::Mul:
+    return static_cast<Imm>(ULHS * URHS);
+  case BinOpKind::Div:
+  case BinOpKind::Mod:
+    if (RHS == 0 || (LHS == std::numeric_limits<Imm>::min() && RHS == -1))
+      return {};
+    return Kind == BinOpKind::Div ? LHS / RHS : LHS % RHS;
+  case BinOpKind::Min:
+    return std::min(LHS, RHS);
+  case BinOpKind::Max:
+    return std::max(LHS, RHS);
+  case BinOpKind::Shl:
+    return static_cast<Imm>(ULHS << (URHS & 31));
+  case BinOpKind::Shr:
+    return static_cast<Imm>(ULHS >> (URHS & 31));
+  case BinOpKind::Shra:
+    return LHS >> (URHS & 31);
+  case BinOpKind::And:
+    return LHS & RHS;
+  case BinOpKind::Or:
+    return LHS | RHS;
+  case BinOpKind::Xor:
+    return LHS ^ RHS;
+  case BinOpKind::Eq:
+    return LHS == RHS;
+  case BinOpKind::Neq:
+    return LHS != RHS;
+  case BinOpKind::Less:
+    return LHS < RHS;
+  case BinOpKind::Leq:
+    return LHS <= RHS;
+  case BinOpKind::Greater:
+    return LHS > RHS;
+  case BinOpKind::Geq:
+    return LHS >= RHS;
+  }
+  assert(false && "Unknown operation");
+  return {};
+}
 
-private:
-  BasicBlock *OwningBB;
+
+/// \brief Kind of an instruction.
+enum class Opcode : std::uint8_t {
+  Receive,
+  Ret,
+  GoTo,
+  Br,
+  Call,
+  UnOp,
+  BinOp,
+  Phi
 };
 
-/// \brief An instructuion which return or might return a value in a symbolic
-/// register.
-template <typename ReturnTy> class ReturningInstBase : public InstBase {
+namespace detail {
+/// \brief 32-bit encoding of an instruction operand.
+/// The low bits tell what the rest of the handle is:
+/// - xx1: an immediate in the upper 31 bits;
+/// - 000: index of a register of the function;
+/// - 010: index of a global variable of the module;
+/// - 100: index of a constant, which doesn't fit into 31 bits, in the constant
+///   pool of the function;
+/// - 110: no operand.
+using Handle = std::uint32_t;
+constexpr unsigned HandleTagBits = 3;
+constexpr Handle ImmediateTag = 1;
+constexpr Handle RegisterTag = 0;
+constexpr Handle GlobalTag = 2;
+constexpr Handle PooledTag = 4;
+constexpr Handle NoHandle = 6;
+
+/// \brief Callee and arguments of a call followed by NumArguments handles.
+struct CallData {
+  Function *Callee;
+  std::uint32_t NumArguments;
+  Handle *arguments() { return reinterpret_cast<Handle *>(this + 1); }
+  const Handle *arguments() const {
+    return reinterpret_cast<const Handle *>(this + 1);
+  }
+};
+
+/// \brief Incoming list of a phi followed by Capacity pairs of handles: an id
+/// of a predecessor and the value coming from it.
+struct PhiData {
+  std::uint32_t Size;
+  std::uint32_t Capacity;
+  Handle *incoming() { return reinterpret_cast<Handle *>(this + 1); }
+};
+} // namespace detail
+
+/// \brief Instruction of a basic block.
+/// An instruction is a compact record tagged with its opcode. Operands are
+/// 32-bit handles resolved through the owning function, successors are ids of
+/// blocks in the function, and only call arguments, phi incoming lists and
+/// use list nodes are kept out of line in the arena of the function.
+/// Use get<> and visit() to access an instruction as one of the classes
+/// below, which add accessors to the record but no data.
+/// Setting an operand keeps the use lists of registers up to date. Operands
+/// are numbered in the order of forEachOperand(). Use lists of global
+/// registers are shared by all functions of a module, so they are changed
+/// under a lock of the module.
+class Instruction {
 public:
-  ReturnTy outRegister() { return OutValue; }
-  const ReturnTy outRegister() const { return OutValue; }
+  Opcode opcode() const { return Op; }
+  /// \return Owning basic block
+  BasicBlock &parent() { return *OwningBB; }
+  const BasicBlock &parent() const { return *OwningBB; }
+  /// \brief Move the record. Uses of registers move with it.
+  Instruction(Instruction &&Other) noexcept { *this = std::move(Other); }
+  Instruction &operator=(Instruction &&Other) noexcept;
+  Instruction(const Instruction &) = delete;
+  Instruction &operator=(const Instruction &) = delete;
+  friend class InstructionList;
+  friend void replaceAllUsesWith(SymReg &Register, Value V);
 
 protected:
-  ReturningInstBase(BasicBlock &BB, ReturnTy OutValue)
-      : InstBase(BB), OutValue{OutValue} {}
+  Instruction(BasicBlock &BB, Opcode Op, std::uint8_t Kind = 0)
+      : OwningBB{&BB}, Op{Op}, Kind{Kind}, Operands{detail::NoHandle,
+                                                    detail::NoHandle} {}
+  Value decode(detail::Handle H) const;
+  /// \brief Encode \p V. Constants which don't fit into a handle are added
+  /// to the constant pool of the function.
+  detail::Handle encode(Value V);
+  /// \pre \p H is a register.
+  SymReg &registerOf(detail::Handle H) const;
+  BasicBlock &block(std::uint32_t Id) const;
+  std::uint32_t blockId(const BasicBlock &BB) const;
+  Arena &arena() const;
+  /// \brief Set operand \p Index to \p V and move its use to the list of
+  /// \p V.
+  void setOperandValue(std::size_t Index, Value V);
+  /// \brief Number of operands a use might be kept for. A phi has a slot for
+  /// every incoming value it has room for.
+  std::size_t numUseSlots() const;
+  /// \brief Number of operands a use is allocated for. Calls and phis have
+  /// uses of all slots once an operand is a register, other instructions
+  /// only up to their last register operand.
+  std::size_t numUses() const;
+  detail::Use &use(std::size_t Index) {
+    return detail::UseGroup::at(Uses, Index);
+  }
+  /// \brief Allocate unlinked uses of the first \p Count operands, moving the
+  /// first \p Kept uses allocated before into them.
+  void allocateUses(std::size_t Count, std::size_t Kept);
+  /// \return If a global register is among the operands with a use.
+  bool usesGlobals();
+  /// \return Lock of the use lists of global registers, which is held if
+  /// \p Needed.
+  std::unique_lock<std::mutex> lockGlobalUses(bool Needed) const;
+  /// \brief Count a change of the owning function. \p ControlFlow tells if
+  /// successors changed.
+  void noteChange(bool ControlFlow = false) const;
+  /// \brief Count a change of the successors and refresh the successors
+  /// cached by the owning block if the instruction is its terminator.
+  void noteSuccessorChange();
+  BasicBlock *OwningBB;
+  Opcode Op;
+  /// UnOpKind or BinOpKind.
+  std::uint8_t Kind;
+  /// numUses() of instructions other than calls and phis.
+  std::uint8_t NumUses{};
+  /// Defined register or the condition of a branch.
+  detail::Handle Out{detail::NoHandle};
+  union {
+    /// Operands or the ids of the true and false successors of a branch.
+    detail::Handle Operands[2];
+    detail::CallData *Call;
+    detail::PhiData *Phi;
+  };
+  /// Uses of the operands or nullptr if no operand has been a register.
+  detail::UseGroup *Uses{};
 
 private:
-  ReturnTy OutValue;
+  /// Empty slot of InstructionList.
+  Instruction() = default;
+  detail::Handle &operandHandle(std::size_t Index);
+  /// \brief Remove the operands from the use lists of registers.
+  void dropUses();
 };
 
-class UnaryInstBase {
+/// \brief Make every instruction reading \p Register read \p V instead.
+/// Costs time proportional to the number of uses of \p Register.
+/// \pre If \p V is a local register, all uses of \p Register are in its
+/// function.
+void replaceAllUsesWith(SymReg &Register, Value V);
+
+namespace detail {
+/// \brief An instructuion which return or might return a value in a symbolic
+/// register.
+template <typename ReturnTy> class ReturningInstBase : public Instruction {
 public:
-  Value operand() { return Operand; }
-  const Value operand() const { return Operand; }
+  ReturnTy outRegister() const {
+    if constexpr (std::is_pointer_v<ReturnTy>)
+      return Out == NoHandle ? nullptr : &registerOf(Out);
+    else
+      return registerOf(Out);
+  }
+  void setOutRegister(ReturnTy Register) {
+    noteChange();
+    if constexpr (std::is_pointer_v<ReturnTy>)
+      Out = Register ? encode(*Register) : NoHandle;
+    else
+      Out = encode(Register);
+  }
 
 protected:
-  UnaryInstBase(Value Operand) : Operand{Operand} {}
-  Value Operand;
+  using Instruction::Instruction;
 };
-
 } // namespace detail
 
 /// \brief Represent receiving function argument.
 /// Define function parameter as a symbolic register with unknown value.
 class ReceiveInst final : public detail::ReturningInstBase<SymReg &> {
 public:
+  static constexpr Opcode ClassOpcode = Opcode::Receive;
   friend class MIRBuilder;
   friend std::ostream &operator<<(std::ostream &Stream,
                                   const ReceiveInst &Inst);
 
 private:
   ReceiveInst(BasicBlock &OwningBB, SymReg &RetReg)
-      : detail::ReturningInstBase<SymReg &>(OwningBB, RetReg) {}
+      : detail::ReturningInstBase<SymReg &>(OwningBB, ClassOpcode) {
+    setOutRegister(RetReg);
+  }
 };
 
 /// \brief Unconditional branch.
-class GoToInst final : public detail::InstBase {
+class GoToInst final : public Instruction {
 public:
+  static constexpr Opcode ClassOpcode = Opcode::GoTo;
   friend class MIRBuilder;
-  BasicBlock &successor() { return Successor; }
-  const BasicBlock &successor() const { return Successor; }
+  BasicBlock &successor() { return block(Operands[0]); }
+  const BasicBlock &successor() const { return block(Operands[0]); }
+  void setSuccessor(BasicBlock &Destination) {
+    Operands[0] = blockId(Destination);
+    noteSuccessorChange();
+  }
   friend std::ostream &operator<<(std::ostream &Stream, const GoToInst &Inst);
 
 private:
   GoToInst(BasicBlock &OwningBB, BasicBlock &Destination)
-      : detail::InstBase(OwningBB), Successor{Destination} {}
-  BasicBlock &Successor;
+      : Instruction(OwningBB, ClassOpcode) {
+    setSuccessor(Destination);
+  }
 };
 
 /// \brief Conditional branch.
-class BrInst final : public detail::InstBase {
+class BrInst final : public Instruction {
 public:
+  static constexpr Opcode ClassOpcode = Opcode::Br;
   friend class MIRBuilder;
-  BasicBlock &trueSuccessor() { return TrueSuccessor; }
-  const BasicBlock &trueSuccessor() const { return TrueSuccessor; }
-  BasicBlock &falseSuccessor() { return FalseSuccessor; }
-  const BasicBlock &falseSuccessor() const { return FalseSuccessor; }
-  Value condition() { return Condition; }
-  const Value condition() const { return Condition; }
+  BasicBlock &trueSuccessor() { return block(Operands[0]); }
+  const BasicBlock &trueSuccessor() const { return block(Operands[0]); }
+  BasicBlock &falseSuccessor() { return block(Operands[1]); }
+  const BasicBlock &falseSuccessor() const { return block(Operands[1]); }
+  Value condition() const { return decode(Out); }
+  void setTrueSuccessor(BasicBlock &BB) {
+    Operands[0] = blockId(BB);
+    noteSuccessorChange();
+  }
+  void setFalseSuccessor(BasicBlock &BB) {
+    Operands[1] = blockId(BB);
+    noteSuccessorChange();
+  }
+  void setCondition(Value V) { setOperandValue(0, V); }
   friend std::ostream &operator<<(std::ostream &Stream, const BrInst &Inst);
 
 private:
   BrInst(BasicBlock &OwningBB, Value Condition, BasicBlock &TrueSuccessor,
          BasicBlock &FalseSuccessor)
-      : detail::InstBase(OwningBB), Condition{Condition},
-        TrueSuccessor{TrueSuccessor}, FalseSuccessor{FalseSuccessor} {}
-  Value Condition;
-  BasicBlock &TrueSuccessor;
-  BasicBlock &FalseSuccessor;
+      : Instruction(OwningBB, ClassOpcode) {
+    setCondition(Condition);
+    setTrueSuccessor(TrueSuccessor);
+    setFalseSuccessor(FalseSuccessor);
+  }
 };
 
 /// \brief Return value from a function.
-class RetInst final : public detail::InstBase, detail::UnaryInstBase {
+class RetInst final : public Instruction {
 public:
+  static constexpr Opcode ClassOpcode = Opcode::Ret;
+  Value operand() const { return decode(Operands[0]); }
+  void setOperand(Value V) { setOperandValue(0, V); }
   friend class MIRBuilder;
   friend std::ostream &operator<<(std::ostream &Stream, const RetInst &Inst);
 
 private:
   RetInst(BasicBlock &OwningBB, Value RetVal)
-      : detail::InstBase(OwningBB), detail::UnaryInstBase(RetVal) {}
+      : Instruction(OwningBB, ClassOpcode) {
+    setOperand(RetVal);
+  }
 };
 
 class CallInst final : public detail::ReturningInstBase<SymReg *> {
+  struct ArgumentDecoder {
+    const CallInst *Inst;
+    Value operator()(detail::Handle H) const { return Inst->decode(H); }
+  };
+  using ArgumentIterator =
+      boost::transform_iterator<ArgumentDecoder, const detail::Handle *>;
+
 public:
-  auto begin() { return std::begin(Arguments); }
-  auto end() { return std::end(Arguments); }
-  auto begin() const { return std::cbegin(Arguments); }
-  auto end() const { return std::cend(Arguments); }
-  Function &callee() {
-    assert(Callee && "Callee mustn't be null");
-    return *Callee;
-  }
-  const Function &callee() const {
-    assert(Callee && "Callee mustn't be null");
-    return *Callee;
+  static constexpr Opcode ClassOpcode = Opcode::Call;
+  ArgumentIterator begin() const {
+    return {Call->arguments(), ArgumentDecoder{this}};
+  }
+  ArgumentIterator end() const {
+    return {Call->arguments() + Call->NumArguments, ArgumentDecoder{this}};
+  }
+  std::size_t numArguments() const { return Call->NumArguments; }
+  Value argument(std::size_t Index) const {
+    assert(Index < numArguments() && "No such argument");
+    return decode(Call->arguments()[Index]);
+  }
+  void setArgument(std::size_t Index, Value V) {
+    assert(Index < numArguments() && "No such argument");
+    setOperandValue(Index, V);
   }
+  Function &callee() { return *Call->Callee; }
+  const Function &callee() const { return *Call->Callee; }
   friend class MIRBuilder;
   friend std::ostream &operator<<(std::ostream &Stream, const CallInst &Inst);
 
 private:
   CallInst(BasicBlock &OwningBB, SymReg *RetReg, Function &Callee,
-           std::vector<Value> &&Arguments)
-      : detail::ReturningInstBase<SymReg *>(OwningBB, RetReg), Callee{&Callee},
-        Arguments{std::move(Arguments)} {}
-  Function *Callee;
-  std::vector<Value> Arguments;
+           std::vector<Value> &&Arguments);
 };
 
-enum class UnOpKind { Assign, Neg, Not };
-
 /// \brief Instruction of form a = op b.
-class UnOpInst : public detail::ReturningInstBase<SymReg &>,
-                 detail::UnaryInstBase {
+class UnOpInst final : public detail::ReturningInstBase<SymReg &> {
 public:
-  UnOpKind kind() const { return Kind; }
+  static constexpr Opcode ClassOpcode = Opcode::UnOp;
+  UnOpKind kind() const { return static_cast<UnOpKind>(Kind); }
+  Value operand() const { return decode(Operands[0]); }
+  void setOperand(Value V) { setOperandValue(0, V); }
   friend class MIRBuilder;
   friend std::ostream &operator<<(std::ostream &Stream, const UnOpInst &Inst);
 
 private:
   UnOpInst(BasicBlock &OwningBB, SymReg &RetReg, UnOpKind Kind, Value Operand)
-      : detail::ReturningInstBase<SymReg &>(OwningBB, RetReg),
-        detail::UnaryInstBase(Operand), Kind{Kind} {}
-  UnOpKind Kind;
-};
-
-enum class BinOpKind {
-  Add,
-  Sub,
-  Mul,
-  Div,
-  Mod,
-  Min,
-  Max,
-  Shl,
-  Shr,
-  Shra,
-  And,
-  Or,
-  Xor,
-  Eq,
-  Neq,
-  Less,
-  Leq,
-  Greater,
-  Geq
+      : detail::ReturningInstBase<SymReg &>(OwningBB, ClassOpcode,
+                                            static_cast<std::uint8_t>(Kind)) {
+    setOutRegister(RetReg);
+    setOperand(Operand);
+  }
 };
 
 /// \brief Instruction of form a = b op c.
-class BinOpInst : public detail::ReturningInstBase<SymReg &> {
+class BinOpInst final : public detail::ReturningInstBase<SymReg &> {
 public:
-  BinOpKind kind() const { return Kind; }
-  Value operand1() { return Operand1; }
-  const Value operand1() const { return Operand1; }
-  Value operand2() { return Operand2; }
-  const Value operand2() const { return Operand2; }
+  static constexpr Opcode ClassOpcode = Opcode::BinOp;
+  BinOpKind kind() const { return static_cast<BinOpKind>(Kind); }
+  Value operand1() const { return decode(Operands[0]); }
+  Value operand2() const { return decode(Operands[1]); }
+  void setOperand1(Value V) { setOperandValue(0, V); }
+  void setOperand2(Value V) { setOperandValue(1, V); }
   friend class MIRBuilder;
   friend std::ostream &operator<<(std::ostream &Stream, const BinOpInst &Inst);
 
 private:
   BinOpInst(BasicBlock &OwningBB, SymReg &RetReg, BinOpKind Kind,
             Value Operand1, Value Operand2)
-      : detail::ReturningInstBase<SymReg &>(OwningBB, RetReg), Kind{Kind},
-        Operand1{Operand1}, Operand2{Operand2} {}
-  BinOpKind Kind;
-  Value Operand1;
-  Value Operand2;
+      : detail::ReturningInstBase<SymReg &>(OwningBB, ClassOpcode,
+                                            static_cast<std::uint8_t>(Kind)) {
+    setOutRegister(RetReg);
+    // Uses are allocated up to the last register operand at once.
+    setOperand2(Operand2);
+    setOperand1(Operand1);
+  }
 };
 
-using Instruction = variant<ReceiveInst, RetInst, GoToInst, BrInst, CallInst,
-                            UnOpInst, BinOpInst>;
+/// \brief SSA phi function: a = phi [v1, BB1], [v2, BB2], ...
+/// Selects the value which corresponds to the predecessor control came from.
+/// Phi instructions are placed at the beginning of a basic block.
+class PhiInst final : public detail::ReturningInstBase<SymReg &> {
+public:
+  static constexpr Opcode ClassOpcode = Opcode::Phi;
+  /// \brief Number of incoming values.
+  std::size_t size() const { return Phi ? Phi->Size : 0; }
+  Value incomingValue(std::size_t Index) const {
+    return decode(incoming(Index)[1]);
+  }
+  BasicBlock &incomingBlock(std::size_t Index) {
+    return block(incoming(Index)[0]);
+  }
+  const BasicBlock &incomingBlock(std::size_t Index) const {
+    return block(incoming(Index)[0]);
+  }
+  void setIncomingValue(std::size_t Index, Value V) {
+    assert(Index < size() && "No such incoming value");
+    setOperandValue(Index, V);
+  }
+  void addIncoming(Value V, BasicBlock &BB);
+  void removeIncoming(std::size_t Index);
+  friend class MIRBuilder;
+  friend std::ostream &operator<<(std::ostream &Stream, const PhiInst &Inst);
+
+private:
+  PhiInst(BasicBlock &OwningBB, SymReg &RetReg)
+      : detail::ReturningInstBase<SymReg &>(OwningBB, ClassOpcode) {
+    setOutRegister(RetReg);
+    Phi = nullptr;
+  }
+  detail::Handle *incoming(std::size_t Index) const {
+    assert(Index < size() && "No such incoming value");
+    return Phi->incoming() + 2 * Index;
+  }
+};
+
+/// \return \p Inst as \p InstT or nullptr if it's another instruction.
+template <typename InstT,
+          typename = std::enable_if_t<std::is_base_of_v<Instruction, InstT>>>
+InstT *get(Instruction *Inst) {
+  if (!Inst || Inst->opcode() != InstT::ClassOpcode)
+    return nullptr;
+  return static_cast<InstT *>(Inst);
+}
+template <typename InstT,
+          typename = std::enable_if_t<std::is_base_of_v<Instruction, InstT>>>
+const InstT *get(const Instruction *Inst) {
+  return get<InstT>(const_cast<Instruction *>(Inst));
+}
+/// \pre \p Inst is InstT.
+template <typename InstT,
+          typename = std::enable_if_t<std::is_base_of_v<Instruction, InstT>>>
+InstT &get(Instruction &Inst) {
+  assert(Inst.opcode() == InstT::ClassOpcode && "Wrong instruction kind");
+  return static_cast<InstT &>(Inst);
+}
+template <typename InstT,
+          typename = std::enable_if_t<std::is_base_of_v<Instruction, InstT>>>
+const InstT &get(const Instruction &Inst) {
+  return get<InstT>(const_cast<Instruction &>(Inst));
+}
+
+/// \brief Call \p Fn with \p Inst as the instruction class of its opcode.
+template <typename FnT> decltype(auto) visit(FnT &&Fn, Instruction &Inst) {
+  switch (Inst.opcode()) {
+  case Opcode::Receive:
+    return Fn(static_cast<ReceiveInst &>(Inst));
+  case Opcode::Ret:
+    return Fn(static_cast<RetInst &>(Inst));
+  case Opcode::GoTo:
+    return Fn(static_cast<GoToInst &>(Inst));
+  case Opcode::Br:
+    return Fn(static_cast<BrInst &>(Inst));
+  case Opcode::Call:
+    return Fn(static_cast<CallInst &>(Inst));
+  case Opcode::UnOp:
+    return Fn(static_cast<UnOpInst &>(Inst));
+  case Opcode::BinOp:
+    return Fn(static_cast<BinOpInst &>(Inst));
+  case Opcode::Phi:
+    break;
+  }
+  return Fn(static_cast<PhiInst &>(Inst));
+}
+template <typename FnT>
+decltype(auto) visit(FnT &&Fn, const Instruction &Inst) {
+  switch (Inst.opcode()) {
+  case Opcode::Receive:
+    return Fn(static_cast<const ReceiveInst &>(Inst));
+  case Opcode::Ret:
+    return Fn(static_cast<const RetInst &>(Inst));
+  case Opcode::GoTo:
+    return Fn(static_cast<const GoToInst &>(Inst));
+  case Opcode::Br:
+    return Fn(static_cast<const BrInst &>(Inst));
+  case Opcode::Call:
+    return Fn(static_cast<const CallInst &>(Inst));
+  case Opcode::UnOp:
+    return Fn(static_cast<const UnOpInst &>(Inst));
+  case Opcode::BinOp:
+    return Fn(static_cast<const BinOpInst &>(Inst));
+  case Opcode::Phi:
+    break;
+  }
+  return Fn(static_cast<const PhiInst &>(Inst));
+}
+
 std::ostream &operator<<(std::ostream &Stream, const Instruction &Inst);
+/// \return If \p Inst transfers control out of its basic block.
+inline bool isTerminator(const Instruction &Inst) {
+  return Inst.opcode() == Opcode::Ret || Inst.opcode() == Opcode::GoTo ||
+         Inst.opcode() == Opcode::Br;
+}
+/// \return Register defined by \p Inst or nullptr.
+SymReg *definedRegister(Instruction &Inst);
+/// \brief Make \p Register the output of \p Inst.
+/// \pre \p Inst defines a register.
+void setDefinedRegister(Instruction &Inst, SymReg &Register);
+/// \return If \p Inst is Div or Mod which might trap: its divisor isn't a
+/// nonzero constant, or it's -1 and the dividend isn't a constant other than
+/// the minimal value.
+bool mightTrap(const Instruction &Inst);
+
+/// \brief Call \p Fn for every operand of \p Inst in order.
+template <typename FnT> void forEachOperand(const Instruction &Inst, FnT Fn) {
+  switch (Inst.opcode()) {
+  case Opcode::Ret:
+    Fn(static_cast<const RetInst &>(Inst).operand());
+    break;
+  case Opcode::UnOp:
+    Fn(static_cast<const UnOpInst &>(Inst).operand());
+    break;
+  case Opcode::Br:
+    Fn(static_cast<const BrInst &>(Inst).condition());
+    break;
+  case Opcode::BinOp: {
+    auto &BinOp = static_cast<const BinOpInst &>(Inst);
+    Fn(BinOp.operand1());
+    Fn(BinOp.operand2());
+    break;
+  }
+  case Opcode::Call: {
+    auto &Call = static_cast<const CallInst &>(Inst);
+    for (std::size_t I = 0, E = Call.numArguments(); I != E; ++I)
+      Fn(Call.argument(I));
+    break;
+  }
+  case Opcode::Phi: {
+    auto &Phi = static_cast<const PhiInst &>(Inst);
+    for (std::size_t I = 0, E = Phi.size(); I != E; ++I)
+      Fn(Phi.incomingValue(I));
+    break;
+  }
+  case Opcode::Receive:
+  case Opcode::GoTo:
+    break;
+  }
+}
+
+/// \brief Replace every operand V of \p Inst with \p Fn(V).
+template <typename FnT> void rewriteOperands(Instruction &Inst, FnT Fn) {
+  switch (Inst.opcode()) {
+  case Opcode::Ret: {
+    auto &Ret = static_cast<RetInst &>(Inst);
+    Ret.setOperand(Fn(Ret.operand()));
+    break;
+  }
+  case Opcode::UnOp: {
+    auto &UnOp = static_cast<UnOpInst &>(Inst);
+    UnOp.setOperand(Fn(UnOp.operand()));
+    break;
+  }
+  case Opcode::Br: {
+    auto &Br = static_cast<BrInst &>(Inst);
+    Br.setCondition(Fn(Br.condition()));
+    break;
+  }
+  case Opcode::BinOp: {
+    auto &BinOp = static_cast<BinOpInst &>(Inst);
+    BinOp.setOperand1(Fn(BinOp.operand1()));
+    BinOp.setOperand2(Fn(BinOp.operand2()));
+    break;
+  }
+  case Opcode::Call: {
+    auto &Call = static_cast<CallInst &>(Inst);
+    for (std::size_t I = 0, E = Call.numArguments(); I != E; ++I)
+      Call.setArgument(I, Fn(Call.argument(I)));
+    break;
+  }
+  case Opcode::Phi: {
+    auto &Phi = static_cast<PhiInst &>(Inst);
+    for (std::size_t I = 0, E = Phi.size(); I != E; ++I)
+      Phi.setIncomingValue(I, Fn(Phi.incomingValue(I)));
+    break;
+  }
+  case Opcode::Receive:
+  case Opcode::GoTo:
+    break;
+  }
+}
+
+/// \brief Instructions of a basic block.
+/// The instructions are kept in the module arena in segments of growing size:
+/// segment K has FirstSegmentSize << K slots. Appending an instruction
+/// doesn't move the others, while inserting or erasing one moves the
+/// instructions after it.
+class InstructionList {
+  template <bool IsConst> class IteratorImpl;
+
+public:
+  using iterator = IteratorImpl<false>;
+  using const_iterator = IteratorImpl<true>;
+  static constexpr std::size_t FirstSegmentSize = 2;
+  explicit InstructionList(Arena &Storage) : Segments(Storage) {}
+  std::size_t size() const { return Size; }
+  bool empty() const { return !Size; }
+  Instruction &operator[](std::size_t Index) { return slot(Index); }
+  const Instruction &operator[](std::size_t Index) const {
+    return slot(Index);
+  }
+  iterator begin();
+  iterator end();
+  const_iterator begin() const;
+  const_iterator end() const;
+  /// \brief Move \p Inst to \p Position.
+  /// \return The inserted instruction.
+  Instruction &insert(std::size_t Position, Instruction &&Inst);
+  void erase(std::size_t Position);
+  /// \brief Erase the instructions at ascending \p Positions in one pass.
+  void erase(const std::vector<std::size_t> &Positions);
+  void clear();
+  Arena &arena() const { return Segments.get_allocator().arena(); }
+
+private:
+  /// \return Segment containing \p Index and position of \p Index in it.
+  static std::pair<std::size_t, std::size_t> locate(std::size_t Index) {
+    const unsigned long long Group = Index / FirstSegmentSize + 1;
+    const std::size_t Segment =
+        std::numeric_limits<unsigned long long>::digits - 1 -
+        __builtin_clzll(Group);
+    return {Segment,
+            Index - FirstSegmentSize * ((std::size_t{1} << Segment) - 1)};
+  }
+  static std::size_t segmentSize(std::size_t Segment) {
+    return FirstSegmentSize << Segment;
+  }
+  Instruction &slot(std::size_t Index) const {
+    assert(Index < Size && "Instruction is out of range");
+    auto [Segment, Offset] = locate(Index);
+    return Segments[Segment][Offset];
+  }
+  ArenaVector<Instruction *> Segments;
+  std::size_t Size{};
+};
+
+template <bool IsConst> class InstructionList::IteratorImpl {
+public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = Instruction;
+  using difference_type = std::ptrdiff_t;
+  using pointer = std::conditional_t<IsConst, const Instruction *,
+                                     Instruction *>;
+  using reference = std::conditional_t<IsConst, const Instruction &,
+                                       Instruction &>;
+  IteratorImpl() = default;
+  template <bool ToConst = true,
+            typename = std::enable_if_t<ToConst && !IsConst>>
+  operator IteratorImpl<ToConst>() const {
+    return {*List, Index};
+  }
+  reference operator*() const { return *Current; }
+  pointer operator->() const { return Current; }
+  IteratorImpl &operator++() {
+    ++Index;
+    if (++Current == SegmentEnd)
+      seek();
+    return *this;
+  }
+  IteratorImpl operator++(int) {
+    IteratorImpl Result = *this;
+    ++*this;
+    return Result;
+  }
+  IteratorImpl &operator--() {
+    --Index;
+    seek();
+    return *this;
+  }
+  IteratorImpl operator--(int) {
+    IteratorImpl Result = *this;
+    --*this;
+    return Result;
+  }
+  bool operator==(const IteratorImpl &Other) const {
+    return Index == Other.Index;
+  }
+  bool operator!=(const IteratorImpl &Other) const {
+    return Index != Other.Index;
+  }
+  friend class InstructionList;
+  template <bool> friend class IteratorImpl;
+
+private:
+  IteratorImpl(const InstructionList &List, std::size_t Index)
+      : List{&List}, Index{Index} {
+    seek();
+  }
+  /// \brief Find the slot of Index.
+  void seek() {
+    auto [Segment, Offset] = locate(Index);
+    if (Segment >= List->Segments.size()) {
+      Current = SegmentEnd = nullptr;
+      return;
+    }
+    Current = List->Segments[Segment] + Offset;
+    SegmentEnd = List->Segments[Segment] + segmentSize(Segment);
+  }
+  const InstructionList *List{};
+  std::size_t Index{};
+  Instruction *Current{};
+  Instruction *SegmentEnd{};
+};
+
+inline InstructionList::iterator InstructionList::begin() {
+  return {*this, 0};
+}
+inline InstructionList::iterator InstructionList::end() {
+  return {*this, Size};
+}
+inline InstructionList::const_iterator InstructionList::begin() const {
+  return {*this, 0};
+}
+inline InstructionList::const_iterator InstructionList::end() const {
+  return {*this, Size};
+}
+
+/// \brief Read-only range of block indices.
+class BlockIndexRange {
+public:
+  BlockIndexRange(const std::uint32_t *Begin, const std::uint32_t *End)
+      : Begin{Begin}, End{End} {}
+  const std::uint32_t *begin() const { return Begin; }
+  const std::uint32_t *end() const { return End; }
+  std::size_t size() const { return End - Begin; }
+  bool empty() const { return Begin == End; }
+  std::uint32_t operator[](std::size_t Index) const { return Begin[Index]; }
 
+private:
+  const std::uint32_t *Begin;
+  const std::uint32_t *End;
+};
+
+/// \brief Sequence of instructions ending with a terminator.
+/// A block caches the indices of its successors, taken from its last
+/// instruction if it's a terminator, and of its predecessors. The builder
+/// refreshes them whenever the last instruction of a block or a successor of
+/// a terminator changes, so walking the control flow needs neither a scan of
+/// the instructions nor a separate graph.
 class BasicBlock {
 public:
   auto begin() { return std::begin(Instructions); }
@@ -276,56 +1026,171 @@ public:
   auto begin() const { return std::cbegin(Instructions); }
   auto end() const { return std::cend(Instructions); }
   Instruction &operator[](size_t index) { return Instructions[index]; }
+  const Instruction &operator[](size_t index) const {
+    return Instructions[index];
+  }
+  size_t size() const { return Instructions.size(); }
+  bool empty() const { return Instructions.empty(); }
   Function &parent() { return OwningFunction; }
   const Function &parent() const { return OwningFunction; }
-  bool hasLabel() const { return HasLabel; }
+  bool hasLabel() const { return Label != EmptyName; }
+  /// \return Label of the block or an empty string if it has none.
+  string_view label() const;
+  /// \brief Position of the block in Function::blockAt(). Blocks are
+  /// indexed in the order of creation, so indices are dense unless blocks are
+  /// erased, and the entry block has index 0.
+  std::uint32_t index() const { return Id; }
+  /// \brief Indices of the successors in the order of the terminator
+  /// operands. A branch to the same block twice lists it twice.
+  BlockIndexRange successorIndices() const {
+    return {Successors, Successors + NumSuccessors};
+  }
+  /// \brief Indices of the predecessors in no particular order, one per
+  /// edge to the block.
+  BlockIndexRange predecessorIndices() const {
+    return {Predecessors.data(), Predecessors.data() + Predecessors.size()};
+  }
+  /// \brief Number in the printed name of a block without a label: its
+  /// position among the unlabeled blocks of the function counting from 1.
+  std::uint32_t number() const { return Number; }
   BasicBlock(const BasicBlock &) = delete;
   BasicBlock &operator=(BasicBlock) = delete;
   BasicBlock(BasicBlock &&) = default;
   BasicBlock &operator=(BasicBlock &&) = default;
+  friend class Instruction;
   friend class MIRBuilder;
   friend std::ostream &operator<<(std::ostream &Stream, const BasicBlock &BB);
 
 private:
-  BasicBlock(Function &Parent) : OwningFunction{Parent} {}
+  BasicBlock(Function &Parent, std::uint32_t Id, Arena &Storage)
+      : OwningFunction{Parent}, Id{Id}, Instructions(Storage),
+        Predecessors(Storage) {}
+  /// \brief Take the successors from the last instruction and move the
+  /// block between the predecessor lists of the old and new successors.
+  void updateSuccessors();
   Function &OwningFunction;
-  boost::container::stable_vector<Instruction> Instructions{};
-  bool HasLabel{};
+  /// Position in the block table of the function. Branches refer to the
+  /// block by it.
+  std::uint32_t Id;
+  InstructionList Instructions;
+  NameId Label{EmptyName};
+  std::uint32_t Number{};
+  std::uint32_t Successors[2]{};
+  std::uint8_t NumSuccessors{};
+  ArenaVector<std::uint32_t> Predecessors;
+};
+
+/// \brief Map from names to IR nodes kept in an arena.
+template <typename T>
+using SymbolMap =
+    std::unordered_map<NameId, T *, std::hash<NameId>, std::equal_to<NameId>,
+                       ArenaAllocator<std::pair<const NameId, T *>>>;
+
+/// \brief Symbols of a function.
+struct FunctionST {
+  explicit FunctionST(Arena &Storage)
+      : Labels(Storage), LocalVariables(Storage) {}
+  SymbolMap<BasicBlock> Labels;
+  SymbolMap<SymReg> LocalVariables;
+};
+
+/// \brief Symbols of a module.
+struct ModuleST {
+  explicit ModuleST(Arena &Storage)
+      : Functions(Storage), GlobalVariables(Storage) {}
+  SymbolMap<Function> Functions;
+  SymbolMap<SymReg> GlobalVariables;
 };
 
 class Function {
+  using BlockIterator =
+      boost::indirect_iterator<ArenaVector<BasicBlock *>::iterator>;
+  using ConstBlockIterator =
+      boost::indirect_iterator<ArenaVector<BasicBlock *>::const_iterator,
+                               const BasicBlock>;
+
 public:
-  auto begin() { return std::begin(BasicBlocks); }
-  auto end() { return std::end(BasicBlocks); }
-  auto begin() const { return std::cbegin(BasicBlocks); }
-  auto end() const { return std::cend(BasicBlocks); }
-  BasicBlock &operator[](size_t index) { return BasicBlocks[index]; }
+  BlockIterator begin() { return BlockIterator{std::begin(BasicBlocks)}; }
+  BlockIterator end() { return BlockIterator{std::end(BasicBlocks)}; }
+  ConstBlockIterator begin() const {
+    return ConstBlockIterator{std::cbegin(BasicBlocks)};
+  }
+  ConstBlockIterator end() const {
+    return ConstBlockIterator{std::cend(BasicBlocks)};
+  }
+  BasicBlock &operator[](size_t index) { return *BasicBlocks[index]; }
+  size_t size() const { return BasicBlocks.size(); }
   Function(const Function &) = delete;
   Function &operator=(Function) = delete;
   Function(Function &&) = default;
   Function &operator=(Function &&) = default;
   Module &parent() { return OwningModule; }
   const Module &parent() const { return OwningModule; }
-  const boost::container::stable_vector<SymReg> &symbolicRegisters() const {
+  const NodeList<SymReg> &symbolicRegisters() const {
     return SymbolicRegisters;
   }
+  /// \brief Memory of the blocks, instructions and registers.
+  const Arena &arena() const { return Storage; }
+  /// \brief Upper bound of the indices of the blocks.
+  std::size_t numBlockIndices() const { return BlockTable.size(); }
+  /// \return Block with index \p Index or nullptr if it was erased.
+  BasicBlock *blockAt(std::uint32_t Index) { return BlockTable[Index]; }
+  const BasicBlock *blockAt(std::uint32_t Index) const {
+    return BlockTable[Index];
+  }
+  /// \brief Number of changes of the function so far. Results of analyses
+  /// computed at another version might be outdated.
+  std::size_t version() const { return Version; }
+  /// \brief Number of changes of the blocks of the function and of the
+  /// edges between them so far.
+  std::size_t cfgVersion() const { return CFGVersion; }
   const string_view Name;
+  friend class Instruction;
   friend class MIRBuilder;
   friend std::ostream &operator<<(std::ostream &stream,
                                   const Function &function);
 
 private:
   Module &OwningModule;
-  std::vector<string_view> ArgNames;
-  Function(Module &Parent, std::string &&Name,
-           std::vector<string_view> &&ArgNames)
-      : Name{internedName(std::move(Name))},
-        OwningModule{Parent}, ArgNames{std::move(ArgNames)} {}
-  boost::container::stable_vector<BasicBlock> BasicBlocks{};
-  boost::container::stable_vector<SymReg> SymbolicRegisters{};
+  Arena &Storage;
+  ArenaVector<string_view> ArgNames;
+  Function(Module &Parent, string_view Name,
+           const std::vector<string_view> &ArgNames, Arena &Storage)
+      : Name{Name}, OwningModule{Parent}, Storage{Storage},
+        ArgNames(std::begin(ArgNames), std::end(ArgNames), Storage),
+        BasicBlocks(Storage), SymbolicRegisters(Storage),
+        BlockTable(Storage), Constants(Storage), Symbols(Storage) {}
+  /// Blocks in layout order. They are created in the arena, so erasing them
+  /// moves only pointers.
+  ArenaVector<BasicBlock *> BasicBlocks;
+  NodeList<SymReg> SymbolicRegisters;
+  /// Blocks by id. Erased blocks leave null entries.
+  ArenaVector<BasicBlock *> BlockTable;
+  /// Constants of instructions which don't fit into a handle.
+  ArenaVector<Imm> Constants;
+  FunctionST Symbols;
+  std::size_t Version{};
+  std::size_t CFGVersion{};
+  /// Number of blocks without a label.
+  std::uint32_t NumUnlabeled{};
+  void noteChange(bool ControlFlow) {
+    ++Version;
+    CFGVersion += ControlFlow;
+  }
 };
 
+/// \brief Top level IR unit.
+/// The module owns an arena keeping its functions, global variables and
+/// symbol tables, and an arena for every function keeping the basic blocks,
+/// instructions and registers of the function. Functions don't share memory
+/// they allocate while changing, so different functions can be transformed
+/// on different threads. IR nodes are never destroyed one by one: a module
+/// frees its arenas in O(chunks) instead.
 class Module {
+  /// Names of the entities of the module. It comes first, so that the name of
+  /// the module can be interned in it.
+  WyrmContext Context{};
+
 public:
   auto begin() { return std::begin(Functions); }
   auto end() const { return std::end(Functions); }
@@ -333,19 +1198,144 @@ public:
   auto cend() const { return std::cend(Functions); }
   Function &operator[](size_t index) { return Functions[index]; }
   const string_view Name;
-  Module(std::string &&name) : Name{internedName(std::move(name))} {}
+  Module(std::string &&name)
+      : Name{Context.internedName(name)},
+        Functions{*Storage.create<NodeList<Function>>(Storage)},
+        GlobalVariables{*Storage.create<NodeList<SymReg>>(Storage)} {}
+  /// IR nodes refer to their module, so it can be neither copied nor moved.
   Module(const Module &) = delete;
   Module &operator=(Module) = delete;
-  Module(Module &&) = default;
-  Module &operator=(Module &&) = default;
+  /// \brief Memory of the functions and global variables. Each function has
+  /// an arena of its own.
+  const Arena &arena() const { return Storage; }
+  const WyrmContext &context() const { return Context; }
+  friend class Instruction;
   friend class MIRBuilder;
   friend std::ostream &operator<<(std::ostream &stream, const Module &module);
 
 private:
-  boost::container::stable_vector<Function> Functions{};
-  boost::container::stable_vector<SymReg> GlobalVariables{};
+  Arena Storage{};
+  NodeList<Function> &Functions;
+  NodeList<SymReg> &GlobalVariables;
+  ModuleST Symbols{Storage};
+  /// Arenas of the functions.
+  std::deque<Arena> FunctionStorage;
+  /// Guards the use lists of global variables.
+  std::mutex GlobalUses;
 };
 
+inline SymReg &Instruction::registerOf(detail::Handle H) const {
+  const auto Index = H >> detail::HandleTagBits;
+  Function &F = OwningBB->OwningFunction;
+  switch (H & ((1u << detail::HandleTagBits) - 1)) {
+  case detail::RegisterTag:
+    return F.SymbolicRegisters[Index];
+  case detail::GlobalTag:
+    return F.OwningModule.GlobalVariables[Index];
+  }
+  assert(false && "The operand isn't a register");
+  return F.SymbolicRegisters[Index];
+}
+
+inline Value Instruction::decode(detail::Handle H) const {
+  if (H & detail::ImmediateTag)
+    return static_cast<Imm>(H) >> 1;
+  assert(H != detail::NoHandle && "No operand");
+  if ((H & ((1u << detail::HandleTagBits) - 1)) == detail::PooledTag)
+    return OwningBB->OwningFunction.Constants[H >> detail::HandleTagBits];
+  return registerOf(H);
+}
+
+inline detail::Handle Instruction::encode(Value V) {
+  Function &F = OwningBB->OwningFunction;
+  if (SymReg *Reg = get<SymReg>(&V)) {
+    assert(Reg->index() < (std::size_t{1} << (32 - detail::HandleTagBits)) &&
+           "Too many registers");
+    const auto Index = static_cast<detail::Handle>(Reg->index());
+    if (!Reg->isLocal())
+      return Index << detail::HandleTagBits | detail::GlobalTag;
+    assert(&Reg->parent<Function>() == &F &&
+           "The register belongs to another function");
+    return Index << detail::HandleTagBits | detail::RegisterTag;
+  }
+  const Imm Constant = *get<Imm>(&V);
+  if (Constant >= -(1 << 30) && Constant < (1 << 30))
+    return static_cast<detail::Handle>(Constant) << 1 | detail::ImmediateTag;
+  F.Constants.push_back(Constant);
+  return static_cast<detail::Handle>(F.Constants.size() - 1)
+             << detail::HandleTagBits |
+         detail::PooledTag;
+}
+
+inline BasicBlock &Instruction::block(std::uint32_t Id) const {
+  return *OwningBB->OwningFunction.BlockTable[Id];
+}
+
+inline std::uint32_t Instruction::blockId(const BasicBlock &BB) const {
+  assert(&BB.OwningFunction == &OwningBB->OwningFunction &&
+         "The block belongs to another function");
+  return BB.Id;
+}
+
+inline Arena &Instruction::arena() const {
+  return OwningBB->Instructions.arena();
+}
+
+inline void Instruction::noteChange(bool ControlFlow) const {
+  OwningBB->OwningFunction.noteChange(ControlFlow);
+}
+
+inline void Instruction::noteSuccessorChange() {
+  noteChange(true);
+  // Terminators under construction aren't in their blocks yet.
+  auto &Instructions = OwningBB->Instructions;
+  if (!Instructions.empty() && &Instructions[Instructions.size() - 1] == this)
+    OwningBB->updateSuccessors();
+}
+
+inline std::size_t Instruction::numUseSlots() const {
+  switch (Op) {
+  case Opcode::Ret:
+  case Opcode::Br:
+  case Opcode::UnOp:
+    return 1;
+  case Opcode::BinOp:
+    return 2;
+  case Opcode::Call:
+    return Call->NumArguments;
+  case Opcode::Phi:
+    return Phi ? Phi->Capacity : 0;
+  case Opcode::Receive:
+  case Opcode::GoTo:
+    break;
+  }
+  return 0;
+}
+
+inline std::size_t Instruction::numUses() const {
+  if (!Uses)
+    return 0;
+  if (Op == Opcode::Call || Op == Opcode::Phi)
+    return numUseSlots();
+  return NumUses;
+}
+
+inline Instruction &Instruction::operator=(Instruction &&Other) noexcept {
+  OwningBB = Other.OwningBB;
+  Op = Other.Op;
+  Kind = Other.Kind;
+  NumUses = Other.NumUses;
+  Out = Other.Out;
+  static_assert(sizeof(Operands) == sizeof(Call) &&
+                    sizeof(Operands) == sizeof(Phi),
+                "Operands must cover the whole union");
+  std::copy(std::begin(Other.Operands), std::end(Other.Operands), Operands);
+  Uses = std::exchange(Other.Uses, nullptr);
+  for (std::size_t I = 0, E = numUses(); I < E; I += detail::UsesPerGroup)
+    Uses[I / detail::UsesPerGroup].User = this;
+  return *this;
+}
+
 /// \brief Helper for building IR.
 class MIRBuilder {
 public:
@@ -357,7 +1347,20 @@ public:
     return InstType(std::forward<ArgTypes...>(args...));
   }
   /// \brief Set \p BB as the current basic block.
-  void setBasicBlock(BasicBlock &bb) { CurrentBB = &bb; }
+  /// New instructions are appended to its end.
+  void setBasicBlock(BasicBlock &bb) {
+    CurrentBB = &bb;
+    InsertPosition.reset();
+  }
+  /// \brief Insert new instructions into \p BB before the instruction at
+  /// \p Position. Consecutive instructions keep their order.
+  /// Inserting moves the instructions after the insert point, so references
+  /// to them are invalidated.
+  void setInsertPoint(BasicBlock &BB, size_t Position) {
+    assert(Position <= BB.size() && "Insert point is out of the block");
+    CurrentBB = &BB;
+    InsertPosition = Position;
+  }
   BasicBlock *currentBasicBlock() { return CurrentBB; }
   /// \brief Add a new basic block to \p func's basic block list.
   /// \param label Optional label for the block for GoTo instructions. Emptry
@@ -388,8 +1391,42 @@ public:
                               std::string &&Name = "");
   Instruction &createUnOpInst(UnOpKind Kind, Value Operand,
                               std::string &&Name = "");
+  /// \brief Create a = op b with existing register \p OutRegister as a.
+  Instruction &createUnOpInst(UnOpKind Kind, Value Operand,
+                              SymReg &OutRegister);
   Instruction &createBinOpInst(BinOpKind Kind, Value Operand1, Value Operand2,
                                std::string &&Name = "");
+  /// \brief Create a = b op c with existing register \p OutRegister as a.
+  Instruction &createBinOpInst(BinOpKind Kind, Value Operand1, Value Operand2,
+                               SymReg &OutRegister);
+  /// \brief Create phi without incoming values at the insert point.
+  Instruction &createPhiInst(SymReg &OutRegister);
+  /// \brief Create new register in \p Func.
+  /// If \p Name is already defined in \p Func name the register
+  /// \p Name.unique_numeric_suffix. Empty \p Name means no name.
+  SymReg &createRegister(Function &Func, std::string &&Name = "");
+  /// \brief Remove the instruction at \p Position from \p BB.
+  /// An insert point after \p Position in \p BB is shifted accordingly.
+  /// References to the instructions after \p Position are invalidated.
+  void eraseInstruction(BasicBlock &BB, size_t Position);
+  /// \brief Remove the instructions at \p Positions from \p BB in one pass.
+  /// Unlike repeated eraseInstruction the cost is linear in the size of
+  /// \p BB. References to the instructions after the first erased one are
+  /// invalidated.
+  /// \pre \p Positions are ascending.
+  void eraseInstructions(BasicBlock &BB, const std::vector<size_t> &Positions);
+  /// \brief Remove \p BB from its function.
+  /// If the insert point is in \p BB, the builder is left without one. The
+  /// instructions of \p BB stop being users of registers.
+  /// \pre No instruction refers to \p BB.
+  void eraseBasicBlock(BasicBlock &BB);
+  /// \brief Remove \p Blocks from their function in one pass.
+  /// Unlike repeated eraseBasicBlock the cost is linear in the size of the
+  /// function: the block list is compacted and the blocks without a label
+  /// are renumbered once.
+  /// \pre \p Blocks are distinct blocks of one function, and no instruction
+  /// of the other blocks refers to them.
+  void eraseBasicBlocks(const std::vector<BasicBlock *> &Blocks);
   Function *currentFuction() {
     return (CurrentBB == nullptr) ? nullptr : &CurrentBB->parent();
   }
@@ -403,14 +1440,23 @@ private:
   SymReg &symReg(std::string &&Name, Function *Func = nullptr);
   Module &TheModule;
   BasicBlock *CurrentBB{nullptr};
+  /// Position in CurrentBB to insert new instructions at. Instructions are
+  /// appended if not set.
+  optional<size_t> InsertPosition{};
 };
 
 template <typename InstTy, typename... ArgsTy>
 Instruction &MIRBuilder::createInst(ArgsTy &&... Args) {
   assert(CurrentBB && "Instruction must belong to a basic block");
   InstTy Inst{*CurrentBB, std::forward<ArgsTy>(Args)...};
-  CurrentBB->Instructions.push_back(std::move(Inst));
-  return CurrentBB->Instructions.back();
+  auto &Instructions = CurrentBB->Instructions;
+  std::size_t Position =
+      InsertPosition ? (*InsertPosition)++ : Instructions.size();
+  CurrentBB->OwningFunction.noteChange(isTerminator(Inst));
+  Instruction &Result = Instructions.insert(Position, std::move(Inst));
+  if (Position + 1 == Instructions.size())
+    CurrentBB->updateSuccessors();
+  return Result;
 }
 
 } // namespace wyrm
@@ -0,0 +1,39 @@
+/// \file
+/// \brief Aggressive dead code elimination.
+#ifndef ADCE_H
+#define ADCE_H
+#include "Analysis/analysis_cache.h"
+#include "MIR.h"
+
+namespace wyrm {
+
+/// \brief Remove the instructions and branches which affect neither the
+/// result nor the side effects of \p F.
+/// Implements the mark-sweep algorithm of Cytron et al., "Efficiently
+/// Computing Static Single Assignment Form and the Control Dependence
+/// Graph", 1991. Returns, calls, receives, writes of global variables and
+/// divisions which might trap are live from the start. An instruction is
+/// live if a live instruction reads a register it defines, and a branch is
+/// live if a block with a live instruction is control dependent on it or a
+/// live phi merges a value coming through it. Everything else is assumed
+/// dead until proven live, so unlike the removal of unused results this
+/// removes cycles of dead computations and branches guarding nothing.
+/// Dead instructions are erased with a single pass over every block. A dead
+/// branch becomes a goto to the immediate post-dominator of its block, as
+/// nothing live runs in between, and then unreachable blocks are erased at
+/// once.
+/// Branches along back edges and in irreducible regions are kept, so loops
+/// which might not terminate stay. Gotos are always kept.
+/// Every definition of a register read by a live instruction is live, so the
+/// pass works on SSA form as well as on registers defined several times.
+/// \pre The entry block of \p F has no predecessors.
+/// \return If \p F changed.
+bool eliminateDeadCode(MIRBuilder &Builder, Function &F);
+/// \brief Same as above with the CFG and the dominator tree of \p F taken
+/// from \p Analyses.
+bool eliminateDeadCode(MIRBuilder &Builder, Function &F,
+                       AnalysisCache &Analyses);
+
+} // namespace wyrm
+
+#endif
@@ -0,0 +1,32 @@
+/// \file
+/// \brief Dominator-tree-scoped global value numbering.
+#ifndef GVN_H
+#define GVN_H
+#include "Analysis/analysis_cache.h"
+#include "MIR.h"
+
+namespace wyrm {
+
+/// \brief Remove unary and binary operations recomputing a value available
+/// from a dominating instruction.
+/// Blocks are visited in preorder of the dominator tree with a scoped hash
+/// table of the expressions computed by the dominators, keyed by the
+/// operation and its operands. Operands of commutative operations are
+/// ordered, and Greater and Geq are rewritten as Less and Leq with swapped
+/// operands, so equivalent forms share a key. Uses of a redundant result are
+/// rewritten to the dominating definition and the redundant instruction is
+/// erased. Copies of registers are propagated the same way.
+/// Only registers defined once by an instruction dominating every use take
+/// part, so the pass is most effective on SSA form. Global variables might
+/// change and are ignored.
+/// \pre The entry block of \p F has no predecessors.
+/// \return If \p F changed.
+bool eliminateRedundancies(MIRBuilder &Builder, Function &F);
+/// \brief Same as above with the CFG and the dominator tree of \p F taken
+/// from \p Analyses.
+bool eliminateRedundancies(MIRBuilder &Builder, Function &F,
+                           AnalysisCache &Analyses);
+
+} // namespace wyrm
+
+#endif
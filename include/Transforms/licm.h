@@ -0,0 +1,37 @@
+/// \file
+/// \brief Loop-invariant code motion.
+#ifndef LICM_H
+#define LICM_H
+#include "Analysis/analysis_cache.h"
+#include "MIR.h"
+
+namespace wyrm {
+
+/// \brief Move unary and binary operations computing the same value on every
+/// iteration of a loop to its preheader.
+/// An operation is invariant in a loop if every operand is an immediate, a
+/// register without definitions in the loop or the result of an operation
+/// hoisted already. It's hoisted if its result is a local register with no
+/// other definition, read only where the operation dominates the read, so
+/// executing it before the loop changes no value observed. Div and Mod which
+/// might trap are hoisted only from the loop header before any call or write
+/// of a global variable, where they run whenever the loop is entered.
+/// Loops are processed innermost first, so an operation invariant in several
+/// nested loops moves out of all of them one by one. A loop gets a preheader,
+/// a block outside it whose only successor is the header and which is the
+/// only block entering the loop, if it has none and an operation might be
+/// hoisted out of it. Phis of the header merging values of several entering
+/// blocks are split with a phi in the new block.
+/// Only registers with a single definition move, so the pass is most
+/// effective on SSA form. Global variables might change and aren't invariant.
+/// \pre The entry block of \p F has no predecessors.
+/// \return If \p F changed.
+bool hoistLoopInvariants(MIRBuilder &Builder, Function &F);
+/// \brief Same as above with the CFG, the dominator tree and the loops of
+/// \p F taken from \p Analyses.
+bool hoistLoopInvariants(MIRBuilder &Builder, Function &F,
+                         AnalysisCache &Analyses);
+
+} // namespace wyrm
+
+#endif
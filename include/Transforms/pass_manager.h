@@ -0,0 +1,115 @@
+/// \file
+/// \brief Running pipelines of passes over the functions of a module on
+/// several threads.
+#ifndef PASS_MANAGER_H
+#define PASS_MANAGER_H
+#include "Analysis/analysis_cache.h"
+#include "MIR.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace wyrm {
+
+/// \brief Transformation of a single function using the analyses cached
+/// for it.
+/// \return If the function changed.
+/// A function pass may create blocks, instructions and registers of its
+/// function and read global variables, but mustn't change other functions,
+/// create functions or global variables, or walk and replace the uses of
+/// global variables: other functions are transformed at the same time.
+using FunctionPass =
+    std::function<bool(MIRBuilder &, Function &, AnalysisCache &)>;
+
+/// \brief Transformation of a whole module.
+/// \return If the module changed.
+using ModulePass = std::function<bool(MIRBuilder &, Module &)>;
+
+/// \brief Pipeline of function and module passes.
+/// Consecutive function passes form a stage running all of them on a
+/// function before the next function is taken. Functions of a stage are
+/// transformed in parallel by a pool of workers with a deque of functions
+/// each: a worker takes functions from the back of its deque and, when it's
+/// empty, steals them from the fronts of the deques of other workers, so
+/// workers done early help the ones which got big functions. A module pass is
+/// a barrier: it runs alone once all functions of the previous stage are
+/// done.
+/// A function is transformed by a single worker with a builder of its own,
+/// so the result doesn't depend on the number of workers.
+/// Every function has an AnalysisCache for the duration of run(), so passes
+/// reuse the analyses computed by the previous passes as long as the
+/// function doesn't change or the passes changing it preserve them.
+class PassManager {
+public:
+  /// \param NumWorkers Number of threads running function passes including
+  /// the one calling run(). Zero means one per hardware thread.
+  explicit PassManager(unsigned NumWorkers = 0);
+  ~PassManager();
+  PassManager(const PassManager &) = delete;
+  PassManager &operator=(const PassManager &) = delete;
+  /// \param Preserved Analyses \p Pass keeps valid when it changes a
+  /// function.
+  void addFunctionPass(FunctionPass Pass,
+                       PreservedAnalyses Preserved = PreservedAnalyses::none());
+  void addModulePass(ModulePass Pass);
+  /// \brief Run the passes on \p M in the order they were added.
+  /// \return If a pass changed \p M.
+  bool run(Module &M);
+  unsigned numWorkers() const {
+    return static_cast<unsigned>(Queues.size());
+  }
+
+private:
+  struct FunctionPassEntry {
+    FunctionPass Run;
+    PreservedAnalyses Preserved;
+  };
+  /// \brief Either function passes or a module pass.
+  struct Stage {
+    std::vector<FunctionPassEntry> FunctionPasses;
+    ModulePass WholeModule;
+  };
+  /// \brief Functions waiting for a worker, given by their analyses. Queues
+  /// of different workers are kept on different cache lines.
+  struct alignas(64) Queue {
+    std::mutex Lock;
+    std::deque<AnalysisCache *> Functions;
+  };
+  using CacheMap =
+      std::unordered_map<const Function *, std::unique_ptr<AnalysisCache>>;
+  bool runFunctionPasses(Module &M,
+                         const std::vector<FunctionPassEntry> &Passes,
+                         CacheMap &Caches);
+  /// \return Analyses of the next function for worker \p Self or nullptr if
+  /// every queue is empty.
+  AnalysisCache *take(unsigned Self);
+  /// \brief Transform functions until every queue is empty.
+  void work(unsigned Self);
+  /// \brief Loop of pool thread \p Self.
+  void serve(unsigned Self);
+  std::vector<Stage> Stages;
+  std::vector<Queue> Queues;
+  std::vector<std::thread> Threads;
+  /// Passes of the running stage.
+  const std::vector<FunctionPassEntry> *CurrentPasses{};
+  std::atomic<bool> Changed{};
+  /// Guards the fields below.
+  std::mutex PoolLock;
+  std::condition_variable Wake;
+  std::condition_variable Idle;
+  /// Number of the last started stage.
+  std::uint64_t Generation{};
+  /// Number of pool threads taking functions.
+  unsigned Active{};
+  bool Stopping{};
+};
+
+} // namespace wyrm
+
+#endif
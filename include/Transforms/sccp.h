@@ -0,0 +1,33 @@
+/// \file
+/// \brief Sparse conditional constant propagation.
+#ifndef SCCP_H
+#define SCCP_H
+#include "Analysis/analysis_cache.h"
+#include "MIR.h"
+
+namespace wyrm {
+
+/// \brief Propagate constants in \p F and remove the code they make dead.
+/// Implements Wegman and Zadeck, "Constant Propagation with Conditional
+/// Branches", 1991: values of registers and executability of CFG edges are
+/// discovered together with an SSA edge worklist and a CFG edge worklist, so
+/// constants flowing only along unexecutable edges don't spoil the result.
+/// Then uses of constant registers are replaced with immediates, their
+/// definitions are removed, branches on constants become gotos and blocks
+/// which are never executed are erased.
+/// Operations which trap, like division by zero, are never folded.
+/// The pass is most precise on SSA form. Only registers defined once by an
+/// instruction dominating every use are tracked: the others might be read
+/// before being defined, and they are treated as unknown values together
+/// with global variables.
+/// \pre The entry block of \p F has no predecessors.
+/// \return If \p F changed.
+bool propagateConstants(MIRBuilder &Builder, Function &F);
+/// \brief Same as above with the CFG and the dominator tree of \p F taken
+/// from \p Analyses.
+bool propagateConstants(MIRBuilder &Builder, Function &F,
+                        AnalysisCache &Analyses);
+
+} // namespace wyrm
+
+#endif
@@ -0,0 +1,34 @@
+/// \file
+/// \brief Conversion of functions into and out of static single assignment
+/// form.
+#ifndef SSA_H
+#define SSA_H
+#include "Analysis/analysis_cache.h"
+#include "MIR.h"
+
+namespace wyrm {
+
+/// \brief Convert \p F into SSA form.
+/// Phi instructions are placed on the iterated dominance frontiers of the
+/// blocks defining a register. Only registers used in some block before
+/// being defined there get phis (semi-pruned SSA). Then registers are renamed
+/// in a preorder walk of the dominator tree: the first definition keeps the
+/// original register, the later ones get new registers. A use which is not
+/// reached by any definition reads 0.
+/// Global variables are left intact.
+/// \pre The entry block of \p F has no predecessors and \p F has no phi
+/// instructions.
+void constructSSA(MIRBuilder &Builder, Function &F);
+/// \brief Same as above with the CFG and the dominator tree of \p F taken
+/// from \p Analyses.
+void constructSSA(MIRBuilder &Builder, Function &F, AnalysisCache &Analyses);
+
+/// \brief Replace phi instructions of \p F with copies.
+/// Every phi a = phi [v1, BB1], ... becomes a = t, where new register t is
+/// assigned t = v1 before the terminator of BB1 and so on. Copying through t
+/// keeps phis of one block parallel and needs no critical edge splitting.
+void destructSSA(MIRBuilder &Builder, Function &F);
+
+} // namespace wyrm
+
+#endif
@@ -0,0 +1,96 @@
+/// \file
+/// \brief Bump pointer allocation of objects with a common lifetime.
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace wyrm {
+
+/// \brief Allocator which carves memory out of big chunks and frees it only
+/// all at once on destruction.
+/// Allocated objects never move. Destructors of objects created in the arena
+/// aren't called, so they mustn't own memory outside of it.
+class Arena {
+public:
+  /// Size of the first chunk. Every next chunk is twice as big up to
+  /// MaxChunkSize.
+  static constexpr std::size_t MinChunkSize = 4096;
+  static constexpr std::size_t MaxChunkSize = 1 << 20;
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  ~Arena();
+  /// \return \p Size bytes aligned by \p Alignment.
+  /// \pre \p Alignment is a power of two not greater than
+  /// alignof(std::max_align_t).
+  void *allocate(std::size_t Size, std::size_t Alignment) {
+    assert(Alignment && !(Alignment & (Alignment - 1)) &&
+           Alignment <= alignof(std::max_align_t) && "Unsupported alignment");
+    auto Address = reinterpret_cast<std::uintptr_t>(Current);
+    auto Aligned = (Address + Alignment - 1) & ~(Alignment - 1);
+    if (!Current || Aligned + Size > reinterpret_cast<std::uintptr_t>(End))
+      return allocateInNewChunk(Size);
+    Current = reinterpret_cast<char *>(Aligned + Size);
+    Allocated += Size;
+    return reinterpret_cast<void *>(Aligned);
+  }
+  /// \brief Construct T in the arena.
+  template <typename T, typename... ArgTys> T *create(ArgTys &&... Args) {
+    return new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<ArgTys>(Args)...);
+  }
+  /// \brief Number of chunks requested from the system.
+  std::size_t numChunks() const { return NumChunks; }
+  /// \brief Total size of the chunks.
+  std::size_t reservedBytes() const { return Reserved; }
+  /// \brief Number of bytes handed out including the ones no longer used.
+  std::size_t allocatedBytes() const { return Allocated; }
+
+private:
+  struct Chunk {
+    Chunk *Previous;
+  };
+  void *allocateInNewChunk(std::size_t Size);
+  /// The last chunk. Each chunk starts with the link to the previous one.
+  Chunk *Chunks{};
+  char *Current{};
+  char *End{};
+  std::size_t NumChunks{};
+  std::size_t Reserved{};
+  std::size_t Allocated{};
+};
+
+/// \brief Standard allocator interface to an arena for containers of IR.
+/// Deallocation does nothing: the memory is reused only after the arena is
+/// destroyed.
+template <typename T> class ArenaAllocator {
+public:
+  using value_type = T;
+  ArenaAllocator(Arena &Storage) : Storage{&Storage} {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &Other) : Storage{Other.Storage} {}
+  T *allocate(std::size_t N) {
+    return static_cast<T *>(Storage->allocate(N * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *, std::size_t) {}
+  Arena &arena() const { return *Storage; }
+  template <typename U> bool operator==(const ArenaAllocator<U> &Other) const {
+    return Storage == Other.Storage;
+  }
+  template <typename U> bool operator!=(const ArenaAllocator<U> &Other) const {
+    return Storage != Other.Storage;
+  }
+  template <typename U> friend class ArenaAllocator;
+
+private:
+  Arena *Storage;
+};
+
+} // namespace wyrm
+
+#endif // ARENA_H
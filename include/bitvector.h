@@ -0,0 +1,132 @@
+/// \file
+/// \brief Dense bit vectors for dataflow analyses.
+/// Word-level kernels process 256 bits at a time with AVX2 when the host CPU
+/// supports it and fall back to 64-bit scalar code otherwise.
+#ifndef BITVECTOR_H
+#define BITVECTOR_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace wyrm {
+
+using BitWord = std::uint64_t;
+constexpr std::size_t BitWordSize = 64;
+
+/// \return Number of words required to keep \p Bits bits.
+constexpr std::size_t bitWords(std::size_t Bits) {
+  return (Bits + BitWordSize - 1) / BitWordSize;
+}
+
+/// \brief LHS[0..N) &= RHS[0..N).
+/// \return true if LHS changed.
+bool andWords(BitWord *LHS, const BitWord *RHS, std::size_t N);
+/// \brief LHS[0..N) |= RHS[0..N).
+/// \return true if LHS changed.
+bool orWords(BitWord *LHS, const BitWord *RHS, std::size_t N);
+
+/// \brief Fixed size vector of bits.
+class BitVector {
+public:
+  BitVector() = default;
+  explicit BitVector(std::size_t Size, bool Value = false)
+      : Size{Size}, Words(bitWords(Size), Value ? ~BitWord{} : 0) {
+    clearUnusedBits();
+  }
+  std::size_t size() const { return Size; }
+  bool test(std::size_t Bit) const {
+    assert(Bit < Size && "Bit is out of range");
+    return Words[Bit / BitWordSize] >> (Bit % BitWordSize) & 1;
+  }
+  void set(std::size_t Bit) {
+    assert(Bit < Size && "Bit is out of range");
+    Words[Bit / BitWordSize] |= BitWord{1} << (Bit % BitWordSize);
+  }
+  void reset(std::size_t Bit) {
+    assert(Bit < Size && "Bit is out of range");
+    Words[Bit / BitWordSize] &= ~(BitWord{1} << (Bit % BitWordSize));
+  }
+  void setAll() {
+    for (auto &Word : Words)
+      Word = ~BitWord{};
+    clearUnusedBits();
+  }
+  void resetAll() {
+    for (auto &Word : Words)
+      Word = 0;
+  }
+  /// \return Number of set bits.
+  std::size_t count() const;
+  bool any() const;
+  /// \brief Intersect with \p RHS in place.
+  /// \return true if the vector changed.
+  bool intersectWith(const BitVector &RHS) {
+    assert(Size == RHS.Size && "Bit vectors must have the same size");
+    return andWords(Words.data(), RHS.Words.data(), Words.size());
+  }
+  /// \brief Unite with \p RHS in place.
+  /// \return true if the vector changed.
+  bool uniteWith(const BitVector &RHS) {
+    assert(Size == RHS.Size && "Bit vectors must have the same size");
+    return orWords(Words.data(), RHS.Words.data(), Words.size());
+  }
+  /// \brief Call \p F with the index of every set bit in ascending order.
+  template <typename FuncT> void forEachSetBit(FuncT F) const {
+    for (std::size_t I = 0, E = Words.size(); I < E; ++I)
+      for (BitWord Word = Words[I]; Word; Word &= Word - 1)
+        F(I * BitWordSize + __builtin_ctzll(Word));
+  }
+  BitWord *words() { return Words.data(); }
+  const BitWord *words() const { return Words.data(); }
+  std::size_t numWords() const { return Words.size(); }
+  bool operator==(const BitVector &RHS) const {
+    return Size == RHS.Size && Words == RHS.Words;
+  }
+  bool operator!=(const BitVector &RHS) const { return !(*this == RHS); }
+
+private:
+  void clearUnusedBits() {
+    if (Size % BitWordSize)
+      Words.back() &= (BitWord{1} << (Size % BitWordSize)) - 1;
+  }
+  std::size_t Size{};
+  std::vector<BitWord> Words{};
+};
+
+/// \brief Read-only view of bits kept elsewhere, e.g. in a row of a bit
+/// matrix.
+class BitVectorView {
+public:
+  BitVectorView(const BitWord *Words, std::size_t Size)
+      : Words{Words}, Size{Size} {}
+  BitVectorView(const BitVector &BV) : Words{BV.words()}, Size{BV.size()} {}
+  std::size_t size() const { return Size; }
+  bool test(std::size_t Bit) const {
+    assert(Bit < Size && "Bit is out of range");
+    return Words[Bit / BitWordSize] >> (Bit % BitWordSize) & 1;
+  }
+  /// \return Number of set bits.
+  std::size_t count() const {
+    std::size_t Result{};
+    for (std::size_t I = 0, E = bitWords(Size); I < E; ++I)
+      Result += __builtin_popcountll(Words[I]);
+    return Result;
+  }
+  /// \brief Call \p F with the index of every set bit in ascending order.
+  template <typename FuncT> void forEachSetBit(FuncT F) const {
+    for (std::size_t I = 0, E = bitWords(Size); I < E; ++I)
+      for (BitWord Word = Words[I]; Word; Word &= Word - 1)
+        F(I * BitWordSize + __builtin_ctzll(Word));
+  }
+  const BitWord *words() const { return Words; }
+
+private:
+  const BitWord *Words;
+  std::size_t Size;
+};
+
+} // namespace wyrm
+
+#endif // BITVECTOR_H
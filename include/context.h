@@ -1,52 +1,43 @@
 /// \file
-/// \brief Keep global data structures.
-/// Provide symbols for all IR entities.
+/// \brief Names of IR entities.
 #ifndef CONTEXT_H
 #define CONTEXT_H
 
 #include "compatibility.h"
-#include <unordered_map>
-#include <unordered_set>
+#include "interner.h"
 
 namespace wyrm {
 
-class Module;
-class Function;
-class BasicBlock;
-class SymReg;
-using InternedStrings = std::unordered_set<std::string>;
-using NameTableT = std::unordered_map<const void *, string_view>;
-struct ModuleST {
-  std::unordered_map<string_view, Function *> Functions;
-  std::unordered_map<string_view, SymReg *> GlobalVariables;
-};
-using ModuleSymbolsT = std::unordered_map<Module *, ModuleST>;
-struct FunctionST {
-  std::unordered_map<string_view, BasicBlock *> Labels;
-  std::unordered_map<string_view, SymReg *> LocalVariables;
-};
-using FunctionSymbolsT = std::unordered_map<Function *, FunctionST>;
+/// \brief Compact id of an interned name. The empty name has id EmptyName.
+using NameId = StringInterner::Id;
+constexpr NameId EmptyName = StringInterner::EmptyId;
 
+/// \brief Names of the entities of a module.
+/// Every module has a context of its own, so independent modules can be
+/// built, optimized and printed on different threads. The context itself is
+/// safe to use from several threads.
 class WyrmContext {
 public:
-  const NameTableT &Names{NameTable};
   WyrmContext(const WyrmContext &) = delete;
   WyrmContext &operator=(WyrmContext) = delete;
   WyrmContext() {}
-  friend class MIRBuilder;
-  friend class Module;
-  friend string_view internedName(std::string &&);
+  /// \return Name with \p Id.
+  string_view name(NameId Id) const { return Names.get(Id); }
+  /// \return Id of \p Name or nothing if \p Name isn't interned.
+  optional<NameId> findName(string_view Name) const {
+    return Names.find(Name);
+  }
+  /// \brief Intern \p Name.
+  /// \return Id of \p Name.
+  NameId intern(string_view Name) { return Names.intern(Name); }
+  /// \brief Intern \p Name.
+  /// \return The interned copy of \p Name.
+  string_view internedName(string_view Name) { return name(intern(Name)); }
 
 private:
-  InternedStrings StringStorage{};
-  NameTableT NameTable{};
-  ModuleSymbolsT ModuleSymbols{};
-  FunctionSymbolsT FunctionSymbols{};
+  StringInterner Names{};
 };
 
-extern WyrmContext GlobalContext;
-string_view internedName(std::string &&name);
-
 } // namespace wyrm
 
 #endif // CONTEXT_H
@@ -0,0 +1,88 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include "graph.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/// \brief Frozen directed graph with pointed root in compressed sparse row
+/// form.
+/// Successors and predecessors of all nodes are kept in two contiguous arrays
+/// indexed by per-node offsets, so traversals touch memory sequentially. Node
+/// identifiers are 32-bit.
+class CSRGraph {
+public:
+  using NodeId = std::uint32_t;
+
+  /// \brief Contiguous read-only range of nodes.
+  class NodeRange {
+  public:
+    NodeRange(const NodeId *Begin, const NodeId *End)
+        : Begin{Begin}, End{End} {}
+    const NodeId *begin() const { return Begin; }
+    const NodeId *end() const { return End; }
+    std::size_t size() const { return End - Begin; }
+    bool empty() const { return Begin == End; }
+    NodeId operator[](std::size_t Index) const { return Begin[Index]; }
+
+  private:
+    const NodeId *Begin;
+    const NodeId *End;
+  };
+
+  /// \brief Freeze \p G.
+  /// Successors of every node are sorted, so the form doesn't depend on the
+  /// iteration order of Graph::NodeSet.
+  explicit CSRGraph(const Graph &G);
+
+  /// \brief Build the graph of \p Size nodes from the list of its arcs.
+  /// Duplicate arcs are merged. Nodes without arcs are kept, unlike Graph
+  /// which only has nodes up to the largest arc end.
+  /// \pre No arc leads to the root.
+  CSRGraph(std::size_t Size, std::vector<Arc> Arcs);
+
+  /// \brief Number of nodes in the graph.
+  std::size_t size() const { return SuccOffsets.size() - 1; }
+
+  /// \brief Number of arcs in the graph.
+  std::size_t arcs() const { return Succs.size(); }
+
+  /// \brief Successors of \p Node in ascending order.
+  NodeRange successors(NodeId Node) const {
+    return range(SuccOffsets, Succs, Node);
+  }
+
+  /// \brief Predecessors of \p Node in ascending order.
+  NodeRange predecessors(NodeId Node) const {
+    return range(PredOffsets, Preds, Node);
+  }
+
+  /// \brief Graph nodes reachable from the root listed in DFS order.
+  std::vector<NodeId> DFSOrder() const;
+
+  /// \brief Graph nodes reachable from the root listed in reverse postorder.
+  /// Every node precedes its successors except along back edges.
+  std::vector<NodeId> reversePostOrder() const;
+
+  /// \return If the graph has \p arc
+  bool hasArc(Arc A) const;
+
+  static constexpr NodeId Root = 0;
+  /// \brief Marker of a missing node.
+  static constexpr NodeId NoNode = std::numeric_limits<NodeId>::max();
+
+private:
+  /// \brief Fill predecessor lists from the successor lists.
+  /// \pre PredOffsets keep in-degrees shifted by one node.
+  void buildPredecessors();
+  NodeRange range(const std::vector<NodeId> &Offsets,
+                  const std::vector<NodeId> &Nodes, NodeId Node) const;
+  std::vector<NodeId> SuccOffsets{};
+  std::vector<NodeId> Succs{};
+  std::vector<NodeId> PredOffsets{};
+  std::vector<NodeId> Preds{};
+};
+
+#endif // CSR_GRAPH_H
@@ -1,6 +1,7 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
+#include <cstddef>
 #include <unordered_set>
 #include <vector>
 
@@ -21,6 +22,10 @@ public:
   // Precondition: arc must not be to the root vertex (#0).
   void addArc(Arc arc);
 
+  // \brief Remove \p arc from the graph.
+  // If the arc doesn't exist does nothing. Vertexes are never removed.
+  void removeArc(Arc arc);
+
   // \brief Number of roots in the graph.
   auto size() const { return Data.size(); }
 
@@ -0,0 +1,63 @@
+/// \file
+/// \brief Traversals of rooted graphs.
+/// A graph type provides the NodeId type, the Root node, size() and
+/// successors(NodeId) returning a range of NodeId.
+#ifndef GRAPH_TRAVERSAL_H
+#define GRAPH_TRAVERSAL_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/// \brief Nodes of \p G reachable from the root listed in DFS order.
+template <typename GraphT>
+std::vector<typename GraphT::NodeId> depthFirstOrder(const GraphT &G) {
+  using NodeId = typename GraphT::NodeId;
+  std::vector<NodeId> Result{};
+  Result.reserve(G.size());
+  std::vector<NodeId> Stack{GraphT::Root};
+  std::vector<bool> Visited(G.size());
+  while (!Stack.empty()) {
+    auto CurrentVertex{Stack.back()};
+    Stack.pop_back();
+    if (Visited[CurrentVertex])
+      continue;
+    Result.push_back(CurrentVertex);
+    Visited[CurrentVertex] = true;
+    for (auto Succ : G.successors(CurrentVertex))
+      if (!Visited[Succ])
+        Stack.push_back(Succ);
+  }
+  return Result;
+}
+
+/// \brief Nodes of \p G reachable from the root listed in reverse
+/// postorder. Every node precedes its successors except along back edges.
+template <typename GraphT>
+std::vector<typename GraphT::NodeId> reversePostOrder(const GraphT &G) {
+  using NodeId = typename GraphT::NodeId;
+  std::vector<NodeId> Result{};
+  Result.reserve(G.size());
+  // Node and index of its next successor to visit.
+  std::vector<std::pair<NodeId, NodeId>> Stack{{GraphT::Root, 0}};
+  std::vector<bool> Visited(G.size());
+  Visited[GraphT::Root] = true;
+  while (!Stack.empty()) {
+    auto &[Node, NextSucc] = Stack.back();
+    auto Successors = G.successors(Node);
+    if (NextSucc == Successors.size()) {
+      Result.push_back(Node);
+      Stack.pop_back();
+      continue;
+    }
+    auto Succ = Successors[NextSucc++];
+    if (!Visited[Succ]) {
+      Visited[Succ] = true;
+      Stack.emplace_back(Succ, 0);
+    }
+  }
+  std::reverse(std::begin(Result), std::end(Result));
+  return Result;
+}
+
+#endif // GRAPH_TRAVERSAL_H
@@ -0,0 +1,93 @@
+/// \file
+/// \brief Thread-safe interning of strings.
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include "arena.h"
+#include "compatibility.h"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace wyrm {
+
+/// \brief Set of unique strings identified by 32-bit ids.
+/// The bytes of the strings are copied into arenas, so that interning a new
+/// string doesn't allocate on its own, and the returned ids and views stay
+/// valid until the interner is destroyed.
+/// Strings are distributed among shards by hash. Every shard has its own
+/// lock, so threads interning different strings rarely wait for each other,
+/// and get() takes no lock at all. A hash is computed once per call: tables
+/// keep the hashes of their strings and grow without rehashing strings.
+class StringInterner {
+public:
+  using Id = std::uint32_t;
+  /// Id of the empty string.
+  static constexpr Id EmptyId = 0;
+  StringInterner() = default;
+  StringInterner(const StringInterner &) = delete;
+  StringInterner &operator=(const StringInterner &) = delete;
+  /// \return Id of \p String. The string is added if it's new.
+  Id intern(string_view String);
+  /// \return Id of \p String or nothing if it isn't interned.
+  optional<Id> find(string_view String) const;
+  /// \return String with \p StringId.
+  /// \pre \p StringId was returned by intern() or find() of this interner.
+  string_view get(Id StringId) const {
+    if (StringId == EmptyId)
+      return {};
+    const Id Index = StringId - 1;
+    auto [Segment, Offset] = locate(Index >> ShardBits);
+    return Shards[Index & (NumShards - 1)].Segments[Segment][Offset];
+  }
+  /// \brief Number of interned strings including the empty one.
+  std::size_t size() const;
+
+private:
+  static constexpr unsigned ShardBits = 4;
+  static constexpr std::size_t NumShards = std::size_t{1} << ShardBits;
+  /// Strings of a shard are numbered and kept in segments of growing size,
+  /// so that they never move: segment K has FirstSegmentSize << K strings.
+  static constexpr std::size_t FirstSegmentSize = 64;
+  /// Enough segments for all ids of a shard.
+  static constexpr std::size_t MaxSegments = 23;
+  static constexpr std::uint32_t NoString = ~std::uint32_t{};
+  /// \brief Entry of an open addressing table.
+  struct Slot {
+    std::uint64_t Hash;
+    /// Number of the string in the shard or NoString.
+    std::uint32_t String;
+  };
+  struct alignas(64) Shard {
+    mutable std::mutex Lock;
+    Arena Storage;
+    /// Table of the strings. Its size is zero or a power of two.
+    std::vector<Slot> Table;
+    std::uint32_t Size{};
+    std::array<string_view *, MaxSegments> Segments{};
+  };
+  /// \return Segment containing string \p Index of a shard and position of
+  /// the string in it.
+  static std::pair<std::size_t, std::size_t> locate(std::size_t Index) {
+    const unsigned long long Group = Index / FirstSegmentSize + 1;
+    const std::size_t Segment =
+        std::numeric_limits<unsigned long long>::digits - 1 -
+        __builtin_clzll(Group);
+    return {Segment,
+            Index - FirstSegmentSize * ((std::size_t{1} << Segment) - 1)};
+  }
+  /// \return Position of the slot of \p String in the table of \p S or of
+  /// the empty slot to insert it into.
+  /// \pre The lock of \p S is held and its table isn't empty.
+  static std::size_t lookup(const Shard &S, std::uint64_t Hash,
+                            string_view String);
+  static void grow(Shard &S);
+  std::array<Shard, NumShards> Shards;
+};
+
+} // namespace wyrm
+
+#endif // INTERNER_H
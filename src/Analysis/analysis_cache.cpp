@@ -0,0 +1,98 @@
+#include "Analysis/analysis_cache.h"
+#include "Analysis/dominance.h"
+
+namespace wyrm {
+
+const FunctionCFG &AnalysisCache::cfg() {
+  if (!CFG || CFGStamp != F.cfgVersion()) {
+    dropCFG();
+    CFG.emplace(F);
+    CFGStamp = F.cfgVersion();
+  }
+  return *CFG;
+}
+
+const DominatorTree &AnalysisCache::dominatorTree() {
+  const FunctionCFG &Graph = cfg();
+  if (!DT || DTStamp != F.cfgVersion()) {
+    DT.emplace(immediateDominators(Graph.graph()));
+    DTStamp = F.cfgVersion();
+  }
+  return *DT;
+}
+
+const LoopInfo &AnalysisCache::loops() {
+  const DominatorTree &Tree = dominatorTree();
+  if (!Loops || LoopsStamp != F.cfgVersion()) {
+    Loops.emplace(cfg().graph(), Tree);
+    LoopsStamp = F.cfgVersion();
+  }
+  return *Loops;
+}
+
+const Liveness &AnalysisCache::liveness() {
+  const FunctionCFG &Graph = cfg();
+  if (!Live || LiveStamp != F.version()) {
+    Live.reset();
+    Live.emplace(Graph);
+    LiveStamp = F.version();
+  }
+  return *Live;
+}
+
+void AnalysisCache::startPass() {
+  StartVersion = F.version();
+  StartCFGVersion = F.cfgVersion();
+}
+
+/// \brief Stamp \p Result with \p Version if it's preserved and valid since
+/// \p Start, otherwise drop it if it's outdated.
+/// \return If \p Result is kept.
+template <typename T>
+static bool finish(optional<T> &Result, std::size_t &Stamp, bool Preserved,
+                   std::size_t Start, std::size_t Version) {
+  if (!Result)
+    return false;
+  if (Preserved && Stamp >= Start)
+    Stamp = Version;
+  else if (Stamp != Version)
+    Result.reset();
+  return static_cast<bool>(Result);
+}
+
+void AnalysisCache::finishPass(PreservedAnalyses Preserved) {
+  if (!finish(CFG, CFGStamp, Preserved.preserves(AnalysisKind::CFG),
+              StartCFGVersion, F.cfgVersion())) {
+    dropCFG();
+    return;
+  }
+  finish(DT, DTStamp, Preserved.preserves(AnalysisKind::DominatorTree),
+         StartCFGVersion, F.cfgVersion());
+  finish(Loops, LoopsStamp, Preserved.preserves(AnalysisKind::Loops),
+         StartCFGVersion, F.cfgVersion());
+  finish(Live, LiveStamp, Preserved.preserves(AnalysisKind::Liveness),
+         StartVersion, F.version());
+}
+
+bool AnalysisCache::isCached(AnalysisKind Kind) const {
+  switch (Kind) {
+  case AnalysisKind::CFG:
+    return CFG && CFGStamp == F.cfgVersion();
+  case AnalysisKind::DominatorTree:
+    return DT && DTStamp == F.cfgVersion();
+  case AnalysisKind::Liveness:
+    return Live && LiveStamp == F.version();
+  case AnalysisKind::Loops:
+    return Loops && LoopsStamp == F.cfgVersion();
+  }
+  return false;
+}
+
+void AnalysisCache::dropCFG() {
+  Live.reset();
+  Loops.reset();
+  DT.reset();
+  CFG.reset();
+}
+
+} // namespace wyrm
@@ -0,0 +1,105 @@
+#include "Analysis/cfg.h"
+#include "Analysis/semi_nca.h"
+
+namespace wyrm {
+
+std::vector<BasicBlock *> successors(BasicBlock &BB) {
+  std::vector<BasicBlock *> Result;
+  for (auto Index : BB.successorIndices())
+    Result.push_back(BB.parent().blockAt(Index));
+  return Result;
+}
+
+static std::vector<BasicBlock *> blocksOf(Function &F) {
+  std::vector<BasicBlock *> Blocks;
+  Blocks.reserve(F.size());
+  for (auto &BB : F)
+    Blocks.push_back(&BB);
+  return Blocks;
+}
+
+static std::vector<CSRGraph::NodeId>
+numbersOf(const Function &F, const std::vector<BasicBlock *> &Blocks) {
+  std::vector<CSRGraph::NodeId> Numbers(F.numBlockIndices(), CSRGraph::NoNode);
+  for (CSRGraph::NodeId Node = 0, E = Blocks.size(); Node < E; ++Node)
+    Numbers[Blocks[Node]->index()] = Node;
+  return Numbers;
+}
+
+static std::vector<Arc> arcsOf(const std::vector<BasicBlock *> &Blocks,
+                               const std::vector<CSRGraph::NodeId> &Numbers) {
+  std::vector<Arc> Arcs;
+  for (std::size_t Node = 0, E = Blocks.size(); Node < E; ++Node)
+    for (auto Succ : Blocks[Node]->successorIndices())
+      Arcs.push_back({Node, Numbers[Succ]});
+  return Arcs;
+}
+
+FunctionCFG::FunctionCFG(Function &F)
+    : Blocks{blocksOf(F)}, Numbers{numbersOf(F, Blocks)},
+      Graph{Blocks.size(), arcsOf(Blocks, Numbers)} {}
+
+std::vector<CSRGraph::NodeId> immediateDominators(const FunctionGraph &CFG) {
+  return detail::SemiNCA<FunctionGraph>{CFG}.run();
+}
+
+std::vector<bool> findDominatingDefinitions(const FunctionCFG &CFG,
+                                            const DominatorTree &DT) {
+  using NodeId = CSRGraph::NodeId;
+  if (!CFG.size())
+    return {};
+  const std::size_t NumRegs =
+      CFG.block(0).parent().symbolicRegisters().size();
+  std::vector<unsigned> NumDefs(NumRegs);
+  // Block of the last definition of every register.
+  std::vector<NodeId> DefNode(NumRegs, CSRGraph::NoNode);
+  for (NodeId Node = 0, E = CFG.size(); Node < E; ++Node)
+    for (auto &Inst : CFG.block(Node)) {
+      SymReg *Reg = definedRegister(Inst);
+      if (Reg && Reg->isLocal()) {
+        ++NumDefs[Reg->index()];
+        DefNode[Reg->index()] = Node;
+      }
+    }
+  std::vector<bool> Result(NumRegs);
+  for (std::size_t Index = 0; Index < NumRegs; ++Index)
+    Result[Index] = NumDefs[Index] == 1 && DT.contains(DefNode[Index]);
+
+  // Registers defined in the block being scanned are stamped with its number.
+  std::vector<NodeId> DefinedIn(NumRegs, CSRGraph::NoNode);
+  auto Tracked = [&Result](Value V) -> SymReg * {
+    SymReg *Reg = get<SymReg>(&V);
+    return Reg && Reg->isLocal() && Result[Reg->index()] ? Reg : nullptr;
+  };
+  for (NodeId Node = 0, E = CFG.size(); Node < E; ++Node) {
+    if (!DT.contains(Node))
+      continue;
+    for (auto &Inst : CFG.block(Node)) {
+      if (auto *Phi = get<PhiInst>(&Inst)) {
+        for (std::size_t I = 0, Size = Phi->size(); I < Size; ++I) {
+          SymReg *Reg = Tracked(Phi->incomingValue(I));
+          const NodeId Pred = CFG.number(Phi->incomingBlock(I));
+          if (Reg && DT.contains(Pred) &&
+              !DT.dominates(DefNode[Reg->index()], Pred))
+            Result[Reg->index()] = false;
+        }
+      } else {
+        forEachOperand(Inst, [&](Value V) {
+          SymReg *Reg = Tracked(V);
+          if (!Reg)
+            return;
+          const NodeId Def = DefNode[Reg->index()];
+          if (Def == Node ? DefinedIn[Reg->index()] != Node
+                          : !DT.dominates(Def, Node))
+            Result[Reg->index()] = false;
+        });
+      }
+      SymReg *Reg = definedRegister(Inst);
+      if (Reg && Reg->isLocal())
+        DefinedIn[Reg->index()] = Node;
+    }
+  }
+  return Result;
+}
+
+} // namespace wyrm
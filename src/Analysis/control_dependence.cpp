@@ -0,0 +1,34 @@
+#include "Analysis/control_dependence.h"
+#include <algorithm>
+#include <utility>
+
+namespace wyrm {
+
+ControlDependenceGraph::ControlDependenceGraph(const CSRGraph &CFG,
+                                               const PostDominatorTree &PDT) {
+  const std::size_t Size = CFG.size();
+  // Pairs of a dependent node and its controller.
+  std::vector<std::pair<NodeId, NodeId>> Dependences;
+  for (NodeId Node = 0; Node < Size; ++Node) {
+    // The walk is empty for the only successor of a node unless the node
+    // is also succeeded by the virtual exit.
+    const NodeId Stop = PDT.ipdom(Node);
+    for (auto Succ : CFG.successors(Node))
+      for (NodeId Runner = Succ; Runner != Stop && Runner != CSRGraph::NoNode;
+           Runner = PDT.ipdom(Runner))
+        Dependences.emplace_back(Runner, Node);
+  }
+  std::sort(std::begin(Dependences), std::end(Dependences));
+  Dependences.erase(std::unique(std::begin(Dependences), std::end(Dependences)),
+                    std::end(Dependences));
+  Offsets.assign(Size + 1, 0);
+  Controllers.reserve(Dependences.size());
+  for (auto [Dependent, Controller] : Dependences) {
+    ++Offsets[Dependent + 1];
+    Controllers.push_back(Controller);
+  }
+  for (std::size_t Node = 0; Node < Size; ++Node)
+    Offsets[Node + 1] += Offsets[Node];
+}
+
+} // namespace wyrm
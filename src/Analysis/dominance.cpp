@@ -1,4 +1,6 @@
 #include "Analysis/dominance.h"
+#include "Analysis/semi_nca.h"
+#include "csr_graph.h"
 #include "graph.h"
 #include <algorithm>
 
@@ -23,14 +25,9 @@ static bool intersectSets(std::unordered_set<T> &LHS,
   return IsChanged;
 }
 
-template <typename T>
-std::unordered_set<T> operator-(std::unordered_set<T> LHS, T Elem) {
-  LHS.erase(Elem);
-  return LHS;
-}
-
+template <typename GraphT>
 static bool updateDominators(DominatorMap &DomMap, size_t Predecessor,
-                             const Graph &CFG) {
+                             const GraphT &CFG) {
   bool IsChanged{};
   for (auto Node : CFG.successors(Predecessor)) {
     Graph::NodeSet NS{DomMap[Predecessor]};
@@ -40,8 +37,9 @@ static bool updateDominators(DominatorMap &DomMap, size_t Predecessor,
   return IsChanged;
 }
 
-DominatorMap dominators_slow(const Graph &CFG) {
-  std::vector<size_t> Nodes{CFG.DFSOrder()};
+template <typename GraphT>
+static DominatorMap dominatorsSlowImpl(const GraphT &CFG) {
+  auto Nodes{CFG.DFSOrder()};
   Graph::NodeSet U{std::begin(Nodes), std::end(Nodes)};
   DominatorMap DomMap;
   DomMap[0] = {0};
@@ -56,19 +54,87 @@ DominatorMap dominators_slow(const Graph &CFG) {
   return DomMap;
 }
 
-Graph buildDominatorTree(const Graph &CFG) {
-  std::vector<size_t> Nodes{CFG.DFSOrder()};
-  Graph::NodeSet U{std::begin(Nodes), std::end(Nodes)};
-  DominatorMap DomMap{dominators_slow(CFG)};
-  Graph Result{};
-  for (auto Node : U - Graph::Root)
-    for (auto DomNode : DomMap[Node]) {
-      if (DomMap[DomNode].size() + 1 == DomMap[Node].size()) {
-        Result.addArc({DomNode, Node});
-        break;
-      }
+DominatorMap dominators_slow(const Graph &CFG) {
+  return dominatorsSlowImpl(CFG);
+}
+
+DominatorMap dominators_slow(const CSRGraph &CFG) {
+  return dominatorsSlowImpl(CFG);
+}
+
+DominatorMatrix dominators_dense(const CSRGraph &CFG) {
+  DominatorMatrix Result{CFG.size()};
+  auto RPO = CFG.reversePostOrder();
+  std::vector<bool> IsReachable(CFG.size());
+  for (auto Node : RPO) {
+    IsReachable[Node] = true;
+    std::fill_n(Result.row(Node), Result.RowWords, ~BitWord{});
+  }
+  std::fill_n(Result.row(CSRGraph::Root), Result.RowWords, 0);
+  Result.row(CSRGraph::Root)[0] = 1;
+  bool IsChanged{true};
+  while (IsChanged) {
+    IsChanged = false;
+    for (auto Node : RPO) {
+      if (Node == CSRGraph::Root)
+        continue;
+      // A node always dominates itself. Keep its bit out of the intersection,
+      // so only changes of the other bits are detected.
+      BitWord *Row = Result.row(Node);
+      BitWord &OwnWord = Row[Node / BitWordSize];
+      BitWord OwnBit = BitWord{1} << (Node % BitWordSize);
+      OwnWord &= ~OwnBit;
+      for (auto Pred : CFG.predecessors(Node))
+        if (IsReachable[Pred])
+          IsChanged |= andWords(Row, Result.row(Pred), Result.RowWords);
+      OwnWord |= OwnBit;
     }
+  }
+  return Result;
+}
+
+DominatorMatrix dominators_dense(const Graph &CFG) {
+  return dominators_dense(CSRGraph{CFG});
+}
+
+DominatorMap DominatorMatrix::toDominatorMap() const {
+  DominatorMap Result;
+  for (size_t Node = 0; Node < Size; ++Node) {
+    Graph::NodeSet Dominators;
+    for (size_t Word = 0; Word < RowWords; ++Word)
+      for (BitWord Bits = row(Node)[Word]; Bits; Bits &= Bits - 1)
+        Dominators.insert(Word * BitWordSize + __builtin_ctzll(Bits));
+    if (!Dominators.empty())
+      Result[Node] = std::move(Dominators);
+  }
+  return Result;
+}
+
+
+std::vector<CSRGraph::NodeId> immediateDominators(const CSRGraph &CFG) {
+  return detail::SemiNCA<CSRGraph>{CFG}.run();
+}
+
+std::vector<size_t> immediateDominators(const Graph &CFG) {
+  auto IDoms = immediateDominators(CSRGraph{CFG});
+  std::vector<size_t> Result(IDoms.size(), NoNode);
+  for (size_t Node = 0, E = IDoms.size(); Node < E; ++Node)
+    if (IDoms[Node] != CSRGraph::NoNode)
+      Result[Node] = IDoms[Node];
   return Result;
 }
 
+Graph buildDominatorTree(const CSRGraph &CFG) {
+  auto IDoms = immediateDominators(CFG);
+  Graph Result{};
+  for (CSRGraph::NodeId Node = 0, E = IDoms.size(); Node < E; ++Node)
+    if (Node != CSRGraph::Root && IDoms[Node] != CSRGraph::NoNode)
+      Result.addArc({IDoms[Node], Node});
+  return Result;
+}
+
+Graph buildDominatorTree(const Graph &CFG) {
+  return buildDominatorTree(CSRGraph{CFG});
+}
+
 } // namespace wyrm
@@ -0,0 +1,90 @@
+#include "Analysis/dominance_frontier.h"
+#include <algorithm>
+
+namespace wyrm {
+
+DominanceFrontier::DominanceFrontier(const CSRGraph &CFG,
+                                     const DominatorTree &DT) {
+  const std::size_t N{CFG.size()};
+  std::vector<std::pair<NodeId, NodeId>> Pairs;
+  for (NodeId Node = 0; Node < N; ++Node) {
+    auto Preds = CFG.predecessors(Node);
+    if (Preds.size() < 2 || !DT.contains(Node))
+      continue;
+    const NodeId IDom = DT.idom(Node);
+    for (auto Runner : Preds) {
+      if (!DT.contains(Runner))
+        continue;
+      for (; Runner != IDom; Runner = DT.idom(Runner))
+        Pairs.emplace_back(Runner, Node);
+    }
+  }
+  std::sort(std::begin(Pairs), std::end(Pairs));
+  Pairs.erase(std::unique(std::begin(Pairs), std::end(Pairs)), std::end(Pairs));
+  Offsets.assign(N + 1, 0);
+  Frontiers.reserve(Pairs.size());
+  for (auto [Node, Frontier] : Pairs) {
+    ++Offsets[Node + 1];
+    Frontiers.push_back(Frontier);
+  }
+  for (NodeId Node = 0; Node < N; ++Node)
+    Offsets[Node + 1] += Offsets[Node];
+}
+
+IDFCalculator::IDFCalculator(const CSRGraph &CFG, const DominatorTree &DT)
+    : CFG{CFG}, DT{DT}, InQueue(CFG.size()), InFrontier(CFG.size()),
+      Visited(CFG.size()) {}
+
+auto IDFCalculator::calculate(const std::vector<NodeId> &DefNodes)
+    -> std::vector<NodeId> {
+  std::vector<NodeId> Result, Touched, Worklist;
+  auto Enqueue = [this, &Touched](NodeId Node) {
+    unsigned Depth{DT.depth(Node)};
+    if (Buckets.size() <= Depth)
+      Buckets.resize(Depth + 1);
+    Buckets[Depth].push_back(Node);
+    InQueue[Node] = true;
+    Touched.push_back(Node);
+  };
+  for (auto Node : DefNodes)
+    if (DT.contains(Node) && !InQueue[Node])
+      Enqueue(Node);
+  // Newly queued nodes are never deeper than the current root, so the bucket
+  // cursor only moves up.
+  for (std::size_t Level = Buckets.size(); Level-- > 0;) {
+    while (!Buckets[Level].empty()) {
+      NodeId Root = Buckets[Level].back();
+      Buckets[Level].pop_back();
+      Worklist.push_back(Root);
+      Visited[Root] = true;
+      Touched.push_back(Root);
+      while (!Worklist.empty()) {
+        NodeId Node = Worklist.back();
+        Worklist.pop_back();
+        for (auto Succ : CFG.successors(Node)) {
+          // Dominator tree arcs never lead to the frontier.
+          if (DT.idom(Succ) == Node || DT.depth(Succ) > Level ||
+              InFrontier[Succ])
+            continue;
+          InFrontier[Succ] = true;
+          Touched.push_back(Succ);
+          Result.push_back(Succ);
+          if (!InQueue[Succ])
+            Enqueue(Succ);
+        }
+        for (auto Child : DT.children(Node))
+          if (!Visited[Child]) {
+            Visited[Child] = true;
+            Touched.push_back(Child);
+            Worklist.push_back(Child);
+          }
+      }
+    }
+  }
+  for (auto Node : Touched)
+    InQueue[Node] = InFrontier[Node] = Visited[Node] = false;
+  std::sort(std::begin(Result), std::end(Result));
+  return Result;
+}
+
+} // namespace wyrm
@@ -0,0 +1,95 @@
+#include "Analysis/dominator_tree.h"
+#include <algorithm>
+
+namespace wyrm {
+
+DominatorTree::DominatorTree(const Graph &Tree)
+    : IDom(Tree.size(), CSRGraph::NoNode) {
+  IDom[Root] = Root;
+  for (std::size_t Node = 0, E = Tree.size(); Node < E; ++Node)
+    for (auto Child : Tree.successors(Node))
+      IDom[Child] = Node;
+  build();
+}
+
+DominatorTree::DominatorTree(const std::vector<NodeId> &IDoms) : IDom{IDoms} {
+  assert(!IDom.empty() && IDom[Root] == Root && "Malformed dominator tree");
+  build();
+}
+
+void DominatorTree::build() {
+  const std::size_t N{size()};
+  ChildOffsets.assign(N + 1, 0);
+  for (NodeId Node = 0; Node < N; ++Node)
+    if (Node != Root && contains(Node))
+      ++ChildOffsets[IDom[Node] + 1];
+  for (NodeId Node = 0; Node < N; ++Node)
+    ChildOffsets[Node + 1] += ChildOffsets[Node];
+  Children.resize(ChildOffsets[N]);
+  // Nodes are visited in ascending order, so children come out sorted.
+  std::vector<NodeId> Cursor{std::cbegin(ChildOffsets),
+                             std::prev(std::cend(ChildOffsets))};
+  for (NodeId Node = 0; Node < N; ++Node)
+    if (Node != Root && contains(Node))
+      Children[Cursor[IDom[Node]]++] = Node;
+
+  Depth.assign(N, 0);
+  In.assign(N, CSRGraph::NoNode);
+  Out.assign(N, CSRGraph::NoNode);
+  Order.reserve(Children.size() + 1);
+  std::vector<NodeId> Stack{Root};
+  while (!Stack.empty()) {
+    NodeId Node = Stack.back();
+    Stack.pop_back();
+    In[Node] = Order.size();
+    Order.push_back(Node);
+    auto NodeChildren = children(Node);
+    for (auto It = NodeChildren.end(); It != NodeChildren.begin();) {
+      --It;
+      Depth[*It] = Depth[Node] + 1;
+      Stack.push_back(*It);
+    }
+  }
+  // A subtree ends right before the subtree of the next sibling, so compute
+  // the ends bottom-up in reverse preorder.
+  for (auto It = Order.rbegin(), E = Order.rend(); It != E; ++It) {
+    auto NodeChildren = children(*It);
+    Out[*It] = NodeChildren.empty() ? In[*It]
+                                    : Out[*std::prev(NodeChildren.end())];
+  }
+
+  const std::size_t Size{Order.size()};
+  SparseTable.emplace_back(Size);
+  for (NodeId Num = 0; Num < Size; ++Num)
+    SparseTable[0][Num] = Num;
+  for (std::size_t Level = 1; (std::size_t{1} << Level) <= Size; ++Level) {
+    const auto &Prev = SparseTable[Level - 1];
+    const std::size_t Half{std::size_t{1} << (Level - 1)};
+    std::vector<NodeId> Current(Size - 2 * Half + 1);
+    for (std::size_t Num = 0, E = Current.size(); Num < E; ++Num) {
+      NodeId Left = Prev[Num], Right = Prev[Num + Half];
+      Current[Num] = Depth[Order[Right]] < Depth[Order[Left]] ? Right : Left;
+    }
+    SparseTable.push_back(std::move(Current));
+  }
+}
+
+auto DominatorTree::shallowest(NodeId First, NodeId Last) const -> NodeId {
+  unsigned Level = 31 - __builtin_clz(Last - First + 1);
+  NodeId Left = SparseTable[Level][First];
+  NodeId Right = SparseTable[Level][Last - (1u << Level) + 1];
+  return Depth[Order[Right]] < Depth[Order[Left]] ? Right : Left;
+}
+
+auto DominatorTree::nearestCommonDominator(NodeId A, NodeId B) const
+    -> NodeId {
+  assert(contains(A) && contains(B) && "Nodes must be reachable");
+  if (A == B)
+    return A;
+  NodeId First = std::min(In[A], In[B]), Last = std::max(In[A], In[B]);
+  // The shallowest node after the first one in preorder up to the last one
+  // is a child of the common dominator on the path to the last node.
+  return IDom[Order[shallowest(First + 1, Last)]];
+}
+
+} // namespace wyrm
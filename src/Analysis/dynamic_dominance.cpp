@@ -0,0 +1,310 @@
+#include "Analysis/dynamic_dominance.h"
+#include "Analysis/dominance.h"
+#include <algorithm>
+#include <cassert>
+#include <queue>
+#include <unordered_map>
+
+namespace wyrm {
+
+DynamicDominatorTree::DynamicDominatorTree(Graph &CFG) : CFG{CFG} {
+  grow(CFG.size());
+  for (size_t Node = 0, E = CFG.size(); Node < E; ++Node)
+    for (auto Succ : CFG.successors(Node))
+      Preds[Succ].push_back(Node);
+  recalculate();
+}
+
+void DynamicDominatorTree::grow(size_t Size) {
+  if (Size <= IDom.size())
+    return;
+  Preds.resize(Size);
+  IDom.resize(Size, NoNode);
+  Depth.resize(Size);
+  Children.resize(Size);
+  Marked.resize(Size);
+}
+
+void DynamicDominatorTree::recalculate() {
+  IDom = immediateDominators(CFG);
+  for (auto &NodeChildren : Children)
+    NodeChildren.clear();
+  for (size_t Node = 0, E = IDom.size(); Node < E; ++Node)
+    if (Node != Graph::Root && IDom[Node] != NoNode)
+      Children[IDom[Node]].push_back(Node);
+  updateDepths(Graph::Root);
+}
+
+bool DynamicDominatorTree::addArc(Arc A) {
+  if (CFG.hasArc(A))
+    return false;
+  CFG.addArc(A);
+  grow(CFG.size());
+  Preds[A.To].push_back(A.From);
+  return true;
+}
+
+bool DynamicDominatorTree::removeArc(Arc A) {
+  if (!CFG.hasArc(A))
+    return false;
+  CFG.removeArc(A);
+  auto &ToPreds = Preds[A.To];
+  ToPreds.erase(std::find(std::begin(ToPreds), std::end(ToPreds), A.From));
+  return true;
+}
+
+void DynamicDominatorTree::insertArc(Arc A) {
+  if (!addArc(A))
+    return;
+  if (isReachable(A.From)) {
+    if (isReachable(A.To))
+      insertReachable(A.From, A.To);
+    else
+      insertUnreachable(A.From, A.To);
+  }
+  assert((!VerifyUpdates || verify()) && "Dominator tree is broken");
+}
+
+void DynamicDominatorTree::deleteArc(Arc A) {
+  if (!removeArc(A))
+    return;
+  // The arc doesn't affect dominance if its source is unreachable or the
+  // destination dominates the source.
+  if (isReachable(A.From) && nearestCommonDominator(A.From, A.To) != A.To) {
+    if (IDom[A.To] != A.From || hasProperSupport(A.To))
+      deleteReachable(A.From, A.To);
+    else
+      deleteUnreachable(A.To);
+  }
+  assert((!VerifyUpdates || verify()) && "Dominator tree is broken");
+}
+
+void DynamicDominatorTree::applyUpdates(const std::vector<CFGUpdate> &Updates) {
+  // Follow LLVM: rebuilding is cheaper once a batch touches more than 1/40
+  // of the nodes.
+  if (Updates.size() <= CFG.size() / 40) {
+    for (auto Update : Updates)
+      if (Update.Kind == CFGUpdate::Insert)
+        insertArc(Update.TheArc);
+      else
+        deleteArc(Update.TheArc);
+    return;
+  }
+  for (auto Update : Updates)
+    if (Update.Kind == CFGUpdate::Insert)
+      addArc(Update.TheArc);
+    else
+      removeArc(Update.TheArc);
+  recalculate();
+  assert((!VerifyUpdates || verify()) && "Dominator tree is broken");
+}
+
+bool DynamicDominatorTree::dominates(size_t A, size_t B) const {
+  if (!isReachable(A) || !isReachable(B))
+    return false;
+  while (Depth[B] > Depth[A])
+    B = IDom[B];
+  return A == B;
+}
+
+size_t DynamicDominatorTree::nearestCommonDominator(size_t A, size_t B) const {
+  assert(isReachable(A) && isReachable(B) && "Nodes must be reachable");
+  while (A != B) {
+    if (Depth[A] < Depth[B])
+      std::swap(A, B);
+    A = IDom[A];
+  }
+  return A;
+}
+
+Graph DynamicDominatorTree::tree() const {
+  Graph Result{};
+  for (size_t Node = 0, E = IDom.size(); Node < E; ++Node)
+    if (Node != Graph::Root && IDom[Node] != NoNode)
+      Result.addArc({IDom[Node], Node});
+  return Result;
+}
+
+bool DynamicDominatorTree::verify() const {
+  Graph Expected{buildDominatorTree(CFG)};
+  Graph Actual{tree()};
+  if (Expected.size() != Actual.size())
+    return false;
+  for (size_t Node = 0, E = Expected.size(); Node < E; ++Node)
+    if (Expected.successors(Node) != Actual.successors(Node))
+      return false;
+  for (size_t Node = 0, E = IDom.size(); Node < E; ++Node)
+    if (Node != Graph::Root && IDom[Node] != NoNode &&
+        Depth[Node] != Depth[IDom[Node]] + 1)
+      return false;
+  return true;
+}
+
+void DynamicDominatorTree::setIDom(size_t Node, size_t NewIDom) {
+  size_t OldIDom = IDom[Node];
+  if (OldIDom == NewIDom)
+    return;
+  if (OldIDom != NoNode) {
+    auto &Siblings = Children[OldIDom];
+    Siblings.erase(std::find(std::begin(Siblings), std::end(Siblings), Node));
+  }
+  IDom[Node] = NewIDom;
+  if (NewIDom != NoNode)
+    Children[NewIDom].push_back(Node);
+}
+
+void DynamicDominatorTree::updateDepths(size_t Top) {
+  std::vector<size_t> Stack{Top};
+  while (!Stack.empty()) {
+    size_t Node = Stack.back();
+    Stack.pop_back();
+    for (auto Child : Children[Node]) {
+      Depth[Child] = Depth[Node] + 1;
+      Stack.push_back(Child);
+    }
+  }
+}
+
+std::vector<size_t> DynamicDominatorTree::subtree(size_t Top) const {
+  std::vector<size_t> Result{Top};
+  for (size_t I = 0; I < Result.size(); ++I)
+    for (auto Child : Children[Result[I]])
+      Result.push_back(Child);
+  return Result;
+}
+
+void DynamicDominatorTree::insertReachable(size_t From, size_t To) {
+  const size_t NCD = nearestCommonDominator(From, To);
+  const size_t NCDDepth = Depth[NCD];
+  if (Depth[To] <= NCDDepth + 1)
+    return;
+  // Nodes are affected if they can be reached from To through nodes deeper
+  // than NCD + 1. They are processed deepest first; a search descends through
+  // nodes deeper than the current one without marking them as affected.
+  std::priority_queue<std::pair<size_t, size_t>> Bucket;
+  std::vector<size_t> Affected, Visited{To}, Deeper;
+  Bucket.emplace(Depth[To], To);
+  Marked[To] = true;
+  while (!Bucket.empty()) {
+    size_t Node = Bucket.top().second;
+    Bucket.pop();
+    Affected.push_back(Node);
+    const size_t CurrentDepth = Depth[Node];
+    while (true) {
+      for (auto Succ : CFG.successors(Node)) {
+        if (!isReachable(Succ) || Marked[Succ] || Depth[Succ] <= NCDDepth + 1)
+          continue;
+        Marked[Succ] = true;
+        Visited.push_back(Succ);
+        if (Depth[Succ] > CurrentDepth)
+          Deeper.push_back(Succ);
+        else
+          Bucket.emplace(Depth[Succ], Succ);
+      }
+      if (Deeper.empty())
+        break;
+      Node = Deeper.back();
+      Deeper.pop_back();
+    }
+  }
+  for (auto Node : Visited)
+    Marked[Node] = false;
+  for (auto Node : Affected) {
+    setIDom(Node, NCD);
+    Depth[Node] = NCDDepth + 1;
+    updateDepths(Node);
+  }
+}
+
+void DynamicDominatorTree::insertUnreachable(size_t From, size_t To) {
+  // Collect nodes which become reachable through the new arc and number them
+  // from To.
+  std::vector<size_t> Region{To};
+  std::unordered_map<size_t, size_t> LocalId{{To, 0}};
+  std::vector<Arc> ArcsToReachable;
+  for (size_t I = 0; I < Region.size(); ++I)
+    for (auto Succ : CFG.successors(Region[I])) {
+      if (isReachable(Succ))
+        ArcsToReachable.push_back({Region[I], Succ});
+      else if (LocalId.emplace(Succ, Region.size()).second)
+        Region.push_back(Succ);
+    }
+  Graph Local{};
+  for (auto Node : Region)
+    for (auto Succ : CFG.successors(Node)) {
+      auto It = LocalId.find(Succ);
+      if (It != std::end(LocalId) && It->second != Graph::Root)
+        Local.addArc({LocalId[Node], It->second});
+    }
+  auto LocalIDoms = immediateDominators(Local);
+  setIDom(To, From);
+  for (size_t I = 1; I < Region.size(); ++I)
+    setIDom(Region[I], Region[LocalIDoms[I]]);
+  Depth[To] = Depth[From] + 1;
+  updateDepths(To);
+  // The region is attached now, arcs from it to the rest of the tree are
+  // ordinary insertions.
+  for (auto A : ArcsToReachable)
+    insertReachable(A.From, A.To);
+}
+
+bool DynamicDominatorTree::hasProperSupport(size_t Node) const {
+  for (auto Pred : Preds[Node])
+    if (isReachable(Pred) && nearestCommonDominator(Pred, Node) != Node)
+      return true;
+  return false;
+}
+
+void DynamicDominatorTree::deleteReachable(size_t From, size_t To) {
+  rebuildSubtree(nearestCommonDominator(From, To));
+}
+
+void DynamicDominatorTree::deleteUnreachable(size_t To) {
+  // To has lost its last path from the root, so does everything it dominates.
+  auto Lost = subtree(To);
+  for (auto Node : Lost)
+    Marked[Node] = true;
+  // Nodes which were reachable through the lost subtree may get deeper
+  // dominators. All of them are dominated by the shallowest common dominator
+  // of To and the arc destinations.
+  size_t Top = NoNode;
+  for (auto Node : Lost)
+    for (auto Succ : CFG.successors(Node)) {
+      if (Marked[Succ] || !isReachable(Succ))
+        continue;
+      size_t NCD = nearestCommonDominator(Succ, To);
+      if (Top == NoNode || Depth[NCD] < Depth[Top])
+        Top = NCD;
+    }
+  for (auto Node : Lost)
+    Marked[Node] = false;
+  for (auto It = Lost.rbegin(), E = Lost.rend(); It != E; ++It)
+    setIDom(*It, NoNode);
+  if (Top != NoNode)
+    rebuildSubtree(Top);
+}
+
+void DynamicDominatorTree::rebuildSubtree(size_t Top) {
+  // Every path from the root to a node of the subtree passes Top and never
+  // leaves the subtree after that, so the subgraph induced by the subtree is
+  // enough to find the new immediate dominators.
+  auto Nodes = subtree(Top);
+  std::unordered_map<size_t, size_t> LocalId;
+  for (size_t I = 0, E = Nodes.size(); I < E; ++I)
+    LocalId[Nodes[I]] = I;
+  Graph Local{};
+  for (auto Node : Nodes)
+    for (auto Succ : CFG.successors(Node)) {
+      auto It = LocalId.find(Succ);
+      if (It != std::end(LocalId) && It->second != Graph::Root)
+        Local.addArc({LocalId[Node], It->second});
+    }
+  auto LocalIDoms = immediateDominators(Local);
+  for (size_t I = 1, E = Nodes.size(); I < E; ++I) {
+    bool IsReachable = I < LocalIDoms.size() && LocalIDoms[I] != NoNode;
+    setIDom(Nodes[I], IsReachable ? Nodes[LocalIDoms[I]] : NoNode);
+  }
+  updateDepths(Top);
+}
+
+} // namespace wyrm
@@ -0,0 +1,41 @@
+#include "Analysis/liveness.h"
+
+namespace wyrm {
+
+void Liveness::Problem::summarize(CSRGraph::NodeId Node,
+                                  BlockSummary &Summary) const {
+  BasicBlock &BB = CFG.block(Node);
+  for (Instruction &Inst : BB) {
+    // Phi operands are used in the predecessors.
+    if (!get<PhiInst>(&Inst))
+      forEachOperand(Inst, [&Summary](Value V) {
+        SymReg *Reg = get<SymReg>(&V);
+        if (Reg && Reg->isLocal() && !Summary.Kill.test(Reg->index()))
+          Summary.Gen.set(Reg->index());
+      });
+    SymReg *Reg = definedRegister(Inst);
+    if (Reg && Reg->isLocal())
+      Summary.Kill.set(Reg->index());
+  }
+  for (auto Succ : CFG.graph().successors(Node))
+    for (Instruction &Inst : CFG.block(Succ)) {
+      auto *Phi = get<PhiInst>(&Inst);
+      if (!Phi)
+        break;
+      for (std::size_t I = 0, E = Phi->size(); I != E; ++I) {
+        Value V = Phi->incomingValue(I);
+        SymReg *Reg = get<SymReg>(&V);
+        if (&Phi->incomingBlock(I) == &BB && Reg && Reg->isLocal())
+          Summary.MeetGen.set(Reg->index());
+      }
+    }
+}
+
+Liveness::Liveness(const FunctionCFG &CFG)
+    : CFG{CFG}, TheProblem{CFG, 0}, Solver{CFG.graph(), TheProblem} {
+  if (CFG.size())
+    TheProblem.NumRegs = CFG.block(0).parent().symbolicRegisters().size();
+  Solver.solve();
+}
+
+} // namespace wyrm
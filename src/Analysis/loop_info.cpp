@@ -0,0 +1,261 @@
+#include "Analysis/loop_info.h"
+#include <algorithm>
+#include <utility>
+
+namespace wyrm {
+
+namespace {
+/// \brief Loops as they are found: innermost first, with the outermost loop
+/// found so far for every loop kept in a union-find forest.
+struct LoopDiscovery {
+  using NodeId = CSRGraph::NodeId;
+  using LoopId = LoopInfo::LoopId;
+  static constexpr LoopId NoLoop = LoopInfo::NoLoop;
+  LoopDiscovery(const CSRGraph &CFG, const DominatorTree &DT);
+  /// \return The outermost loop found so far which contains \p Loop.
+  LoopId outermost(LoopId Loop);
+  std::vector<LoopId> InnermostLoop;
+  std::vector<NodeId> Headers{};
+  std::vector<LoopId> Parents{};
+  /// Union-find links towards the outermost loops.
+  std::vector<LoopId> Outer{};
+  std::vector<std::pair<LoopId, NodeId>> Latches{};
+};
+
+LoopDiscovery::LoopDiscovery(const CSRGraph &CFG, const DominatorTree &DT)
+    : InnermostLoop(CFG.size(), NoLoop) {
+  std::vector<NodeId> Worklist;
+  // Inner loop headers are dominated by the headers of the outer loops, so
+  // walking the dominator tree bottom up finds inner loops first.
+  auto Preorder = DT.preorder();
+  for (auto It = std::end(Preorder); It != std::begin(Preorder);) {
+    const NodeId Header = *--It;
+    for (auto Pred : CFG.predecessors(Header))
+      if (DT.dominates(Header, Pred))
+        Worklist.push_back(Pred);
+    if (Worklist.empty())
+      continue;
+    const auto Loop = static_cast<LoopId>(Headers.size());
+    Headers.push_back(Header);
+    Parents.push_back(NoLoop);
+    Outer.push_back(Loop);
+    for (auto Latch : Worklist)
+      Latches.emplace_back(Loop, Latch);
+    InnermostLoop[Header] = Loop;
+    while (!Worklist.empty()) {
+      const NodeId Node = Worklist.back();
+      Worklist.pop_back();
+      if (InnermostLoop[Node] == NoLoop) {
+        InnermostLoop[Node] = Loop;
+        // Unreachable nodes can't be in a loop even if they reach it.
+        for (auto Pred : CFG.predecessors(Node))
+          if (DT.contains(Pred))
+            Worklist.push_back(Pred);
+        continue;
+      }
+      // Step over the subloop to the predecessors of its header outside it.
+      const LoopId Subloop = outermost(InnermostLoop[Node]);
+      if (Subloop == Loop)
+        continue;
+      Parents[Subloop] = Outer[Subloop] = Loop;
+      const NodeId SubHeader = Headers[Subloop];
+      for (auto Pred : CFG.predecessors(SubHeader))
+        if (DT.contains(Pred) && !DT.dominates(SubHeader, Pred))
+          Worklist.push_back(Pred);
+    }
+  }
+}
+
+auto LoopDiscovery::outermost(LoopId Loop) -> LoopId {
+  while (Outer[Loop] != Loop) {
+    Outer[Loop] = Outer[Outer[Loop]];
+    Loop = Outer[Loop];
+  }
+  return Loop;
+}
+} // namespace
+
+/// \brief Group \p Pairs by their first element into CSR form with
+/// \p NumGroups groups. Items of a group are sorted and unique.
+static void groupPairs(std::vector<std::pair<LoopInfo::LoopId,
+                                             CSRGraph::NodeId>> &Pairs,
+                       std::size_t NumGroups,
+                       std::vector<CSRGraph::NodeId> &Offsets,
+                       std::vector<CSRGraph::NodeId> &Items) {
+  std::sort(std::begin(Pairs), std::end(Pairs));
+  Pairs.erase(std::unique(std::begin(Pairs), std::end(Pairs)),
+              std::end(Pairs));
+  Offsets.assign(NumGroups + 1, 0);
+  Items.reserve(Pairs.size());
+  for (auto [Group, Item] : Pairs) {
+    ++Offsets[Group + 1];
+    Items.push_back(Item);
+  }
+  for (std::size_t Group = 0; Group < NumGroups; ++Group)
+    Offsets[Group + 1] += Offsets[Group];
+}
+
+LoopInfo::LoopInfo(const CSRGraph &CFG, const DominatorTree &DT,
+                   bool FindIrreducible) {
+  LoopDiscovery Found{CFG, DT};
+  const std::size_t NumLoops = Found.Headers.size();
+  const std::size_t NumNodes = CFG.size();
+  // Number the loops in preorder of the forest. Siblings are ordered by
+  // their headers, so the numbering doesn't depend on the discovery order.
+  std::vector<std::vector<LoopId>> Children(NumLoops);
+  std::vector<LoopId> Roots;
+  for (LoopId Loop = 0; Loop < NumLoops; ++Loop)
+    (Found.Parents[Loop] == NoLoop ? Roots : Children[Found.Parents[Loop]])
+        .push_back(Loop);
+  auto ByHeader = [&Found](LoopId A, LoopId B) {
+    return Found.Headers[A] < Found.Headers[B];
+  };
+  std::vector<LoopId> NewId(NumLoops);
+  Headers.resize(NumLoops);
+  Parents.resize(NumLoops);
+  Depths.resize(NumLoops);
+  LoopEnd.resize(NumLoops);
+  // Loops on the path from a root and the number of their visited children.
+  std::vector<std::pair<LoopId, std::size_t>> Stack;
+  std::sort(std::begin(Roots), std::end(Roots), ByHeader);
+  LoopId Next = 0;
+  for (LoopId Root : Roots) {
+    Stack.emplace_back(Root, 0);
+    while (!Stack.empty()) {
+      auto &[Loop, Visited] = Stack.back();
+      if (!Visited) {
+        const LoopId Id = NewId[Loop] = Next++;
+        const LoopId Parent = Found.Parents[Loop];
+        Headers[Id] = Found.Headers[Loop];
+        Parents[Id] = Parent == NoLoop ? NoLoop : NewId[Parent];
+        Depths[Id] = Parent == NoLoop ? 1 : Depths[NewId[Parent]] + 1;
+        std::sort(std::begin(Children[Loop]), std::end(Children[Loop]),
+                  ByHeader);
+      }
+      if (Visited == Children[Loop].size()) {
+        LoopEnd[NewId[Loop]] = Next;
+        Stack.pop_back();
+        continue;
+      }
+      const LoopId Child = Children[Loop][Visited++];
+      Stack.emplace_back(Child, 0);
+    }
+  }
+  for (LoopId Root : Roots)
+    TopLevel.push_back(NewId[Root]);
+  std::vector<std::pair<LoopId, NodeId>> Nested;
+  for (LoopId Loop = 0; Loop < NumLoops; ++Loop)
+    if (Parents[Loop] != NoLoop)
+      Nested.emplace_back(Parents[Loop], Loop);
+  groupPairs(Nested, NumLoops, SubloopOffsets, Subloops);
+
+  // Nodes of every loop itself in the order of loops, header first, so the
+  // nodes of the subloops follow.
+  InnermostLoop.assign(NumNodes, NoLoop);
+  BlockBegin.assign(NumLoops + 1, 0);
+  for (NodeId Node = 0; Node < NumNodes; ++Node)
+    if (Found.InnermostLoop[Node] != NoLoop) {
+      InnermostLoop[Node] = NewId[Found.InnermostLoop[Node]];
+      ++BlockBegin[InnermostLoop[Node] + 1];
+    }
+  for (LoopId Loop = 0; Loop < NumLoops; ++Loop)
+    BlockBegin[Loop + 1] += BlockBegin[Loop];
+  Blocks.resize(BlockBegin[NumLoops]);
+  Position.assign(NumNodes, 0);
+  std::vector<NodeId> Cursor{std::begin(BlockBegin), std::end(BlockBegin)};
+  for (LoopId Loop = 0; Loop < NumLoops; ++Loop)
+    Position[Headers[Loop]] = Cursor[Loop]++;
+  for (NodeId Node = 0; Node < NumNodes; ++Node) {
+    const LoopId Loop = InnermostLoop[Node];
+    if (Loop != NoLoop && Headers[Loop] != Node)
+      Position[Node] = Cursor[Loop]++;
+  }
+  for (NodeId Node = 0; Node < NumNodes; ++Node)
+    if (InnermostLoop[Node] != NoLoop)
+      Blocks[Position[Node]] = Node;
+  BlockEnd.resize(NumLoops);
+  for (LoopId Loop = 0; Loop < NumLoops; ++Loop)
+    BlockEnd[Loop] = BlockBegin[LoopEnd[Loop]];
+  BlockBegin.pop_back();
+
+  for (auto &[Loop, Latch] : Found.Latches)
+    Loop = NewId[Loop];
+  groupPairs(Found.Latches, NumLoops, LatchOffsets, Latches);
+  findExits(CFG);
+  if (FindIrreducible)
+    findIrreducible(CFG, DT);
+}
+
+void LoopInfo::findExits(const CSRGraph &CFG) {
+  // An arc leaves the loops containing its source up to the innermost loop
+  // containing its target, so the work is linear in the number of exits.
+  std::vector<std::pair<LoopId, NodeId>> Pairs;
+  for (NodeId Node = 0, E = numNodes(); Node < E; ++Node)
+    if (InnermostLoop[Node] != NoLoop)
+      for (auto Succ : CFG.successors(Node))
+        for (LoopId Loop = InnermostLoop[Node];
+             Loop != NoLoop && !contains(Loop, Succ); Loop = Parents[Loop])
+          Pairs.emplace_back(Loop, Succ);
+  groupPairs(Pairs, size(), ExitOffsets, Exits);
+}
+
+void LoopInfo::findIrreducible(const CSRGraph &CFG, const DominatorTree &DT) {
+  const std::size_t NumNodes = numNodes();
+  // Strongly connected components of the reachable part of the CFG without
+  // back edges found with Tarjan's algorithm. A component of more than one
+  // node is a cycle without a header dominating it.
+  auto IsForward = [&DT](NodeId From, NodeId To) {
+    return DT.contains(To) && !DT.dominates(To, From);
+  };
+  std::vector<NodeId> Index(NumNodes, CSRGraph::NoNode), LowLink(NumNodes);
+  std::vector<bool> OnStack(NumNodes);
+  std::vector<NodeId> Component;
+  // Node and index of its next successor to visit.
+  std::vector<std::pair<NodeId, NodeId>> Stack;
+  Irreducible.assign(NumNodes, false);
+  NodeId NextIndex = 0;
+  for (auto Start : DT.preorder()) {
+    if (Index[Start] != CSRGraph::NoNode)
+      continue;
+    Stack.emplace_back(Start, 0);
+    Index[Start] = LowLink[Start] = NextIndex++;
+    Component.push_back(Start);
+    OnStack[Start] = true;
+    while (!Stack.empty()) {
+      auto &[Node, NextSucc] = Stack.back();
+      auto Successors = CFG.successors(Node);
+      if (NextSucc < Successors.size()) {
+        const NodeId Succ = Successors[NextSucc++];
+        if (!IsForward(Node, Succ))
+          continue;
+        if (Index[Succ] == CSRGraph::NoNode) {
+          Index[Succ] = LowLink[Succ] = NextIndex++;
+          Component.push_back(Succ);
+          OnStack[Succ] = true;
+          Stack.emplace_back(Succ, 0);
+        } else if (OnStack[Succ]) {
+          LowLink[Node] = std::min(LowLink[Node], Index[Succ]);
+        }
+        continue;
+      }
+      const NodeId Done = Node;
+      Stack.pop_back();
+      if (!Stack.empty())
+        LowLink[Stack.back().first] =
+            std::min(LowLink[Stack.back().first], LowLink[Done]);
+      if (LowLink[Done] != Index[Done])
+        continue;
+      const bool IsCycle = Component.back() != Done;
+      NodeId Member;
+      do {
+        Member = Component.back();
+        Component.pop_back();
+        OnStack[Member] = false;
+        Irreducible[Member] = IsCycle;
+        NumIrreducible += IsCycle;
+      } while (Member != Done);
+    }
+  }
+}
+
+} // namespace wyrm
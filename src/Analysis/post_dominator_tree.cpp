@@ -0,0 +1,58 @@
+#include "Analysis/post_dominator_tree.h"
+#include "Analysis/dominance.h"
+#include <algorithm>
+
+namespace wyrm {
+
+/// \brief Reversed \p CFG with a virtual exit as node 0 succeeded by
+/// \p Exits.
+/// \param Exits Filled with the nodes without successors and one node of
+/// every region reaching none.
+static CSRGraph reverseWithExit(const CSRGraph &CFG,
+                                std::vector<CSRGraph::NodeId> &Exits) {
+  using NodeId = CSRGraph::NodeId;
+  const std::size_t Size = CFG.size();
+  std::vector<bool> ReachesExit(Size);
+  std::vector<NodeId> Worklist;
+  auto Connect = [&](NodeId Exit) {
+    Exits.push_back(Exit);
+    ReachesExit[Exit] = true;
+    Worklist.push_back(Exit);
+    while (!Worklist.empty()) {
+      const NodeId Node = Worklist.back();
+      Worklist.pop_back();
+      for (auto Pred : CFG.predecessors(Node))
+        if (!ReachesExit[Pred]) {
+          ReachesExit[Pred] = true;
+          Worklist.push_back(Pred);
+        }
+    }
+  };
+  for (NodeId Node = 0; Node < Size; ++Node)
+    if (CFG.successors(Node).empty() && !ReachesExit[Node])
+      Connect(Node);
+  // A node finished first by the DFS is deep in its region, so more of the
+  // region is post-dominated by it.
+  const auto Order = CFG.reversePostOrder();
+  for (auto It = std::rbegin(Order); It != std::rend(Order); ++It)
+    if (!ReachesExit[*It])
+      Connect(*It);
+  for (NodeId Node = 0; Node < Size; ++Node)
+    if (!ReachesExit[Node])
+      Connect(Node);
+  std::sort(std::begin(Exits), std::end(Exits));
+
+  std::vector<Arc> Arcs;
+  Arcs.reserve(CFG.arcs() + Exits.size());
+  for (auto Exit : Exits)
+    Arcs.push_back({0, Exit + std::size_t{1}});
+  for (NodeId Node = 0; Node < Size; ++Node)
+    for (auto Succ : CFG.successors(Node))
+      Arcs.push_back({Succ + std::size_t{1}, Node + std::size_t{1}});
+  return CSRGraph{Size + 1, std::move(Arcs)};
+}
+
+PostDominatorTree::PostDominatorTree(const CSRGraph &CFG)
+    : Tree{immediateDominators(reverseWithExit(CFG, Exits))} {}
+
+} // namespace wyrm
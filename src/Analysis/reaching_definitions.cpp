@@ -0,0 +1,38 @@
+#include "Analysis/reaching_definitions.h"
+
+namespace wyrm {
+
+void ReachingDefinitions::Problem::summarize(CSRGraph::NodeId Node,
+                                             BlockSummary &Summary) const {
+  for (std::size_t Def = BlockBegin[Node], E = BlockBegin[Node + 1]; Def < E;
+       ++Def) {
+    SymReg *Reg = definedRegister(*Definitions[Def]);
+    for (auto Killed : RegisterDefinitions[Reg->index()]) {
+      Summary.Gen.reset(Killed);
+      Summary.Kill.set(Killed);
+    }
+    Summary.Gen.set(Def);
+  }
+}
+
+ReachingDefinitions::ReachingDefinitions(const FunctionCFG &CFG)
+    : CFG{CFG}, TheProblem{CFG}, Solver{CFG.graph(), TheProblem} {
+  if (CFG.size())
+    TheProblem.RegisterDefinitions.resize(
+        CFG.block(0).parent().symbolicRegisters().size());
+  for (CSRGraph::NodeId Node = 0, E = CFG.size(); Node < E; ++Node) {
+    TheProblem.BlockBegin.push_back(TheProblem.Definitions.size());
+    for (Instruction &Inst : CFG.block(Node)) {
+      SymReg *Reg = definedRegister(Inst);
+      if (!Reg || !Reg->isLocal())
+        continue;
+      TheProblem.RegisterDefinitions[Reg->index()].push_back(
+          TheProblem.Definitions.size());
+      TheProblem.Definitions.push_back(&Inst);
+    }
+  }
+  TheProblem.BlockBegin.push_back(TheProblem.Definitions.size());
+  Solver.solve();
+}
+
+} // namespace wyrm
@@ -0,0 +1,693 @@
+#include "ExecutionEngine/batch.h"
+#include <algorithm>
+#include <climits>
+
+namespace wyrm {
+
+namespace {
+#if defined(__AVX2__)
+constexpr std::size_t VectorBytes = 32;
+#else
+constexpr std::size_t VectorBytes = 16;
+#endif
+/// \brief SIMD vector of lanes, a GCC and Clang extension.
+/// Comparisons of vectors give -1 in lanes where they hold and 0 elsewhere,
+/// which is the format of masks.
+typedef Imm Lanes __attribute__((vector_size(VectorBytes)));
+typedef std::uint32_t UnsignedLanes __attribute__((vector_size(VectorBytes)));
+constexpr std::size_t LanesPerVector = VectorBytes / sizeof(Imm);
+constexpr std::size_t VectorsPerRow =
+    BatchEvaluator::GroupSize / LanesPerVector;
+static_assert(BatchEvaluator::GroupSize % LanesPerVector == 0,
+              "A group must consist of whole vectors");
+
+/// \brief Index of a row of the register file of a group.
+using Row = std::uint32_t;
+
+constexpr std::int32_t NumBinOps =
+    static_cast<std::int32_t>(BinOpKind::Geq) + 1;
+/// \brief Operations are BinOpKind values followed by these.
+enum KernelOp : std::int32_t { OpAssign = NumBinOps, OpNeg, OpNot, OpCall };
+
+struct Operation {
+  std::int32_t Op;
+  /// For OpCall LHS is the number of the call site.
+  Row Out, LHS, RHS;
+};
+
+struct Copy {
+  Row To, From;
+};
+
+struct Successor {
+  std::int32_t Block;
+  /// Parallel copies of phis on the edge: all reads precede all writes.
+  std::vector<Copy> Copies;
+};
+
+struct LoweredBlock {
+  std::vector<Operation> Operations{};
+  enum TerminatorKind { Jump, Branch, Return };
+  TerminatorKind Terminator{Return};
+  /// Condition of a branch or the returned value.
+  Row Operand{};
+  Successor Successors[2]{};
+  std::uint64_t Size{};
+};
+
+Lanes select(Lanes Mask, Lanes True, Lanes False) {
+  return (True & Mask) | (False & ~Mask);
+}
+
+bool any(Lanes Mask) {
+  for (std::size_t L = 0; L < LanesPerVector; ++L)
+    if (Mask[L])
+      return true;
+  return false;
+}
+
+UnsignedLanes toUnsigned(Lanes X) { return (UnsignedLanes)X; }
+Lanes toSigned(UnsignedLanes X) { return (Lanes)X; }
+} // namespace
+
+/// \brief Function lowered for groups.
+/// Rows of the register file keep parameters, registers, phi temporaries
+/// and constants in this order.
+struct BatchEvaluator::LoweredFunction {
+  struct CallSite {
+    const LoweredFunction *Callee;
+    std::vector<Row> Arguments;
+    bool HasResult;
+  };
+  /// Reachable blocks in reverse postorder, so a block number is also its
+  /// priority.
+  std::vector<LoweredBlock> Blocks{};
+  std::vector<CallSite> Calls{};
+  std::vector<Imm> Constants{};
+  std::size_t NumParams{};
+  Row ConstantBase{};
+  /// Groups running the function at each call depth, kept for reuse.
+  mutable std::vector<std::unique_ptr<Group>> Groups{};
+};
+
+/// \brief Lowering of a function for groups.
+class BatchEvaluator::Lowering {
+public:
+  Lowering(BatchEvaluator &Evaluator, const Function &F,
+           LoweredFunction &Result)
+      : Evaluator{Evaluator}, F{F}, Result{Result} {}
+  void run();
+
+private:
+  Row row(Value V);
+  Row constant(Imm Number);
+  Successor successor(const BasicBlock &From, const BasicBlock &To);
+  void lower(const Instruction &Inst, LoweredBlock &Block,
+             std::size_t &NumReceives);
+  BatchEvaluator &Evaluator;
+  const Function &F;
+  LoweredFunction &Result;
+  std::unordered_map<const BasicBlock *, std::int32_t> Numbers{};
+  std::unordered_map<Imm, Row> Constants{};
+};
+
+Row BatchEvaluator::Lowering::constant(Imm Number) {
+  auto [It, IsNew] = Constants.emplace(
+      Number, Result.ConstantBase + static_cast<Row>(Result.Constants.size()));
+  if (IsNew)
+    Result.Constants.push_back(Number);
+  return It->second;
+}
+
+Row BatchEvaluator::Lowering::row(Value V) {
+  if (const Imm *Number = get<Imm>(&V))
+    return constant(*Number);
+  const SymReg &Reg = *get<SymReg>(&V);
+  assert(Reg.isLocal() && "Global variables aren't supported");
+  return static_cast<Row>(Result.NumParams + Reg.index());
+}
+
+Successor BatchEvaluator::Lowering::successor(const BasicBlock &From,
+                                              const BasicBlock &To) {
+  Successor Edge{Numbers.at(&To), {}};
+  std::vector<Row> Outs;
+  const auto TempBase =
+      static_cast<Row>(Result.NumParams + F.symbolicRegisters().size());
+  for (const Instruction &Inst : To) {
+    auto *Phi = get<PhiInst>(&Inst);
+    if (!Phi)
+      break;
+    std::size_t I = 0, E = Phi->size();
+    while (I != E && &Phi->incomingBlock(I) != &From)
+      ++I;
+    // A phi without a value for the edge keeps its value.
+    Value Incoming = I != E ? Phi->incomingValue(I) : Phi->outRegister();
+    Edge.Copies.push_back(
+        {TempBase + static_cast<Row>(Outs.size()), row(Incoming)});
+    Outs.push_back(row(Phi->outRegister()));
+  }
+  for (std::size_t I = 0, E = Outs.size(); I != E; ++I)
+    Edge.Copies.push_back({Outs[I], TempBase + static_cast<Row>(I)});
+  return Edge;
+}
+
+void BatchEvaluator::Lowering::lower(const Instruction &Inst,
+                                     LoweredBlock &Block,
+                                     std::size_t &NumReceives) {
+  if (auto *BinOp = get<BinOpInst>(&Inst)) {
+    Block.Operations.push_back({static_cast<std::int32_t>(BinOp->kind()),
+                                row(BinOp->outRegister()),
+                                row(BinOp->operand1()),
+                                row(BinOp->operand2())});
+  } else if (auto *UnOp = get<UnOpInst>(&Inst)) {
+    Block.Operations.push_back(
+        {OpAssign + static_cast<std::int32_t>(UnOp->kind()),
+         row(UnOp->outRegister()), row(UnOp->operand()), 0});
+  } else if (auto *Receive = get<ReceiveInst>(&Inst)) {
+    Block.Operations.push_back({OpAssign, row(Receive->outRegister()),
+                                static_cast<Row>(NumReceives++), 0});
+  } else if (auto *Call = get<CallInst>(&Inst)) {
+    LoweredFunction::CallSite Site{&Evaluator.lowered(Call->callee()), {},
+                                   Call->outRegister() != nullptr};
+    for (Value Argument : *Call)
+      Site.Arguments.push_back(row(Argument));
+    Block.Operations.push_back(
+        {OpCall, Site.HasResult ? row(*Call->outRegister()) : 0,
+         static_cast<Row>(Result.Calls.size()), 0});
+    Result.Calls.push_back(std::move(Site));
+  }
+}
+
+void BatchEvaluator::Lowering::run() {
+  std::size_t MaxPhis{};
+  std::vector<const BasicBlock *> Layout;
+  for (const auto &BB : F) {
+    Layout.push_back(&BB);
+    std::size_t NumPhis{};
+    for (const Instruction &Inst : BB) {
+      Result.NumParams += get<ReceiveInst>(&Inst) != nullptr;
+      NumPhis += get<PhiInst>(&Inst) != nullptr;
+    }
+    MaxPhis = std::max(MaxPhis, NumPhis);
+  }
+  Result.ConstantBase = static_cast<Row>(
+      Result.NumParams + F.symbolicRegisters().size() + MaxPhis);
+  if (Layout.empty()) {
+    Result.Blocks.emplace_back().Operand = constant(0);
+    return;
+  }
+
+  // Blocks are numbered in reverse postorder of the CFG.
+  auto Successors = [&Layout](std::size_t Position) {
+    std::vector<const BasicBlock *> Succs;
+    const BasicBlock &BB = *Layout[Position];
+    assert(!BB.empty() && isTerminator(*std::prev(std::end(BB))) &&
+           "Every block must end with a terminator");
+    if (auto *Br = get<BrInst>(&*std::prev(std::end(BB)))) {
+      Succs = {&Br->trueSuccessor(), &Br->falseSuccessor()};
+    } else if (auto *GoTo = get<GoToInst>(&*std::prev(std::end(BB)))) {
+      Succs.push_back(&GoTo->successor());
+    }
+    return Succs;
+  };
+  std::unordered_map<const BasicBlock *, std::size_t> Positions;
+  for (std::size_t Position = 0; Position < Layout.size(); ++Position)
+    Positions[Layout[Position]] = Position;
+  std::vector<std::size_t> PostOrder;
+  std::vector<bool> Visited(Layout.size());
+  std::vector<std::pair<std::size_t, std::size_t>> Stack{{0, 0}};
+  Visited[0] = true;
+  while (!Stack.empty()) {
+    auto &[Position, Next] = Stack.back();
+    auto Succs = Successors(Position);
+    if (Next == Succs.size()) {
+      PostOrder.push_back(Position);
+      Stack.pop_back();
+      continue;
+    }
+    std::size_t Succ = Positions.at(Succs[Next++]);
+    if (!Visited[Succ]) {
+      Visited[Succ] = true;
+      Stack.emplace_back(Succ, 0);
+    }
+  }
+  std::reverse(std::begin(PostOrder), std::end(PostOrder));
+  for (std::size_t I = 0, E = PostOrder.size(); I != E; ++I)
+    Numbers[Layout[PostOrder[I]]] = static_cast<std::int32_t>(I);
+
+  Result.Blocks.resize(PostOrder.size());
+  // Receives are numbered in layout order, which might differ.
+  std::size_t NumReceives{};
+  for (std::size_t Position = 0; Position < Layout.size(); ++Position) {
+    const BasicBlock &BB = *Layout[Position];
+    auto It = Numbers.find(&BB);
+    if (It == std::end(Numbers)) {
+      for (const Instruction &Inst : BB)
+        NumReceives += get<ReceiveInst>(&Inst) != nullptr;
+      continue;
+    }
+    LoweredBlock &Block = Result.Blocks[It->second];
+    Block.Size = BB.size();
+    for (const Instruction &Inst : BB)
+      lower(Inst, Block, NumReceives);
+    const Instruction &Last = *std::prev(std::end(BB));
+    if (auto *Br = get<BrInst>(&Last)) {
+      Block.Terminator = LoweredBlock::Branch;
+      Block.Operand = row(Br->condition());
+      Block.Successors[0] = successor(BB, Br->trueSuccessor());
+      Block.Successors[1] = successor(BB, Br->falseSuccessor());
+    } else if (auto *GoTo = get<GoToInst>(&Last)) {
+      Block.Terminator = LoweredBlock::Jump;
+      Block.Successors[0] = successor(BB, GoTo->successor());
+    } else {
+      Block.Operand = row(get<RetInst>(Last).operand());
+    }
+  }
+}
+
+/// \brief Execution of a function by up to GroupSize lanes.
+class BatchEvaluator::Group {
+public:
+  Group(BatchEvaluator &Evaluator, const LoweredFunction &F,
+        std::size_t Depth);
+  /// \return The group running \p F at call depth \p Depth.
+  static Group &get(BatchEvaluator &Evaluator, const LoweredFunction &F,
+                    std::size_t Depth);
+  /// \brief Run \p NumLanes lanes.
+  /// \param Args Arguments: the K-th one of lane L is Args[K * GroupSize + L].
+  /// \param Executed Numbers of instructions executed by the lanes, which are
+  /// updated.
+  void run(std::size_t NumLanes, const std::vector<Imm> &Args,
+           ExecutionResult *Results, std::uint64_t *Executed);
+
+private:
+  Lanes *row(Row R) { return &Rows[R * VectorsPerRow]; }
+  Imm &lane(Row R, std::size_t Lane) {
+    return row(R)[Lane / LanesPerVector][Lane % LanesPerVector];
+  }
+  static bool isSet(const Lanes *Mask, std::size_t Lane) {
+    return Mask[Lane / LanesPerVector][Lane % LanesPerVector];
+  }
+  /// \brief Set up a run of \p NumLanes lanes, with parameters as in run().
+  void start(std::size_t NumLanes, const std::vector<Imm> &Args,
+             ExecutionResult *Results, std::uint64_t *Executed);
+  /// \brief Execute the lanes until they finish or call a function.
+  /// \return The started group of the callee, or nullptr if the lanes have
+  /// finished.
+  Group *resume();
+  /// \brief Pick the next block and its lanes.
+  /// \return Whether some lanes are still running.
+  bool enter();
+  /// \brief Execute the terminator of \p Block, which is current.
+  void leave(const LoweredBlock &Block);
+  /// \brief Finish \p Lane, which is active, with \p Status.
+  void finish(std::size_t Lane, ExecutionResult::StatusKind Status);
+  /// \brief Add Counts to Executed and finish the lanes over the limit.
+  void count();
+  void binary(BinOpKind Kind, Row Out, Row LHS, Row RHS);
+  void unary(std::int32_t Op, Row Out, Row Operand);
+  /// \brief Start a call by the active lanes.
+  /// \return The started group of the callee, or nullptr if no lane calls.
+  Group *call(const LoweredFunction::CallSite &Site);
+  /// \brief Take the results of PendingCall after its group has run.
+  void returned();
+  void copy(const std::vector<Copy> &Copies, const Lanes *EdgeMask);
+  BatchEvaluator &Evaluator;
+  const LoweredFunction &F;
+  const std::size_t Depth;
+  std::size_t NumLanes{};
+  std::vector<Lanes> Rows;
+  /// Current blocks of the lanes.
+  Lanes PC[VectorsPerRow]{};
+  /// Lanes which haven't finished.
+  Lanes Running[VectorsPerRow]{};
+  /// Lanes executing the current block.
+  Lanes Mask[VectorsPerRow]{};
+  /// Instructions executed by the lanes since the last count(), and how
+  /// many more they may execute before the next one.
+  UnsignedLanes Counts[VectorsPerRow]{};
+  UnsignedLanes Budgets[VectorsPerRow]{};
+  ExecutionResult *Results{};
+  std::uint64_t *Executed{};
+  /// Block being executed, and the position of its next operation.
+  std::int32_t Current{};
+  std::size_t NextOperation{};
+  /// State of the call waiting for the callee group. It lives here rather
+  /// than on the native stack, where deep recursion would overflow it.
+  const Operation *PendingCall{};
+  std::size_t Callers[GroupSize]{};
+  std::size_t NumCallers{};
+  ExecutionResult CalleeResults[GroupSize]{};
+  std::uint64_t CalleeExecuted[GroupSize]{};
+  /// Arguments of calls, kept to avoid allocations.
+  std::vector<Imm> CallArgs{};
+};
+
+BatchEvaluator::Group::Group(BatchEvaluator &Evaluator,
+                             const LoweredFunction &F, std::size_t Depth)
+    : Evaluator{Evaluator}, F{F}, Depth{Depth},
+      Rows((F.ConstantBase + F.Constants.size()) * VectorsPerRow) {
+  for (std::size_t I = 0, E = F.Constants.size(); I != E; ++I)
+    std::fill_n(row(F.ConstantBase + static_cast<Row>(I)), VectorsPerRow,
+                Lanes{} + F.Constants[I]);
+}
+
+auto BatchEvaluator::Group::get(BatchEvaluator &Evaluator,
+                                const LoweredFunction &F, std::size_t Depth)
+    -> Group & {
+  // A function runs at most once at each depth at a time.
+  if (F.Groups.size() <= Depth)
+    F.Groups.resize(Depth + 1);
+  if (!F.Groups[Depth])
+    F.Groups[Depth] = std::make_unique<Group>(Evaluator, F, Depth);
+  return *F.Groups[Depth];
+}
+
+void BatchEvaluator::Group::finish(std::size_t Lane,
+                                   ExecutionResult::StatusKind Status) {
+  Results[Lane].Status = Status;
+  Running[Lane / LanesPerVector][Lane % LanesPerVector] = 0;
+  Mask[Lane / LanesPerVector][Lane % LanesPerVector] = 0;
+}
+
+void BatchEvaluator::Group::count() {
+  const std::uint64_t Limit{Evaluator.InstructionLimit};
+  for (std::size_t Lane = 0; Lane < NumLanes; ++Lane) {
+    const std::size_t V = Lane / LanesPerVector, L = Lane % LanesPerVector;
+    Executed[Lane] += Counts[V][L];
+    Counts[V][L] = 0;
+    if (!Running[V][L])
+      continue;
+    if (Executed[Lane] > Limit) {
+      finish(Lane, ExecutionResult::LimitExceeded);
+      continue;
+    }
+    // Counts can't overflow before the next count().
+    Budgets[V][L] = static_cast<std::uint32_t>(
+        std::min<std::uint64_t>(Limit - Executed[Lane], 1u << 30));
+  }
+}
+
+void BatchEvaluator::Group::binary(BinOpKind Kind, Row Out, Row LHS,
+                                   Row RHS) {
+  Lanes *Result = row(Out);
+  const Lanes *A = row(LHS), *B = row(RHS);
+  auto Apply = [&](auto Op) {
+    for (std::size_t V = 0; V < VectorsPerRow; ++V)
+      Result[V] = select(Mask[V], Op(A[V], B[V]), Result[V]);
+  };
+  switch (Kind) {
+  case BinOpKind::Add:
+    return Apply([](Lanes X, Lanes Y) {
+      return toSigned(toUnsigned(X) + toUnsigned(Y));
+    });
+  case BinOpKind::Sub:
+    return Apply([](Lanes X, Lanes Y) {
+      return toSigned(toUnsigned(X) - toUnsigned(Y));
+    });
+  case BinOpKind::Mul:
+    return Apply([](Lanes X, Lanes Y) {
+      return toSigned(toUnsigned(X) * toUnsigned(Y));
+    });
+  case BinOpKind::Div:
+  case BinOpKind::Mod: {
+    // Trapping lanes finish, the others divide only in active lanes.
+    for (std::size_t V = 0; V < VectorsPerRow; ++V) {
+      Lanes Traps =
+          Mask[V] & ((B[V] == 0) | ((A[V] == INT_MIN) & (B[V] == -1)));
+      if (any(Traps))
+        for (std::size_t L = 0; L < LanesPerVector; ++L)
+          if (Traps[L])
+            finish(V * LanesPerVector + L, ExecutionResult::Trapped);
+      Lanes Divisor = select(Mask[V], B[V], Lanes{} + 1);
+      Lanes Quotient =
+          Kind == BinOpKind::Div ? A[V] / Divisor : A[V] % Divisor;
+      Result[V] = select(Mask[V], Quotient, Result[V]);
+    }
+    return;
+  }
+  case BinOpKind::Min:
+    return Apply([](Lanes X, Lanes Y) { return select(X < Y, X, Y); });
+  case BinOpKind::Max:
+    return Apply([](Lanes X, Lanes Y) { return select(X > Y, X, Y); });
+  case BinOpKind::Shl:
+    return Apply([](Lanes X, Lanes Y) {
+      return toSigned(toUnsigned(X) << toUnsigned(Y & 31));
+    });
+  case BinOpKind::Shr:
+    return Apply([](Lanes X, Lanes Y) {
+      return toSigned(toUnsigned(X) >> toUnsigned(Y & 31));
+    });
+  case BinOpKind::Shra:
+    return Apply([](Lanes X, Lanes Y) { return X >> (Y & 31); });
+  case BinOpKind::And:
+    return Apply([](Lanes X, Lanes Y) { return X & Y; });
+  case BinOpKind::Or:
+    return Apply([](Lanes X, Lanes Y) { return X | Y; });
+  case BinOpKind::Xor:
+    return Apply([](Lanes X, Lanes Y) { return X ^ Y; });
+  case BinOpKind::Eq:
+    return Apply([](Lanes X, Lanes Y) { return (X == Y) & 1; });
+  case BinOpKind::Neq:
+    return Apply([](Lanes X, Lanes Y) { return (X != Y) & 1; });
+  case BinOpKind::Less:
+    return Apply([](Lanes X, Lanes Y) { return (X < Y) & 1; });
+  case BinOpKind::Leq:
+    return Apply([](Lanes X, Lanes Y) { return (X <= Y) & 1; });
+  case BinOpKind::Greater:
+    return Apply([](Lanes X, Lanes Y) { return (X > Y) & 1; });
+  case BinOpKind::Geq:
+    return Apply([](Lanes X, Lanes Y) { return (X >= Y) & 1; });
+  }
+}
+
+void BatchEvaluator::Group::unary(std::int32_t Op, Row Out, Row Operand) {
+  Lanes *Result = row(Out);
+  const Lanes *A = row(Operand);
+  for (std::size_t V = 0; V < VectorsPerRow; ++V) {
+    Lanes Value = Op == OpAssign ? A[V]
+                  : Op == OpNeg  ? toSigned(-toUnsigned(A[V]))
+                                 : ~A[V];
+    Result[V] = select(Mask[V], Value, Result[V]);
+  }
+}
+
+auto BatchEvaluator::Group::call(const LoweredFunction::CallSite &Site)
+    -> Group * {
+  // The callee runs as a group of the active lanes.
+  NumCallers = 0;
+  for (std::size_t Lane = 0; Lane < NumLanes; ++Lane)
+    if (isSet(Mask, Lane))
+      Callers[NumCallers++] = Lane;
+  if (!NumCallers)
+    return nullptr;
+  if (Depth == Evaluator.CallDepthLimit) {
+    for (std::size_t I = 0; I < NumCallers; ++I)
+      finish(Callers[I], ExecutionResult::StackOverflow);
+    return nullptr;
+  }
+  const LoweredFunction &Callee = *Site.Callee;
+  std::vector<Imm> &Args = CallArgs;
+  Args.assign(Callee.NumParams * GroupSize, 0);
+  for (std::size_t K = 0; K < std::min(Callee.NumParams, Site.Arguments.size());
+       ++K)
+    for (std::size_t I = 0; I < NumCallers; ++I)
+      Args[K * GroupSize + I] = lane(Site.Arguments[K], Callers[I]);
+  count();
+  for (std::size_t I = 0; I < NumCallers; ++I)
+    CalleeExecuted[I] = Executed[Callers[I]];
+  Group &CalleeGroup = get(Evaluator, Callee, Depth + 1);
+  CalleeGroup.start(NumCallers, Args, CalleeResults, CalleeExecuted);
+  return &CalleeGroup;
+}
+
+void BatchEvaluator::Group::returned() {
+  const LoweredFunction::CallSite &Site = F.Calls[PendingCall->LHS];
+  const Row Out = PendingCall->Out;
+  for (std::size_t I = 0; I < NumCallers; ++I) {
+    std::size_t Lane = Callers[I];
+    Executed[Lane] = CalleeExecuted[I];
+    if (!CalleeResults[I].returned())
+      finish(Lane, CalleeResults[I].Status);
+    else if (Site.HasResult)
+      lane(Out, Lane) = CalleeResults[I].ReturnValue;
+  }
+  count();
+}
+
+void BatchEvaluator::Group::copy(const std::vector<Copy> &Copies,
+                                 const Lanes *EdgeMask) {
+  for (auto [To, From] : Copies) {
+    Lanes *Dst = row(To);
+    const Lanes *Src = row(From);
+    for (std::size_t V = 0; V < VectorsPerRow; ++V)
+      Dst[V] = select(EdgeMask[V], Src[V], Dst[V]);
+  }
+}
+
+void BatchEvaluator::Group::run(std::size_t NumLanes,
+                                const std::vector<Imm> &Args,
+                                ExecutionResult *Results,
+                                std::uint64_t *Executed) {
+  // Groups of callees are run by this loop rather than recursively, so the
+  // call depth doesn't use the native stack.
+  start(NumLanes, Args, Results, Executed);
+  std::vector<Group *> Calls{this};
+  while (!Calls.empty()) {
+    if (Group *Callee = Calls.back()->resume()) {
+      Calls.push_back(Callee);
+      continue;
+    }
+    Calls.pop_back();
+    if (!Calls.empty())
+      Calls.back()->returned();
+  }
+}
+
+void BatchEvaluator::Group::start(std::size_t NumLanes,
+                                  const std::vector<Imm> &Args,
+                                  ExecutionResult *Results,
+                                  std::uint64_t *Executed) {
+  assert(NumLanes <= GroupSize && "Too many lanes");
+  this->NumLanes = NumLanes;
+  this->Results = Results;
+  this->Executed = Executed;
+  // Registers read before being written are 0.
+  std::fill(std::begin(Rows), std::begin(Rows) + F.ConstantBase * VectorsPerRow,
+            Lanes{});
+  for (std::size_t K = 0; K < F.NumParams; ++K)
+    for (std::size_t Lane = 0; Lane < NumLanes; ++Lane)
+      lane(static_cast<Row>(K), Lane) = Args[K * GroupSize + Lane];
+  for (std::size_t V = 0; V < VectorsPerRow; ++V) {
+    PC[V] = Lanes{};
+    Running[V] = Lanes{};
+  }
+  for (std::size_t Lane = 0; Lane < NumLanes; ++Lane)
+    Running[Lane / LanesPerVector][Lane % LanesPerVector] = -1;
+  count();
+}
+
+bool BatchEvaluator::Group::enter() {
+  // The running lanes at the first block in reverse postorder go on.
+  Lanes Firsts = Lanes{} + INT_MAX;
+  for (std::size_t V = 0; V < VectorsPerRow; ++V) {
+    Lanes Candidates = select(Running[V], PC[V], Lanes{} + INT_MAX);
+    Firsts = select(Candidates < Firsts, Candidates, Firsts);
+  }
+  Current = INT_MAX;
+  for (std::size_t L = 0; L < LanesPerVector; ++L)
+    Current = std::min(Current, Firsts[L]);
+  if (Current == INT_MAX)
+    return false;
+  const auto Size = static_cast<std::uint32_t>(F.Blocks[Current].Size);
+  for (std::size_t V = 0; V < VectorsPerRow; ++V) {
+    Mask[V] = Running[V] & (PC[V] == Current);
+    Counts[V] += toUnsigned(Mask[V]) & Size;
+  }
+  NextOperation = 0;
+  return true;
+}
+
+void BatchEvaluator::Group::leave(const LoweredBlock &Block) {
+  if (Block.Terminator == LoweredBlock::Return) {
+    for (std::size_t Lane = 0; Lane < NumLanes; ++Lane)
+      if (isSet(Mask, Lane)) {
+        Results[Lane].ReturnValue = lane(Block.Operand, Lane);
+        finish(Lane, ExecutionResult::Returned);
+      }
+    return;
+  }
+  const Successor &True = Block.Successors[0];
+  const Successor &False = Block.Successors[1];
+  Lanes TrueMask[VectorsPerRow], FalseMask[VectorsPerRow];
+  Lanes OverBudget{};
+  for (std::size_t V = 0; V < VectorsPerRow; ++V) {
+    TrueMask[V] = Mask[V];
+    FalseMask[V] = Lanes{};
+    if (Block.Terminator == LoweredBlock::Branch) {
+      TrueMask[V] &= row(Block.Operand)[V] != 0;
+      FalseMask[V] = Mask[V] & ~TrueMask[V];
+    }
+    OverBudget |= Mask[V] & (Counts[V] > Budgets[V]);
+  }
+  copy(True.Copies, TrueMask);
+  copy(False.Copies, FalseMask);
+  for (std::size_t V = 0; V < VectorsPerRow; ++V)
+    PC[V] = select(TrueMask[V], Lanes{} + True.Block,
+                   select(FalseMask[V], Lanes{} + False.Block, PC[V]));
+  if (any(OverBudget))
+    count();
+}
+
+auto BatchEvaluator::Group::resume() -> Group * {
+  // A group stops only at a call, in the middle of its block.
+  if (PendingCall) {
+    PendingCall = nullptr;
+  } else if (!enter()) {
+    count();
+    return nullptr;
+  }
+  for (;;) {
+    const LoweredBlock &Block = F.Blocks[Current];
+    const Operation *Op = Block.Operations.data() + NextOperation;
+    const Operation *End = Block.Operations.data() + Block.Operations.size();
+    for (; Op != End; ++Op) {
+      if (Op->Op < NumBinOps) {
+        binary(static_cast<BinOpKind>(Op->Op), Op->Out, Op->LHS, Op->RHS);
+      } else if (Op->Op != OpCall) {
+        unary(Op->Op, Op->Out, Op->LHS);
+      } else if (Group *Callee = call(F.Calls[Op->LHS])) {
+        NextOperation = static_cast<std::size_t>(
+            Op + 1 - Block.Operations.data());
+        PendingCall = Op;
+        return Callee;
+      }
+    }
+    leave(Block);
+    if (!enter()) {
+      count();
+      return nullptr;
+    }
+  }
+}
+
+BatchEvaluator::BatchEvaluator(const Module &M) : TheModule{M} {}
+
+BatchEvaluator::~BatchEvaluator() = default;
+
+auto BatchEvaluator::lowered(const Function &F) -> const LoweredFunction & {
+  assert(&F.parent() == &TheModule && "The function is in another module");
+  auto [It, IsNew] = Functions.emplace(&F, nullptr);
+  if (!IsNew)
+    return *It->second;
+  // Recursive calls refer to the function being lowered. Lowering callees
+  // might rehash the map, which keeps only references to elements valid.
+  auto &Result = *(It->second = std::make_unique<LoweredFunction>());
+  Lowering{*this, F, Result}.run();
+  return Result;
+}
+
+std::vector<ExecutionResult>
+BatchEvaluator::run(const Function &F, std::size_t NumLanes,
+                    const std::vector<std::vector<Imm>> &Args) {
+  const LoweredFunction &Lowered = lowered(F);
+  std::vector<ExecutionResult> Results(NumLanes,
+                                       {ExecutionResult::Returned});
+  std::vector<Imm> GroupArgs(Lowered.NumParams * GroupSize);
+  Group &TheGroup = Group::get(*this, Lowered, 0);
+  for (std::size_t First = 0; First < NumLanes; First += GroupSize) {
+    const std::size_t Size = std::min(GroupSize, NumLanes - First);
+    for (std::size_t K = 0; K < std::min(Lowered.NumParams, Args.size()); ++K) {
+      assert(Args[K].size() == NumLanes && "Some arguments are missing");
+      std::copy_n(std::begin(Args[K]) + First, Size,
+                  std::begin(GroupArgs) + K * GroupSize);
+    }
+    std::uint64_t Counts[GroupSize]{};
+    TheGroup.run(Size, GroupArgs, Results.data() + First, Counts);
+    for (std::size_t Lane = 0; Lane < Size; ++Lane)
+      Executed += Counts[Lane];
+  }
+  return Results;
+}
+
+} // namespace wyrm
@@ -0,0 +1,479 @@
+#include "ExecutionEngine/interpreter.h"
+#include <algorithm>
+#include <map>
+
+namespace wyrm {
+
+namespace {
+/// \brief Bytecode operations with their operand cells.
+enum Bytecode : std::int32_t {
+  // Binary operations in the order of BinOpKind: result, lhs, rhs.
+  OpAdd,
+  OpSub,
+  OpMul,
+  OpDiv,
+  OpMod,
+  OpMin,
+  OpMax,
+  OpShl,
+  OpShr,
+  OpShra,
+  OpAnd,
+  OpOr,
+  OpXor,
+  OpEq,
+  OpNeq,
+  OpLess,
+  OpLeq,
+  OpGreater,
+  OpGeq,
+  // Unary operations in the order of UnOpKind: result, operand.
+  OpMov,
+  OpNeg,
+  OpNot,
+  // Target.
+  OpJump,
+  // Condition, true target, false target.
+  OpBr,
+  // Value.
+  OpRet,
+  // Callee, result or NoSlot, number of arguments, arguments.
+  OpCall,
+  // Result, global variable.
+  OpLoadGlobal,
+  // Global variable, value.
+  OpStoreGlobal,
+  NumOpcodes
+};
+
+constexpr std::int32_t NoSlot = -1;
+} // namespace
+
+/// \brief Lowering of a function to bytecode.
+class Interpreter::Lowering {
+public:
+  Lowering(Interpreter &Engine, const Function &F);
+  CompiledFunction run();
+
+private:
+  /// \brief Where a jump goes: a block or copies of the phis of the
+  /// destination on an edge.
+  struct Fixup {
+    std::size_t Cell;
+    const BasicBlock *From;
+    const BasicBlock *To;
+  };
+  std::int32_t slot(const SymReg &Reg) const {
+    return static_cast<std::int32_t>(Result.NumParams + Reg.index());
+  }
+  std::int32_t constant(Imm Number);
+  /// \return Slot holding \p V. A global variable is loaded into the
+  /// operand scratch slot \p Scratch first.
+  std::int32_t operand(Value V, std::int32_t Scratch);
+  /// \return Slot to write \p Reg to. A global variable is written to the
+  /// result scratch slot, which storeResult copies into it.
+  std::int32_t result(const SymReg &Reg) const {
+    return Reg.isLocal() ? slot(Reg) : ResultScratch;
+  }
+  void storeResult(const SymReg &Reg);
+  void emit(Bytecode Op, std::initializer_list<std::int32_t> Operands);
+  /// \brief Emit a jump target cell for the edge from \p From to \p To.
+  void target(const BasicBlock &From, const BasicBlock &To);
+  void lower(const BasicBlock &BB, const Instruction &Inst,
+             std::size_t &NumReceives);
+  /// \brief Emit parallel copies of the phis of \p To for the edge from
+  /// \p From.
+  void emitEdgeCopies(const BasicBlock &From, const BasicBlock &To);
+  Interpreter &Engine;
+  const Function &F;
+  CompiledFunction Result{};
+  std::int32_t ResultScratch{};
+  /// First of the scratch slots of phi copies.
+  std::int32_t PhiScratch{};
+  std::int32_t ConstantBase{};
+  std::unordered_map<Imm, std::int32_t> Constants{};
+  std::unordered_map<const BasicBlock *, std::size_t> BlockOffsets{};
+  std::vector<Fixup> Fixups{};
+};
+
+static bool hasPhis(const BasicBlock &BB) {
+  return !BB.empty() && get<PhiInst>(&*std::begin(BB));
+}
+
+Interpreter::Lowering::Lowering(Interpreter &Engine, const Function &F)
+    : Engine{Engine}, F{F} {
+  std::size_t MaxOperands{2}, MaxPhis{};
+  for (const auto &BB : F) {
+    std::size_t NumPhis{};
+    for (const Instruction &Inst : BB) {
+      Result.NumParams += get<ReceiveInst>(&Inst) != nullptr;
+      if (auto *Call = get<CallInst>(&Inst))
+        MaxOperands = std::max(MaxOperands, Call->numArguments());
+      NumPhis += get<PhiInst>(&Inst) != nullptr;
+    }
+    MaxPhis = std::max(MaxPhis, NumPhis);
+  }
+  Result.NumRegisters = F.symbolicRegisters().size();
+  ResultScratch =
+      static_cast<std::int32_t>(Result.NumParams + Result.NumRegisters +
+                                MaxOperands);
+  PhiScratch = ResultScratch + 1;
+  ConstantBase = PhiScratch + static_cast<std::int32_t>(MaxPhis);
+}
+
+std::int32_t Interpreter::Lowering::constant(Imm Number) {
+  auto [It, IsNew] = Constants.emplace(
+      Number,
+      ConstantBase + static_cast<std::int32_t>(Result.Constants.size()));
+  if (IsNew)
+    Result.Constants.push_back(Number);
+  return It->second;
+}
+
+std::int32_t Interpreter::Lowering::operand(Value V, std::int32_t Scratch) {
+  if (const Imm *Number = get<Imm>(&V))
+    return constant(*Number);
+  const SymReg &Reg = *get<SymReg>(&V);
+  if (Reg.isLocal())
+    return slot(Reg);
+  std::int32_t Slot = ResultScratch - 1 - Scratch;
+  emit(OpLoadGlobal,
+       {Slot, static_cast<std::int32_t>(Engine.globalSlot(Reg))});
+  return Slot;
+}
+
+void Interpreter::Lowering::storeResult(const SymReg &Reg) {
+  if (!Reg.isLocal())
+    emit(OpStoreGlobal,
+         {static_cast<std::int32_t>(Engine.globalSlot(Reg)), ResultScratch});
+}
+
+void Interpreter::Lowering::emit(Bytecode Op,
+                                 std::initializer_list<std::int32_t> Operands) {
+  Result.Operations.push_back(Result.Code.size());
+  Result.Code.push_back(Op);
+  Result.Code.insert(std::end(Result.Code), Operands);
+}
+
+void Interpreter::Lowering::target(const BasicBlock &From,
+                                   const BasicBlock &To) {
+  Fixups.push_back({Result.Code.size(), &From, &To});
+  Result.Code.push_back(0);
+}
+
+void Interpreter::Lowering::lower(const BasicBlock &BB,
+                                  const Instruction &Inst,
+                                  std::size_t &NumReceives) {
+  if (auto *BinOp = get<BinOpInst>(&Inst)) {
+    std::int32_t LHS = operand(BinOp->operand1(), 0);
+    std::int32_t RHS = operand(BinOp->operand2(), 1);
+    emit(static_cast<Bytecode>(OpAdd + static_cast<int>(BinOp->kind())),
+         {result(BinOp->outRegister()), LHS, RHS});
+    return storeResult(BinOp->outRegister());
+  }
+  if (auto *UnOp = get<UnOpInst>(&Inst)) {
+    std::int32_t Operand = operand(UnOp->operand(), 0);
+    emit(static_cast<Bytecode>(OpMov + static_cast<int>(UnOp->kind())),
+         {result(UnOp->outRegister()), Operand});
+    return storeResult(UnOp->outRegister());
+  }
+  if (auto *Receive = get<ReceiveInst>(&Inst)) {
+    emit(OpMov, {result(Receive->outRegister()),
+                 static_cast<std::int32_t>(NumReceives++)});
+    return storeResult(Receive->outRegister());
+  }
+  if (auto *Call = get<CallInst>(&Inst)) {
+    std::vector<std::int32_t> Arguments;
+    for (std::size_t I = 0, E = Call->numArguments(); I != E; ++I)
+      Arguments.push_back(
+          operand(Call->argument(I), static_cast<std::int32_t>(I)));
+    SymReg *Out = Call->outRegister();
+    std::int32_t Callee = Engine.functionId(Call->callee());
+    emit(OpCall, {Callee, Out ? result(*Out) : NoSlot,
+                  static_cast<std::int32_t>(Arguments.size())});
+    Result.Code.insert(std::end(Result.Code), std::begin(Arguments),
+                       std::end(Arguments));
+    if (Out)
+      storeResult(*Out);
+    return;
+  }
+  if (auto *Ret = get<RetInst>(&Inst))
+    return emit(OpRet, {operand(Ret->operand(), 0)});
+  if (auto *GoTo = get<GoToInst>(&Inst)) {
+    emit(OpJump, {});
+    return target(BB, GoTo->successor());
+  }
+  auto &Br = get<BrInst>(Inst);
+  emit(OpBr, {operand(Br.condition(), 0)});
+  target(BB, Br.trueSuccessor());
+  target(BB, Br.falseSuccessor());
+}
+
+void Interpreter::Lowering::emitEdgeCopies(const BasicBlock &From,
+                                           const BasicBlock &To) {
+  // Read every incoming value before writing any phi.
+  std::vector<const SymReg *> Outs;
+  for (const Instruction &Inst : To) {
+    auto *Phi = get<PhiInst>(&Inst);
+    if (!Phi)
+      break;
+    std::int32_t Temp = PhiScratch + static_cast<std::int32_t>(Outs.size());
+    Outs.push_back(&Phi->outRegister());
+    std::size_t I = 0, E = Phi->size();
+    while (I != E && &Phi->incomingBlock(I) != &From)
+      ++I;
+    // A phi without a value for the edge keeps its value.
+    Value Incoming = I != E ? Phi->incomingValue(I) : Phi->outRegister();
+    const SymReg *Reg = get<SymReg>(&Incoming);
+    if (Reg && !Reg->isLocal())
+      emit(OpLoadGlobal,
+           {Temp, static_cast<std::int32_t>(Engine.globalSlot(*Reg))});
+    else
+      emit(OpMov, {Temp, operand(Incoming, 0)});
+  }
+  for (std::size_t I = 0, E = Outs.size(); I != E; ++I) {
+    std::int32_t Temp = PhiScratch + static_cast<std::int32_t>(I);
+    if (Outs[I]->isLocal())
+      emit(OpMov, {slot(*Outs[I]), Temp});
+    else
+      emit(OpStoreGlobal,
+           {static_cast<std::int32_t>(Engine.globalSlot(*Outs[I])), Temp});
+  }
+}
+
+auto Interpreter::Lowering::run() -> CompiledFunction {
+  std::size_t NumReceives{};
+  for (const BasicBlock &BB : F) {
+    assert(!BB.empty() && isTerminator(*std::prev(std::end(BB))) &&
+           "Every block must end with a terminator");
+    BlockOffsets[&BB] = Result.Code.size();
+    for (const Instruction &Inst : BB)
+      if (!get<PhiInst>(&Inst))
+        lower(BB, Inst, NumReceives);
+  }
+  if (!F.size())
+    emit(OpRet, {constant(0)});
+  // Phi copies of an edge are emitted once and jump to the destination.
+  std::map<std::pair<const BasicBlock *, const BasicBlock *>, std::size_t>
+      Stubs;
+  for (auto [Cell, From, To] : Fixups) {
+    if (!hasPhis(*To)) {
+      Result.Code[Cell] = static_cast<std::int32_t>(BlockOffsets.at(To));
+      continue;
+    }
+    auto [It, IsNew] = Stubs.emplace(std::make_pair(From, To),
+                                     Result.Code.size());
+    if (IsNew) {
+      emitEdgeCopies(*From, *To);
+      emit(OpJump, {static_cast<std::int32_t>(BlockOffsets.at(To))});
+    }
+    Result.Code[Cell] = static_cast<std::int32_t>(It->second);
+  }
+  Result.FrameSize = ConstantBase + Result.Constants.size();
+  return std::move(Result);
+}
+
+std::int32_t Interpreter::functionId(const Function &F) {
+  assert(&F.parent() == &TheModule && "The function is in another module");
+  auto [It, IsNew] = FunctionIds.emplace(
+      &F, static_cast<std::int32_t>(Functions.size()));
+  std::int32_t Id = It->second;
+  if (IsNew) {
+    // Lowering might add callees, so the function is stored after it.
+    Functions.emplace_back();
+    CompiledFunction Compiled = Lowering{*this, F}.run();
+    Functions[Id] = std::move(Compiled);
+  }
+  return Id;
+}
+
+std::size_t Interpreter::globalSlot(const SymReg &Var) {
+  assert(!Var.isLocal() && &Var.parent<Module>() == &TheModule &&
+         "Not a global variable of the module");
+  if (Globals.size() <= Var.index())
+    Globals.resize(Var.index() + 1);
+  return Var.index();
+}
+
+Imm Interpreter::global(const SymReg &Var) const {
+  assert(!Var.isLocal() && "Not a global variable");
+  return Var.index() < Globals.size() ? Globals[Var.index()] : 0;
+}
+
+void Interpreter::setGlobal(const SymReg &Var, Imm Number) {
+  Globals[globalSlot(Var)] = Number;
+}
+
+ExecutionResult Interpreter::run(const Function &F,
+                                 const std::vector<Imm> &Args) {
+  std::int32_t Id = functionId(F);
+  return execute(Functions[Id], Args);
+}
+
+Imm *Interpreter::enterFrame(const CompiledFunction &Callee,
+                             std::size_t Base) {
+  std::size_t End = Base + Callee.FrameSize;
+  if (Stack.size() < End)
+    Stack.resize(std::max(End, 2 * Stack.size()));
+  Imm *Frame = Stack.data() + Base;
+  std::fill_n(Frame + Callee.NumParams, Callee.NumRegisters, 0);
+  std::copy(std::begin(Callee.Constants), std::end(Callee.Constants),
+            Frame + End - Base - Callee.Constants.size());
+  return Frame;
+}
+
+// Operations of bytecode are executed by handlers jumping directly to the
+// handler of the next operation. Each handler ends with a dispatch through
+// the offset of the next handler from the first one.
+#define WYRM_HANDLER(Label)                                                    \
+  static_cast<std::int32_t>(static_cast<char *>(&&Label) - Handlers)
+
+#define WYRM_DISPATCH(Length)                                                  \
+  do {                                                                         \
+    PC += (Length);                                                            \
+    ++Count;                                                                   \
+    goto *(Handlers + *PC);                                                    \
+  } while (false)
+
+#define WYRM_BINOP_HANDLER(Kind)                                               \
+  Do##Kind : {                                                                 \
+    auto Result = evaluate(BinOpKind::Kind, Frame[PC[2]], Frame[PC[3]]);       \
+    if (!Result)                                                               \
+      goto Trap;                                                               \
+    Frame[PC[1]] = *Result;                                                    \
+    WYRM_DISPATCH(4);                                                          \
+  }
+
+#define WYRM_UNOP_HANDLER(Label, Kind)                                         \
+  Label : {                                                                    \
+    Frame[PC[1]] = evaluate(UnOpKind::Kind, Frame[PC[2]]);                     \
+    WYRM_DISPATCH(3);                                                          \
+  }
+
+ExecutionResult Interpreter::execute(const CompiledFunction &Entry,
+                                     const std::vector<Imm> &Args) {
+  char *const Handlers = static_cast<char *>(&&DoAdd);
+  const std::int32_t HandlerOffsets[NumOpcodes] = {
+      WYRM_HANDLER(DoAdd), WYRM_HANDLER(DoSub), WYRM_HANDLER(DoMul),
+      WYRM_HANDLER(DoDiv), WYRM_HANDLER(DoMod), WYRM_HANDLER(DoMin),
+      WYRM_HANDLER(DoMax), WYRM_HANDLER(DoShl), WYRM_HANDLER(DoShr),
+      WYRM_HANDLER(DoShra), WYRM_HANDLER(DoAnd), WYRM_HANDLER(DoOr),
+      WYRM_HANDLER(DoXor), WYRM_HANDLER(DoEq), WYRM_HANDLER(DoNeq),
+      WYRM_HANDLER(DoLess), WYRM_HANDLER(DoLeq), WYRM_HANDLER(DoGreater),
+      WYRM_HANDLER(DoGeq), WYRM_HANDLER(DoMov), WYRM_HANDLER(DoNeg),
+      WYRM_HANDLER(DoNot), WYRM_HANDLER(DoJump), WYRM_HANDLER(DoBr),
+      WYRM_HANDLER(DoRet), WYRM_HANDLER(DoCall), WYRM_HANDLER(DoLoadGlobal),
+      WYRM_HANDLER(DoStoreGlobal)};
+  for (auto &Compiled : Functions) {
+    if (Compiled.IsThreaded)
+      continue;
+    for (auto Cell : Compiled.Operations)
+      Compiled.Code[Cell] = HandlerOffsets[Compiled.Code[Cell]];
+    Compiled.IsThreaded = true;
+  }
+
+  const std::uint64_t Limit{InstructionLimit};
+  std::uint64_t Count{};
+  ExecutionResult Outcome{ExecutionResult::Returned};
+  const CompiledFunction *Current = &Entry;
+  std::size_t Base{};
+  Imm *Frame = enterFrame(Entry, Base);
+  for (std::size_t I = 0; I < Entry.NumParams; ++I)
+    Frame[I] = I < Args.size() ? Args[I] : 0;
+  const std::int32_t *PC = Entry.Code.data();
+  WYRM_DISPATCH(0);
+
+  WYRM_BINOP_HANDLER(Add)
+  WYRM_BINOP_HANDLER(Sub)
+  WYRM_BINOP_HANDLER(Mul)
+  WYRM_BINOP_HANDLER(Div)
+  WYRM_BINOP_HANDLER(Mod)
+  WYRM_BINOP_HANDLER(Min)
+  WYRM_BINOP_HANDLER(Max)
+  WYRM_BINOP_HANDLER(Shl)
+  WYRM_BINOP_HANDLER(Shr)
+  WYRM_BINOP_HANDLER(Shra)
+  WYRM_BINOP_HANDLER(And)
+  WYRM_BINOP_HANDLER(Or)
+  WYRM_BINOP_HANDLER(Xor)
+  WYRM_BINOP_HANDLER(Eq)
+  WYRM_BINOP_HANDLER(Neq)
+  WYRM_BINOP_HANDLER(Less)
+  WYRM_BINOP_HANDLER(Leq)
+  WYRM_BINOP_HANDLER(Greater)
+  WYRM_BINOP_HANDLER(Geq)
+  WYRM_UNOP_HANDLER(DoMov, Assign)
+  WYRM_UNOP_HANDLER(DoNeg, Neg)
+  WYRM_UNOP_HANDLER(DoNot, Not)
+DoJump:
+  if (Count > Limit)
+    goto OutOfLimit;
+  PC = Current->Code.data() + PC[1];
+  WYRM_DISPATCH(0);
+DoBr:
+  if (Count > Limit)
+    goto OutOfLimit;
+  PC = Current->Code.data() + (Frame[PC[1]] ? PC[2] : PC[3]);
+  WYRM_DISPATCH(0);
+DoRet : {
+  Imm Result = Frame[PC[1]];
+  if (Calls.empty()) {
+    Outcome.ReturnValue = Result;
+    goto Exit;
+  }
+  CallRecord Record = Calls.back();
+  Calls.pop_back();
+  Current = Record.Caller;
+  Base = Record.Base;
+  Frame = Stack.data() + Base;
+  PC = Record.ReturnAddress;
+  if (Record.Result != NoSlot)
+    Frame[Record.Result] = Result;
+  WYRM_DISPATCH(0);
+}
+DoCall : {
+  if (Count > Limit)
+    goto OutOfLimit;
+  if (Calls.size() == CallDepthLimit) {
+    Outcome.Status = ExecutionResult::StackOverflow;
+    goto Exit;
+  }
+  const CompiledFunction &Callee = Functions[PC[1]];
+  const std::int32_t NumArguments = PC[3];
+  Calls.push_back({Current, PC + 4 + NumArguments, Base, PC[2]});
+  std::size_t CalleeBase = Base + Current->FrameSize;
+  Imm *CalleeFrame = enterFrame(Callee, CalleeBase);
+  // The stack might have moved.
+  Frame = Stack.data() + Base;
+  for (std::size_t I = 0; I < Callee.NumParams; ++I)
+    CalleeFrame[I] =
+        I < static_cast<std::size_t>(NumArguments) ? Frame[PC[4 + I]] : 0;
+  Current = &Callee;
+  Base = CalleeBase;
+  Frame = CalleeFrame;
+  PC = Callee.Code.data();
+  WYRM_DISPATCH(0);
+}
+DoLoadGlobal:
+  Frame[PC[1]] = Globals[PC[2]];
+  WYRM_DISPATCH(3);
+DoStoreGlobal:
+  Globals[PC[1]] = Frame[PC[2]];
+  WYRM_DISPATCH(3);
+Trap:
+  Outcome.Status = ExecutionResult::Trapped;
+  goto Exit;
+OutOfLimit:
+  Outcome.Status = ExecutionResult::LimitExceeded;
+Exit:
+  Calls.clear();
+  Executed += Count;
+  return Outcome;
+}
+
+#undef WYRM_UNOP_HANDLER
+#undef WYRM_BINOP_HANDLER
+#undef WYRM_DISPATCH
+#undef WYRM_HANDLER
+
+} // namespace wyrm
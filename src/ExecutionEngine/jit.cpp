@@ -0,0 +1,821 @@
+#include "ExecutionEngine/jit.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace wyrm {
+
+namespace {
+enum Register : std::uint8_t {
+  RAX,
+  RCX,
+  RDX,
+  RBX,
+  RSP,
+  RBP,
+  RSI,
+  RDI,
+  R8,
+  R9,
+  R10,
+  R11,
+  R12,
+  R13,
+  R14,
+  R15
+};
+
+/// \brief Condition codes of jcc, setcc and cmovcc.
+/// Flipping the lowest bit negates a condition.
+enum Condition : std::uint8_t {
+  CondE = 0x4,
+  CondNE = 0x5,
+  CondL = 0xC,
+  CondGE = 0xD,
+  CondLE = 0xE,
+  CondG = 0xF
+};
+
+/// \brief Binary ALU operations with the opcode of their r32, r/m32 form and
+/// the ModRM digit of their r/m32, imm form.
+enum class AluOp : std::uint16_t {
+  Add = 0x03 << 8 | 0,
+  Or = 0x0B << 8 | 1,
+  And = 0x23 << 8 | 4,
+  Sub = 0x2B << 8 | 5,
+  Xor = 0x33 << 8 | 6,
+  Cmp = 0x3B << 8 | 7
+};
+
+/// \brief Location of a 32-bit value.
+struct Location {
+  enum KindT { InRegister, OnStack, Constant };
+  KindT Kind;
+  Register Reg{RAX};
+  /// Offset from rbp or the constant.
+  std::int32_t Number{};
+  static Location reg(Register R) { return {InRegister, R, 0}; }
+  static Location stack(std::int32_t Offset) { return {OnStack, RAX, Offset}; }
+  static Location constant(Imm Number) { return {Constant, RAX, Number}; }
+  bool isRegister(Register R) const { return Kind == InRegister && Reg == R; }
+};
+
+/// \brief Encoder of the used subset of x86-64.
+/// Operations are 32-bit unless their name says otherwise, and memory
+/// operands are addressed relative to rbp.
+class Assembler {
+public:
+  std::size_t size() const { return Code.size(); }
+  const std::vector<std::uint8_t> &code() const { return Code; }
+  /// \brief Overwrite the rel32 field at \p Position with a jump to
+  /// \p Target.
+  void patch(std::size_t Position, std::size_t Target) {
+    auto Rel32 = static_cast<std::int32_t>(Target - (Position + 4));
+    std::memcpy(Code.data() + Position, &Rel32, sizeof(Rel32));
+  }
+  void mov(Register Dst, const Location &Src) {
+    if (Src.Kind == Location::Constant) {
+      if (!Src.Number)
+        return withModRM({0x31}, Dst, Location::reg(Dst));
+      rex(false, 0, Dst);
+      byte(0xB8 + (Dst & 7));
+      return dword(Src.Number);
+    }
+    if (!Src.isRegister(Dst))
+      withModRM({0x8B}, Dst, Src);
+  }
+  void store(const Location &Dst, Register Src) {
+    if (Dst.Kind == Location::InRegister)
+      return mov(Dst.Reg, Location::reg(Src));
+    withModRM({0x89}, Src, Dst);
+  }
+  void storeConstant(const Location &Dst, Imm Number) {
+    if (Dst.Kind == Location::InRegister)
+      return mov(Dst.Reg, Location::constant(Number));
+    withModRM({0xC7}, 0, Dst);
+    dword(Number);
+  }
+  void alu(AluOp Op, Register Dst, const Location &Src) {
+    auto Encoding = static_cast<std::uint16_t>(Op);
+    if (Src.Kind != Location::Constant)
+      return withModRM({static_cast<std::uint8_t>(Encoding >> 8)}, Dst, Src);
+    immediate(Encoding & 7, Location::reg(Dst), Src.Number);
+  }
+  /// \brief Compare the memory or register \p Lhs with \p Number.
+  void cmp(const Location &Lhs, Imm Number) { immediate(7, Lhs, Number); }
+  void imul(Register Dst, const Location &Src) {
+    if (Src.Kind != Location::Constant)
+      return withModRM({0x0F, 0xAF}, Dst, Src);
+    withModRM({0x69}, Dst, Location::reg(Dst));
+    dword(Src.Number);
+  }
+  void neg(Register Dst) { withModRM({0xF7}, 3, Location::reg(Dst)); }
+  void bitwiseNot(Register Dst) { withModRM({0xF7}, 2, Location::reg(Dst)); }
+  /// \brief Divide edx:eax by \p Divisor.
+  void idiv(const Location &Divisor) { withModRM({0xF7}, 7, Divisor); }
+  /// \brief edx:eax = eax * \p Factor, signed.
+  void imulWide(const Location &Factor) { withModRM({0xF7}, 5, Factor); }
+  void cdq() { byte(0x99); }
+  /// \brief Shift \p Dst by a constant or by cl.
+  /// \param Digit 4 for shl, 5 for shr and 7 for sar.
+  void shift(unsigned Digit, Register Dst, const Location &Amount) {
+    if (Amount.Kind != Location::Constant)
+      return withModRM({0xD3}, Digit, Location::reg(Dst));
+    withModRM({0xC1}, Digit, Location::reg(Dst));
+    byte(Amount.Number & 31);
+  }
+  void cmov(Condition Cond, Register Dst, const Location &Src) {
+    withModRM({0x0F, static_cast<std::uint8_t>(0x40 | Cond)}, Dst, Src);
+  }
+  /// \brief eax = Cond ? 1 : 0.
+  void setToEax(Condition Cond) {
+    byte(0x0F);
+    byte(0x90 | Cond);
+    byte(0xC0);
+    // movzx eax, al
+    byte(0x0F);
+    byte(0xB6);
+    byte(0xC0);
+  }
+  void test(Register R) { withModRM({0x85}, R, Location::reg(R)); }
+  /// \return Position of the rel32 field.
+  std::size_t jmp() { return rel32({0xE9}); }
+  std::size_t jcc(Condition Cond) {
+    return rel32({0x0F, static_cast<std::uint8_t>(0x80 | Cond)});
+  }
+  std::size_t call() { return rel32({0xE8}); }
+  void callRax() { withModRM({0xFF}, 2, Location::reg(RAX)); }
+  void push(Register R) {
+    rex(false, 0, R);
+    byte(0x50 + (R & 7));
+  }
+  void pop(Register R) {
+    rex(false, 0, R);
+    byte(0x58 + (R & 7));
+  }
+  void ret() { byte(0xC3); }
+  /// \brief 64-bit mov of \p Number to \p Dst.
+  void movabs(Register Dst, std::uint64_t Number) {
+    rex(true, 0, Dst);
+    byte(0xB8 + (Dst & 7));
+    for (int I = 0; I < 8; ++I)
+      byte(static_cast<std::uint8_t>(Number >> 8 * I));
+  }
+  /// \brief mov rbp, rsp.
+  void setFramePointer() { withModRM({0x89}, RSP, Location::reg(RBP), true); }
+  /// \brief lea rsp, [rbp + Offset].
+  void resetStackPointer(std::int32_t Offset) {
+    withModRM({0x8D}, RSP, Location::stack(Offset), true);
+  }
+  /// \brief rsp += Bytes.
+  void adjustStackPointer(std::int32_t Bytes) {
+    if (Bytes > 0)
+      immediate(0, Location::reg(RSP), Bytes, true);
+    else if (Bytes < 0)
+      immediate(5, Location::reg(RSP), -Bytes, true);
+  }
+  /// \brief Load a 32-bit value from \p Address using r11.
+  void load(Register Dst, const void *Address) {
+    movabs(R11, reinterpret_cast<std::uintptr_t>(Address));
+    rex(false, Dst, R11);
+    byte(0x8B);
+    byte((Dst & 7) << 3 | (R11 & 7));
+  }
+  /// \brief Store a 32-bit value to \p Address using r11.
+  void store(void *Address, Register Src) {
+    movabs(R11, reinterpret_cast<std::uintptr_t>(Address));
+    rex(false, Src, R11);
+    byte(0x89);
+    byte((Src & 7) << 3 | (R11 & 7));
+  }
+
+private:
+  void byte(std::uint8_t Byte) { Code.push_back(Byte); }
+  void dword(std::int32_t Number) {
+    for (int I = 0; I < 4; ++I)
+      byte(static_cast<std::uint8_t>(static_cast<std::uint32_t>(Number) >>
+                                     8 * I));
+  }
+  void rex(bool Wide, unsigned Reg, unsigned Base) {
+    unsigned Prefix = 0x40 | Wide << 3 | (Reg >> 3) << 2 | Base >> 3;
+    if (Prefix != 0x40)
+      byte(static_cast<std::uint8_t>(Prefix));
+  }
+  /// \brief Emit \p Opcode with a ModRM byte of the register or digit
+  /// \p Reg and the register or stack operand \p RM.
+  void withModRM(std::initializer_list<std::uint8_t> Opcode, unsigned Reg,
+                 const Location &RM, bool Wide = false) {
+    assert(RM.Kind != Location::Constant && "Constant can't be an r/m");
+    unsigned Base = RM.Kind == Location::InRegister ? RM.Reg : RBP;
+    rex(Wide, Reg, Base);
+    for (auto Byte : Opcode)
+      byte(Byte);
+    if (RM.Kind == Location::InRegister) {
+      byte(static_cast<std::uint8_t>(0xC0 | (Reg & 7) << 3 | (Base & 7)));
+      return;
+    }
+    byte(static_cast<std::uint8_t>(0x80 | (Reg & 7) << 3 | (Base & 7)));
+    dword(RM.Number);
+  }
+  /// \brief Group 1 operation \p Digit of \p RM and \p Number.
+  void immediate(unsigned Digit, const Location &RM, std::int32_t Number,
+                 bool Wide = false) {
+    bool IsShort = Number >= -128 && Number <= 127;
+    withModRM({IsShort ? std::uint8_t{0x83} : std::uint8_t{0x81}}, Digit, RM,
+              Wide);
+    if (IsShort)
+      byte(static_cast<std::uint8_t>(Number));
+    else
+      dword(Number);
+  }
+  std::size_t rel32(std::initializer_list<std::uint8_t> Opcode) {
+    for (auto Byte : Opcode)
+      byte(Byte);
+    std::size_t Position = size();
+    dword(0);
+    return Position;
+  }
+  std::vector<std::uint8_t> Code{};
+};
+
+constexpr Register ArgumentRegisters[] = {RDI, RSI, RDX, RCX, R8, R9};
+constexpr std::size_t NumArgumentRegisters = std::size(ArgumentRegisters);
+constexpr Register CalleeSaved[] = {RBX, R12, R13, R14, R15};
+// rax, rcx, rdx and r11 are scratch registers of the templates.
+constexpr Register CallerSaved[] = {RSI, RDI, R8, R9, R10};
+
+bool isCommutative(BinOpKind Kind) {
+  return Kind == BinOpKind::Add || Kind == BinOpKind::Mul ||
+         Kind == BinOpKind::And || Kind == BinOpKind::Or ||
+         Kind == BinOpKind::Xor;
+}
+
+Condition condition(BinOpKind Kind) {
+  switch (Kind) {
+  case BinOpKind::Eq:
+    return CondE;
+  case BinOpKind::Neq:
+    return CondNE;
+  case BinOpKind::Less:
+    return CondL;
+  case BinOpKind::Leq:
+    return CondLE;
+  case BinOpKind::Greater:
+    return CondG;
+  default:
+    assert(Kind == BinOpKind::Geq && "Not a comparison");
+    return CondGE;
+  }
+}
+
+Condition negate(Condition Cond) { return static_cast<Condition>(Cond ^ 1); }
+
+/// \brief Multiplier and shift replacing a division by a constant.
+struct MagicNumber {
+  std::int32_t Multiplier;
+  unsigned Shift;
+};
+
+/// \brief Compute the magic number of \p Divisor as in Hacker's Delight,
+/// 10-1: the quotient of n is the high half of n * Multiplier, plus n if
+/// Multiplier and Divisor have different signs, shifted right by Shift and
+/// rounded towards zero.
+/// \pre |Divisor| >= 2.
+MagicNumber magic(Imm Divisor) {
+  const std::uint32_t TwoTo31 = 0x80000000u;
+  const std::uint32_t D = static_cast<std::uint32_t>(Divisor);
+  const std::uint32_t AbsD = Divisor < 0 ? 0u - D : D;
+  assert(AbsD >= 2 && "Divisions by 0 and +-1 aren't replaced");
+  const std::uint32_t T = TwoTo31 + (D >> 31);
+  // |nc|, the largest n with rem(n, d) = d - 1.
+  const std::uint32_t AbsNc = T - 1 - T % AbsD;
+  unsigned P = 31;
+  std::uint32_t Q1 = TwoTo31 / AbsNc, R1 = TwoTo31 - Q1 * AbsNc;
+  std::uint32_t Q2 = TwoTo31 / AbsD, R2 = TwoTo31 - Q2 * AbsD;
+  std::uint32_t Delta;
+  do {
+    ++P;
+    Q1 *= 2;
+    R1 *= 2;
+    if (R1 >= AbsNc) {
+      ++Q1;
+      R1 -= AbsNc;
+    }
+    Q2 *= 2;
+    R2 *= 2;
+    if (R2 >= AbsD) {
+      ++Q2;
+      R2 -= AbsD;
+    }
+    Delta = AbsD - R2;
+  } while (Q1 < Delta || (Q1 == Delta && R1 == 0));
+  const std::uint32_t Multiplier = Divisor < 0 ? 0u - (Q2 + 1) : Q2 + 1;
+  return {static_cast<std::int32_t>(Multiplier), P - 32};
+}
+
+/// \brief Call in a batch of functions compiled together.
+struct CallFixup {
+  std::size_t Position;
+  const Function *Callee;
+};
+} // namespace
+
+/// \brief Translation of a function into an assembler.
+class JITCompiler::FunctionCompiler {
+public:
+  /// \param Batch Offsets of the functions compiled together with \p F,
+  /// calls to which are collected in \p Calls.
+  FunctionCompiler(
+      JITCompiler &JIT, Assembler &Asm, const Function &F,
+      const std::unordered_map<const Function *, std::size_t> &Batch,
+      std::vector<CallFixup> &Calls)
+      : JIT{JIT}, Asm{Asm}, F{F}, Batch{Batch}, Calls{Calls} {}
+  void run();
+
+private:
+  void allocate();
+  /// \brief Stack slot \p Number of the frame.
+  /// Slots of parameters passed in registers come first, then slots of
+  /// spilled registers. They are below the saved registers.
+  Location slot(std::size_t Number) const;
+  /// \return Location of the \p K-th parameter.
+  Location parameter(std::size_t K) const;
+  void prologue();
+  void epilogue();
+  /// \return Location of \p V. A global variable is loaded into \p Scratch.
+  Location operand(Value V, Register Scratch);
+  /// \return The register \p Out is cached in or rax.
+  Register target(const SymReg &Out) const;
+  void write(const SymReg &Out, Register Src);
+  void jumpTo(const BasicBlock &BB);
+  /// \brief Jump to \p True if \p Cond holds and to \p False otherwise.
+  void branch(Condition Cond, const BasicBlock &True, const BasicBlock &False);
+  /// \return If \p BinOp is a comparison fused with the branch \p Next.
+  bool isFused(const BinOpInst &BinOp, const Instruction *Next) const;
+  void compile(const BinOpInst &BinOp, const BrInst *FusedBranch);
+  /// \brief Divide \p LHS by \p Divisor with a multiplication.
+  /// \pre |Divisor| >= 2.
+  void divide(const BinOpInst &BinOp, const Location &LHS, Imm Divisor);
+  void compile(const UnOpInst &UnOp);
+  void compile(const CallInst &Call);
+  void compile(const BrInst &Br);
+  JITCompiler &JIT;
+  Assembler &Asm;
+  const Function &F;
+  const std::unordered_map<const Function *, std::size_t> &Batch;
+  std::vector<CallFixup> &Calls;
+  std::vector<Location> Locations{};
+  std::vector<unsigned> NumUses{};
+  std::vector<Register> Saved{};
+  std::size_t NumParams{};
+  std::size_t NumReceives{};
+  std::int32_t FrameBytes{};
+  const BasicBlock *NextBlock{};
+  std::unordered_map<const BasicBlock *, std::size_t> Labels{};
+  std::vector<std::pair<std::size_t, const BasicBlock *>> Jumps{};
+};
+
+void JITCompiler::FunctionCompiler::allocate() {
+  const std::size_t NumRegs{F.symbolicRegisters().size()};
+  NumUses.assign(NumRegs, 0);
+  std::vector<unsigned> NumReferences(NumRegs);
+  bool IsLeaf{true};
+  for (const auto &BB : F)
+    for (const Instruction &Inst : BB) {
+      assert(!get<PhiInst>(&Inst) && "Phis aren't supported");
+      IsLeaf &= !get<CallInst>(&Inst);
+      NumParams += get<ReceiveInst>(&Inst) != nullptr;
+      forEachOperand(Inst, [&](Value V) {
+        SymReg *Reg = get<SymReg>(&V);
+        if (Reg && Reg->isLocal()) {
+          ++NumUses[Reg->index()];
+          ++NumReferences[Reg->index()];
+        }
+      });
+      SymReg *Reg = definedRegister(const_cast<Instruction &>(Inst));
+      if (Reg && Reg->isLocal())
+        ++NumReferences[Reg->index()];
+    }
+  std::vector<std::size_t> Order(NumRegs);
+  std::iota(std::begin(Order), std::end(Order), 0);
+  std::stable_sort(std::begin(Order), std::end(Order),
+                   [&NumReferences](std::size_t A, std::size_t B) {
+                     return NumReferences[A] > NumReferences[B];
+                   });
+  // Caller-saved registers are free to use in leaves and need no saving.
+  std::vector<Register> Pool;
+  if (IsLeaf)
+    Pool.assign(std::begin(CallerSaved), std::end(CallerSaved));
+  Pool.insert(std::end(Pool), std::begin(CalleeSaved), std::end(CalleeSaved));
+
+  Locations.assign(NumRegs, Location::stack(0));
+  std::size_t NumCached{}, NumSpilled{};
+  std::vector<std::size_t> Spilled;
+  for (auto Index : Order) {
+    if (!NumReferences[Index])
+      break;
+    if (NumCached == Pool.size()) {
+      Spilled.push_back(Index);
+      continue;
+    }
+    Register R = Pool[NumCached++];
+    Locations[Index] = Location::reg(R);
+    if (std::find(std::begin(CalleeSaved), std::end(CalleeSaved), R) !=
+        std::end(CalleeSaved))
+      Saved.push_back(R);
+  }
+  const std::size_t NumParamSlots = std::min(NumParams, NumArgumentRegisters);
+  for (auto Index : Spilled)
+    Locations[Index] = slot(NumParamSlots + NumSpilled++);
+  const auto SavedBytes = static_cast<std::int32_t>(8 * Saved.size());
+  // rsp is aligned to 16 bytes after pushing rbp, keep it so at calls.
+  std::int32_t Bytes =
+      SavedBytes + 4 * static_cast<std::int32_t>(NumParamSlots + NumSpilled);
+  FrameBytes = (Bytes + 15) / 16 * 16 - SavedBytes;
+}
+
+Location JITCompiler::FunctionCompiler::slot(std::size_t Number) const {
+  return Location::stack(-static_cast<std::int32_t>(8 * Saved.size() +
+                                                    4 * (Number + 1)));
+}
+
+Location JITCompiler::FunctionCompiler::parameter(std::size_t K) const {
+  if (K < NumArgumentRegisters)
+    return slot(K);
+  // Above the return address and the saved rbp.
+  return Location::stack(
+      static_cast<std::int32_t>(16 + 8 * (K - NumArgumentRegisters)));
+}
+
+void JITCompiler::FunctionCompiler::prologue() {
+  Asm.push(RBP);
+  Asm.setFramePointer();
+  for (auto R : Saved)
+    Asm.push(R);
+  Asm.adjustStackPointer(-FrameBytes);
+  for (std::size_t K = 0; K < std::min(NumParams, NumArgumentRegisters); ++K)
+    Asm.store(parameter(K), ArgumentRegisters[K]);
+  // Registers read before being written are 0.
+  for (std::size_t Index = 0, E = Locations.size(); Index < E; ++Index)
+    if (NumUses[Index])
+      Asm.storeConstant(Locations[Index], 0);
+}
+
+void JITCompiler::FunctionCompiler::epilogue() {
+  Asm.resetStackPointer(-static_cast<std::int32_t>(8 * Saved.size()));
+  for (auto It = Saved.rbegin(), E = Saved.rend(); It != E; ++It)
+    Asm.pop(*It);
+  Asm.pop(RBP);
+  Asm.ret();
+}
+
+Location JITCompiler::FunctionCompiler::operand(Value V, Register Scratch) {
+  if (const Imm *Number = get<Imm>(&V))
+    return Location::constant(*Number);
+  const SymReg &Reg = *get<SymReg>(&V);
+  if (Reg.isLocal())
+    return Locations[Reg.index()];
+  Asm.load(Scratch, JIT.globalAddress(Reg));
+  return Location::reg(Scratch);
+}
+
+Register JITCompiler::FunctionCompiler::target(const SymReg &Out) const {
+  if (!Out.isLocal())
+    return RAX;
+  const Location &Loc = Locations[Out.index()];
+  return Loc.Kind == Location::InRegister ? Loc.Reg : RAX;
+}
+
+void JITCompiler::FunctionCompiler::write(const SymReg &Out, Register Src) {
+  if (Out.isLocal())
+    Asm.store(Locations[Out.index()], Src);
+  else
+    Asm.store(JIT.globalAddress(Out), Src);
+}
+
+void JITCompiler::FunctionCompiler::jumpTo(const BasicBlock &BB) {
+  if (&BB != NextBlock)
+    Jumps.emplace_back(Asm.jmp(), &BB);
+}
+
+void JITCompiler::FunctionCompiler::branch(Condition Cond,
+                                           const BasicBlock &True,
+                                           const BasicBlock &False) {
+  if (&True == NextBlock) {
+    Jumps.emplace_back(Asm.jcc(negate(Cond)), &False);
+    return;
+  }
+  Jumps.emplace_back(Asm.jcc(Cond), &True);
+  jumpTo(False);
+}
+
+bool JITCompiler::FunctionCompiler::isFused(const BinOpInst &BinOp,
+                                            const Instruction *Next) const {
+  if (BinOp.kind() < BinOpKind::Eq || !Next)
+    return false;
+  auto *Br = get<BrInst>(Next);
+  if (!Br)
+    return false;
+  Value Condition = Br->condition();
+  const SymReg &Out = BinOp.outRegister();
+  return get<SymReg>(&Condition) == &Out && Out.isLocal() &&
+         NumUses[Out.index()] == 1;
+}
+
+void JITCompiler::FunctionCompiler::compile(const BinOpInst &BinOp,
+                                            const BrInst *FusedBranch) {
+  const BinOpKind Kind = BinOp.kind();
+  const SymReg &Out = BinOp.outRegister();
+  // A global operand is loaded into the scratch register of its position.
+  Location RHS = operand(BinOp.operand2(), RCX);
+  Location LHS = operand(BinOp.operand1(), RAX);
+  switch (Kind) {
+  case BinOpKind::Add:
+  case BinOpKind::Sub:
+  case BinOpKind::Mul:
+  case BinOpKind::And:
+  case BinOpKind::Or:
+  case BinOpKind::Xor: {
+    Register Dst = target(Out);
+    if (Dst != RAX && RHS.isRegister(Dst)) {
+      if (isCommutative(Kind))
+        std::swap(LHS, RHS);
+      else
+        Dst = RAX;
+    }
+    Asm.mov(Dst, LHS);
+    if (Kind == BinOpKind::Mul)
+      Asm.imul(Dst, RHS);
+    else
+      Asm.alu(Kind == BinOpKind::Add   ? AluOp::Add
+              : Kind == BinOpKind::Sub ? AluOp::Sub
+              : Kind == BinOpKind::And ? AluOp::And
+              : Kind == BinOpKind::Or  ? AluOp::Or
+                                       : AluOp::Xor,
+              Dst, RHS);
+    return write(Out, Dst);
+  }
+  case BinOpKind::Div:
+  case BinOpKind::Mod:
+    // Division by 0 and the overflow of Min / -1 still trap in idiv.
+    if (RHS.Kind == Location::Constant && (RHS.Number < -1 || RHS.Number > 1))
+      return divide(BinOp, LHS, RHS.Number);
+    if (RHS.Kind == Location::Constant) {
+      Asm.mov(RCX, RHS);
+      RHS = Location::reg(RCX);
+    }
+    Asm.mov(RAX, LHS);
+    Asm.cdq();
+    Asm.idiv(RHS);
+    return write(Out, Kind == BinOpKind::Div ? RAX : RDX);
+  case BinOpKind::Shl:
+  case BinOpKind::Shr:
+  case BinOpKind::Shra: {
+    if (RHS.Kind != Location::Constant)
+      Asm.mov(RCX, RHS);
+    Register Dst = target(Out);
+    Asm.mov(Dst, LHS);
+    Asm.shift(Kind == BinOpKind::Shl ? 4 : Kind == BinOpKind::Shr ? 5 : 7,
+              Dst, RHS);
+    return write(Out, Dst);
+  }
+  case BinOpKind::Min:
+  case BinOpKind::Max: {
+    if (RHS.Kind == Location::Constant) {
+      Asm.mov(RCX, RHS);
+      RHS = Location::reg(RCX);
+    }
+    Register Dst = RHS.isRegister(target(Out)) ? RAX : target(Out);
+    Asm.mov(Dst, LHS);
+    Asm.alu(AluOp::Cmp, Dst, RHS);
+    Asm.cmov(Kind == BinOpKind::Min ? CondG : CondL, Dst, RHS);
+    return write(Out, Dst);
+  }
+  default: {
+    Register Lhs = RAX;
+    if (LHS.Kind == Location::InRegister)
+      Lhs = LHS.Reg;
+    else
+      Asm.mov(RAX, LHS);
+    Asm.alu(AluOp::Cmp, Lhs, RHS);
+    if (FusedBranch)
+      return branch(condition(Kind), FusedBranch->trueSuccessor(),
+                    FusedBranch->falseSuccessor());
+    Asm.setToEax(condition(Kind));
+    return write(Out, RAX);
+  }
+  }
+}
+
+void JITCompiler::FunctionCompiler::divide(const BinOpInst &BinOp,
+                                           const Location &LHS, Imm Divisor) {
+  const auto [Multiplier, Shift] = magic(Divisor);
+  Asm.mov(RCX, LHS);
+  Asm.mov(RAX, Location::constant(Multiplier));
+  Asm.imulWide(Location::reg(RCX));
+  if (Divisor > 0 && Multiplier < 0)
+    Asm.alu(AluOp::Add, RDX, Location::reg(RCX));
+  else if (Divisor < 0 && Multiplier > 0)
+    Asm.alu(AluOp::Sub, RDX, Location::reg(RCX));
+  if (Shift)
+    Asm.shift(7, RDX, Location::constant(static_cast<Imm>(Shift)));
+  // Add 1 to negative quotients to round them towards zero.
+  Asm.mov(RAX, Location::reg(RDX));
+  Asm.shift(5, RAX, Location::constant(31));
+  Asm.alu(AluOp::Add, RDX, Location::reg(RAX));
+  if (BinOp.kind() == BinOpKind::Div)
+    return write(BinOp.outRegister(), RDX);
+  Asm.imul(RDX, Location::constant(Divisor));
+  Asm.mov(RAX, Location::reg(RCX));
+  Asm.alu(AluOp::Sub, RAX, Location::reg(RDX));
+  write(BinOp.outRegister(), RAX);
+}
+
+void JITCompiler::FunctionCompiler::compile(const UnOpInst &UnOp) {
+  const SymReg &Out = UnOp.outRegister();
+  Location Operand = operand(UnOp.operand(), RAX);
+  if (UnOp.kind() == UnOpKind::Assign && Out.isLocal() &&
+      Operand.Kind == Location::Constant)
+    return Asm.storeConstant(Locations[Out.index()], Operand.Number);
+  Register Dst = target(Out);
+  Asm.mov(Dst, Operand);
+  if (UnOp.kind() == UnOpKind::Neg)
+    Asm.neg(Dst);
+  else if (UnOp.kind() == UnOpKind::Not)
+    Asm.bitwiseNot(Dst);
+  write(Out, Dst);
+}
+
+void JITCompiler::FunctionCompiler::compile(const CallInst &Call) {
+  const Function &Callee = Call.callee();
+  // Callees always get as many arguments as they receive.
+  const std::size_t NumArguments = numParameters(Callee);
+  auto Argument = [&Call](std::size_t K) -> Value {
+    return K < Call.numArguments() ? Call.argument(K) : Value{0};
+  };
+  const std::size_t NumPushed =
+      NumArguments > NumArgumentRegisters
+          ? NumArguments - NumArgumentRegisters
+          : 0;
+  const auto PushedBytes = static_cast<std::int32_t>(8 * (NumPushed % 2));
+  Asm.adjustStackPointer(-PushedBytes);
+  for (std::size_t K = NumArguments; K-- > NumArgumentRegisters;) {
+    Asm.mov(RAX, operand(Argument(K), RAX));
+    Asm.push(RAX);
+  }
+  for (std::size_t K = 0; K < std::min(NumArguments, NumArgumentRegisters);
+       ++K) {
+    Register Dst = ArgumentRegisters[K];
+    Asm.mov(Dst, operand(Argument(K), Dst));
+  }
+  if (Batch.count(&Callee)) {
+    Calls.push_back({Asm.call(), &Callee});
+  } else {
+    Asm.movabs(RAX, reinterpret_cast<std::uintptr_t>(JIT.Entries.at(&Callee)));
+    Asm.callRax();
+  }
+  Asm.adjustStackPointer(
+      PushedBytes + static_cast<std::int32_t>(8 * NumPushed));
+  if (SymReg *Out = Call.outRegister())
+    write(*Out, RAX);
+}
+
+void JITCompiler::FunctionCompiler::compile(const BrInst &Br) {
+  Location Condition = operand(Br.condition(), RAX);
+  if (Condition.Kind == Location::Constant)
+    return jumpTo(Condition.Number ? Br.trueSuccessor() : Br.falseSuccessor());
+  if (Condition.Kind == Location::InRegister)
+    Asm.test(Condition.Reg);
+  else
+    Asm.cmp(Condition, 0);
+  branch(CondNE, Br.trueSuccessor(), Br.falseSuccessor());
+}
+
+void JITCompiler::FunctionCompiler::run() {
+  allocate();
+  prologue();
+  for (auto It = std::begin(F), E = std::end(F); It != E; ++It) {
+    const BasicBlock &BB = *It;
+    assert(!BB.empty() && isTerminator(*std::prev(std::end(BB))) &&
+           "Every block must end with a terminator");
+    auto Next = std::next(It);
+    NextBlock = Next != E ? &*Next : nullptr;
+    Labels[&BB] = Asm.size();
+    for (auto InstIt = std::begin(BB), InstE = std::end(BB); InstIt != InstE;
+         ++InstIt) {
+      const Instruction &Inst = *InstIt;
+      if (auto *BinOp = get<BinOpInst>(&Inst)) {
+        auto NextInst = std::next(InstIt);
+        if (isFused(*BinOp, NextInst != InstE ? &*NextInst : nullptr)) {
+          compile(*BinOp, get<BrInst>(&*NextInst));
+          ++InstIt;
+        } else {
+          compile(*BinOp, nullptr);
+        }
+      } else if (auto *UnOp = get<UnOpInst>(&Inst)) {
+        compile(*UnOp);
+      } else if (auto *Receive = get<ReceiveInst>(&Inst)) {
+        Register Dst = target(Receive->outRegister());
+        Asm.mov(Dst, parameter(NumReceives++));
+        write(Receive->outRegister(), Dst);
+      } else if (auto *Call = get<CallInst>(&Inst)) {
+        compile(*Call);
+      } else if (auto *Ret = get<RetInst>(&Inst)) {
+        Asm.mov(RAX, operand(Ret->operand(), RAX));
+        epilogue();
+      } else if (auto *GoTo = get<GoToInst>(&Inst)) {
+        jumpTo(GoTo->successor());
+      } else {
+        compile(get<BrInst>(Inst));
+      }
+    }
+  }
+  // A function without blocks returns 0.
+  if (!F.size()) {
+    Asm.mov(RAX, Location::constant(0));
+    epilogue();
+  }
+  for (auto [Position, BB] : Jumps)
+    Asm.patch(Position, Labels.at(BB));
+}
+
+std::size_t JITCompiler::numParameters(const Function &F) {
+  std::size_t Count{};
+  for (const auto &BB : F)
+    for (const Instruction &Inst : BB)
+      Count += get<ReceiveInst>(&Inst) != nullptr;
+  return Count;
+}
+
+Imm *JITCompiler::globalAddress(const SymReg &Var) {
+  assert(!Var.isLocal() && &Var.parent<Module>() == &TheModule &&
+         "Not a global variable of the module");
+  // Growing a deque at the end keeps references to its elements.
+  if (Globals.size() <= Var.index())
+    Globals.resize(Var.index() + 1);
+  return &Globals[Var.index()];
+}
+
+Imm JITCompiler::global(const SymReg &Var) const {
+  assert(!Var.isLocal() && "Not a global variable");
+  return Var.index() < Globals.size() ? Globals[Var.index()] : 0;
+}
+
+void *JITCompiler::compileFunction(const Function &F) {
+  assert(IsSupported && "The host can't run x86-64 code");
+  assert(&F.parent() == &TheModule && "The function is in another module");
+  if (auto It = Entries.find(&F); It != std::end(Entries))
+    return It->second;
+  // Compile the new functions reachable through calls together, so they
+  // call each other directly.
+  std::unordered_map<const Function *, std::size_t> Batch{{&F, 0}};
+  std::vector<const Function *> Order{&F};
+  for (std::size_t I = 0; I < Order.size(); ++I)
+    for (const auto &BB : *Order[I])
+      for (const Instruction &Inst : BB) {
+        auto *Call = get<CallInst>(&Inst);
+        if (Call && !Entries.count(&Call->callee()) &&
+            Batch.emplace(&Call->callee(), 0).second)
+          Order.push_back(&Call->callee());
+      }
+  Assembler Asm;
+  std::vector<CallFixup> Calls;
+  for (auto *G : Order) {
+    Batch[G] = Asm.size();
+    FunctionCompiler{*this, Asm, *G, Batch, Calls}.run();
+  }
+  for (auto [Position, Callee] : Calls)
+    Asm.patch(Position, Batch.at(Callee));
+
+#if defined(__x86_64__) && defined(__linux__)
+  const auto PageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  const std::size_t Size = (Asm.size() + PageSize - 1) / PageSize * PageSize;
+  void *Memory = mmap(nullptr, Size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (Memory == MAP_FAILED)
+    return nullptr;
+  std::memcpy(Memory, Asm.code().data(), Asm.size());
+  if (mprotect(Memory, Size, PROT_READ | PROT_EXEC)) {
+    munmap(Memory, Size);
+    return nullptr;
+  }
+  Mappings.emplace_back(Memory, Size);
+  for (auto *G : Order)
+    Entries[G] = static_cast<std::uint8_t *>(Memory) + Batch.at(G);
+#endif
+  return Entries[&F];
+}
+
+JITCompiler::~JITCompiler() {
+#if defined(__x86_64__) && defined(__linux__)
+  for (auto [Memory, Size] : Mappings)
+    munmap(Memory, Size);
+#endif
+}
+
+} // namespace wyrm
@@ -6,18 +6,17 @@
 
 namespace wyrm {
 
-static size_t bbNumber(const BasicBlock &BB) {
-  if (BB.hasLabel())
-    return 0;
-  size_t BBNum{1};
-  auto &Func = BB.parent();
-  for (const auto &CurrBB : Func) {
-    if (&BB == &CurrBB)
-      break;
-    BBNum += !CurrBB.hasLabel();
-  }
-  return BBNum;
-}
+// Instruction classes are views of the same record.
+static_assert(sizeof(Instruction) == 32, "Instruction isn't compact");
+static_assert(sizeof(ReceiveInst) == sizeof(Instruction) &&
+                  sizeof(RetInst) == sizeof(Instruction) &&
+                  sizeof(GoToInst) == sizeof(Instruction) &&
+                  sizeof(BrInst) == sizeof(Instruction) &&
+                  sizeof(CallInst) == sizeof(Instruction) &&
+                  sizeof(UnOpInst) == sizeof(Instruction) &&
+                  sizeof(BinOpInst) == sizeof(Instruction) &&
+                  sizeof(PhiInst) == sizeof(Instruction),
+              "Instruction classes mustn't add data");
 
 std::ostream &operator<<(std::ostream &Stream, const ReceiveInst &Inst) {
   Stream << "  " << Inst.outRegister() << " = receive\n";
@@ -26,9 +25,9 @@ std::ostream &operator<<(std::ostream &Stream, const ReceiveInst &Inst) {
 
 static void dumpLabel(std::ostream &Stream, const BasicBlock &BB) {
   if (BB.hasLabel())
-    Stream << GlobalContext.Names.at(&BB);
+    Stream << BB.label();
   else
-    Stream << "BB" << std::to_string(bbNumber(BB));
+    Stream << "BB" << BB.number();
 }
 
 std::ostream &operator<<(std::ostream &Stream, const GoToInst &Inst) {
@@ -63,12 +62,8 @@ std::ostream &operator<<(std::ostream &Stream, const CallInst &Inst) {
   if (RetVal)
     Stream << *RetVal << " = call ";
   Stream << Inst.callee().Name << "(";
-  auto It = std::cbegin(Inst);
-  if (It != std::cend(Inst)) {
-    for (auto E = std::prev(std::cend(Inst)); It != E; ++It)
-      Stream << *It << ", ";
-    Stream << *It;
-  }
+  for (size_t I = 0, E = Inst.numArguments(); I != E; ++I)
+    Stream << (I ? ", " : "") << Inst.argument(I);
   Stream << ")\n";
   return Stream;
 }
@@ -101,44 +96,343 @@ std::ostream &operator<<(std::ostream &Stream, const BinOpInst &Inst) {
   return Stream;
 }
 
+std::ostream &operator<<(std::ostream &Stream, const PhiInst &Inst) {
+  Stream << "  " << Inst.outRegister() << " = phi ";
+  for (size_t I = 0, E = Inst.size(); I != E; ++I) {
+    Stream << (I ? ", [" : "[") << Inst.incomingValue(I) << ", ";
+    dumpLabel(Stream, Inst.incomingBlock(I));
+    Stream << "]";
+  }
+  Stream << "\n";
+  return Stream;
+}
+
 std::ostream &operator<<(std::ostream &Stream, const Instruction &Inst) {
   visit([&Stream](auto &&Arg) { Stream << Arg; }, Inst);
   return Stream;
 }
 
-std::ostream &operator<<(std::ostream &stream, const SymReg &symReg) {
-  if (symReg.HasName)
-    stream << "%" << GlobalContext.Names.at(&symReg);
-  else {
-    auto &Func = symReg.parent<Function>();
-    auto It =
-        std::find_if(std::cbegin(Func.symbolicRegisters()),
-                     std::cend(Func.symbolicRegisters()),
-                     [&symReg](const SymReg &Reg) { return &symReg == &Reg; });
-    size_t Number = It - std::cbegin(Func.symbolicRegisters()) + 1;
-    stream << "%" << Number;
+/// Instructions which always define a register.
+template <typename InstT>
+constexpr bool HasOutRegister =
+    std::is_base_of_v<detail::ReturningInstBase<SymReg &>, InstT>;
+
+SymReg *definedRegister(Instruction &Inst) {
+  return visit(
+      [](auto &&Arg) -> SymReg * {
+        using InstT = std::decay_t<decltype(Arg)>;
+        if constexpr (std::is_same_v<InstT, CallInst>)
+          return Arg.outRegister();
+        else if constexpr (HasOutRegister<InstT>)
+          return &Arg.outRegister();
+        else
+          return nullptr;
+      },
+      Inst);
+}
+
+bool mightTrap(const Instruction &Inst) {
+  auto *BinOp = get<BinOpInst>(&Inst);
+  if (!BinOp ||
+      (BinOp->kind() != BinOpKind::Div && BinOp->kind() != BinOpKind::Mod))
+    return false;
+  Value LHS = BinOp->operand1(), RHS = BinOp->operand2();
+  const Imm *Divisor = get<Imm>(&RHS);
+  if (!Divisor || *Divisor == 0)
+    return true;
+  const Imm *Dividend = get<Imm>(&LHS);
+  return *Divisor == -1 &&
+         (!Dividend || *Dividend == std::numeric_limits<Imm>::min());
+}
+
+void setDefinedRegister(Instruction &Inst, SymReg &Register) {
+  visit(
+      [&Register](auto &&Arg) {
+        using InstT = std::decay_t<decltype(Arg)>;
+        if constexpr (std::is_same_v<InstT, CallInst>)
+          Arg.setOutRegister(&Register);
+        else if constexpr (HasOutRegister<InstT>)
+          Arg.setOutRegister(Register);
+        else
+          assert(false && "The instruction doesn't define a register");
+      },
+      Inst);
+}
+
+Instruction &InstructionList::insert(std::size_t Position,
+                                     Instruction &&Inst) {
+  assert(Position <= Size && "Insert position is out of the list");
+  auto [Last, LastOffset] = locate(Size);
+  if (LastOffset == 0 && Last == Segments.size()) {
+    const std::size_t Slots = segmentSize(Last);
+    auto *Segment = static_cast<Instruction *>(
+        arena().allocate(Slots * sizeof(Instruction), alignof(Instruction)));
+    for (std::size_t I = 0; I < Slots; ++I)
+      new (Segment + I) Instruction();
+    // Most blocks fit into two segments.
+    if (Segments.empty())
+      Segments.reserve(2);
+    Segments.push_back(Segment);
+  }
+  // Shift [Position, Size) up by one slot a segment at a time.
+  for (std::size_t To = Size; To > Position;) {
+    auto [Segment, Offset] = locate(To);
+    Instruction *Slots = Segments[Segment];
+    if (Offset == 0) {
+      Slots[0] = std::move(slot(To - 1));
+      --To;
+      continue;
+    }
+    std::size_t Count = std::min(Offset, To - Position);
+    std::move_backward(Slots + Offset - Count, Slots + Offset,
+                       Slots + Offset + 1);
+    To -= Count;
   }
+  ++Size;
+  return slot(Position) = std::move(Inst);
+}
+
+void InstructionList::erase(std::size_t Position) {
+  assert(Position < Size && "No instruction to erase");
+  slot(Position).dropUses();
+  // Shift (Position, Size) down by one slot a segment at a time.
+  for (std::size_t To = Position; To + 1 < Size;) {
+    auto [Segment, Offset] = locate(To);
+    Instruction *Slots = Segments[Segment];
+    if (Offset + 1 == segmentSize(Segment)) {
+      Slots[Offset] = std::move(slot(To + 1));
+      ++To;
+      continue;
+    }
+    std::size_t Count =
+        std::min(segmentSize(Segment) - Offset - 1, Size - To - 1);
+    std::move(Slots + Offset + 1, Slots + Offset + 1 + Count, Slots + Offset);
+    To += Count;
+  }
+  --Size;
+}
+
+void InstructionList::erase(const std::vector<std::size_t> &Positions) {
+  if (Positions.empty())
+    return;
+  assert(std::is_sorted(std::begin(Positions), std::end(Positions)) &&
+         Positions.back() < Size && "No instructions to erase");
+  auto Erased = std::begin(Positions);
+  iterator Kept{*this, *Erased};
+  iterator Current = Kept;
+  for (std::size_t Index = *Erased; Index < Size; ++Index, ++Current) {
+    if (Erased != std::end(Positions) && *Erased == Index) {
+      Current->dropUses();
+      ++Erased;
+      continue;
+    }
+    *Kept = std::move(*Current);
+    ++Kept;
+  }
+  Size -= Positions.size();
+}
+
+void InstructionList::clear() {
+  for (Instruction &Inst : *this)
+    Inst.dropUses();
+  Size = 0;
+}
+
+detail::Handle &Instruction::operandHandle(std::size_t Index) {
+  assert(Index < numUseSlots() && "No such operand");
+  switch (Op) {
+  case Opcode::Br:
+    return Out;
+  case Opcode::Call:
+    return Call->arguments()[Index];
+  case Opcode::Phi:
+    return Phi->incoming()[2 * Index + 1];
+  default:
+    return Operands[Index];
+  }
+}
+
+void Instruction::allocateUses(std::size_t Count, std::size_t Kept) {
+  assert(Count && Kept <= Count && "Nothing to allocate");
+  using detail::UseGroup, detail::UsesPerGroup;
+  const std::size_t NumGroups = (Count + UsesPerGroup - 1) / UsesPerGroup;
+  const std::size_t InLast = Count - (NumGroups - 1) * UsesPerGroup;
+  // The old uses stay in the arena until the module is destroyed.
+  UseGroup *Old = std::exchange(
+      Uses, static_cast<UseGroup *>(arena().allocate(
+                (NumGroups - 1) * sizeof(UseGroup) +
+                    offsetof(UseGroup, Uses) + InLast * sizeof(detail::Use),
+                alignof(UseGroup))));
+  for (std::size_t G = 0; G < NumGroups; ++G)
+    Uses[G].User = this;
+  for (std::size_t I = 0; I < Count; ++I) {
+    new (&use(I)) detail::Use{nullptr, I % UsesPerGroup};
+    if (I < Kept)
+      UseGroup::at(Old, I).moveTo(use(I));
+  }
+  if (Op != Opcode::Call && Op != Opcode::Phi)
+    NumUses = static_cast<std::uint8_t>(Count);
+}
+
+/// \return If \p H refers to a global register.
+static bool isGlobal(detail::Handle H) {
+  return (H & ((1u << detail::HandleTagBits) - 1)) == detail::GlobalTag;
+}
+
+bool Instruction::usesGlobals() {
+  // Uses might be relinked by other threads, so only operands are checked.
+  if (Uses)
+    for (std::size_t I = 0, E = Op == Opcode::Phi ? Phi->Size : numUseSlots();
+         I != E; ++I)
+      if (isGlobal(operandHandle(I)))
+        return true;
+  return false;
+}
+
+std::unique_lock<std::mutex> Instruction::lockGlobalUses(bool Needed) const {
+  std::unique_lock<std::mutex> Lock{
+      OwningBB->OwningFunction.OwningModule.GlobalUses, std::defer_lock};
+  if (Needed)
+    Lock.lock();
+  return Lock;
+}
+
+void Instruction::setOperandValue(std::size_t Index, Value V) {
+  detail::Handle &Operand = operandHandle(Index);
+  SymReg *Reg = get<SymReg>(&V);
+  const std::size_t NumAllocated = numUses();
+  // Growing moves the uses of the other operands.
+  const bool Grows = Reg && Index >= NumAllocated;
+  auto Lock = lockGlobalUses((Index < NumAllocated && isGlobal(Operand)) ||
+                             (Reg && !Reg->isLocal()) ||
+                             (Grows && usesGlobals()));
+  noteChange();
+  if (Index < NumAllocated)
+    use(Index).unlink();
+  Operand = encode(V);
+  if (Reg) {
+    if (Grows)
+      allocateUses(Op == Opcode::Call || Op == Opcode::Phi ? numUseSlots()
+                                                           : Index + 1,
+                   NumAllocated);
+    use(Index).link(Reg->FirstUse);
+  }
+}
+
+void Instruction::dropUses() {
+  auto Lock = lockGlobalUses(usesGlobals());
+  for (std::size_t I = 0, E = numUses(); I != E; ++I)
+    use(I).unlink();
+}
+
+void replaceAllUsesWith(SymReg &Register, Value V) {
+  if (get<SymReg>(&V) == &Register)
+    return;
+  // Setting an operand unlinks its use from the list of Register.
+  while (detail::Use *First = Register.FirstUse) {
+    const detail::UseGroup &Group = First->group();
+    Instruction &User = *Group.User;
+    User.setOperandValue((&Group - User.Uses) * detail::UsesPerGroup +
+                             First->position(),
+                         V);
+  }
+}
+
+CallInst::CallInst(BasicBlock &OwningBB, SymReg *RetReg, Function &Callee,
+                   std::vector<Value> &&Arguments)
+    : detail::ReturningInstBase<SymReg *>(OwningBB, ClassOpcode) {
+  setOutRegister(RetReg);
+  void *Memory = arena().allocate(sizeof(detail::CallData) +
+                                      Arguments.size() * sizeof(detail::Handle),
+                                  alignof(detail::CallData));
+  Call = new (Memory) detail::CallData{
+      &Callee, static_cast<std::uint32_t>(Arguments.size())};
+  std::fill_n(Call->arguments(), Arguments.size(), detail::NoHandle);
+  for (std::size_t I = 0, E = Arguments.size(); I != E; ++I)
+    setOperandValue(I, Arguments[I]);
+}
+
+void PhiInst::addIncoming(Value V, BasicBlock &BB) {
+  const std::uint32_t Size = size();
+  if (!Phi || Size == Phi->Capacity) {
+    // The old list stays in the arena until the module is destroyed.
+    const std::uint32_t Capacity = Size ? 2 * Size : 2;
+    void *Memory = arena().allocate(
+        sizeof(detail::PhiData) + 2 * Capacity * sizeof(detail::Handle),
+        alignof(detail::PhiData));
+    auto *Grown = new (Memory) detail::PhiData{Size, Capacity};
+    // Moving a use relinks its neighbours in the list of the register.
+    auto Lock = lockGlobalUses(usesGlobals());
+    if (Size)
+      std::copy_n(Phi->incoming(), 2 * Size, Grown->incoming());
+    Phi = Grown;
+    if (Uses)
+      allocateUses(Capacity, Size);
+  }
+  Phi->incoming()[2 * Size] = blockId(BB);
+  Phi->incoming()[2 * Size + 1] = detail::NoHandle;
+  ++Phi->Size;
+  setOperandValue(Size, V);
+}
+
+void PhiInst::removeIncoming(std::size_t Index) {
+  noteChange();
+  auto Lock = lockGlobalUses(usesGlobals());
+  detail::Handle *Removed = incoming(Index);
+  std::copy(Removed + 2, Phi->incoming() + 2 * Phi->Size, Removed);
+  if (Uses) {
+    use(Index).unlink();
+    for (std::size_t I = Index + 1; I < Phi->Size; ++I)
+      use(I).moveTo(use(I - 1));
+  }
+  --Phi->Size;
+}
+
+std::ostream &operator<<(std::ostream &stream, const SymReg &symReg) {
+  if (symReg.hasName())
+    stream << "%" << symReg.name();
+  else
+    stream << "%" << symReg.index() + 1;
   return stream;
 }
 
 std::ostream &operator<<(std::ostream &Stream, const BasicBlock &BB) {
   if (BB.hasLabel())
-    Stream << GlobalContext.Names.at(&BB) << ":\n";
+    Stream << BB.label() << ":\n";
   else {
-    auto &Func = BB.parent();
-    size_t BBNum{1};
-    for (const auto &CurrBB : Func) {
-      if (&BB == &CurrBB)
-        break;
-      BBNum += !CurrBB.hasLabel();
-    }
-    Stream << "BB" << BBNum << ":\n";
+    Stream << "BB" << BB.Number << ":\n";
     for (const Instruction &Inst : BB)
       Stream << Inst;
   }
   return Stream;
 }
 
+void BasicBlock::updateSuccessors() {
+  for (std::uint8_t I = 0; I < NumSuccessors; ++I) {
+    // The successor might be erased before the block.
+    BasicBlock *Succ = OwningFunction.blockAt(Successors[I]);
+    if (!Succ)
+      continue;
+    auto &Preds = Succ->Predecessors;
+    auto It = std::find(std::begin(Preds), std::end(Preds), Id);
+    assert(It != std::end(Preds) && "Predecessor lists are inconsistent");
+    *It = Preds.back();
+    Preds.pop_back();
+  }
+  NumSuccessors = 0;
+  if (!Instructions.empty()) {
+    const Instruction &Last = Instructions[Instructions.size() - 1];
+    if (const auto *GoTo = get<GoToInst>(&Last)) {
+      Successors[NumSuccessors++] = GoTo->successor().Id;
+    } else if (const auto *Br = get<BrInst>(&Last)) {
+      Successors[NumSuccessors++] = Br->trueSuccessor().Id;
+      Successors[NumSuccessors++] = Br->falseSuccessor().Id;
+    }
+  }
+  for (std::uint8_t I = 0; I < NumSuccessors; ++I)
+    OwningFunction.blockAt(Successors[I])->Predecessors.push_back(Id);
+}
+
 std::ostream &operator<<(std::ostream &stream, const Function &function) {
   stream << "function " << function.Name << "(";
   for (auto ArgName : function.ArgNames)
@@ -159,37 +453,53 @@ std::ostream &operator<<(std::ostream &stream, const Module &module) {
   return stream;
 }
 
+string_view SymReg::name() const {
+  const Module &M = OwningModule ? *OwningModule : OwningFunction->parent();
+  return M.context().name(Name);
+}
+
+string_view BasicBlock::label() const {
+  return OwningFunction.parent().context().name(Label);
+}
+
+/// \return Node named \p Name in \p Symbols of module \p M or nullptr.
+template <typename T>
+static T *findSymbol(const Module &M, const SymbolMap<T> &Symbols,
+                     string_view Name) {
+  auto Id = M.context().findName(Name);
+  if (!Id)
+    return nullptr;
+  auto It = Symbols.find(*Id);
+  return It == std::end(Symbols) ? nullptr : It->second;
+}
+
 SymReg &MIRBuilder::createGlobalVariable(std::string &&name) {
-  TheModule.GlobalVariables.emplace_back(TheModule, true);
-  SymReg &Result = TheModule.GlobalVariables.back();
-  auto &GlobalNames = GlobalContext.ModuleSymbols[&TheModule].GlobalVariables;
+  auto &GlobalNames = TheModule.Symbols.GlobalVariables;
   size_t i = 1;
   auto NewName = [name](size_t i) { return name + "." + std::to_string(i); };
   bool NeedRename{};
-  if (GlobalNames.count(name) != 0u) {
+  if (findSymbol(TheModule, GlobalNames, name)) {
     NeedRename = true;
-    while (GlobalNames.count(NewName(i)) != 0u) {
+    while (findSymbol(TheModule, GlobalNames, NewName(i))) {
       ++i;
     }
   }
-  auto InternedName = internedName(NeedRename ? NewName(i) : name);
-  GlobalNames[InternedName] = &Result;
-  GlobalContext.NameTable[&Result] = InternedName;
+  NameId Id = TheModule.Context.intern(NeedRename ? NewName(i) : name);
+  TheModule.GlobalVariables.emplace_back(TheModule, Id);
+  SymReg &Result = TheModule.GlobalVariables.back();
+  Result.Index = TheModule.GlobalVariables.size() - 1;
+  GlobalNames[Id] = &Result;
   return Result;
 }
 
 SymReg *MIRBuilder::findGlobalVariable(string_view name) const {
-  auto &GlobalNames = GlobalContext.ModuleSymbols[&TheModule].GlobalVariables;
-  if (GlobalNames.count(name) == 0u)
-    return nullptr;
-  return GlobalNames[name];
+  return findSymbol(TheModule, TheModule.Symbols.GlobalVariables, name);
 }
 
 Function *
 MIRBuilder::createFunction(std::string &&Name,
                            std::vector<std::string> &&NamedParameters) {
-  auto &FunctionNames = GlobalContext.ModuleSymbols[&TheModule].Functions;
-  if (FunctionNames.count(Name) != 0u)
+  if (findSymbol(TheModule, TheModule.Symbols.Functions, Name))
     return nullptr;
   // TODO: private constructor might be called from emplace_back
   // see:
@@ -197,34 +507,33 @@ MIRBuilder::createFunction(std::string &&Name,
   std::vector<string_view> InternedParameters;
   InternedParameters.reserve(NamedParameters.size());
   for (auto &ParName : NamedParameters)
-    InternedParameters.push_back(internedName(std::move(ParName)));
-  Function F(TheModule, std::move(Name), std::move(InternedParameters));
+    InternedParameters.push_back(TheModule.Context.internedName(ParName));
+  NameId Id = TheModule.Context.intern(Name);
+  Function F(TheModule, TheModule.Context.name(Id), InternedParameters,
+             TheModule.FunctionStorage.emplace_back());
   TheModule.Functions.emplace_back(std::move(F));
-  auto FuncName = TheModule.Functions.back().Name;
-  return FunctionNames[FuncName] = &TheModule.Functions.back();
+  return TheModule.Symbols.Functions[Id] = &TheModule.Functions.back();
 }
 
 Function *MIRBuilder::findFunction(string_view name) const {
-  auto &FunctionNames = GlobalContext.ModuleSymbols[&TheModule].Functions;
-  if (FunctionNames.count(name) == 0u)
-    return nullptr;
-  return FunctionNames[name];
+  return findSymbol(TheModule, TheModule.Symbols.Functions, name);
 }
 
 BasicBlock &MIRBuilder::createBasicBlock(Function &Func, std::string &&Label) {
   assert((Label.empty() ||
-          GlobalContext.FunctionSymbols[&Func].Labels.count(Label) == 0u) &&
+          !findSymbol(Func.parent(), Func.Symbols.Labels, Label)) &&
          "Label must be unique");
-  BasicBlock BB(Func);
-  BB.HasLabel = !Label.empty();
-  // TODO: private constructor might be called from emplace_back
-  Func.BasicBlocks.emplace_back(std::move(BB));
-  auto &BBRef = Func.BasicBlocks.back();
-  if (Label.empty())
-    return BBRef;
-  string_view InternedLabel = internedName(std::move(Label));
-  GlobalContext.NameTable[&BBRef] = InternedLabel;
-  GlobalContext.FunctionSymbols[&Func].Labels[InternedLabel] = &BBRef;
+  BasicBlock BB(Func, static_cast<std::uint32_t>(Func.BlockTable.size()),
+                Func.Storage);
+  BB.Label = Func.parent().Context.intern(Label);
+  if (!BB.hasLabel())
+    BB.Number = ++Func.NumUnlabeled;
+  auto &BBRef = *Func.Storage.create<BasicBlock>(std::move(BB));
+  Func.BasicBlocks.push_back(&BBRef);
+  Func.BlockTable.push_back(&BBRef);
+  Func.noteChange(true);
+  if (BBRef.hasLabel())
+    Func.Symbols.Labels[BBRef.Label] = &BBRef;
   return BBRef;
 }
 
@@ -233,20 +542,98 @@ SymReg &MIRBuilder::symReg(std::string &&Name, Function *Func) {
   assert(Func && "Symbolic register must belong to a function");
   auto &SymRegs = Func->SymbolicRegisters;
   if (Name.empty()) {
-    SymRegs.emplace_back(*Func, false);
+    SymRegs.emplace_back(*Func);
+    SymRegs.back().Index = SymRegs.size() - 1;
     return SymRegs.back();
   }
-  string_view InternedName = internedName(std::move(Name));
-  auto &NameToSymReg = GlobalContext.FunctionSymbols[Func].LocalVariables;
-  if (NameToSymReg.count(InternedName))
-    return *NameToSymReg.at(InternedName);
-  SymRegs.emplace_back(*Func, true);
+  NameId Id = Func->parent().Context.intern(Name);
+  auto &NameToSymReg = Func->Symbols.LocalVariables;
+  auto It = NameToSymReg.find(Id);
+  if (It != std::end(NameToSymReg))
+    return *It->second;
+  SymRegs.emplace_back(*Func, Id);
   SymReg &Result = SymRegs.back();
-  GlobalContext.NameTable[&Result] = InternedName;
-  NameToSymReg[InternedName] = &Result;
+  Result.Index = SymRegs.size() - 1;
+  NameToSymReg[Id] = &Result;
   return Result;
 }
 
+SymReg &MIRBuilder::createRegister(Function &Func, std::string &&Name) {
+  if (Name.empty())
+    return symReg(std::move(Name), &Func);
+  auto &LocalNames = Func.Symbols.LocalVariables;
+  if (!findSymbol(Func.parent(), LocalNames, Name))
+    return symReg(std::move(Name), &Func);
+  auto NewName = [&Name](size_t i) { return Name + "." + std::to_string(i); };
+  size_t i = 1;
+  while (findSymbol(Func.parent(), LocalNames, NewName(i)))
+    ++i;
+  return symReg(NewName(i), &Func);
+}
+
+void MIRBuilder::eraseBasicBlock(BasicBlock &BB) { eraseBasicBlocks({&BB}); }
+
+void MIRBuilder::eraseBasicBlocks(const std::vector<BasicBlock *> &Blocks) {
+  if (Blocks.empty())
+    return;
+  Function &Func = Blocks.front()->parent();
+  for (BasicBlock *BB : Blocks) {
+    assert(&BB->parent() == &Func && Func.BlockTable[BB->Id] == BB &&
+           "The block is not in the function");
+    if (CurrentBB == BB) {
+      CurrentBB = nullptr;
+      InsertPosition.reset();
+    }
+    if (BB->hasLabel())
+      Func.Symbols.Labels.erase(BB->Label);
+    BB->Instructions.clear();
+    BB->updateSuccessors();
+    Func.BlockTable[BB->Id] = nullptr;
+  }
+  // Erased blocks are the ones missing from the block table now.
+  auto &Layout = Func.BasicBlocks;
+  std::size_t Kept{};
+  std::uint32_t Number{};
+  for (BasicBlock *BB : Layout) {
+    if (!Func.BlockTable[BB->Id])
+      continue;
+    if (!BB->hasLabel())
+      BB->Number = ++Number;
+    Layout[Kept++] = BB;
+  }
+  Layout.resize(Kept);
+  Func.NumUnlabeled = Number;
+  Func.noteChange(true);
+}
+
+void MIRBuilder::eraseInstruction(BasicBlock &BB, size_t Position) {
+  assert(Position < BB.size() && "No instruction to erase");
+  BB.parent().noteChange(isTerminator(BB[Position]));
+  BB.Instructions.erase(Position);
+  if (Position == BB.size())
+    BB.updateSuccessors();
+  if (CurrentBB == &BB && InsertPosition && *InsertPosition > Position)
+    --*InsertPosition;
+}
+
+void MIRBuilder::eraseInstructions(BasicBlock &BB,
+                                   const std::vector<size_t> &Positions) {
+  if (Positions.empty())
+    return;
+  BB.parent().noteChange(std::any_of(
+      std::begin(Positions), std::end(Positions),
+      [&BB](size_t Position) { return isTerminator(BB[Position]); }));
+  const bool ErasesLast = Positions.back() + 1 == BB.size();
+  BB.Instructions.erase(Positions);
+  if (ErasesLast)
+    BB.updateSuccessors();
+  if (CurrentBB == &BB && InsertPosition)
+    *InsertPosition -=
+        std::lower_bound(std::begin(Positions), std::end(Positions),
+                         *InsertPosition) -
+        std::begin(Positions);
+}
+
 Instruction &MIRBuilder::createReceiveInst(std::string &&Name) {
   SymReg &Register = symReg(std::move(Name));
   return createInst<ReceiveInst>(Register);
@@ -284,4 +671,18 @@ Instruction &MIRBuilder::createBinOpInst(BinOpKind Kind, Value Operand1,
   SymReg &RetReg = symReg(std::move(Name));
   return createInst<BinOpInst>(RetReg, Kind, Operand1, Operand2);
 }
+
+Instruction &MIRBuilder::createUnOpInst(UnOpKind Kind, Value Operand,
+                                        SymReg &OutRegister) {
+  return createInst<UnOpInst>(OutRegister, Kind, Operand);
+}
+
+Instruction &MIRBuilder::createBinOpInst(BinOpKind Kind, Value Operand1,
+                                         Value Operand2, SymReg &OutRegister) {
+  return createInst<BinOpInst>(OutRegister, Kind, Operand1, Operand2);
+}
+
+Instruction &MIRBuilder::createPhiInst(SymReg &OutRegister) {
+  return createInst<PhiInst>(OutRegister);
+}
 } // namespace wyrm
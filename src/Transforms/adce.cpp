@@ -0,0 +1,182 @@
+#include "Transforms/adce.h"
+#include "Analysis/cfg.h"
+#include "Analysis/control_dependence.h"
+#include "Analysis/dominator_tree.h"
+#include "Analysis/loop_info.h"
+#include "Analysis/post_dominator_tree.h"
+
+#include <utility>
+
+namespace wyrm {
+
+namespace {
+using NodeId = CSRGraph::NodeId;
+/// \brief Instruction given by its block and position.
+using Location = std::pair<NodeId, std::size_t>;
+} // namespace
+
+bool eliminateDeadCode(MIRBuilder &Builder, Function &F) {
+  AnalysisCache Analyses{F};
+  return eliminateDeadCode(Builder, F, Analyses);
+}
+
+bool eliminateDeadCode(MIRBuilder &Builder, Function &F,
+                       AnalysisCache &Analyses) {
+  if (!F.size())
+    return false;
+  // The CFG isn't recomputed while the pass changes branches and erases
+  // blocks: the cache does it only on the next request.
+  const FunctionCFG &CFG = Analyses.cfg();
+  const DominatorTree &DT = Analyses.dominatorTree();
+  const PostDominatorTree PDT{CFG.graph()};
+  const ControlDependenceGraph CDG{CFG.graph(), PDT};
+  const std::size_t NumNodes = CFG.size();
+
+  // Instructions are numbered block after block.
+  std::vector<std::size_t> FirstInst(NumNodes + 1);
+  for (NodeId Node = 0; Node < NumNodes; ++Node)
+    FirstInst[Node + 1] = FirstInst[Node] + CFG.block(Node).size();
+  // Reachable definitions of every local register. The unreachable ones are
+  // erased and mustn't keep anything alive.
+  std::vector<std::size_t> DefOffsets(F.symbolicRegisters().size() + 1);
+  for (NodeId Node = 0; Node < NumNodes; ++Node) {
+    if (!DT.contains(Node))
+      continue;
+    for (auto &Inst : CFG.block(Node)) {
+      SymReg *Reg = definedRegister(Inst);
+      if (Reg && Reg->isLocal())
+        ++DefOffsets[Reg->index() + 1];
+    }
+  }
+  for (std::size_t I = 1; I < DefOffsets.size(); ++I)
+    DefOffsets[I] += DefOffsets[I - 1];
+  std::vector<Location> Defs(DefOffsets.back());
+  {
+    std::vector<std::size_t> Cursor{std::begin(DefOffsets),
+                                    std::end(DefOffsets)};
+    for (NodeId Node = 0; Node < NumNodes; ++Node) {
+      if (!DT.contains(Node))
+        continue;
+      BasicBlock &BB = CFG.block(Node);
+      for (std::size_t Position = 0, E = BB.size(); Position < E; ++Position) {
+        SymReg *Reg = definedRegister(BB[Position]);
+        if (Reg && Reg->isLocal())
+          Defs[Cursor[Reg->index()]++] = {Node, Position};
+      }
+    }
+  }
+
+  // Mark.
+  std::vector<bool> IsLive(FirstInst.back()), IsLiveBlock(NumNodes);
+  std::vector<Location> Worklist;
+  auto MarkLive = [&](NodeId Node, std::size_t Position) {
+    if (IsLive[FirstInst[Node] + Position])
+      return;
+    IsLive[FirstInst[Node] + Position] = true;
+    Worklist.emplace_back(Node, Position);
+  };
+  // Branches of unreachable blocks can't decide anything.
+  auto MarkTerminator = [&](NodeId Node) {
+    BasicBlock &BB = CFG.block(Node);
+    if (DT.contains(Node) && !BB.empty() && isTerminator(BB[BB.size() - 1]))
+      MarkLive(Node, BB.size() - 1);
+  };
+  // Every cycle has a back edge or lies in an irreducible region. Unlike the
+  // retreating arcs of a DFS neither depends on the order of successors, so
+  // a second run keeps the same branches.
+  const LoopInfo Loops{CFG.graph(), DT, /*FindIrreducible=*/true};
+  auto ClosesCycle = [&](NodeId Node) {
+    if (Loops.isIrreducible(Node))
+      return true;
+    for (auto Succ : CFG.graph().successors(Node))
+      if (DT.dominates(Succ, Node))
+        return true;
+    return false;
+  };
+  for (NodeId Node = 0; Node < NumNodes; ++Node) {
+    if (!DT.contains(Node))
+      continue;
+    BasicBlock &BB = CFG.block(Node);
+    for (std::size_t Position = 0, E = BB.size(); Position < E; ++Position) {
+      Instruction &Inst = BB[Position];
+      SymReg *Reg = definedRegister(Inst);
+      if (get<RetInst>(&Inst) || get<CallInst>(&Inst) ||
+          get<ReceiveInst>(&Inst) || (Reg && !Reg->isLocal()) ||
+          mightTrap(Inst))
+        MarkLive(Node, Position);
+    }
+    // A branch to blocks without a common post-dominator can't be replaced.
+    if (ClosesCycle(Node) || PDT.ipdom(Node) == CSRGraph::NoNode)
+      MarkTerminator(Node);
+  }
+  while (!Worklist.empty()) {
+    auto [Node, Position] = Worklist.back();
+    Worklist.pop_back();
+    if (!IsLiveBlock[Node]) {
+      IsLiveBlock[Node] = true;
+      for (auto Controller : CDG.controllers(Node))
+        MarkTerminator(Controller);
+    }
+    Instruction &Inst = CFG.block(Node)[Position];
+    forEachOperand(Inst, [&](Value V) {
+      SymReg *Reg = get<SymReg>(&V);
+      if (!Reg || !Reg->isLocal())
+        return;
+      for (auto I = DefOffsets[Reg->index()],
+                E = DefOffsets[Reg->index() + 1];
+           I < E; ++I)
+        MarkLive(Defs[I].first, Defs[I].second);
+    });
+    if (auto *Phi = get<PhiInst>(&Inst))
+      for (std::size_t I = 0, E = Phi->size(); I < E; ++I)
+        MarkTerminator(CFG.number(Phi->incomingBlock(I)));
+  }
+
+  // Sweep.
+  bool Changed{};
+  std::vector<std::size_t> Dead;
+  for (NodeId Node = 0; Node < NumNodes; ++Node) {
+    if (!DT.contains(Node))
+      continue;
+    BasicBlock &BB = CFG.block(Node);
+    Dead.clear();
+    for (std::size_t Position = 0, E = BB.size(); Position < E; ++Position)
+      if (!IsLive[FirstInst[Node] + Position] &&
+          !get<GoToInst>(&BB[Position]))
+        Dead.push_back(Position);
+    if (Dead.empty())
+      continue;
+    const bool IsDeadBranch =
+        Dead.back() == BB.size() - 1 && get<BrInst>(&BB[BB.size() - 1]);
+    Builder.eraseInstructions(BB, Dead);
+    if (IsDeadBranch) {
+      Builder.setBasicBlock(BB);
+      Builder.createGoToInst(CFG.block(PDT.ipdom(Node)));
+    }
+    Changed = true;
+  }
+  if (!Changed)
+    return false;
+
+  // Dead branches might leave blocks unreachable.
+  const FunctionGraph Graph{F};
+  std::vector<bool> IsReachable(F.numBlockIndices());
+  for (auto Index : Graph.DFSOrder())
+    IsReachable[Index] = true;
+  std::vector<BasicBlock *> Unreachable;
+  for (auto &BB : F) {
+    if (!IsReachable[BB.index()]) {
+      Unreachable.push_back(&BB);
+      continue;
+    }
+    for (auto &Inst : BB)
+      if (auto *Phi = get<PhiInst>(&Inst))
+        for (std::size_t I = Phi->size(); I-- > 0;)
+          if (!IsReachable[Phi->incomingBlock(I).index()])
+            Phi->removeIncoming(I);
+  }
+  Builder.eraseBasicBlocks(Unreachable);
+  return true;
+}
+
+} // namespace wyrm
@@ -0,0 +1,231 @@
+#include "Transforms/gvn.h"
+#include "Analysis/cfg.h"
+#include "Analysis/dominance.h"
+#include "Analysis/dominator_tree.h"
+
+#include <cstdint>
+#include <limits>
+
+namespace wyrm {
+
+namespace {
+using NodeId = CSRGraph::NodeId;
+
+/// \brief Operation with canonical operands.
+struct Expression {
+  std::uint32_t Opcode;
+  std::uint64_t LHS;
+  std::uint64_t RHS;
+  bool operator==(const Expression &Other) const {
+    return Opcode == Other.Opcode && LHS == Other.LHS && RHS == Other.RHS;
+  }
+};
+
+/// \brief Open addressing hash table of the expressions available in the
+/// current scope of a dominator tree walk.
+/// The capacity is fixed on construction, so the walk never allocates. A
+/// scope is popped by clearing the slots inserted since its start in reverse
+/// order, which restores every probe sequence exactly without tombstones.
+class ScopedExpressionTable {
+public:
+  /// \brief Prepare the table for at most \p MaxEntries live entries.
+  explicit ScopedExpressionTable(std::size_t MaxEntries);
+  /// \return The register computing \p Key or nullptr.
+  SymReg *lookup(const Expression &Key) const {
+    return Slots[find(Key)].Leader;
+  }
+  /// \pre \p Key is not in the table.
+  void insert(const Expression &Key, SymReg &Leader);
+  /// \brief Marker of the current scope for popScope.
+  std::size_t scope() const { return Inserted.size(); }
+  /// \brief Remove the entries inserted after \p Mark was taken.
+  void popScope(std::size_t Mark);
+
+private:
+  struct Slot {
+    Expression Key{};
+    SymReg *Leader{};
+  };
+  /// \return Slot of \p Key or the empty slot ending its probe sequence.
+  std::size_t find(const Expression &Key) const;
+  std::vector<Slot> Slots;
+  std::size_t Mask;
+  /// Slots in the order of insertion.
+  std::vector<std::size_t> Inserted{};
+};
+} // namespace
+
+ScopedExpressionTable::ScopedExpressionTable(std::size_t MaxEntries) {
+  std::size_t Capacity{16};
+  // Keep the load factor under 1/2.
+  while (Capacity < 2 * MaxEntries)
+    Capacity *= 2;
+  Slots.resize(Capacity);
+  Mask = Capacity - 1;
+  Inserted.reserve(MaxEntries);
+}
+
+std::size_t ScopedExpressionTable::find(const Expression &Key) const {
+  std::uint64_t Hash = Key.Opcode;
+  for (std::uint64_t Part : {Key.LHS, Key.RHS}) {
+    Hash ^= Part + 0x9e3779b97f4a7c15ULL + (Hash << 6) + (Hash >> 2);
+    Hash *= 0xff51afd7ed558ccdULL;
+  }
+  Hash ^= Hash >> 33;
+  for (std::size_t Index = Hash & Mask;; Index = (Index + 1) & Mask)
+    if (!Slots[Index].Leader || Slots[Index].Key == Key)
+      return Index;
+}
+
+void ScopedExpressionTable::insert(const Expression &Key, SymReg &Leader) {
+  std::size_t Index = find(Key);
+  assert(!Slots[Index].Leader && "The expression is already available");
+  Slots[Index] = {Key, &Leader};
+  Inserted.push_back(Index);
+}
+
+void ScopedExpressionTable::popScope(std::size_t Mark) {
+  for (; Inserted.size() > Mark; Inserted.pop_back())
+    Slots[Inserted.back()].Leader = nullptr;
+}
+
+static bool isCommutative(BinOpKind Kind) {
+  switch (Kind) {
+  case BinOpKind::Add:
+  case BinOpKind::Mul:
+  case BinOpKind::And:
+  case BinOpKind::Or:
+  case BinOpKind::Xor:
+  case BinOpKind::Min:
+  case BinOpKind::Max:
+  case BinOpKind::Eq:
+  case BinOpKind::Neq:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// \brief Opcodes of unary operations follow the binary ones.
+constexpr std::uint32_t UnOpBase =
+    static_cast<std::uint32_t>(BinOpKind::Geq) + 1;
+
+bool eliminateRedundancies(MIRBuilder &Builder, Function &F) {
+  AnalysisCache Analyses{F};
+  return eliminateRedundancies(Builder, F, Analyses);
+}
+
+bool eliminateRedundancies(MIRBuilder &Builder, Function &F,
+                           AnalysisCache &Analyses) {
+  if (!F.size())
+    return false;
+  const FunctionCFG &CFG = Analyses.cfg();
+  const DominatorTree &DT = Analyses.dominatorTree();
+  const std::size_t NumRegs{F.symbolicRegisters().size()};
+
+  std::size_t NumCandidates{};
+  for (auto &BB : F)
+    for (auto &Inst : BB)
+      NumCandidates += get<BinOpInst>(&Inst) || get<UnOpInst>(&Inst);
+  // A register read before its definition might differ from its value.
+  const std::vector<bool> HasDominatingDef = findDominatingDefinitions(CFG, DT);
+  auto IsTracked = [&HasDominatingDef](const SymReg &Reg) {
+    return Reg.isLocal() && HasDominatingDef[Reg.index()];
+  };
+
+  std::vector<SymReg *> Replacement(NumRegs);
+  auto Resolve = [&Replacement](Value V) -> Value {
+    SymReg *Reg = get<SymReg>(&V);
+    if (!Reg || !Reg->isLocal() || !Replacement[Reg->index()])
+      return V;
+    return *Replacement[Reg->index()];
+  };
+  // Registers are numbered above all 32-bit immediates.
+  auto Encode = [](Value V) -> std::uint64_t {
+    if (const Imm *Constant = get<Imm>(&V))
+      return static_cast<std::uint32_t>(*Constant);
+    return (std::uint64_t{1} << 32) + get<SymReg>(&V)->index();
+  };
+  auto IsValueNumbered = [&IsTracked](Value V) {
+    SymReg *Reg = get<SymReg>(&V);
+    return !Reg || IsTracked(*Reg);
+  };
+
+  ScopedExpressionTable Table{NumCandidates};
+  std::vector<std::vector<std::size_t>> Redundant(CFG.size());
+  constexpr std::size_t NoMark = std::numeric_limits<std::size_t>::max();
+  std::vector<std::pair<NodeId, std::size_t>> Stack;
+  Stack.reserve(CFG.size());
+  Stack.emplace_back(DT.Root, NoMark);
+  while (!Stack.empty()) {
+    auto [Node, Mark] = Stack.back();
+    Stack.pop_back();
+    if (Mark != NoMark) {
+      Table.popScope(Mark);
+      continue;
+    }
+    Stack.emplace_back(Node, Table.scope());
+    BasicBlock &BB = CFG.block(Node);
+    for (std::size_t Position = 0, E = BB.size(); Position < E; ++Position) {
+      Instruction &Inst = BB[Position];
+      // Phi operands might come from blocks which are not visited yet.
+      if (get<PhiInst>(&Inst))
+        continue;
+      rewriteOperands(Inst, Resolve);
+      SymReg *Out = definedRegister(Inst);
+      if (!Out || !IsTracked(*Out))
+        continue;
+      Expression Key;
+      if (auto *UnOp = get<UnOpInst>(&Inst)) {
+        Value Operand = UnOp->operand();
+        if (!IsValueNumbered(Operand))
+          continue;
+        SymReg *Copied = get<SymReg>(&Operand);
+        if (UnOp->kind() == UnOpKind::Assign && Copied) {
+          Replacement[Out->index()] = Copied;
+          Redundant[Node].push_back(Position);
+          continue;
+        }
+        Key = {UnOpBase + static_cast<std::uint32_t>(UnOp->kind()),
+               Encode(Operand), 0};
+      } else if (auto *BinOp = get<BinOpInst>(&Inst)) {
+        Value LHS = BinOp->operand1(), RHS = BinOp->operand2();
+        if (!IsValueNumbered(LHS) || !IsValueNumbered(RHS))
+          continue;
+        BinOpKind Kind = BinOp->kind();
+        Key = {0, Encode(LHS), Encode(RHS)};
+        if (Kind == BinOpKind::Greater || Kind == BinOpKind::Geq) {
+          Kind = Kind == BinOpKind::Greater ? BinOpKind::Less : BinOpKind::Leq;
+          std::swap(Key.LHS, Key.RHS);
+        }
+        if (isCommutative(Kind) && Key.RHS < Key.LHS)
+          std::swap(Key.LHS, Key.RHS);
+        Key.Opcode = static_cast<std::uint32_t>(Kind);
+      } else {
+        continue;
+      }
+      if (SymReg *Leader = Table.lookup(Key)) {
+        Replacement[Out->index()] = Leader;
+        Redundant[Node].push_back(Position);
+      } else {
+        Table.insert(Key, *Out);
+      }
+    }
+    auto Children = DT.children(Node);
+    for (auto It = Children.end(); It != Children.begin();)
+      Stack.emplace_back(*--It, NoMark);
+  }
+
+  bool Changed{};
+  for (NodeId Node = 0, E = CFG.size(); Node < E; ++Node) {
+    BasicBlock &BB = CFG.block(Node);
+    // Phis and unreachable blocks might still use replaced registers.
+    for (auto &Inst : BB)
+      rewriteOperands(Inst, Resolve);
+    Builder.eraseInstructions(BB, Redundant[Node]);
+    Changed |= !Redundant[Node].empty();
+  }
+  return Changed;
+}
+
+} // namespace wyrm
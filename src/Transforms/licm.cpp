@@ -0,0 +1,331 @@
+#include "Transforms/licm.h"
+#include "Analysis/cfg.h"
+#include "Analysis/dominator_tree.h"
+#include "Analysis/loop_info.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace wyrm {
+
+namespace {
+using NodeId = CSRGraph::NodeId;
+using LoopId = LoopInfo::LoopId;
+
+/// \brief Blocks defining every local register of a function.
+class Definitions {
+public:
+  Definitions(Function &F, const FunctionCFG &CFG);
+  /// \return If \p Reg is a local register with a single definition.
+  bool isSingleDef(const SymReg &Reg) const {
+    return Reg.isLocal() &&
+           Offsets[Reg.index() + 1] - Offsets[Reg.index()] == 1;
+  }
+  /// \return If \p Reg might change in \p Loop.
+  bool isDefinedIn(const LoopInfo &Loops, LoopId Loop,
+                   const SymReg &Reg) const;
+  /// \brief Note that the definition of \p Reg moved to \p Node.
+  /// \pre \p Reg has a single definition.
+  void move(const SymReg &Reg, NodeId Node) {
+    Nodes[Offsets[Reg.index()]] = Node;
+  }
+
+private:
+  std::vector<std::uint32_t> Offsets;
+  std::vector<NodeId> Nodes{};
+};
+} // namespace
+
+Definitions::Definitions(Function &F, const FunctionCFG &CFG)
+    : Offsets(F.symbolicRegisters().size() + 1) {
+  for (NodeId Node = 0, E = CFG.size(); Node < E; ++Node)
+    for (auto &Inst : CFG.block(Node)) {
+      SymReg *Reg = definedRegister(Inst);
+      if (Reg && Reg->isLocal())
+        ++Offsets[Reg->index() + 1];
+    }
+  for (std::size_t I = 1; I < Offsets.size(); ++I)
+    Offsets[I] += Offsets[I - 1];
+  Nodes.resize(Offsets.back());
+  std::vector<std::uint32_t> Cursor{std::begin(Offsets), std::end(Offsets)};
+  for (NodeId Node = 0, E = CFG.size(); Node < E; ++Node)
+    for (auto &Inst : CFG.block(Node)) {
+      SymReg *Reg = definedRegister(Inst);
+      if (Reg && Reg->isLocal())
+        Nodes[Cursor[Reg->index()]++] = Node;
+    }
+}
+
+bool Definitions::isDefinedIn(const LoopInfo &Loops, LoopId Loop,
+                              const SymReg &Reg) const {
+  // Calls in the loop might write global variables.
+  if (!Reg.isLocal())
+    return true;
+  for (auto I = Offsets[Reg.index()], E = Offsets[Reg.index() + 1]; I < E;
+       ++I)
+    if (Loops.contains(Loop, Nodes[I]))
+      return true;
+  return false;
+}
+
+/// \return Register defined by \p Inst if it's a unary or binary operation
+/// which might be hoisted, otherwise nullptr.
+static SymReg *candidate(Instruction &Inst, const Definitions &Defs) {
+  if (!get<UnOpInst>(&Inst) && !get<BinOpInst>(&Inst))
+    return nullptr;
+  SymReg *Out = definedRegister(Inst);
+  return Defs.isSingleDef(*Out) ? Out : nullptr;
+}
+
+/// \return If no operand of \p Inst changes in \p Loop.
+static bool hasInvariantOperands(Instruction &Inst, const Definitions &Defs,
+                                 const LoopInfo &Loops, LoopId Loop) {
+  bool Invariant{true};
+  forEachOperand(Inst, [&](Value V) {
+    const SymReg *Reg = get<SymReg>(&V);
+    Invariant &= !Reg || !Defs.isDefinedIn(Loops, Loop, *Reg);
+  });
+  return Invariant;
+}
+
+/// \return The only block entering \p Loop if it has no other successor,
+/// otherwise nullptr.
+static BasicBlock *findPreheader(const FunctionCFG &CFG,
+                                 const LoopInfo &Loops, LoopId Loop) {
+  BasicBlock *Preheader{};
+  for (auto Pred : CFG.graph().predecessors(Loops.header(Loop))) {
+    if (Loops.contains(Loop, Pred))
+      continue;
+    if (Preheader && Preheader != &CFG.block(Pred))
+      return nullptr;
+    Preheader = &CFG.block(Pred);
+  }
+  return Preheader && Preheader->successorIndices().size() == 1 ? Preheader
+                                                                 : nullptr;
+}
+
+/// \brief Make a new block the only block entering \p Loop.
+static void insertPreheader(MIRBuilder &Builder, Function &F,
+                            const FunctionCFG &CFG, const LoopInfo &Loops,
+                            LoopId Loop) {
+  const NodeId HeaderNode = Loops.header(Loop);
+  BasicBlock &Header = CFG.block(HeaderNode);
+  std::vector<NodeId> Entering;
+  for (auto Pred : CFG.graph().predecessors(HeaderNode))
+    if (!Loops.contains(Loop, Pred))
+      Entering.push_back(Pred);
+  std::sort(std::begin(Entering), std::end(Entering));
+  Entering.erase(std::unique(std::begin(Entering), std::end(Entering)),
+                 std::end(Entering));
+  std::vector<bool> IsEntering(F.numBlockIndices());
+  for (auto Node : Entering)
+    IsEntering[CFG.block(Node).index()] = true;
+
+  auto IsSame = [](Value A, Value B) {
+    const Imm *LHS = get<Imm>(&A), *RHS = get<Imm>(&B);
+    if (LHS || RHS)
+      return LHS && RHS && *LHS == *RHS;
+    return get<SymReg>(&A) == get<SymReg>(&B);
+  };
+  BasicBlock &Preheader = Builder.createBasicBlock(F);
+  std::size_t NumPhis{};
+  std::vector<std::size_t> Incoming;
+  for (auto &Inst : Header) {
+    auto *Phi = get<PhiInst>(&Inst);
+    if (!Phi)
+      continue;
+    Incoming.clear();
+    for (std::size_t I = 0, E = Phi->size(); I < E; ++I)
+      if (IsEntering[Phi->incomingBlock(I).index()])
+        Incoming.push_back(I);
+    if (Incoming.empty())
+      continue;
+    const Value First = Phi->incomingValue(Incoming[0]);
+    bool NeedsPhi{};
+    for (auto I : Incoming)
+      NeedsPhi |= !IsSame(First, Phi->incomingValue(I));
+    SymReg *Merged{};
+    if (NeedsPhi) {
+      SymReg &Reg =
+          Builder.createRegister(F, std::string{Phi->outRegister().name()});
+      Builder.setInsertPoint(Preheader, NumPhis++);
+      auto &Split = *get<PhiInst>(&Builder.createPhiInst(Reg));
+      for (auto I : Incoming)
+        Split.addIncoming(Phi->incomingValue(I), Phi->incomingBlock(I));
+      Merged = &Reg;
+    }
+    for (auto It = std::rbegin(Incoming); It != std::rend(Incoming); ++It)
+      Phi->removeIncoming(*It);
+    Phi->addIncoming(Merged ? Value{*Merged} : First, Preheader);
+  }
+  Builder.setBasicBlock(Preheader);
+  Builder.createGoToInst(Header);
+
+  for (auto Node : Entering) {
+    BasicBlock &BB = CFG.block(Node);
+    Instruction &Terminator = BB[BB.size() - 1];
+    if (auto *GoTo = get<GoToInst>(&Terminator)) {
+      GoTo->setSuccessor(Preheader);
+      continue;
+    }
+    auto &Br = *get<BrInst>(&Terminator);
+    if (&Br.trueSuccessor() == &Header)
+      Br.setTrueSuccessor(Preheader);
+    if (&Br.falseSuccessor() == &Header)
+      Br.setFalseSuccessor(Preheader);
+  }
+}
+
+/// \brief Create a copy of \p Inst at the insert point of \p Builder.
+static void copyOperation(MIRBuilder &Builder, Instruction &Inst) {
+  if (auto *UnOp = get<UnOpInst>(&Inst)) {
+    Builder.createUnOpInst(UnOp->kind(), UnOp->operand(),
+                           UnOp->outRegister());
+    return;
+  }
+  auto &BinOp = *get<BinOpInst>(&Inst);
+  Builder.createBinOpInst(BinOp.kind(), BinOp.operand1(), BinOp.operand2(),
+                          BinOp.outRegister());
+}
+
+bool hoistLoopInvariants(MIRBuilder &Builder, Function &F) {
+  AnalysisCache Analyses{F};
+  return hoistLoopInvariants(Builder, F, Analyses);
+}
+
+bool hoistLoopInvariants(MIRBuilder &Builder, Function &F,
+                         AnalysisCache &Analyses) {
+  if (!F.size() || !Analyses.loops().size())
+    return false;
+
+  // Give a preheader to every loop which might need one. Invariance of the
+  // operands is monotone: an operand changing in a loop changes in the loops
+  // containing it, so the walk outwards stops at the first such loop.
+  bool Changed{};
+  {
+    const FunctionCFG &CFG = Analyses.cfg();
+    const LoopInfo &Loops = Analyses.loops();
+    const Definitions Defs{F, CFG};
+    std::vector<bool> NeedsPreheader(Loops.size());
+    for (NodeId Node = 0, E = CFG.size(); Node < E; ++Node) {
+      const LoopId Innermost = Loops.loopFor(Node);
+      if (Innermost == LoopInfo::NoLoop)
+        continue;
+      for (auto &Inst : CFG.block(Node)) {
+        if (!candidate(Inst, Defs))
+          continue;
+        // Only the header runs whenever the loop is entered. A trapping
+        // operation moves on to the preheader, which runs whenever the
+        // parent loop is entered if it's the header of the parent. New
+        // preheaders never are.
+        const bool Traps = mightTrap(Inst);
+        NodeId At = Node;
+        for (LoopId Loop = Innermost;
+             Loop != LoopInfo::NoLoop &&
+             (!Traps || At == Loops.header(Loop)) &&
+             hasInvariantOperands(Inst, Defs, Loops, Loop);
+             Loop = Loops.parent(Loop)) {
+          NeedsPreheader[Loop] = true;
+          if (Traps) {
+            BasicBlock *Preheader = findPreheader(CFG, Loops, Loop);
+            At = Preheader ? CFG.number(*Preheader) : CSRGraph::NoNode;
+          }
+        }
+      }
+    }
+    for (LoopId Loop = 0, E = Loops.size(); Loop < E; ++Loop)
+      if (NeedsPreheader[Loop] && !findPreheader(CFG, Loops, Loop)) {
+        insertPreheader(Builder, F, CFG, Loops, Loop);
+        Changed = true;
+      }
+  }
+
+  const FunctionCFG &CFG = Analyses.cfg();
+  const DominatorTree &DT = Analyses.dominatorTree();
+  const LoopInfo &Loops = Analyses.loops();
+  Definitions Defs{F, CFG};
+  std::vector<NodeId> PreorderNumber(CFG.size());
+  NodeId Next{};
+  for (auto Node : DT.preorder())
+    PreorderNumber[Node] = Next++;
+  auto DominatesUses = [&](NodeId Node, SymReg &Reg) {
+    for (auto &User : Reg.users()) {
+      if (auto *Phi = get<PhiInst>(&User)) {
+        for (std::size_t I = 0, E = Phi->size(); I < E; ++I) {
+          Value V = Phi->incomingValue(I);
+          if (get<SymReg>(&V) == &Reg &&
+              !DT.dominates(Node, CFG.number(Phi->incomingBlock(I))))
+            return false;
+        }
+        continue;
+      }
+      const NodeId UserNode = CFG.number(User.parent());
+      if (UserNode != Node && !DT.dominates(Node, UserNode))
+        return false;
+    }
+    return true;
+  };
+
+  // Registers read in the block being scanned are stamped with its number.
+  std::vector<std::size_t> ReadIn(F.symbolicRegisters().size());
+  std::size_t Stamp{};
+  std::vector<NodeId> Body;
+  std::vector<std::size_t> Hoisted;
+  // Subloops are numbered after their parents.
+  for (LoopId Loop = Loops.size(); Loop-- > 0;) {
+    BasicBlock *Preheader = findPreheader(CFG, Loops, Loop);
+    if (!Preheader)
+      continue;
+    // Operations left in the subloops change in them, so only the blocks of
+    // the loop itself are scanned. They come first in blocks().
+    Body.clear();
+    for (auto Node : Loops.blocks(Loop)) {
+      if (Loops.loopFor(Node) != Loop)
+        break;
+      Body.push_back(Node);
+    }
+    // Dominators first, so chains of invariant operations move together.
+    std::sort(std::begin(Body), std::end(Body),
+              [&PreorderNumber](NodeId A, NodeId B) {
+                return PreorderNumber[A] < PreorderNumber[B];
+              });
+    const NodeId PreheaderNode = CFG.number(*Preheader);
+    Builder.setInsertPoint(*Preheader, Preheader->size() - 1);
+    for (auto Node : Body) {
+      BasicBlock &BB = CFG.block(Node);
+      bool TrapsAllowed = Node == Loops.header(Loop);
+      ++Stamp;
+      Hoisted.clear();
+      for (std::size_t Position = 0, E = BB.size(); Position < E;
+           ++Position) {
+        Instruction &Inst = BB[Position];
+        // Phi operands are read at the end of the predecessors.
+        if (get<PhiInst>(&Inst))
+          continue;
+        SymReg *Out = candidate(Inst, Defs);
+        if (Out && ReadIn[Out->index()] != Stamp &&
+            (TrapsAllowed || !mightTrap(Inst)) &&
+            hasInvariantOperands(Inst, Defs, Loops, Loop) &&
+            DominatesUses(Node, *Out)) {
+          copyOperation(Builder, Inst);
+          Defs.move(*Out, PreheaderNode);
+          Hoisted.push_back(Position);
+          continue;
+        }
+        forEachOperand(Inst, [&](Value V) {
+          if (SymReg *Reg = get<SymReg>(&V); Reg && Reg->isLocal())
+            ReadIn[Reg->index()] = Stamp;
+        });
+        // A trap mustn't overtake side effects.
+        SymReg *Defined = definedRegister(Inst);
+        if (get<CallInst>(&Inst) || (Defined && !Defined->isLocal()))
+          TrapsAllowed = false;
+      }
+      Builder.eraseInstructions(BB, Hoisted);
+      Changed |= !Hoisted.empty();
+    }
+  }
+  return Changed;
+}
+
+} // namespace wyrm
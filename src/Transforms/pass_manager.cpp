@@ -0,0 +1,144 @@
+#include "Transforms/pass_manager.h"
+
+namespace wyrm {
+
+PassManager::PassManager(unsigned NumWorkers)
+    : Queues(NumWorkers ? NumWorkers
+                        : std::max(1u, std::thread::hardware_concurrency())) {
+  // The thread calling run() is worker 0.
+  for (unsigned I = 1; I < Queues.size(); ++I)
+    Threads.emplace_back([this, I] { serve(I); });
+}
+
+PassManager::~PassManager() {
+  {
+    std::lock_guard<std::mutex> Guard{PoolLock};
+    Stopping = true;
+  }
+  Wake.notify_all();
+  for (auto &Thread : Threads)
+    Thread.join();
+}
+
+void PassManager::addFunctionPass(FunctionPass Pass,
+                                  PreservedAnalyses Preserved) {
+  if (Stages.empty() || Stages.back().WholeModule)
+    Stages.emplace_back();
+  Stages.back().FunctionPasses.push_back({std::move(Pass), Preserved});
+}
+
+void PassManager::addModulePass(ModulePass Pass) {
+  Stages.emplace_back();
+  Stages.back().WholeModule = std::move(Pass);
+}
+
+bool PassManager::run(Module &M) {
+  CacheMap Caches;
+  bool ModuleChanged = false;
+  for (const Stage &S : Stages) {
+    if (S.WholeModule) {
+      MIRBuilder Builder{M};
+      ModuleChanged |= S.WholeModule(Builder, M);
+      continue;
+    }
+    ModuleChanged |= runFunctionPasses(M, S.FunctionPasses, Caches);
+  }
+  return ModuleChanged;
+}
+
+bool PassManager::runFunctionPasses(
+    Module &M, const std::vector<FunctionPassEntry> &Passes,
+    CacheMap &Caches) {
+  std::vector<AnalysisCache *> Functions;
+  for (Function &F : M) {
+    auto &Analyses = Caches[&F];
+    if (!Analyses)
+      Analyses = std::make_unique<AnalysisCache>(F);
+    Functions.push_back(Analyses.get());
+  }
+  // Workers read the passes only after taking a function from a queue, which
+  // is filled afterwards.
+  CurrentPasses = &Passes;
+  Changed.store(false, std::memory_order_relaxed);
+  // Every worker starts with a contiguous range of functions.
+  const std::size_t NumFunctions = Functions.size();
+  const std::size_t NumQueues = Queues.size();
+  for (std::size_t I = 0; I < NumQueues; ++I) {
+    std::lock_guard<std::mutex> Guard{Queues[I].Lock};
+    Queues[I].Functions.assign(
+        std::begin(Functions) + I * NumFunctions / NumQueues,
+        std::begin(Functions) + (I + 1) * NumFunctions / NumQueues);
+  }
+  if (!Threads.empty()) {
+    {
+      std::lock_guard<std::mutex> Guard{PoolLock};
+      ++Generation;
+    }
+    Wake.notify_all();
+  }
+  work(0);
+  // The queues are empty, but pool threads might still transform the last
+  // functions they took.
+  std::unique_lock<std::mutex> Guard{PoolLock};
+  Idle.wait(Guard, [this] { return Active == 0; });
+  return Changed.load(std::memory_order_relaxed);
+}
+
+AnalysisCache *PassManager::take(unsigned Self) {
+  {
+    Queue &Own = Queues[Self];
+    std::lock_guard<std::mutex> Guard{Own.Lock};
+    if (!Own.Functions.empty()) {
+      AnalysisCache *Analyses = Own.Functions.back();
+      Own.Functions.pop_back();
+      return Analyses;
+    }
+  }
+  const auto NumQueues = static_cast<unsigned>(Queues.size());
+  for (unsigned Offset = 1; Offset < NumQueues; ++Offset) {
+    Queue &Victim = Queues[(Self + Offset) % NumQueues];
+    std::lock_guard<std::mutex> Guard{Victim.Lock};
+    if (!Victim.Functions.empty()) {
+      AnalysisCache *Analyses = Victim.Functions.front();
+      Victim.Functions.pop_front();
+      return Analyses;
+    }
+  }
+  return nullptr;
+}
+
+void PassManager::work(unsigned Self) {
+  while (AnalysisCache *Analyses = take(Self)) {
+    Function &F = Analyses->function();
+    MIRBuilder Builder{F.parent()};
+    bool FunctionChanged = false;
+    for (const FunctionPassEntry &Pass : *CurrentPasses) {
+      Analyses->startPass();
+      const bool PassChanged = Pass.Run(Builder, F, *Analyses);
+      Analyses->finishPass(PassChanged ? Pass.Preserved
+                                       : PreservedAnalyses::all());
+      FunctionChanged |= PassChanged;
+    }
+    if (FunctionChanged)
+      Changed.store(true, std::memory_order_relaxed);
+  }
+}
+
+void PassManager::serve(unsigned Self) {
+  std::uint64_t Seen = 0;
+  std::unique_lock<std::mutex> Guard{PoolLock};
+  for (;;) {
+    Wake.wait(Guard, [&] { return Stopping || Generation != Seen; });
+    if (Stopping)
+      return;
+    Seen = Generation;
+    ++Active;
+    Guard.unlock();
+    work(Self);
+    Guard.lock();
+    if (--Active == 0)
+      Idle.notify_all();
+  }
+}
+
+} // namespace wyrm
@@ -0,0 +1,297 @@
+#include "Transforms/sccp.h"
+#include "Analysis/cfg.h"
+#include "Analysis/dominator_tree.h"
+
+#include <cstdint>
+#include <unordered_set>
+
+namespace wyrm {
+
+namespace {
+using NodeId = CSRGraph::NodeId;
+
+/// \brief Lattice value of a register.
+/// Unknown values might still become constants, overdefined ones can't.
+struct LatticeValue {
+  enum KindT { Unknown, Constant, Overdefined };
+  KindT Kind{Unknown};
+  Imm Number{};
+  bool isConstant() const { return Kind == Constant; }
+  bool operator==(const LatticeValue &RHS) const {
+    return Kind == RHS.Kind && (Kind != Constant || Number == RHS.Number);
+  }
+  bool operator!=(const LatticeValue &RHS) const { return !(*this == RHS); }
+  static LatticeValue constant(Imm C) { return {Constant, C}; }
+  static LatticeValue overdefined() { return {Overdefined, 0}; }
+};
+
+LatticeValue meet(LatticeValue A, LatticeValue B) {
+  if (A.Kind == LatticeValue::Unknown)
+    return B;
+  if (B.Kind == LatticeValue::Unknown || A == B)
+    return A;
+  return LatticeValue::overdefined();
+}
+
+class SCCPSolver {
+public:
+  SCCPSolver(const FunctionCFG &CFG, const DominatorTree &DT);
+  void solve();
+  LatticeValue value(Value V) const;
+  bool isExecutable(NodeId Node) const { return Executable[Node]; }
+  bool isExecutable(NodeId From, NodeId To) const {
+    return ExecutableEdges.count(edgeKey(From, To));
+  }
+
+private:
+  static std::uint64_t edgeKey(NodeId From, NodeId To) {
+    return std::uint64_t{From} << 32 | To;
+  }
+  bool isTracked(const SymReg &Reg) const {
+    return Reg.isLocal() && Reg.index() < Values.size();
+  }
+  void markEdge(NodeId From, NodeId To);
+  void setValue(const SymReg &Reg, LatticeValue V);
+  void visitBlock(NodeId Node);
+  void visit(Instruction &Inst, NodeId Node);
+  void visitPhi(PhiInst &Phi, NodeId Node);
+  void visitBranch(BrInst &Br, NodeId Node);
+  /// \brief Make both edges of branches on unknown values executable.
+  /// Unknown values survive in executable blocks only if they are read
+  /// before being defined, so nothing is known about them.
+  /// \return false if nothing changed.
+  bool resolveUnknownBranches();
+  const FunctionCFG &CFG;
+  std::vector<LatticeValue> Values;
+  std::vector<bool> Executable;
+  std::unordered_set<std::uint64_t> ExecutableEdges{};
+  /// Destinations of edges which became executable.
+  std::vector<NodeId> CFGWorklist{};
+  std::vector<std::size_t> SSAWorklist{};
+  /// Instructions using a register together with their blocks.
+  std::vector<std::vector<std::pair<Instruction *, NodeId>>> Users;
+};
+} // namespace
+
+SCCPSolver::SCCPSolver(const FunctionCFG &CFG, const DominatorTree &DT)
+    : CFG{CFG}, Values(CFG.block(0).parent().symbolicRegisters().size()),
+      Executable(CFG.size()), Users(Values.size()) {
+  for (NodeId Node = 0, E = CFG.size(); Node < E; ++Node)
+    for (Instruction &Inst : CFG.block(Node))
+      forEachOperand(Inst, [&](Value V) {
+        SymReg *Reg = get<SymReg>(&V);
+        if (Reg && isTracked(*Reg))
+          Users[Reg->index()].emplace_back(&Inst, Node);
+      });
+  // Only a single definition read after it gives a register one value.
+  const std::vector<bool> IsTracked = findDominatingDefinitions(CFG, DT);
+  for (std::size_t Index = 0, E = Values.size(); Index < E; ++Index)
+    if (!IsTracked[Index])
+      Values[Index] = LatticeValue::overdefined();
+}
+
+LatticeValue SCCPSolver::value(Value V) const {
+  if (const Imm *Constant = get<Imm>(&V))
+    return LatticeValue::constant(*Constant);
+  const SymReg *Reg = get<SymReg>(&V);
+  if (!isTracked(*Reg))
+    return LatticeValue::overdefined();
+  return Values[Reg->index()];
+}
+
+void SCCPSolver::solve() {
+  Executable[CSRGraph::Root] = true;
+  visitBlock(CSRGraph::Root);
+  do {
+    while (!CFGWorklist.empty() || !SSAWorklist.empty()) {
+      while (!CFGWorklist.empty()) {
+        NodeId To = CFGWorklist.back();
+        CFGWorklist.pop_back();
+        if (!Executable[To]) {
+          Executable[To] = true;
+          visitBlock(To);
+          continue;
+        }
+        // Only phis depend on the new edge.
+        for (Instruction &Inst : CFG.block(To)) {
+          auto *Phi = get<PhiInst>(&Inst);
+          if (!Phi)
+            break;
+          visitPhi(*Phi, To);
+        }
+      }
+      while (!SSAWorklist.empty()) {
+        std::size_t Index = SSAWorklist.back();
+        SSAWorklist.pop_back();
+        for (auto [Inst, Node] : Users[Index])
+          if (Executable[Node])
+            visit(*Inst, Node);
+      }
+    }
+  } while (resolveUnknownBranches());
+}
+
+void SCCPSolver::markEdge(NodeId From, NodeId To) {
+  if (ExecutableEdges.insert(edgeKey(From, To)).second)
+    CFGWorklist.push_back(To);
+}
+
+void SCCPSolver::setValue(const SymReg &Reg, LatticeValue V) {
+  if (!isTracked(Reg))
+    return;
+  auto &Current = Values[Reg.index()];
+  V = meet(Current, V);
+  if (V == Current)
+    return;
+  Current = V;
+  SSAWorklist.push_back(Reg.index());
+}
+
+void SCCPSolver::visitBlock(NodeId Node) {
+  for (Instruction &Inst : CFG.block(Node))
+    visit(Inst, Node);
+}
+
+void SCCPSolver::visit(Instruction &Inst, NodeId Node) {
+  if (auto *Phi = get<PhiInst>(&Inst))
+    return visitPhi(*Phi, Node);
+  if (auto *Br = get<BrInst>(&Inst))
+    return visitBranch(*Br, Node);
+  if (auto *GoTo = get<GoToInst>(&Inst))
+    return markEdge(Node, CFG.number(GoTo->successor()));
+  if (auto *UnOp = get<UnOpInst>(&Inst)) {
+    LatticeValue Operand = value(UnOp->operand());
+    if (Operand.isConstant())
+      Operand.Number = evaluate(UnOp->kind(), Operand.Number);
+    return setValue(UnOp->outRegister(), Operand);
+  }
+  if (auto *BinOp = get<BinOpInst>(&Inst)) {
+    LatticeValue LHS = value(BinOp->operand1());
+    LatticeValue RHS = value(BinOp->operand2());
+    if (LHS.Kind == LatticeValue::Overdefined ||
+        RHS.Kind == LatticeValue::Overdefined)
+      return setValue(BinOp->outRegister(), LatticeValue::overdefined());
+    if (!LHS.isConstant() || !RHS.isConstant())
+      return;
+    auto Result = evaluate(BinOp->kind(), LHS.Number, RHS.Number);
+    // The operation traps, so it must stay.
+    if (!Result)
+      return setValue(BinOp->outRegister(), LatticeValue::overdefined());
+    return setValue(BinOp->outRegister(), LatticeValue::constant(*Result));
+  }
+  // Received arguments and call results are unknown.
+  if (SymReg *Reg = definedRegister(Inst))
+    setValue(*Reg, LatticeValue::overdefined());
+}
+
+void SCCPSolver::visitPhi(PhiInst &Phi, NodeId Node) {
+  LatticeValue Result;
+  for (std::size_t I = 0, E = Phi.size(); I != E; ++I)
+    if (isExecutable(CFG.number(Phi.incomingBlock(I)), Node))
+      Result = meet(Result, value(Phi.incomingValue(I)));
+  setValue(Phi.outRegister(), Result);
+}
+
+void SCCPSolver::visitBranch(BrInst &Br, NodeId Node) {
+  LatticeValue Condition = value(Br.condition());
+  if (Condition.Kind == LatticeValue::Unknown)
+    return;
+  NodeId True = CFG.number(Br.trueSuccessor());
+  NodeId False = CFG.number(Br.falseSuccessor());
+  if (!Condition.isConstant() || Condition.Number)
+    markEdge(Node, True);
+  if (!Condition.isConstant() || !Condition.Number)
+    markEdge(Node, False);
+}
+
+bool SCCPSolver::resolveUnknownBranches() {
+  bool Changed{};
+  for (NodeId Node = 0, E = CFG.size(); Node < E; ++Node) {
+    BasicBlock &BB = CFG.block(Node);
+    if (!Executable[Node] || BB.empty())
+      continue;
+    auto *Br = get<BrInst>(&*std::prev(std::end(BB)));
+    if (!Br || value(Br->condition()).Kind != LatticeValue::Unknown)
+      continue;
+    for (auto *Succ : {&Br->trueSuccessor(), &Br->falseSuccessor()}) {
+      auto Size = CFGWorklist.size();
+      markEdge(Node, CFG.number(*Succ));
+      Changed |= CFGWorklist.size() != Size;
+    }
+  }
+  return Changed;
+}
+
+/// \return If the only effect of \p Inst is writing its register.
+static bool isPure(const Instruction &Inst) {
+  return get<UnOpInst>(&Inst) || get<BinOpInst>(&Inst) || get<PhiInst>(&Inst);
+}
+
+bool propagateConstants(MIRBuilder &Builder, Function &F) {
+  AnalysisCache Analyses{F};
+  return propagateConstants(Builder, F, Analyses);
+}
+
+bool propagateConstants(MIRBuilder &Builder, Function &F,
+                        AnalysisCache &Analyses) {
+  if (!F.size())
+    return false;
+  // The CFG isn't recomputed while the pass changes branches and erases
+  // blocks: the cache does it only on the next request.
+  const FunctionCFG &CFG = Analyses.cfg();
+  SCCPSolver Solver{CFG, Analyses.dominatorTree()};
+  Solver.solve();
+
+  bool Changed{};
+  for (NodeId Node = 0, E = CFG.size(); Node < E; ++Node) {
+    if (!Solver.isExecutable(Node))
+      continue;
+    BasicBlock &BB = CFG.block(Node);
+    std::vector<std::size_t> Dead;
+    for (std::size_t Position = 0, Size = BB.size(); Position < Size;
+         ++Position) {
+      Instruction &Inst = BB[Position];
+      if (auto *Phi = get<PhiInst>(&Inst))
+        for (std::size_t I = Phi->size(); I-- > 0;)
+          if (!Solver.isExecutable(CFG.number(Phi->incomingBlock(I)), Node)) {
+            Phi->removeIncoming(I);
+            Changed = true;
+          }
+      SymReg *Reg = definedRegister(Inst);
+      if (!Reg || !Solver.value(*Reg).isConstant())
+        continue;
+      // Every use is folded including the ones in unreachable blocks, which
+      // are erased below.
+      Changed |= Reg->hasUses();
+      replaceAllUsesWith(*Reg, Solver.value(*Reg).Number);
+      if (isPure(Inst))
+        Dead.push_back(Position);
+    }
+    Builder.eraseInstructions(BB, Dead);
+    Changed |= !Dead.empty();
+
+    if (BB.empty())
+      continue;
+    auto *Br = get<BrInst>(&*std::prev(std::end(BB)));
+    if (!Br)
+      continue;
+    BasicBlock &True = Br->trueSuccessor(), &False = Br->falseSuccessor();
+    bool IsTrueTaken = Solver.isExecutable(Node, CFG.number(True));
+    bool IsFalseTaken = Solver.isExecutable(Node, CFG.number(False));
+    if (IsTrueTaken && IsFalseTaken && &True != &False)
+      continue;
+    Builder.eraseInstruction(BB, BB.size() - 1);
+    Builder.setInsertPoint(BB, BB.size());
+    Builder.createGoToInst(IsTrueTaken ? True : False);
+    Changed = true;
+  }
+
+  std::vector<BasicBlock *> Unreachable;
+  for (NodeId Node = 0, E = CFG.size(); Node < E; ++Node)
+    if (!Solver.isExecutable(Node))
+      Unreachable.push_back(&CFG.block(Node));
+  Builder.eraseBasicBlocks(Unreachable);
+  return Changed || !Unreachable.empty();
+}
+
+} // namespace wyrm
@@ -0,0 +1,199 @@
+#include "Transforms/ssa.h"
+#include "Analysis/cfg.h"
+#include "Analysis/dominance.h"
+#include "Analysis/dominance_frontier.h"
+#include "Analysis/dominator_tree.h"
+
+#include <limits>
+
+namespace wyrm {
+
+static std::string nameOf(const SymReg &Reg) {
+  return std::string{Reg.name()};
+}
+
+namespace {
+using NodeId = CSRGraph::NodeId;
+/// Phi instructions of a block with the registers they were placed for.
+using BlockPhis = std::vector<std::pair<PhiInst *, SymReg *>>;
+
+/// \brief Renaming phase of constructSSA.
+/// Every original register has a stack of its current definitions. Blocks
+/// are renamed in preorder of the dominator tree and the definitions pushed
+/// by a block are popped when the walk leaves its subtree.
+class SSARenamer {
+public:
+  SSARenamer(MIRBuilder &Builder, Function &F, const FunctionCFG &CFG,
+             const std::vector<BlockPhis> &Phis, std::size_t NumRegs)
+      : Builder{Builder}, F{F}, CFG{CFG}, Phis{Phis}, NumRegs{NumRegs},
+        Stacks(NumRegs), Renamed(NumRegs) {}
+  void run(const DominatorTree &DT);
+
+private:
+  static constexpr std::size_t NoMark = std::numeric_limits<std::size_t>::max();
+  bool isTracked(const SymReg &Reg) const {
+    return Reg.isLocal() && Reg.index() < NumRegs;
+  }
+  void renameBlock(NodeId Node);
+  /// \brief Pop definitions pushed after \p DefLog had \p Mark entries.
+  void unwind(std::size_t Mark);
+  SymReg &newDefinition(SymReg &Reg);
+  Value currentValue(Value V) const;
+  MIRBuilder &Builder;
+  Function &F;
+  const FunctionCFG &CFG;
+  const std::vector<BlockPhis> &Phis;
+  const std::size_t NumRegs;
+  std::vector<std::vector<SymReg *>> Stacks;
+  /// Registers which already have a definition renamed.
+  std::vector<bool> Renamed;
+  /// Indices of registers in the order their definitions were pushed.
+  std::vector<std::size_t> DefLog{};
+};
+} // namespace
+
+void SSARenamer::run(const DominatorTree &DT) {
+  std::vector<std::pair<NodeId, std::size_t>> Stack{{DT.Root, NoMark}};
+  while (!Stack.empty()) {
+    auto [Node, Mark] = Stack.back();
+    Stack.pop_back();
+    if (Mark != NoMark) {
+      unwind(Mark);
+      continue;
+    }
+    Stack.emplace_back(Node, DefLog.size());
+    renameBlock(Node);
+    auto Children = DT.children(Node);
+    for (auto It = Children.end(); It != Children.begin();)
+      Stack.emplace_back(*--It, NoMark);
+  }
+  // Unreachable blocks see only their own definitions.
+  for (NodeId Node = 0, E = CFG.size(); Node < E; ++Node)
+    if (!DT.contains(Node)) {
+      renameBlock(Node);
+      unwind(0);
+    }
+}
+
+void SSARenamer::renameBlock(NodeId Node) {
+  BasicBlock &BB = CFG.block(Node);
+  for (Instruction &Inst : BB) {
+    // Phi operands are filled from the predecessors.
+    if (!get<PhiInst>(&Inst))
+      rewriteOperands(Inst, [this](Value V) { return currentValue(V); });
+    SymReg *Reg = definedRegister(Inst);
+    if (!Reg || !isTracked(*Reg))
+      continue;
+    SymReg &NewReg = newDefinition(*Reg);
+    setDefinedRegister(Inst, NewReg);
+    Stacks[Reg->index()].push_back(&NewReg);
+    DefLog.push_back(Reg->index());
+  }
+  for (auto Succ : CFG.graph().successors(Node))
+    for (auto [Phi, Reg] : Phis[Succ])
+      Phi->addIncoming(currentValue(*Reg), BB);
+}
+
+void SSARenamer::unwind(std::size_t Mark) {
+  for (; DefLog.size() > Mark; DefLog.pop_back())
+    Stacks[DefLog.back()].pop_back();
+}
+
+SymReg &SSARenamer::newDefinition(SymReg &Reg) {
+  if (!Renamed[Reg.index()]) {
+    Renamed[Reg.index()] = true;
+    return Reg;
+  }
+  return Builder.createRegister(F, nameOf(Reg));
+}
+
+Value SSARenamer::currentValue(Value V) const {
+  SymReg *Reg = get<SymReg>(&V);
+  if (!Reg || !isTracked(*Reg))
+    return V;
+  const auto &Stack = Stacks[Reg->index()];
+  if (Stack.empty())
+    return 0;
+  return *Stack.back();
+}
+
+void constructSSA(MIRBuilder &Builder, Function &F) {
+  AnalysisCache Analyses{F};
+  constructSSA(Builder, F, Analyses);
+}
+
+void constructSSA(MIRBuilder &Builder, Function &F, AnalysisCache &Analyses) {
+  if (!F.size())
+    return;
+  const FunctionCFG &CFG = Analyses.cfg();
+  const CSRGraph &G = CFG.graph();
+  const DominatorTree &DT = Analyses.dominatorTree();
+  const std::size_t NumRegs{F.symbolicRegisters().size()};
+  auto IsTracked = [NumRegs](const SymReg &Reg) {
+    return Reg.isLocal() && Reg.index() < NumRegs;
+  };
+
+  // Find registers live on entry to some block and blocks defining them.
+  std::vector<bool> UsedBeforeDef(NumRegs);
+  std::vector<SymReg *> Registers(NumRegs);
+  std::vector<std::vector<NodeId>> DefBlocks(NumRegs);
+  std::vector<NodeId> LastDefBlock(NumRegs, CSRGraph::NoNode);
+  for (NodeId Node = 0, E = CFG.size(); Node < E; ++Node)
+    for (Instruction &Inst : CFG.block(Node)) {
+      assert(!get<PhiInst>(&Inst) && "The function is already in SSA form");
+      forEachOperand(Inst, [&](Value V) {
+        SymReg *Reg = get<SymReg>(&V);
+        if (Reg && IsTracked(*Reg) && LastDefBlock[Reg->index()] != Node)
+          UsedBeforeDef[Reg->index()] = true;
+      });
+      SymReg *Reg = definedRegister(Inst);
+      if (!Reg || !IsTracked(*Reg) || LastDefBlock[Reg->index()] == Node)
+        continue;
+      Registers[Reg->index()] = Reg;
+      LastDefBlock[Reg->index()] = Node;
+      DefBlocks[Reg->index()].push_back(Node);
+    }
+
+  std::vector<BlockPhis> Phis(CFG.size());
+  IDFCalculator IDF{G, DT};
+  for (std::size_t Index = 0; Index < NumRegs; ++Index) {
+    if (!UsedBeforeDef[Index] || DefBlocks[Index].empty())
+      continue;
+    for (auto Node : IDF.calculate(DefBlocks[Index])) {
+      Builder.setInsertPoint(CFG.block(Node), Phis[Node].size());
+      auto &Phi = get<PhiInst>(Builder.createPhiInst(*Registers[Index]));
+      Phis[Node].emplace_back(&Phi, Registers[Index]);
+    }
+  }
+
+  SSARenamer{Builder, F, CFG, Phis, NumRegs}.run(DT);
+}
+
+void destructSSA(MIRBuilder &Builder, Function &F) {
+  for (BasicBlock &BB : F) {
+    std::vector<std::pair<SymReg *, SymReg *>> Copies;
+    for (std::size_t Position = 0; Position < BB.size(); ++Position) {
+      auto *Phi = get<PhiInst>(&BB[Position]);
+      if (!Phi)
+        break;
+      SymReg &Out = Phi->outRegister();
+      SymReg &Temp = Builder.createRegister(F, nameOf(Out));
+      for (std::size_t I = 0, E = Phi->size(); I != E; ++I) {
+        BasicBlock &Pred = Phi->incomingBlock(I);
+        std::size_t End = Pred.size();
+        if (End && isTerminator(Pred[End - 1]))
+          --End;
+        Builder.setInsertPoint(Pred, End);
+        Builder.createUnOpInst(UnOpKind::Assign, Phi->incomingValue(I), Temp);
+      }
+      Copies.emplace_back(&Out, &Temp);
+    }
+    for (std::size_t I = 0; I < Copies.size(); ++I)
+      Builder.eraseInstruction(BB, 0);
+    Builder.setInsertPoint(BB, 0);
+    for (auto [Out, Temp] : Copies)
+      Builder.createUnOpInst(UnOpKind::Assign, *Temp, *Out);
+  }
+}
+
+} // namespace wyrm
@@ -0,0 +1,42 @@
+#include "arena.h"
+
+#include <algorithm>
+
+namespace wyrm {
+
+/// Chunk header padded to keep allocations maximally aligned.
+static constexpr std::size_t HeaderSize =
+    (sizeof(void *) + alignof(std::max_align_t) - 1) &
+    ~(alignof(std::max_align_t) - 1);
+
+Arena::~Arena() {
+  while (Chunks) {
+    Chunk *Previous = Chunks->Previous;
+    ::operator delete(Chunks);
+    Chunks = Previous;
+  }
+}
+
+void *Arena::allocateInNewChunk(std::size_t Size) {
+  std::size_t ChunkSize =
+      std::min(MinChunkSize << std::min<std::size_t>(NumChunks, 8),
+               MaxChunkSize);
+  // A big object gets a chunk of its own, so that the rest of the current
+  // chunk isn't wasted.
+  bool Dedicated = Size > ChunkSize / 4;
+  if (Dedicated)
+    ChunkSize = HeaderSize + Size;
+  auto *Memory = static_cast<char *>(::operator new(ChunkSize));
+  Chunks = new (Memory) Chunk{Chunks};
+  ++NumChunks;
+  Reserved += ChunkSize;
+  Allocated += Size;
+  char *Result = Memory + HeaderSize;
+  if (!Dedicated) {
+    Current = Result + Size;
+    End = Memory + ChunkSize;
+  }
+  return Result;
+}
+
+} // namespace wyrm
@@ -0,0 +1,100 @@
+#include "bitvector.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WYRM_HAS_AVX2_KERNELS
+#endif
+
+namespace wyrm {
+
+namespace {
+template <typename OpT>
+bool applyWords(BitWord *LHS, const BitWord *RHS, std::size_t N, OpT Op) {
+  BitWord Diff{};
+  for (std::size_t I = 0; I < N; ++I) {
+    BitWord Result = Op(LHS[I], RHS[I]);
+    Diff |= Result ^ LHS[I];
+    LHS[I] = Result;
+  }
+  return Diff != 0;
+}
+
+#ifdef WYRM_HAS_AVX2_KERNELS
+// Kernels are compiled for AVX2 regardless of the target flags and chosen at
+// run time, so a generic build still uses 256-bit operations where possible.
+__attribute__((target("avx2"))) bool andWordsAVX2(BitWord *LHS,
+                                                  const BitWord *RHS,
+                                                  std::size_t N) {
+  __m256i Diff = _mm256_setzero_si256();
+  std::size_t I = 0;
+  for (; I + 4 <= N; I += 4) {
+    auto *L = reinterpret_cast<__m256i *>(LHS + I);
+    __m256i Old = _mm256_loadu_si256(L);
+    __m256i Result = _mm256_and_si256(
+        Old, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(RHS + I)));
+    Diff = _mm256_or_si256(Diff, _mm256_xor_si256(Old, Result));
+    _mm256_storeu_si256(L, Result);
+  }
+  bool IsChanged = !_mm256_testz_si256(Diff, Diff);
+  return applyWords(LHS + I, RHS + I, N - I,
+                    [](BitWord L, BitWord R) { return L & R; }) ||
+         IsChanged;
+}
+
+__attribute__((target("avx2"))) bool orWordsAVX2(BitWord *LHS,
+                                                 const BitWord *RHS,
+                                                 std::size_t N) {
+  __m256i Diff = _mm256_setzero_si256();
+  std::size_t I = 0;
+  for (; I + 4 <= N; I += 4) {
+    auto *L = reinterpret_cast<__m256i *>(LHS + I);
+    __m256i Old = _mm256_loadu_si256(L);
+    __m256i Result = _mm256_or_si256(
+        Old, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(RHS + I)));
+    Diff = _mm256_or_si256(Diff, _mm256_xor_si256(Old, Result));
+    _mm256_storeu_si256(L, Result);
+  }
+  bool IsChanged = !_mm256_testz_si256(Diff, Diff);
+  return applyWords(LHS + I, RHS + I, N - I,
+                    [](BitWord L, BitWord R) { return L | R; }) ||
+         IsChanged;
+}
+
+bool hasAVX2() {
+  static const bool Result = __builtin_cpu_supports("avx2");
+  return Result;
+}
+#endif
+} // namespace
+
+bool andWords(BitWord *LHS, const BitWord *RHS, std::size_t N) {
+#ifdef WYRM_HAS_AVX2_KERNELS
+  if (hasAVX2())
+    return andWordsAVX2(LHS, RHS, N);
+#endif
+  return applyWords(LHS, RHS, N, [](BitWord L, BitWord R) { return L & R; });
+}
+
+bool orWords(BitWord *LHS, const BitWord *RHS, std::size_t N) {
+#ifdef WYRM_HAS_AVX2_KERNELS
+  if (hasAVX2())
+    return orWordsAVX2(LHS, RHS, N);
+#endif
+  return applyWords(LHS, RHS, N, [](BitWord L, BitWord R) { return L | R; });
+}
+
+std::size_t BitVector::count() const {
+  std::size_t Result{};
+  for (auto Word : Words)
+    Result += __builtin_popcountll(Word);
+  return Result;
+}
+
+bool BitVector::any() const {
+  for (auto Word : Words)
+    if (Word)
+      return true;
+  return false;
+}
+
+} // namespace wyrm
@@ -0,0 +1,87 @@
+#include "csr_graph.h"
+#include "graph_traversal.h"
+
+#include <algorithm>
+#include <cassert>
+
+CSRGraph::CSRGraph(const Graph &G) {
+  const std::size_t N{G.size()};
+  assert(N < NoNode && "The graph is too large for 32-bit node identifiers");
+  SuccOffsets.reserve(N + 1);
+  SuccOffsets.push_back(0);
+  // Count in-degrees while copying successors, so the predecessor offsets are
+  // known right after the only pass over the hash sets.
+  PredOffsets.assign(N + 1, 0);
+  for (std::size_t Node = 0; Node < N; ++Node) {
+    const auto &Successors = G.successors(Node);
+    auto First = Succs.size();
+    Succs.insert(std::end(Succs), std::cbegin(Successors),
+                 std::cend(Successors));
+    std::sort(std::begin(Succs) + First, std::end(Succs));
+    for (auto Succ : Successors)
+      ++PredOffsets[Succ + 1];
+    SuccOffsets.push_back(Succs.size());
+  }
+  buildPredecessors();
+}
+
+CSRGraph::CSRGraph(std::size_t Size, std::vector<Arc> Arcs) {
+  assert(Size < NoNode && "The graph is too large for 32-bit node identifiers");
+  std::sort(std::begin(Arcs), std::end(Arcs), [](Arc A, Arc B) {
+    return A.From < B.From || (A.From == B.From && A.To < B.To);
+  });
+  SuccOffsets.assign(Size + 1, 0);
+  PredOffsets.assign(Size + 1, 0);
+  Succs.reserve(Arcs.size());
+  for (std::size_t I = 0, E = Arcs.size(); I < E; ++I) {
+    Arc A = Arcs[I];
+    assert(A.From < Size && A.To < Size && "The arc is out of the graph");
+    assert(A.To != Root && "Arcs to the root vertex are prohibited");
+    if (I && Arcs[I - 1].From == A.From && Arcs[I - 1].To == A.To)
+      continue;
+    Succs.push_back(A.To);
+    ++SuccOffsets[A.From + 1];
+    ++PredOffsets[A.To + 1];
+  }
+  for (std::size_t Node = 0; Node < Size; ++Node)
+    SuccOffsets[Node + 1] += SuccOffsets[Node];
+  buildPredecessors();
+}
+
+void CSRGraph::buildPredecessors() {
+  const std::size_t N{size()};
+  for (std::size_t Node = 0; Node < N; ++Node)
+    PredOffsets[Node + 1] += PredOffsets[Node];
+  // Successors are visited in ascending order of their sources, so every
+  // predecessor list comes out sorted.
+  Preds.resize(Succs.size());
+  std::vector<NodeId> Cursor{std::cbegin(PredOffsets),
+                             std::prev(std::cend(PredOffsets))};
+  for (NodeId Node = 0; Node < N; ++Node)
+    for (auto Succ : successors(Node))
+      Preds[Cursor[Succ]++] = Node;
+}
+
+CSRGraph::NodeRange CSRGraph::range(const std::vector<NodeId> &Offsets,
+                                    const std::vector<NodeId> &Nodes,
+                                    NodeId Node) const {
+  assert(Node < size() && "The vertex is not in the graph");
+  const NodeId *Data = Nodes.data();
+  return {Data + Offsets[Node], Data + Offsets[Node + 1]};
+}
+
+std::vector<CSRGraph::NodeId> CSRGraph::DFSOrder() const {
+  return depthFirstOrder(*this);
+}
+
+std::vector<CSRGraph::NodeId> CSRGraph::reversePostOrder() const {
+  return ::reversePostOrder(*this);
+}
+
+bool CSRGraph::hasArc(Arc A) const {
+  if (A.From >= size())
+    return false;
+  auto Successors = successors(A.From);
+  return std::binary_search(std::begin(Successors), std::end(Successors),
+                            A.To);
+}
@@ -14,6 +14,11 @@ void Graph::addArc(Arc arc) {
   Data[arc.From].insert(arc.To);
 }
 
+void Graph::removeArc(Arc arc) {
+  if (arc.From < Data.size())
+    Data[arc.From].erase(arc.To);
+}
+
 Graph::Graph(const std::vector<Arc> &arcs) {
   Data.emplace_back(NodeSet{});
   for (const auto arc : arcs)
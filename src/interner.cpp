@@ -0,0 +1,97 @@
+#include "interner.h"
+
+#include <cassert>
+#include <cstring>
+#include <functional>
+
+namespace wyrm {
+
+static std::uint64_t hashString(string_view String) {
+  return std::hash<string_view>{}(String);
+}
+
+std::size_t StringInterner::lookup(const Shard &S, std::uint64_t Hash,
+                                   string_view String) {
+  const std::size_t Mask = S.Table.size() - 1;
+  for (std::size_t Position = Hash & Mask;; Position = (Position + 1) & Mask) {
+    const Slot &Current = S.Table[Position];
+    if (Current.String == NoString)
+      return Position;
+    if (Current.Hash != Hash)
+      continue;
+    auto [Segment, Offset] = locate(Current.String);
+    if (S.Segments[Segment][Offset] == String)
+      return Position;
+  }
+}
+
+void StringInterner::grow(Shard &S) {
+  std::vector<Slot> Table(S.Table.empty() ? 64 : 2 * S.Table.size(),
+                          Slot{0, NoString});
+  const std::size_t Mask = Table.size() - 1;
+  // The hashes are cached, so the strings aren't touched.
+  for (const Slot &Old : S.Table) {
+    if (Old.String == NoString)
+      continue;
+    std::size_t Position = Old.Hash & Mask;
+    while (Table[Position].String != NoString)
+      Position = (Position + 1) & Mask;
+    Table[Position] = Old;
+  }
+  S.Table = std::move(Table);
+}
+
+StringInterner::Id StringInterner::intern(string_view String) {
+  if (String.empty())
+    return EmptyId;
+  const std::uint64_t Hash = hashString(String);
+  const std::size_t ShardIndex = Hash >> (64 - ShardBits);
+  Shard &S = Shards[ShardIndex];
+  std::lock_guard<std::mutex> Guard{S.Lock};
+  // Keep the table at most half full.
+  if (2 * (S.Size + 1) > S.Table.size())
+    grow(S);
+  Slot &Found = S.Table[lookup(S, Hash, String)];
+  if (Found.String == NoString) {
+    const std::uint32_t Index = S.Size;
+    assert(Index < (NoString >> ShardBits) && "Too many strings");
+    auto [Segment, Offset] = locate(Index);
+    if (!Offset) {
+      const std::size_t Size = FirstSegmentSize << Segment;
+      S.Segments[Segment] = static_cast<string_view *>(S.Storage.allocate(
+          Size * sizeof(string_view), alignof(string_view)));
+    }
+    auto *Bytes = static_cast<char *>(S.Storage.allocate(String.size(), 1));
+    std::memcpy(Bytes, String.data(), String.size());
+    new (S.Segments[Segment] + Offset) string_view(Bytes, String.size());
+    Found = Slot{Hash, Index};
+    ++S.Size;
+  }
+  return (Found.String << ShardBits | static_cast<Id>(ShardIndex)) + 1;
+}
+
+optional<StringInterner::Id> StringInterner::find(string_view String) const {
+  if (String.empty())
+    return EmptyId;
+  const std::uint64_t Hash = hashString(String);
+  const std::size_t ShardIndex = Hash >> (64 - ShardBits);
+  const Shard &S = Shards[ShardIndex];
+  std::lock_guard<std::mutex> Guard{S.Lock};
+  if (S.Table.empty())
+    return {};
+  const Slot &Found = S.Table[lookup(S, Hash, String)];
+  if (Found.String == NoString)
+    return {};
+  return (Found.String << ShardBits | static_cast<Id>(ShardIndex)) + 1;
+}
+
+std::size_t StringInterner::size() const {
+  std::size_t Result = 1;
+  for (const Shard &S : Shards) {
+    std::lock_guard<std::mutex> Guard{S.Lock};
+    Result += S.Size;
+  }
+  return Result;
+}
+
+} // namespace wyrm
@@ -0,0 +1,240 @@
+#include "Analysis/analysis_cache.h"
+#include "Analysis/cfg.h"
+#include "Analysis/dominance.h"
+#include "Analysis/liveness.h"
+#include "Analysis/reaching_definitions.h"
+#include "MIR.h"
+#include "Transforms/ssa.h"
+#include "gtest/gtest.h"
+#include "utils.h"
+#include <set>
+
+using namespace wyrm;
+using namespace wyrm::test;
+
+namespace {
+std::set<std::size_t> toSet(BitVectorView Bits) {
+  std::set<std::size_t> Result;
+  Bits.forEachSetBit([&Result](std::size_t Bit) { Result.insert(Bit); });
+  return Result;
+}
+
+/// \brief Names of registers which bits are set in \p Bits.
+std::set<std::string> registerNames(const Function &F, BitVectorView Bits) {
+  std::set<std::string> Result;
+  Bits.forEachSetBit([&](std::size_t Bit) {
+    auto &Reg = F.symbolicRegisters()[Bit];
+    Result.insert(std::string{Reg.name()});
+  });
+  return Result;
+}
+
+using NameSet = std::set<std::string>;
+} // namespace
+
+TEST(AnalysisCache, RecomputesAfterChanges) {
+  auto [TheModule, Builder, F] = createFunctionContext("f");
+  buildSumLoop(*Builder, *F);
+  AnalysisCache Analyses{*F};
+  EXPECT_FALSE(Analyses.isCached(AnalysisKind::CFG));
+  const FunctionCFG *CFG = &Analyses.cfg();
+  const DominatorTree *DT = &Analyses.dominatorTree();
+  Analyses.liveness();
+  EXPECT_EQ(CFG, &Analyses.cfg());
+  EXPECT_EQ(DT, &Analyses.dominatorTree());
+  // A new instruction other than a terminator keeps the CFG.
+  BasicBlock &Body = (*F)[2];
+  Builder->setInsertPoint(Body, 0);
+  Builder->createBinOpInst(BinOpKind::Mul, 2, 3, "t");
+  EXPECT_TRUE(Analyses.isCached(AnalysisKind::DominatorTree));
+  EXPECT_FALSE(Analyses.isCached(AnalysisKind::Liveness));
+  Value S = get<BinOpInst>(Body[1]).operand1();
+  EXPECT_TRUE(Analyses.liveness().isLiveIn(*get<SymReg>(&S), Body));
+  // Replacing a branch changes the CFG.
+  BasicBlock &Header = (*F)[1];
+  Builder->eraseInstruction(Header, Header.size() - 1);
+  EXPECT_FALSE(Analyses.isCached(AnalysisKind::CFG));
+  Builder->setBasicBlock(Header);
+  Builder->createGoToInst((*F)[3]);
+  EXPECT_FALSE(Analyses.dominatorTree().dominates(
+      Analyses.cfg().number(Header), Analyses.cfg().number(Body)));
+}
+
+TEST(AnalysisCache, PassesKeepPreservedAnalyses) {
+  auto [TheModule, Builder, F] = createFunctionContext("f");
+  buildSumLoop(*Builder, *F);
+  AnalysisCache Analyses{*F};
+  Analyses.liveness();
+  Analyses.startPass();
+  // Swapping the successors of a branch keeps the edges and liveness, but
+  // the pass doesn't declare the dominator tree, which wasn't computed.
+  auto &Br = get<BrInst>(*std::prev(std::end((*F)[1])));
+  BasicBlock &True = Br.trueSuccessor();
+  Br.setTrueSuccessor(Br.falseSuccessor());
+  Br.setFalseSuccessor(True);
+  Analyses.finishPass(PreservedAnalyses::none()
+                          .preserve(AnalysisKind::CFG)
+                          .preserve(AnalysisKind::Liveness));
+  EXPECT_TRUE(Analyses.isCached(AnalysisKind::CFG));
+  EXPECT_FALSE(Analyses.isCached(AnalysisKind::DominatorTree));
+  EXPECT_TRUE(Analyses.isCached(AnalysisKind::Liveness));
+  // Results outdated before the pass started aren't revived.
+  Builder->setInsertPoint((*F)[2], 0);
+  Builder->createBinOpInst(BinOpKind::Mul, 2, 3, "t");
+  Analyses.startPass();
+  Analyses.finishPass(PreservedAnalyses::all());
+  EXPECT_TRUE(Analyses.isCached(AnalysisKind::CFG));
+  EXPECT_FALSE(Analyses.isCached(AnalysisKind::Liveness));
+}
+
+TEST(AnalysisCache, LoopsFollowControlFlow) {
+  auto [TheModule, Builder, F] = createFunctionContext("f");
+  buildSumLoop(*Builder, *F);
+  AnalysisCache Analyses{*F};
+  BasicBlock &Header = (*F)[1], &Body = (*F)[2];
+  const LoopInfo *Loops = &Analyses.loops();
+  ASSERT_EQ(1u, Loops->size());
+  EXPECT_EQ(Analyses.cfg().number(Header), Loops->header(0));
+  EXPECT_EQ(1u, Loops->depth(Analyses.cfg().number(Body)));
+  EXPECT_EQ(0u, Loops->depth(Analyses.cfg().number((*F)[3])));
+  // Instructions other than terminators keep the loops.
+  Builder->setInsertPoint(Body, 0);
+  Builder->createBinOpInst(BinOpKind::Mul, 2, 3, "t");
+  EXPECT_TRUE(Analyses.isCached(AnalysisKind::Loops));
+  EXPECT_EQ(Loops, &Analyses.loops());
+  // Leaving the body for the exit breaks the loop.
+  Builder->eraseInstruction(Body, Body.size() - 1);
+  EXPECT_FALSE(Analyses.isCached(AnalysisKind::Loops));
+  Builder->setBasicBlock(Body);
+  Builder->createGoToInst((*F)[3]);
+  EXPECT_EQ(0u, Analyses.loops().size());
+}
+
+TEST(FunctionGraph, MatchesFunctionCFG) {
+  std::mt19937 Gen{5};
+  for (std::size_t Test = 0; Test < 100; ++Test) {
+    auto [TheModule, Builder, F] =
+        createFunctionContext("random" + std::to_string(Test));
+    buildRandomFunction(Gen, *Builder, *F, 2 + Test % 30);
+    // Erase a block no other block jumps to, so the indices get a hole.
+    for (auto &BB : *F)
+      if (BB.index() && BB.predecessorIndices().empty()) {
+        Builder->eraseBasicBlock(BB);
+        break;
+      }
+    FunctionCFG CFG{*F};
+    FunctionGraph View{*F};
+    auto IDoms = immediateDominators(CFG.graph());
+    auto ViewIDoms = immediateDominators(View);
+    ASSERT_EQ(F->numBlockIndices(), ViewIDoms.size());
+    for (CSRGraph::NodeId Index = 0; Index < View.size(); ++Index) {
+      const BasicBlock *BB = F->blockAt(Index);
+      if (!BB) {
+        EXPECT_EQ(CSRGraph::NoNode, ViewIDoms[Index]);
+        EXPECT_TRUE(View.successors(Index).empty());
+        continue;
+      }
+      auto Node = CFG.number(*BB);
+      EXPECT_EQ(CFG.graph().successors(Node).size() == 0,
+                View.successors(Index).empty());
+      if (IDoms[Node] == CSRGraph::NoNode)
+        EXPECT_EQ(CSRGraph::NoNode, ViewIDoms[Index]);
+      else
+        EXPECT_EQ(&CFG.block(IDoms[Node]), F->blockAt(ViewIDoms[Index]));
+    }
+    auto Order = View.reversePostOrder();
+    EXPECT_EQ(CFG.graph().reversePostOrder().size(), Order.size());
+    // Immediate dominators precede the blocks they dominate.
+    std::vector<bool> Seen(View.size());
+    for (auto Index : Order) {
+      EXPECT_TRUE(Index == FunctionGraph::Root || Seen[ViewIDoms[Index]]);
+      Seen[Index] = true;
+    }
+  }
+}
+
+TEST(Liveness, SumLoop) {
+  auto [TheModule, Builder, F] = createFunctionContext("sum");
+  buildSumLoop(*Builder, *F);
+  FunctionCFG CFG{*F};
+  Liveness Live{CFG};
+  EXPECT_EQ(NameSet{}, registerNames(*F, Live.liveIn((*F)[0])));
+  EXPECT_EQ((NameSet{"i", "n", "s"}), registerNames(*F, Live.liveOut((*F)[0])));
+  EXPECT_EQ((NameSet{"i", "n", "s"}), registerNames(*F, Live.liveIn((*F)[1])));
+  EXPECT_EQ((NameSet{"i", "n", "s"}), registerNames(*F, Live.liveOut((*F)[2])));
+  EXPECT_EQ(NameSet{"s"}, registerNames(*F, Live.liveIn((*F)[3])));
+  EXPECT_EQ(NameSet{}, registerNames(*F, Live.liveOut((*F)[3])));
+}
+
+TEST(Liveness, PhiOperandsAreLiveInPredecessors) {
+  auto [TheModule, Builder, F] = createFunctionContext("sum");
+  buildSumLoop(*Builder, *F);
+  constructSSA(*Builder, *F);
+  FunctionCFG CFG{*F};
+  Liveness Live{CFG};
+  EXPECT_EQ((NameSet{"i", "n", "s"}), registerNames(*F, Live.liveOut((*F)[0])));
+  EXPECT_EQ(NameSet{"n"}, registerNames(*F, Live.liveIn((*F)[1])));
+  EXPECT_EQ((NameSet{"i.1", "n", "s.1"}),
+            registerNames(*F, Live.liveIn((*F)[2])));
+  EXPECT_EQ((NameSet{"i.2", "n", "s.2"}),
+            registerNames(*F, Live.liveOut((*F)[2])));
+  EXPECT_EQ(NameSet{"s.1"}, registerNames(*F, Live.liveIn((*F)[3])));
+}
+
+TEST(Liveness, RandomFunctionsMatchFixedPoint) {
+  std::mt19937 Gen{11};
+  for (std::size_t Test = 0; Test < 100; ++Test) {
+    auto [TheModule, Builder, F] =
+        createFunctionContext("random" + std::to_string(Test));
+    buildRandomFunction(Gen, *Builder, *F, 2 + Test % 20);
+    FunctionCFG CFG{*F};
+    Liveness Live{CFG};
+    // Instruction by instruction fixed point over reachable blocks.
+    const auto &G = CFG.graph();
+    std::vector<bool> Reachable(CFG.size());
+    for (auto Node : G.DFSOrder())
+      Reachable[Node] = true;
+    std::vector<std::set<std::size_t>> LiveIn(CFG.size());
+    for (bool Changed = true; Changed;) {
+      Changed = false;
+      for (CSRGraph::NodeId Node = 0; Node < CFG.size(); ++Node) {
+        if (!Reachable[Node])
+          continue;
+        std::set<std::size_t> Current;
+        for (auto Succ : G.successors(Node))
+          Current.insert(LiveIn[Succ].begin(), LiveIn[Succ].end());
+        auto &BB = CFG.block(Node);
+        for (std::size_t Position = BB.size(); Position-- > 0;) {
+          if (auto *Reg = definedRegister(BB[Position]))
+            Current.erase(Reg->index());
+          forEachOperand(BB[Position], [&Current](Value V) {
+            if (auto *Reg = get<SymReg>(&V))
+              Current.insert(Reg->index());
+          });
+        }
+        if (Current != LiveIn[Node]) {
+          LiveIn[Node] = std::move(Current);
+          Changed = true;
+        }
+      }
+    }
+    for (CSRGraph::NodeId Node = 0; Node < CFG.size(); ++Node)
+      EXPECT_EQ(LiveIn[Node], toSet(Live.liveIn(CFG.block(Node))));
+  }
+}
+
+TEST(ReachingDefinitions, SumLoop) {
+  auto [TheModule, Builder, F] = createFunctionContext("sum");
+  buildSumLoop(*Builder, *F);
+  FunctionCFG CFG{*F};
+  ReachingDefinitions Reaching{CFG};
+  // n = receive, i = 0, s = 0, c = cmp lt i, n, s = add s, i, i = add i, 1.
+  ASSERT_EQ(6u, Reaching.definitions().size());
+  EXPECT_EQ(&(*F)[2][1], Reaching.definitions()[5]);
+  using DefSet = std::set<std::size_t>;
+  EXPECT_EQ(DefSet{}, toSet(Reaching.reachingIn((*F)[0])));
+  EXPECT_EQ((DefSet{0, 1, 2}), toSet(Reaching.reachingOut((*F)[0])));
+  EXPECT_EQ((DefSet{0, 1, 2, 3, 4, 5}), toSet(Reaching.reachingIn((*F)[1])));
+  EXPECT_EQ((DefSet{0, 3, 4, 5}), toSet(Reaching.reachingOut((*F)[2])));
+  EXPECT_EQ((DefSet{0, 1, 2, 3, 4, 5}), toSet(Reaching.reachingIn((*F)[3])));
+}
@@ -0,0 +1,496 @@
+#include "ExecutionEngine/batch.h"
+#include "ExecutionEngine/interpreter.h"
+#include "ExecutionEngine/jit.h"
+#include "Transforms/gvn.h"
+#include "Transforms/sccp.h"
+#include "Transforms/ssa.h"
+#include "gtest/gtest.h"
+#include "utils.h"
+#include <csignal>
+
+using namespace wyrm;
+using namespace wyrm::test;
+
+namespace {
+/// \brief Build fib(n) computed with two recursive calls.
+void buildFib(MIRBuilder &Builder, Function &F) {
+  auto &Entry = Builder.createBasicBlock(F);
+  auto &Small = Builder.createBasicBlock(F);
+  auto &Large = Builder.createBasicBlock(F);
+  Builder.setBasicBlock(Entry);
+  auto &N = get<ReceiveInst>(Builder.createReceiveInst("n")).outRegister();
+  auto &C = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Less, N, 2, "c"))
+                .outRegister();
+  Builder.createBrInst(C, Small, Large);
+  Builder.setBasicBlock(Small);
+  Builder.createRetInst(N);
+  Builder.setBasicBlock(Large);
+  auto &N1 = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Sub, N, 1, "n1"))
+                 .outRegister();
+  auto &N2 = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Sub, N, 2, "n2"))
+                 .outRegister();
+  auto &A = *get<CallInst>(Builder.createCallInst(true, F, {N1}, "a"))
+                 .outRegister();
+  auto &B = *get<CallInst>(Builder.createCallInst(true, F, {N2}, "b"))
+                 .outRegister();
+  auto &S = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Add, A, B, "s"))
+                .outRegister();
+  Builder.createRetInst(S);
+}
+} // namespace
+
+TEST(Interpreter, SumLoop) {
+  auto [TheModule, Builder, F] = createFunctionContext("sum");
+  buildSumLoop(*Builder, *F);
+  Interpreter Engine{*TheModule};
+  auto Result = Engine.run(*F, {10});
+  ASSERT_TRUE(Result.returned());
+  EXPECT_EQ(45, Result.ReturnValue);
+  // 4 instructions on entry, 5 per iteration, the last check and ret.
+  EXPECT_EQ(4u + 10 * 5 + 3, Engine.executedInstructions());
+  EXPECT_EQ(0, Engine.run(*F).ReturnValue);
+}
+
+TEST(Interpreter, Recursion) {
+  auto [TheModule, Builder, F] = createFunctionContext("fib");
+  buildFib(*Builder, *F);
+  Interpreter Engine{*TheModule};
+  auto Result = Engine.run(*F, {20});
+  ASSERT_TRUE(Result.returned());
+  EXPECT_EQ(6765, Result.ReturnValue);
+  Engine.setCallDepthLimit(10);
+  EXPECT_EQ(ExecutionResult::StackOverflow, Engine.run(*F, {20}).Status);
+  EXPECT_EQ(55, Engine.run(*F, {10}).ReturnValue);
+}
+
+TEST(Interpreter, Operations) {
+  auto [TheModule, Builder, F] = createFunctionContext("ops");
+  std::vector<std::pair<BinOpKind, Function *>> BinOps;
+  for (int I = 0; I <= static_cast<int>(BinOpKind::Geq); ++I) {
+    auto Kind = static_cast<BinOpKind>(I);
+    auto *Op = Builder->createFunction("binop" + std::to_string(I));
+    Builder->setBasicBlock(Builder->createBasicBlock(*Op));
+    auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+    auto &B = get<ReceiveInst>(Builder->createReceiveInst("b")).outRegister();
+    Builder->createRetInst(
+        get<BinOpInst>(Builder->createBinOpInst(Kind, A, B)).outRegister());
+    BinOps.emplace_back(Kind, Op);
+  }
+  std::vector<std::pair<UnOpKind, Function *>> UnOps;
+  for (auto Kind : {UnOpKind::Assign, UnOpKind::Neg, UnOpKind::Not}) {
+    auto *Op =
+        Builder->createFunction("unop" + std::to_string(UnOps.size()));
+    Builder->setBasicBlock(Builder->createBasicBlock(*Op));
+    auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+    Builder->createRetInst(
+        get<UnOpInst>(Builder->createUnOpInst(Kind, A)).outRegister());
+    UnOps.emplace_back(Kind, Op);
+  }
+  const Imm Min = std::numeric_limits<Imm>::min();
+  const Imm Max = std::numeric_limits<Imm>::max();
+  Interpreter Engine{*TheModule};
+  for (Imm A : {0, 1, -1, 7, -7, 33, Min, Max}) {
+    for (auto [Kind, Op] : UnOps)
+      EXPECT_EQ(evaluate(Kind, A), Engine.run(*Op, {A}).ReturnValue);
+    for (Imm B : {0, 1, -1, 3, -3, 31, 32, Min, Max})
+      for (auto [Kind, Op] : BinOps) {
+        auto Expected = evaluate(Kind, A, B);
+        auto Result = Engine.run(*Op, {A, B});
+        if (!Expected) {
+          EXPECT_EQ(ExecutionResult::Trapped, Result.Status);
+          continue;
+        }
+        ASSERT_TRUE(Result.returned());
+        EXPECT_EQ(*Expected, Result.ReturnValue);
+      }
+  }
+}
+
+TEST(Interpreter, Globals) {
+  auto [TheModule, Builder, F] = createFunctionContext("counter");
+  auto &Counter = Builder->createGlobalVariable("counter");
+  auto &Entry = Builder->createBasicBlock(*F);
+  auto &Next = Builder->createBasicBlock(*F);
+  Builder->setBasicBlock(Entry);
+  Builder->createBinOpInst(BinOpKind::Add, Counter, 1, Counter);
+  Builder->createGoToInst(Next);
+  Builder->setBasicBlock(Next);
+  Builder->createBinOpInst(BinOpKind::Mul, Counter, 2, Counter);
+  Builder->createRetInst(0);
+  Interpreter Engine{*TheModule};
+  Engine.setGlobal(Counter, 1);
+  auto Result = Engine.run(*F);
+  ASSERT_TRUE(Result.returned());
+  EXPECT_EQ(0, Result.ReturnValue);
+  EXPECT_EQ(4, Engine.global(Counter));
+  Engine.run(*F);
+  EXPECT_EQ(10, Engine.global(Counter));
+}
+
+TEST(Interpreter, InstructionLimit) {
+  auto [TheModule, Builder, F] = createFunctionContext("forever");
+  auto &Loop = Builder->createBasicBlock(*F);
+  Builder->setBasicBlock(Loop);
+  Builder->createGoToInst(Loop);
+  Interpreter Engine{*TheModule};
+  Engine.setInstructionLimit(1000);
+  EXPECT_EQ(ExecutionResult::LimitExceeded, Engine.run(*F).Status);
+}
+
+TEST(Interpreter, OptimizationsPreserveResults) {
+  std::mt19937 Seeds{23};
+  std::size_t NumReturned{};
+  for (std::size_t Test = 0; Test < 200; ++Test) {
+    RandomFunctionPair Functions{Seeds(), 2 + Test % 30};
+    auto &Builder = Functions.Builder;
+    auto &F = Functions.F;
+    constructSSA(Builder, F);
+    NumReturned += Functions.expectSameResults("SSA");
+    propagateConstants(Builder, F);
+    Functions.expectSameResults("SCCP");
+    eliminateRedundancies(Builder, F);
+    Functions.expectSameResults("GVN");
+    destructSSA(Builder, F);
+    Functions.expectSameResults("Out of SSA");
+  }
+  EXPECT_LT(500u, NumReturned);
+}
+
+TEST(JIT, Recursion) {
+  if (!JITCompiler::IsSupported)
+    GTEST_SKIP();
+  auto [TheModule, Builder, F] = createFunctionContext("fib");
+  buildFib(*Builder, *F);
+  JITCompiler JIT{*TheModule};
+  auto *Fib = JIT.compile<Imm>(*F);
+  EXPECT_EQ(6765, Fib(20));
+  EXPECT_EQ(1, Fib(1));
+  EXPECT_EQ(Fib, JIT.compile<Imm>(*F));
+}
+
+TEST(JIT, Operations) {
+  if (!JITCompiler::IsSupported)
+    GTEST_SKIP();
+  auto [TheModule, Builder, F] = createFunctionContext("ops");
+  // Operands come from registers, constants and both.
+  std::vector<std::tuple<BinOpKind, Function *, Imm>> BinOps;
+  for (int I = 0; I <= static_cast<int>(BinOpKind::Geq); ++I)
+    for (Imm Constant : {0, 3, -1, 1000}) {
+      auto Kind = static_cast<BinOpKind>(I);
+      auto *Op = Builder->createFunction("binop" + std::to_string(I) + "_" +
+                                         std::to_string(Constant));
+      Builder->setBasicBlock(Builder->createBasicBlock(*Op));
+      auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+      auto &B = get<ReceiveInst>(Builder->createReceiveInst("b")).outRegister();
+      Value RHS = Constant ? Value{Constant} : Value{B};
+      Builder->createRetInst(
+          get<BinOpInst>(Builder->createBinOpInst(Kind, A, RHS)).outRegister());
+      BinOps.emplace_back(Kind, Op, Constant);
+    }
+  std::vector<std::pair<UnOpKind, Function *>> UnOps;
+  for (auto Kind : {UnOpKind::Assign, UnOpKind::Neg, UnOpKind::Not}) {
+    auto *Op =
+        Builder->createFunction("unop" + std::to_string(UnOps.size()));
+    Builder->setBasicBlock(Builder->createBasicBlock(*Op));
+    auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+    Builder->createRetInst(
+        get<UnOpInst>(Builder->createUnOpInst(Kind, A)).outRegister());
+    UnOps.emplace_back(Kind, Op);
+  }
+  const Imm Min = std::numeric_limits<Imm>::min();
+  const Imm Max = std::numeric_limits<Imm>::max();
+  JITCompiler JIT{*TheModule};
+  for (Imm A : {0, 1, -1, 7, -7, 33, Min, Max}) {
+    for (auto [Kind, Op] : UnOps)
+      EXPECT_EQ(evaluate(Kind, A), JIT.compile<Imm>(*Op)(A));
+    for (Imm B : {0, 1, -1, 3, -3, 31, 32, Min, Max})
+      for (auto [Kind, Op, Constant] : BinOps) {
+        auto Expected = evaluate(Kind, A, Constant ? Constant : B);
+        if (!Expected)
+          continue;
+        EXPECT_EQ(*Expected, (JIT.compile<Imm, Imm>(*Op)(A, B)))
+            << static_cast<int>(Kind) << " " << A << " " << B;
+      }
+  }
+}
+
+TEST(JIT, DivisionByConstants) {
+  if (!JITCompiler::IsSupported)
+    GTEST_SKIP();
+  auto [TheModule, Builder, F] = createFunctionContext("div");
+  const Imm Min = std::numeric_limits<Imm>::min();
+  const Imm Max = std::numeric_limits<Imm>::max();
+  std::vector<Imm> Divisors{Min, Max, -Max, 1 << 30, 641, -1000, 1 << 16};
+  for (Imm D = -40; D <= 40; ++D)
+    Divisors.push_back(D);
+  std::vector<std::tuple<BinOpKind, Function *, Imm>> Divisions;
+  for (auto Kind : {BinOpKind::Div, BinOpKind::Mod})
+    for (Imm D : Divisors) {
+      auto *Op = Builder->createFunction(
+          std::to_string(Divisions.size()) + "_" + std::to_string(D));
+      Builder->setBasicBlock(Builder->createBasicBlock(*Op));
+      auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+      Builder->createRetInst(
+          get<BinOpInst>(Builder->createBinOpInst(Kind, A, D)).outRegister());
+      Divisions.emplace_back(Kind, Op, D);
+    }
+  JITCompiler JIT{*TheModule};
+  std::mt19937 Gen{7};
+  std::vector<Imm> Dividends{0, 1, -1, 6, -6, 7, -7, Min, Min + 1, Max};
+  for (int I = 0; I < 50; ++I)
+    Dividends.push_back(static_cast<Imm>(Gen()));
+  for (auto [Kind, Op, D] : Divisions)
+    for (Imm A : Dividends)
+      if (auto Expected = evaluate(Kind, A, D)) {
+        EXPECT_EQ(*Expected, JIT.compile<Imm>(*Op)(A))
+            << static_cast<int>(Kind) << " " << A << " " << D;
+      }
+}
+
+TEST(JIT, DivisionByZeroTraps) {
+  if (!JITCompiler::IsSupported)
+    GTEST_SKIP();
+  auto [TheModule, Builder, F] = createFunctionContext("div");
+  Builder->setBasicBlock(Builder->createBasicBlock(*F));
+  auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+  auto &B = get<ReceiveInst>(Builder->createReceiveInst("b")).outRegister();
+  Builder->createRetInst(
+      get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Div, A, B))
+          .outRegister());
+  JITCompiler JIT{*TheModule};
+  auto *Div = JIT.compile<Imm, Imm>(*F);
+  EXPECT_EQ(-3, Div(7, -2));
+  EXPECT_EXIT(Div(1, 0), testing::KilledBySignal(SIGFPE), "");
+}
+
+TEST(JIT, GlobalsAndStackArguments) {
+  if (!JITCompiler::IsSupported)
+    GTEST_SKIP();
+  auto [TheModule, Builder, F] = createFunctionContext("caller");
+  auto &Counter = Builder->createGlobalVariable("counter");
+  // sum8(a0..a7) = a0 + 2 * a1 + ... + 8 * a7 and counts its calls.
+  auto *Sum = Builder->createFunction("sum8");
+  Builder->setBasicBlock(Builder->createBasicBlock(*Sum));
+  auto &Acc = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, 0, "acc"))
+                  .outRegister();
+  for (int K = 0; K < 8; ++K) {
+    auto &Arg = get<ReceiveInst>(Builder->createReceiveInst()).outRegister();
+    auto &Term = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Mul, Arg,
+                                                         K + 1))
+                     .outRegister();
+    Builder->createBinOpInst(BinOpKind::Add, Acc, Term, Acc);
+  }
+  Builder->createBinOpInst(BinOpKind::Add, Counter, 1, Counter);
+  Builder->createRetInst(Acc);
+  // caller(x) = sum8(x, .., x + 6) with the last argument missing, so 0.
+  auto &Entry = Builder->createBasicBlock(*F);
+  Builder->setBasicBlock(Entry);
+  auto &X = get<ReceiveInst>(Builder->createReceiveInst("x")).outRegister();
+  std::vector<Value> Args;
+  for (int K = 0; K < 7; ++K)
+    Args.push_back(
+        get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Add, X, K))
+            .outRegister());
+  auto &R = *get<CallInst>(
+                 Builder->createCallInst(true, *Sum, std::move(Args), "r"))
+                 .outRegister();
+  Builder->createRetInst(R);
+
+  JITCompiler JIT{*TheModule};
+  JIT.setGlobal(Counter, 40);
+  EXPECT_EQ(1 + 2 * 2 + 3 * 3 + 4 * 4 + 5 * 5 + 6 * 6 + 7 * 7,
+            JIT.compile<Imm>(*F)(1));
+  EXPECT_EQ(8 * 10, (JIT.compile<Imm, Imm, Imm, Imm, Imm, Imm, Imm, Imm>(
+                        *Sum)(0, 0, 0, 0, 0, 0, 0, 10)));
+  EXPECT_EQ(42, JIT.global(Counter));
+}
+
+TEST(JIT, MatchesInterpreter) {
+  if (!JITCompiler::IsSupported)
+    GTEST_SKIP();
+  std::mt19937 Gen{29};
+  std::size_t NumReturned{};
+  for (std::size_t Test = 0; Test < 200; ++Test) {
+    auto [TheModule, Builder, F] =
+        createFunctionContext("random" + std::to_string(Test));
+    buildRandomFunction(Gen, *Builder, *F, 2 + Test % 30);
+    const std::vector<Imm> Args{static_cast<Imm>(Test), 5};
+    Interpreter Engine{*TheModule};
+    Engine.setInstructionLimit(10000);
+    auto Expected = Engine.run(*F, Args);
+    // Native code can neither trap safely nor be stopped.
+    if (!Expected.returned())
+      continue;
+    ++NumReturned;
+    JITCompiler JIT{*TheModule};
+    EXPECT_EQ(Expected.ReturnValue,
+              (JIT.compile<Imm, Imm>(*F)(Args[0], Args[1])));
+    constructSSA(*Builder, *F);
+    propagateConstants(*Builder, *F);
+    eliminateRedundancies(*Builder, *F);
+    destructSSA(*Builder, *F);
+    JITCompiler Optimized{*TheModule};
+    EXPECT_EQ(Expected.ReturnValue,
+              (Optimized.compile<Imm, Imm>(*F)(Args[0], Args[1])));
+  }
+  EXPECT_LT(50u, NumReturned);
+}
+
+TEST(Batch, Operations) {
+  auto [TheModule, Builder, F] = createFunctionContext("ops");
+  const Imm Min = std::numeric_limits<Imm>::min();
+  const Imm Max = std::numeric_limits<Imm>::max();
+  // Every pair of the values is a lane.
+  const Imm Values[] = {0, 1, -1, 3, -3, 7, 31, 32, 33, Min, Max};
+  std::vector<std::vector<Imm>> Args(2);
+  for (Imm A : Values)
+    for (Imm B : Values) {
+      Args[0].push_back(A);
+      Args[1].push_back(B);
+    }
+  const std::size_t NumLanes = Args[0].size();
+  BatchEvaluator Evaluator{*TheModule};
+  for (int I = 0; I <= static_cast<int>(BinOpKind::Geq); ++I) {
+    auto Kind = static_cast<BinOpKind>(I);
+    auto *Op = Builder->createFunction("binop" + std::to_string(I));
+    Builder->setBasicBlock(Builder->createBasicBlock(*Op));
+    auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+    auto &B = get<ReceiveInst>(Builder->createReceiveInst("b")).outRegister();
+    Builder->createRetInst(
+        get<BinOpInst>(Builder->createBinOpInst(Kind, A, B)).outRegister());
+    auto Results = Evaluator.run(*Op, NumLanes, Args);
+    for (std::size_t Lane = 0; Lane < NumLanes; ++Lane) {
+      auto Expected = evaluate(Kind, Args[0][Lane], Args[1][Lane]);
+      if (!Expected) {
+        EXPECT_EQ(ExecutionResult::Trapped, Results[Lane].Status);
+        continue;
+      }
+      ASSERT_TRUE(Results[Lane].returned());
+      EXPECT_EQ(*Expected, Results[Lane].ReturnValue)
+          << I << " " << Args[0][Lane] << " " << Args[1][Lane];
+    }
+  }
+  for (auto Kind : {UnOpKind::Assign, UnOpKind::Neg, UnOpKind::Not}) {
+    auto *Op = Builder->createFunction("unop" +
+                                       std::to_string(static_cast<int>(Kind)));
+    Builder->setBasicBlock(Builder->createBasicBlock(*Op));
+    auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+    Builder->createRetInst(
+        get<UnOpInst>(Builder->createUnOpInst(Kind, A)).outRegister());
+    auto Results = Evaluator.run(*Op, NumLanes, Args);
+    for (std::size_t Lane = 0; Lane < NumLanes; ++Lane)
+      EXPECT_EQ(evaluate(Kind, Args[0][Lane]), Results[Lane].ReturnValue);
+  }
+}
+
+TEST(Batch, DivergentLoops) {
+  auto [TheModule, Builder, F] = createFunctionContext("sum");
+  buildSumLoop(*Builder, *F);
+  // Lanes run different numbers of iterations and the last group is partial.
+  std::vector<std::vector<Imm>> Args(1);
+  for (Imm N = 0; N < 150; ++N)
+    Args[0].push_back(N % 37);
+  BatchEvaluator Evaluator{*TheModule};
+  auto Results = Evaluator.run(*F, Args[0].size(), Args);
+  ASSERT_EQ(Args[0].size(), Results.size());
+  std::uint64_t Expected{};
+  for (std::size_t Lane = 0; Lane < Results.size(); ++Lane) {
+    Imm N = Args[0][Lane];
+    ASSERT_TRUE(Results[Lane].returned());
+    EXPECT_EQ(N * (N - 1) / 2, Results[Lane].ReturnValue);
+    Expected += 4 + 5 * N + 3;
+  }
+  EXPECT_EQ(Expected, Evaluator.executedInstructions());
+  EXPECT_TRUE(Evaluator.run(*F, 0, Args).empty());
+}
+
+TEST(Batch, RecursionAndLimits) {
+  auto [TheModule, Builder, F] = createFunctionContext("fib");
+  buildFib(*Builder, *F);
+  auto *Forever = Builder->createFunction("forever");
+  auto &Entry = Builder->createBasicBlock(*Forever);
+  auto &Loop = Builder->createBasicBlock(*Forever);
+  auto &Exit = Builder->createBasicBlock(*Forever);
+  Builder->setBasicBlock(Entry);
+  auto &N = get<ReceiveInst>(Builder->createReceiveInst("n")).outRegister();
+  Builder->createBrInst(N, Loop, Exit);
+  Builder->setBasicBlock(Loop);
+  Builder->createGoToInst(Loop);
+  Builder->setBasicBlock(Exit);
+  Builder->createRetInst(7);
+
+  std::vector<std::vector<Imm>> Args{{0, 1, 2, 10, 20, 15}};
+  BatchEvaluator Evaluator{*TheModule};
+  auto Results = Evaluator.run(*F, 6, Args);
+  for (std::size_t Lane = 0; Lane < 6; ++Lane) {
+    Interpreter Engine{*TheModule};
+    EXPECT_EQ(Engine.run(*F, {Args[0][Lane]}).ReturnValue,
+              Results[Lane].ReturnValue);
+  }
+  Evaluator.setCallDepthLimit(12);
+  Results = Evaluator.run(*F, 6, Args);
+  EXPECT_EQ(55, Results[3].ReturnValue);
+  EXPECT_EQ(ExecutionResult::StackOverflow, Results[4].Status);
+  EXPECT_EQ(ExecutionResult::StackOverflow, Results[5].Status);
+
+  Evaluator.setInstructionLimit(1000);
+  Results = Evaluator.run(*Forever, 6, Args);
+  EXPECT_EQ(7, Results[0].ReturnValue);
+  for (std::size_t Lane = 1; Lane < 6; ++Lane)
+    EXPECT_EQ(ExecutionResult::LimitExceeded, Results[Lane].Status);
+}
+
+TEST(Batch, UnboundedRecursion) {
+  auto [TheModule, Builder, F] = createFunctionContext("down");
+  Builder->setBasicBlock(Builder->createBasicBlock(*F));
+  auto &N = get<ReceiveInst>(Builder->createReceiveInst("n")).outRegister();
+  auto &Next =
+      get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Add, N, 1, "next"))
+          .outRegister();
+  auto &R = *get<CallInst>(Builder->createCallInst(true, *F, {Next}, "r"))
+                 .outRegister();
+  Builder->createRetInst(R);
+
+  // The default depth limit is reached before the native stack overflows.
+  BatchEvaluator Evaluator{*TheModule};
+  for (std::size_t NumLanes : {1u, 64u}) {
+    auto Results = Evaluator.run(*F, NumLanes);
+    for (const auto &Lane : Results)
+      EXPECT_EQ(ExecutionResult::StackOverflow, Lane.Status);
+  }
+}
+
+TEST(Batch, MatchesInterpreter) {
+  std::mt19937 Gen{31};
+  std::uniform_int_distribution<Imm> Argument(-20, 20);
+  for (std::size_t Test = 0; Test < 100; ++Test) {
+    auto [TheModule, Builder, F] =
+        createFunctionContext("random" + std::to_string(Test));
+    buildRandomFunction(Gen, *Builder, *F, 2 + Test % 30);
+    const std::size_t NumLanes = 100;
+    std::vector<std::vector<Imm>> Args(2);
+    for (auto &Column : Args)
+      for (std::size_t Lane = 0; Lane < NumLanes; ++Lane)
+        Column.push_back(Argument(Gen));
+    auto Check = [&, F = F](const char *Stage) {
+      BatchEvaluator Evaluator{*TheModule};
+      Evaluator.setInstructionLimit(3000);
+      auto Results = Evaluator.run(*F, NumLanes, Args);
+      Interpreter Engine{*TheModule};
+      Engine.setInstructionLimit(2000);
+      for (std::size_t Lane = 0; Lane < NumLanes; ++Lane) {
+        auto Expected = Engine.run(*F, {Args[0][Lane], Args[1][Lane]});
+        // Limits count instructions differently.
+        if (Expected.Status == ExecutionResult::LimitExceeded)
+          continue;
+        ASSERT_EQ(Expected.Status, Results[Lane].Status) << Stage;
+        if (Expected.returned()) {
+          EXPECT_EQ(Expected.ReturnValue, Results[Lane].ReturnValue) << Stage;
+        }
+      }
+    };
+    Check("Original");
+    constructSSA(*Builder, *F);
+    Check("SSA");
+  }
+}
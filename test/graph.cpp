@@ -1,7 +1,16 @@
 #include "graph.h"
+#include "Analysis/control_dependence.h"
 #include "Analysis/dominance.h"
+#include "Analysis/dominance_frontier.h"
+#include "Analysis/dominator_tree.h"
+#include "Analysis/dynamic_dominance.h"
+#include "Analysis/loop_info.h"
+#include "Analysis/post_dominator_tree.h"
+#include "csr_graph.h"
 #include "gtest/gtest.h"
 #include <algorithm>
+#include <random>
+#include <set>
 
 std::vector<Graph> Graphs{
     {{0, 1}, {0, 2}, {1, 2}},
@@ -17,6 +26,28 @@ TEST(Graph, DFSOrder) {
   EXPECT_TRUE(areEqual(IfG.DFSOrder(), {0, 1, 2}));
 }
 
+TEST(CSRGraph, SuccessorsAndPredecessors) {
+  CSRGraph G{Graphs[1]};
+  ASSERT_EQ(G.size(), Graphs[1].size());
+  EXPECT_EQ(G.arcs(), 9u);
+  auto Succs = G.successors(4);
+  EXPECT_EQ(std::vector<CSRGraph::NodeId>(Succs.begin(), Succs.end()),
+            (std::vector<CSRGraph::NodeId>{5, 6}));
+  auto Preds = G.predecessors(7);
+  EXPECT_EQ(std::vector<CSRGraph::NodeId>(Preds.begin(), Preds.end()),
+            (std::vector<CSRGraph::NodeId>{2, 5}));
+  EXPECT_TRUE(G.predecessors(0).empty());
+  EXPECT_TRUE(G.hasArc({6, 4}));
+  EXPECT_FALSE(G.hasArc({4, 3}));
+}
+
+TEST(CSRGraph, DFSOrder) {
+  for (const auto &G : Graphs) {
+    auto Order = CSRGraph{G}.DFSOrder();
+    EXPECT_TRUE(areEqual({std::begin(Order), std::end(Order)}, G.DFSOrder()));
+  }
+}
+
 TEST(Dominance, DominatorsAreCalculatedForAllNodes) {
   for (const auto &Graph : Graphs) {
     auto DomMap = wyrm::dominators_slow(Graph);
@@ -79,3 +110,472 @@ TEST(Dominance, ImmediateDominators) {
   EXPECT_TRUE(DomTree.hasArc({4, 6}));
   EXPECT_TRUE(DomTree.hasArc({1, 7}));
 }
+
+/// \brief Build a dominator tree from dominators_slow output.
+/// Immediate dominator of a node is its only dominator which has one
+/// dominator less than the node itself.
+static Graph slowDominatorTree(const Graph &CFG) {
+  auto DomMap = wyrm::dominators_slow(CFG);
+  Graph Result{};
+  for (auto &[Node, Dominators] : DomMap)
+    for (auto DomNode : Dominators)
+      if (DomMap[DomNode].size() + 1 == Dominators.size()) {
+        Result.addArc({DomNode, Node});
+        break;
+      }
+  return Result;
+}
+
+/// \brief Generate random graph with all nodes reachable from the root.
+static Graph randomGraph(std::mt19937 &Gen, size_t Size, size_t ExtraArcs) {
+  Graph Result{};
+  for (size_t Node = 1; Node < Size; ++Node)
+    Result.addArc(
+        {std::uniform_int_distribution<size_t>{0, Node - 1}(Gen), Node});
+  std::uniform_int_distribution<size_t> From{0, Size - 1}, To{1, Size - 1};
+  for (size_t I = 0; I < ExtraArcs; ++I)
+    Result.addArc({From(Gen), To(Gen)});
+  return Result;
+}
+
+static bool haveSameArcs(const Graph &G1, const Graph &G2) {
+  if (G1.size() != G2.size())
+    return false;
+  for (size_t Node = 0, E = G1.size(); Node < E; ++Node)
+    if (G1.successors(Node) != G2.successors(Node))
+      return false;
+  return true;
+}
+
+TEST(Dominance, ImmediateDominatorsOfRootAndUnreachable) {
+  Graph G{{0, 1}, {1, 2}, {3, 2}};
+  auto IDoms = wyrm::immediateDominators(G);
+  ASSERT_EQ(IDoms.size(), 4u);
+  EXPECT_EQ(IDoms[0], Graph::Root);
+  EXPECT_EQ(IDoms[1], 0u);
+  EXPECT_EQ(IDoms[2], 1u);
+  EXPECT_EQ(IDoms[3], wyrm::NoNode);
+}
+
+TEST(Dominance, SemiNCAMatchesSlowAlgorithm) {
+  std::mt19937 Gen{42};
+  for (size_t Size : {2, 5, 17, 64, 200})
+    for (size_t Density : {0, 1, 3})
+      for (int Iteration = 0; Iteration < 10; ++Iteration) {
+        Graph CFG = randomGraph(Gen, Size, Size * Density);
+        EXPECT_TRUE(haveSameArcs(wyrm::buildDominatorTree(CFG),
+                                 slowDominatorTree(CFG)));
+      }
+}
+
+TEST(Dominance, FrozenGraphDominators) {
+  std::mt19937 Gen{7};
+  for (int Iteration = 0; Iteration < 20; ++Iteration) {
+    Graph CFG = randomGraph(Gen, 100, 150);
+    CSRGraph Frozen{CFG};
+    EXPECT_EQ(wyrm::dominators_slow(Frozen), wyrm::dominators_slow(CFG));
+    EXPECT_TRUE(haveSameArcs(wyrm::buildDominatorTree(Frozen),
+                             wyrm::buildDominatorTree(CFG)));
+  }
+}
+
+TEST(Dominance, DenseDominatorsMatchSlowAlgorithm) {
+  for (const auto &G : Graphs)
+    EXPECT_EQ(wyrm::dominators_dense(G).toDominatorMap(),
+              wyrm::dominators_slow(G));
+  std::mt19937 Gen{13};
+  for (size_t Size : {3, 64, 65, 300})
+    for (int Iteration = 0; Iteration < 10; ++Iteration) {
+      Graph CFG = randomGraph(Gen, Size, Size);
+      EXPECT_EQ(wyrm::dominators_dense(CFG).toDominatorMap(),
+                wyrm::dominators_slow(CFG));
+    }
+}
+
+TEST(Dominance, DenseDominatesQuery) {
+  auto Dominators = wyrm::dominators_dense(Graph{{0, 1}, {1, 2}, {3, 2}});
+  EXPECT_TRUE(Dominators.dominates(0, 2));
+  EXPECT_TRUE(Dominators.dominates(1, 2));
+  EXPECT_TRUE(Dominators.dominates(2, 2));
+  EXPECT_FALSE(Dominators.dominates(2, 1));
+  // Unreachable nodes are dominated by nothing and dominate nothing.
+  EXPECT_FALSE(Dominators.dominates(3, 2));
+  EXPECT_FALSE(Dominators.dominates(3, 3));
+}
+
+TEST(Graph, RemoveArc) {
+  Graph G{{0, 1}, {1, 2}};
+  G.removeArc({1, 2});
+  G.removeArc({2, 1});
+  G.removeArc({5, 1});
+  EXPECT_FALSE(G.hasArc({1, 2}));
+  EXPECT_TRUE(G.hasArc({0, 1}));
+  EXPECT_EQ(G.size(), 3u);
+}
+
+TEST(DynamicDominance, InsertAndDelete) {
+  Graph CFG{Graphs[1]};
+  wyrm::DynamicDominatorTree DT{CFG};
+  DT.setVerification(true);
+  EXPECT_EQ(DT.idom(7), 1u);
+  // 5 -> 7 is not the only way to 7, so it's still dominated by 1.
+  DT.insertArc({6, 7});
+  EXPECT_EQ(DT.idom(7), 1u);
+  // Bypass 3: 4 is now dominated by 1 only.
+  DT.insertArc({2, 4});
+  EXPECT_EQ(DT.idom(4), 1u);
+  EXPECT_FALSE(DT.dominates(3, 5));
+  DT.deleteArc({2, 4});
+  EXPECT_EQ(DT.idom(4), 3u);
+  EXPECT_TRUE(DT.dominates(3, 5));
+  // Cut 3 off, its subtree becomes unreachable.
+  DT.deleteArc({1, 3});
+  EXPECT_FALSE(DT.isReachable(3));
+  EXPECT_FALSE(DT.isReachable(6));
+  EXPECT_EQ(DT.idom(7), 2u);
+  // New node attaches an unreachable region back.
+  DT.insertArc({7, 8});
+  DT.insertArc({8, 3});
+  EXPECT_EQ(DT.idom(3), 8u);
+  EXPECT_EQ(DT.idom(4), 3u);
+  EXPECT_EQ(DT.depth(4), 6u);
+  EXPECT_TRUE(DT.verify());
+}
+
+TEST(DynamicDominance, RandomUpdatesMatchRecalculation) {
+  std::mt19937 Gen{3};
+  for (size_t Size : {4, 10, 50}) {
+    Graph CFG = randomGraph(Gen, Size, Size / 2);
+    wyrm::DynamicDominatorTree DT{CFG};
+    std::uniform_int_distribution<size_t> From{0, Size - 1}, To{1, Size - 1};
+    for (int Iteration = 0; Iteration < 300; ++Iteration) {
+      Arc A{From(Gen), To(Gen)};
+      if (Gen() % 2)
+        DT.insertArc(A);
+      else
+        DT.deleteArc(A);
+      ASSERT_TRUE(DT.verify());
+    }
+  }
+}
+
+TEST(DynamicDominance, BatchUpdates) {
+  std::mt19937 Gen{5};
+  Graph CFG = randomGraph(Gen, 400, 200);
+  wyrm::DynamicDominatorTree DT{CFG};
+  std::uniform_int_distribution<size_t> From{0, 399}, To{1, 399};
+  for (size_t BatchSize : {3, 50}) {
+    std::vector<wyrm::CFGUpdate> Updates;
+    for (size_t I = 0; I < BatchSize; ++I)
+      Updates.push_back({I % 2 ? wyrm::CFGUpdate::Insert
+                               : wyrm::CFGUpdate::Delete,
+                         {From(Gen), To(Gen)}});
+    DT.applyUpdates(Updates);
+    EXPECT_TRUE(DT.verify());
+  }
+}
+
+TEST(DominatorTree, Queries) {
+  wyrm::DominatorTree DT{wyrm::buildDominatorTree(Graphs[1])};
+  auto Children = DT.children(1);
+  EXPECT_EQ(std::vector<size_t>(Children.begin(), Children.end()),
+            (std::vector<size_t>{2, 3, 7}));
+  EXPECT_TRUE(DT.children(5).empty());
+  EXPECT_EQ(DT.idom(4), 3u);
+  EXPECT_EQ(DT.depth(6), 4u);
+  EXPECT_TRUE(DT.dominates(3, 6));
+  EXPECT_TRUE(DT.dominates(6, 6));
+  EXPECT_FALSE(DT.properlyDominates(6, 6));
+  EXPECT_FALSE(DT.dominates(2, 7));
+  EXPECT_EQ(DT.nearestCommonDominator(5, 6), 4u);
+  EXPECT_EQ(DT.nearestCommonDominator(2, 6), 1u);
+  EXPECT_EQ(DT.nearestCommonDominator(4, 5), 4u);
+  EXPECT_EQ(DT.nearestCommonDominator(0, 0), 0u);
+  EXPECT_EQ(DT.preorder().size(), 8u);
+}
+
+TEST(DominatorTree, MatchesDenseDominators) {
+  std::mt19937 Gen{11};
+  for (size_t Size : {2, 30, 150}) {
+    Graph CFG = randomGraph(Gen, Size, Size);
+    // Unreachable node.
+    CFG.addArc({Size, 1});
+    CSRGraph Frozen{CFG};
+    wyrm::DominatorTree DT{wyrm::immediateDominators(Frozen)};
+    auto Dominators = wyrm::dominators_dense(Frozen);
+    EXPECT_FALSE(DT.contains(Size));
+    for (size_t A = 0; A <= Size; ++A)
+      for (size_t B = 0; B <= Size; ++B) {
+        ASSERT_EQ(DT.dominates(A, B), Dominators.dominates(A, B));
+        if (!DT.contains(A) || !DT.contains(B))
+          continue;
+        // The nearest common dominator dominates both nodes and none of its
+        // children does.
+        auto NCD = DT.nearestCommonDominator(A, B);
+        ASSERT_TRUE(Dominators.dominates(NCD, A));
+        ASSERT_TRUE(Dominators.dominates(NCD, B));
+        for (auto Child : DT.children(NCD))
+          ASSERT_FALSE(DT.dominates(Child, A) && DT.dominates(Child, B));
+      }
+  }
+}
+
+static std::vector<size_t> toVector(CSRGraph::NodeRange Range) {
+  return {Range.begin(), Range.end()};
+}
+
+TEST(DominanceFrontier, Frontiers) {
+  CSRGraph CFG{Graphs[1]};
+  wyrm::DominatorTree DT{wyrm::immediateDominators(CFG)};
+  wyrm::DominanceFrontier DF{CFG, DT};
+  EXPECT_TRUE(DF.frontier(0).empty());
+  EXPECT_TRUE(DF.frontier(1).empty());
+  EXPECT_EQ(toVector(DF.frontier(2)), (std::vector<size_t>{7}));
+  EXPECT_EQ(toVector(DF.frontier(3)), (std::vector<size_t>{7}));
+  EXPECT_EQ(toVector(DF.frontier(4)), (std::vector<size_t>{4, 7}));
+  EXPECT_EQ(toVector(DF.frontier(5)), (std::vector<size_t>{7}));
+  EXPECT_EQ(toVector(DF.frontier(6)), (std::vector<size_t>{4}));
+  EXPECT_TRUE(DF.frontier(7).empty());
+}
+
+TEST(DominanceFrontier, IteratedFrontierMatchesFixedPoint) {
+  std::mt19937 Gen{17};
+  for (size_t Size : {5, 40, 120}) {
+    CSRGraph CFG{randomGraph(Gen, Size, Size)};
+    wyrm::DominatorTree DT{wyrm::immediateDominators(CFG)};
+    wyrm::DominanceFrontier DF{CFG, DT};
+    wyrm::IDFCalculator IDF{CFG, DT};
+    for (int Iteration = 0; Iteration < 20; ++Iteration) {
+      std::vector<CSRGraph::NodeId> Defs;
+      for (size_t I = 0, E = Gen() % 4 + 1; I < E; ++I)
+        Defs.push_back(Gen() % Size);
+      // IDF is the limit of DF(Defs), DF(Defs + DF(Defs)), ...
+      std::set<size_t> Expected, Work{std::begin(Defs), std::end(Defs)};
+      bool IsChanged{true};
+      while (IsChanged) {
+        IsChanged = false;
+        for (auto Node : std::set<size_t>{Work})
+          for (auto Frontier : DF.frontier(Node)) {
+            IsChanged |= Expected.insert(Frontier).second;
+            Work.insert(Frontier);
+          }
+      }
+      auto Actual = IDF.calculate(Defs);
+      EXPECT_EQ(std::vector<size_t>(std::begin(Actual), std::end(Actual)),
+                std::vector<size_t>(std::begin(Expected), std::end(Expected)));
+    }
+  }
+}
+
+TEST(LoopInfo, NestedLoops) {
+  // 0 -> 1 -> 2 -> 3 -> 2, 3 -> 4 -> 1, 4 -> 5, 1 -> 6 -> 6
+  CSRGraph CFG{7,
+               {{0, 1}, {1, 2}, {2, 3}, {3, 2}, {3, 4}, {4, 1}, {4, 5},
+                {1, 6}, {6, 6}}};
+  wyrm::DominatorTree DT{wyrm::immediateDominators(CFG)};
+  wyrm::LoopInfo Loops{CFG, DT};
+  ASSERT_EQ(3u, Loops.size());
+  EXPECT_EQ(toVector(Loops.topLevelLoops()), (std::vector<size_t>{0, 2}));
+  EXPECT_EQ(1u, Loops.header(0));
+  EXPECT_EQ(2u, Loops.header(1));
+  EXPECT_EQ(6u, Loops.header(2));
+  EXPECT_EQ(toVector(Loops.subloops(0)), (std::vector<size_t>{1}));
+  EXPECT_EQ(0u, Loops.parent(1));
+  EXPECT_EQ(wyrm::LoopInfo::NoLoop, Loops.parent(2));
+  EXPECT_TRUE(Loops.encloses(0, 1));
+  EXPECT_FALSE(Loops.encloses(1, 0));
+  EXPECT_EQ(toVector(Loops.blocks(0)), (std::vector<size_t>{1, 4, 2, 3}));
+  EXPECT_EQ(toVector(Loops.latches(0)), (std::vector<size_t>{4}));
+  EXPECT_EQ(toVector(Loops.latches(1)), (std::vector<size_t>{3}));
+  EXPECT_EQ(toVector(Loops.exitBlocks(0)), (std::vector<size_t>{5, 6}));
+  EXPECT_EQ(toVector(Loops.exitBlocks(1)), (std::vector<size_t>{4}));
+  EXPECT_TRUE(Loops.exitBlocks(2).empty());
+  for (auto [Node, Depth] : {std::pair<unsigned, unsigned>{0, 0},
+                             {1, 1}, {2, 2}, {3, 2}, {4, 1}, {5, 0}, {6, 1}})
+    EXPECT_EQ(Depth, Loops.depth(Node));
+  EXPECT_TRUE(Loops.contains(0, 3));
+  EXPECT_FALSE(Loops.contains(1, 4));
+  EXPECT_TRUE(Loops.isHeader(2));
+  EXPECT_FALSE(Loops.isHeader(3));
+  EXPECT_FALSE(Loops.hasIrreducibleRegions());
+}
+
+TEST(LoopInfo, IrreducibleRegions) {
+  // The cycle 2 <-> 3 is entered from 1 and from 0, the loop at 4 is fine.
+  CSRGraph CFG{6, {{0, 1}, {0, 2}, {1, 3}, {2, 3}, {3, 2}, {3, 4}, {4, 4},
+                   {4, 5}}};
+  wyrm::DominatorTree DT{wyrm::immediateDominators(CFG)};
+  wyrm::LoopInfo Loops{CFG, DT, true};
+  ASSERT_EQ(1u, Loops.size());
+  EXPECT_EQ(4u, Loops.header(0));
+  EXPECT_TRUE(Loops.hasIrreducibleRegions());
+  for (auto [Node, IsIrreducible] :
+       {std::pair<unsigned, bool>{0, false}, {1, false}, {2, true},
+        {3, true}, {4, false}, {5, false}})
+    EXPECT_EQ(IsIrreducible, Loops.isIrreducible(Node));
+  EXPECT_FALSE(wyrm::LoopInfo(CFG, DT).isIrreducible(2));
+}
+
+TEST(LoopInfo, RandomGraphsMatchDefinition) {
+  std::mt19937 Gen{23};
+  for (size_t Size : {3, 20, 90})
+    for (int Iteration = 0; Iteration < 20; ++Iteration) {
+      CSRGraph CFG{randomGraph(Gen, Size, Size / 2)};
+      wyrm::DominatorTree DT{wyrm::immediateDominators(CFG)};
+      wyrm::LoopInfo Loops{CFG, DT, true};
+      // Natural loop of every header by its definition.
+      std::vector<std::vector<bool>> Bodies;
+      std::vector<size_t> Depth(Size);
+      for (CSRGraph::NodeId Header = 0; Header < Size; ++Header) {
+        std::vector<bool> Body(Size);
+        std::vector<CSRGraph::NodeId> Work;
+        for (auto Pred : CFG.predecessors(Header))
+          if (DT.dominates(Header, Pred))
+            Work.push_back(Pred);
+        if (Work.empty())
+          continue;
+        Body[Header] = true;
+        while (!Work.empty()) {
+          auto Node = Work.back();
+          Work.pop_back();
+          if (Body[Node])
+            continue;
+          Body[Node] = true;
+          for (auto Pred : CFG.predecessors(Node))
+            Work.push_back(Pred);
+        }
+        ASSERT_TRUE(Loops.isHeader(Header));
+        auto Loop = Loops.loopFor(Header);
+        for (CSRGraph::NodeId Node = 0; Node < Size; ++Node) {
+          EXPECT_EQ(Body[Node], Loops.contains(Loop, Node));
+          Depth[Node] += Body[Node];
+        }
+        EXPECT_EQ(std::count(std::begin(Body), std::end(Body), true),
+                  static_cast<long>(Loops.blocks(Loop).size()));
+        Bodies.push_back(std::move(Body));
+      }
+      EXPECT_EQ(Bodies.size(), Loops.size());
+      for (CSRGraph::NodeId Node = 0; Node < Size; ++Node)
+        EXPECT_EQ(Depth[Node], Loops.depth(Node));
+      // The graph is reducible iff it's acyclic without the back edges.
+      std::vector<size_t> InDegree(Size);
+      for (CSRGraph::NodeId Node = 0; Node < Size; ++Node)
+        for (auto Succ : CFG.successors(Node))
+          InDegree[Succ] += !DT.dominates(Succ, Node);
+      std::vector<CSRGraph::NodeId> Ready{CSRGraph::Root};
+      size_t NumSorted = 0;
+      while (!Ready.empty()) {
+        auto Node = Ready.back();
+        Ready.pop_back();
+        ++NumSorted;
+        for (auto Succ : CFG.successors(Node))
+          if (!DT.dominates(Succ, Node) && --InDegree[Succ] == 0)
+            Ready.push_back(Succ);
+      }
+      EXPECT_EQ(NumSorted != Size, Loops.hasIrreducibleRegions());
+      for (wyrm::LoopInfo::LoopId Loop = 0; Loop < Loops.size(); ++Loop) {
+        auto Parent = Loops.parent(Loop);
+        EXPECT_TRUE(Parent == wyrm::LoopInfo::NoLoop ||
+                    (Parent < Loop && Loops.encloses(Parent, Loop) &&
+                     Loops.loopDepth(Loop) == Loops.loopDepth(Parent) + 1));
+        for (auto Exit : Loops.exitBlocks(Loop)) {
+          EXPECT_FALSE(Loops.contains(Loop, Exit));
+          auto Preds = CFG.predecessors(Exit);
+          EXPECT_TRUE(std::any_of(std::begin(Preds), std::end(Preds),
+                                  [&](CSRGraph::NodeId Pred) {
+                                    return Loops.contains(Loop, Pred);
+                                  }));
+        }
+      }
+    }
+}
+
+TEST(PostDominatorTree, InfiniteLoop) {
+  // 0 -> 1 -> 3 -> 4, 0 -> 2 -> 3, 2 -> 5 -> 6 -> 5
+  CSRGraph CFG{7, {{0, 1}, {0, 2}, {1, 3}, {2, 3}, {3, 4}, {2, 5}, {5, 6},
+                   {6, 5}}};
+  wyrm::PostDominatorTree PDT{CFG};
+  ASSERT_EQ(7u, PDT.size());
+  // The infinite loop is left through its node finished first by the DFS,
+  // which decides whether the loop runs again.
+  EXPECT_EQ(toVector(PDT.exits()), (std::vector<size_t>{4, 6}));
+  constexpr auto Exit = CSRGraph::NoNode;
+  for (auto [Node, IPDom] : {std::pair<unsigned, unsigned>{0, Exit},
+                             {1, 3}, {2, Exit}, {3, 4}, {4, Exit}, {5, 6},
+                             {6, Exit}})
+    EXPECT_EQ(IPDom, PDT.ipdom(Node));
+  EXPECT_TRUE(PDT.postDominates(3, 1));
+  EXPECT_TRUE(PDT.postDominates(3, 3));
+  EXPECT_FALSE(PDT.strictlyPostDominates(3, 3));
+  EXPECT_FALSE(PDT.postDominates(3, 0));
+  EXPECT_FALSE(PDT.postDominates(5, 6));
+
+  wyrm::ControlDependenceGraph CDG{CFG, PDT};
+  ASSERT_EQ(7u, CDG.size());
+  const std::vector<std::vector<size_t>> Controllers{
+      {}, {0}, {0}, {0, 2}, {0, 2}, {2, 6}, {2, 6}};
+  for (CSRGraph::NodeId Node = 0; Node < 7; ++Node)
+    EXPECT_EQ(Controllers[Node], toVector(CDG.controllers(Node)));
+}
+
+TEST(PostDominatorTree, RandomGraphsMatchDefinition) {
+  std::mt19937 Gen{29};
+  for (size_t Size : {3, 20, 90})
+    for (int Iteration = 0; Iteration < 20; ++Iteration) {
+      CSRGraph CFG{randomGraph(Gen, Size, Size / 2)};
+      wyrm::PostDominatorTree PDT{CFG};
+      std::vector<bool> IsExit(Size);
+      for (auto Exit : PDT.exits())
+        IsExit[Exit] = true;
+      for (CSRGraph::NodeId Node = 0; Node < Size; ++Node)
+        if (CFG.successors(Node).empty()) {
+          EXPECT_TRUE(IsExit[Node]);
+        }
+      // A post-dominates B iff B can't reach the virtual exit without A.
+      std::vector<std::vector<bool>> PostDominates(Size);
+      for (CSRGraph::NodeId A = 0; A < Size; ++A) {
+        std::vector<bool> Reaches(Size);
+        std::vector<CSRGraph::NodeId> Work;
+        for (auto Exit : PDT.exits())
+          if (Exit != A)
+            Work.push_back(Exit);
+        while (!Work.empty()) {
+          auto Node = Work.back();
+          Work.pop_back();
+          if (Reaches[Node])
+            continue;
+          Reaches[Node] = true;
+          for (auto Pred : CFG.predecessors(Node))
+            if (Pred != A)
+              Work.push_back(Pred);
+        }
+        PostDominates[A].resize(Size);
+        for (CSRGraph::NodeId B = 0; B < Size; ++B) {
+          PostDominates[A][B] = A == B || !Reaches[B];
+          EXPECT_EQ(PostDominates[A][B], PDT.postDominates(A, B));
+        }
+      }
+      for (CSRGraph::NodeId B = 0; B < Size; ++B) {
+        auto IPDom = PDT.ipdom(B);
+        for (CSRGraph::NodeId A = 0; A < Size; ++A)
+          if (A != B && PostDominates[A][B]) {
+            ASSERT_NE(CSRGraph::NoNode, IPDom);
+            EXPECT_TRUE(PostDominates[A][IPDom]);
+          }
+      }
+      // Y is control dependent on X iff a successor of X is post-dominated
+      // by Y and X isn't strictly post-dominated by Y.
+      wyrm::ControlDependenceGraph CDG{CFG, PDT};
+      for (CSRGraph::NodeId Y = 0; Y < Size; ++Y) {
+        std::vector<size_t> Expected;
+        for (CSRGraph::NodeId X = 0; X < Size; ++X) {
+          bool IsDependent = false;
+          for (auto Succ : CFG.successors(X))
+            IsDependent |= PostDominates[Y][Succ];
+          if (IsDependent && (X == Y || !PostDominates[Y][X]))
+            Expected.push_back(X);
+        }
+        EXPECT_EQ(Expected, toVector(CDG.controllers(Y)));
+      }
+    }
+}
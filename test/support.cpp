@@ -0,0 +1,117 @@
+#include "arena.h"
+#include "bitvector.h"
+#include "interner.h"
+#include "gtest/gtest.h"
+#include <string>
+#include <thread>
+
+using namespace wyrm;
+
+TEST(BitVector, SetTestCount) {
+  BitVector BV(130);
+  EXPECT_FALSE(BV.any());
+  BV.set(0);
+  BV.set(64);
+  BV.set(129);
+  EXPECT_TRUE(BV.test(64));
+  EXPECT_FALSE(BV.test(65));
+  EXPECT_EQ(BV.count(), 3u);
+  BV.reset(64);
+  std::vector<size_t> Bits;
+  BV.forEachSetBit([&Bits](size_t Bit) { Bits.push_back(Bit); });
+  EXPECT_EQ(Bits, (std::vector<size_t>{0, 129}));
+  BV.setAll();
+  EXPECT_EQ(BV.count(), 130u);
+}
+
+TEST(BitVector, IntersectAndUniteReportChanges) {
+  // Large enough to exercise both the 256-bit and the scalar tail paths.
+  BitVector LHS(1000, true), RHS(1000, true);
+  EXPECT_FALSE(LHS.intersectWith(RHS));
+  RHS.reset(999);
+  RHS.reset(3);
+  EXPECT_TRUE(LHS.intersectWith(RHS));
+  EXPECT_FALSE(LHS.test(999));
+  EXPECT_FALSE(LHS.test(3));
+  EXPECT_EQ(LHS.count(), 998u);
+  EXPECT_FALSE(LHS.intersectWith(RHS));
+  BitVector Bit(1000);
+  Bit.set(999);
+  EXPECT_TRUE(LHS.uniteWith(Bit));
+  EXPECT_FALSE(LHS.uniteWith(Bit));
+  EXPECT_EQ(LHS.count(), 999u);
+}
+
+TEST(Arena, AlignsAndGrowsChunks) {
+  Arena A;
+  EXPECT_EQ(A.numChunks(), 0u);
+  auto *C = static_cast<char *>(A.allocate(1, 1));
+  auto *D = A.create<double>(1.5);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(D) % alignof(double), 0u);
+  EXPECT_EQ(*D, 1.5);
+  EXPECT_EQ(A.numChunks(), 1u);
+  // Small allocations fill the chunk before a new one is requested.
+  std::size_t Objects = Arena::MinChunkSize / sizeof(double);
+  for (std::size_t I = 0; I < Objects; ++I)
+    A.create<double>(0.0);
+  EXPECT_EQ(A.numChunks(), 2u);
+  EXPECT_EQ(A.reservedBytes(), 3 * Arena::MinChunkSize);
+  // A big object gets its own chunk and the current one is kept.
+  auto *Big = A.allocate(Arena::MaxChunkSize, 16);
+  EXPECT_EQ(A.numChunks(), 3u);
+  auto *Next = A.create<double>(2.5);
+  EXPECT_EQ(A.numChunks(), 3u);
+  EXPECT_NE(Big, static_cast<void *>(Next));
+  EXPECT_EQ(A.allocatedBytes(),
+            1 + (Objects + 2) * sizeof(double) + Arena::MaxChunkSize);
+  *C = 'c';
+  EXPECT_EQ(*C, 'c');
+}
+
+TEST(StringInterner, InternsOnce) {
+  StringInterner Strings;
+  EXPECT_EQ(StringInterner::EmptyId, Strings.intern(""));
+  EXPECT_EQ("", Strings.get(StringInterner::EmptyId));
+  auto Wyrm = Strings.intern("wyrm");
+  auto Drake = Strings.intern(std::string{"drake"});
+  EXPECT_NE(Wyrm, Drake);
+  EXPECT_EQ(Wyrm, Strings.intern("wyrm"));
+  EXPECT_EQ("wyrm", Strings.get(Wyrm));
+  EXPECT_EQ(Drake, Strings.find("drake"));
+  EXPECT_FALSE(Strings.find("dragon"));
+  // Strings don't move while the tables grow.
+  const char *Data = Strings.get(Wyrm).data();
+  for (int I = 0; I < 100000; ++I)
+    Strings.intern("name" + std::to_string(I));
+  EXPECT_EQ(Data, Strings.get(Wyrm).data());
+  EXPECT_EQ(100003u, Strings.size());
+  for (int I = 0; I < 100000; I += 997) {
+    std::string Name = "name" + std::to_string(I);
+    auto Id = Strings.find(Name);
+    ASSERT_TRUE(Id);
+    EXPECT_EQ(Name, Strings.get(*Id));
+  }
+}
+
+TEST(StringInterner, ConcurrentInterning) {
+  StringInterner Strings;
+  constexpr int NumThreads = 4, NumNames = 20000;
+  // Every thread interns all names starting at a different one.
+  std::vector<std::vector<StringInterner::Id>> Ids(
+      NumThreads, std::vector<StringInterner::Id>(NumNames));
+  std::vector<std::thread> Threads;
+  for (int T = 0; T < NumThreads; ++T)
+    Threads.emplace_back([&Strings, &Ids, T] {
+      for (int I = 0; I < NumNames; ++I) {
+        int Name = (I + T * NumNames / NumThreads) % NumNames;
+        Ids[T][Name] = Strings.intern("v" + std::to_string(Name));
+      }
+    });
+  for (auto &Thread : Threads)
+    Thread.join();
+  EXPECT_EQ(NumNames + 1u, Strings.size());
+  for (int T = 1; T < NumThreads; ++T)
+    EXPECT_EQ(Ids[0], Ids[T]);
+  for (int Name = 0; Name < NumNames; ++Name)
+    EXPECT_EQ("v" + std::to_string(Name), Strings.get(Ids[0][Name]));
+}
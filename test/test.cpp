@@ -1,5 +1,6 @@
 #include "MIR.h"
 #include "gtest/gtest.h"
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <sstream>
@@ -51,6 +52,25 @@ TEST(MIRBuilder, GlobalVariables3) {
   EXPECT_FALSE(drake);
 }
 
+TEST(MIRBuilder, ModulesKeepOwnSymbols) {
+  Module First{"first"}, Second{"second"};
+  MIRBuilder FirstBuilder{First}, SecondBuilder{Second};
+  auto *F = FirstBuilder.createFunction("f");
+  ASSERT_TRUE(F);
+  EXPECT_FALSE(SecondBuilder.findFunction("f"));
+  auto *G = SecondBuilder.createFunction("f");
+  ASSERT_TRUE(G);
+  EXPECT_EQ(F, FirstBuilder.findFunction("f"));
+  EXPECT_EQ(G, SecondBuilder.findFunction("f"));
+  auto &BB = FirstBuilder.createBasicBlock(*F, "entry");
+  auto &X = FirstBuilder.createRegister(*F, "x");
+  auto &Y = SecondBuilder.createRegister(*G, "x");
+  EXPECT_NE(&X, &Y);
+  EXPECT_EQ("entry", BB.label());
+  EXPECT_EQ("x", X.name());
+  EXPECT_EQ("", FirstBuilder.createRegister(*F).name());
+}
+
 TEST(MIRBuilder, FunctionParent) {
   Module TheModule{"my_module"};
   MIRBuilder Builder{TheModule};
@@ -247,4 +267,412 @@ TEST(MIRBuilder, BinOpInstDump) {
   Builder.release();
   TheModule.release();
 }
+
+TEST(MIRBuilder, EraseInstructions) {
+  auto[TheModule, Builder] = createInstContext();
+  auto &BB = *Builder->currentBasicBlock();
+  for (Imm I = 0; I < 5; ++I)
+    Builder->createUnOpInst(UnOpKind::Assign, I);
+  Builder->setInsertPoint(BB, 4);
+  Builder->eraseInstructions(BB, {0, 2, 4});
+  Builder->createUnOpInst(UnOpKind::Neg, 5);
+  std::stringstream Expected{}, Actual{};
+  Expected << "  %2 = 1\n"
+              "  %4 = 3\n"
+              "  %6 = neg 5\n";
+  for (auto &Inst : BB)
+    Actual << Inst;
+  EXPECT_EQ(Expected.str(), Actual.str());
+  Builder.release();
+  TheModule.release();
+}
+
+TEST(MIRBuilder, OperandEncoding) {
+  auto[TheModule, Builder] = createInstContext();
+  auto &G = Builder->createGlobalVariable("g");
+  auto &F = Builder->currentBasicBlock()->parent();
+  auto &X = Builder->createRegister(F, "x");
+  const Imm Constants[] = {0,
+                           -1,
+                           (1 << 30) - 1,
+                           1 << 30,
+                           -(1 << 30),
+                           -(1 << 30) - 1,
+                           std::numeric_limits<Imm>::max(),
+                           std::numeric_limits<Imm>::min()};
+  for (Imm C : Constants) {
+    auto &BinOp =
+        get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Add, C, G, X));
+    EXPECT_EQ(C, get<Imm>(BinOp.operand1()));
+    Value Operand2 = BinOp.operand2();
+    EXPECT_EQ(&G, get<SymReg>(&Operand2));
+    EXPECT_EQ(&X, &BinOp.outRegister());
+    // Negated with wrapping, as -C overflows for the minimal value.
+    const Imm Negated = static_cast<Imm>(0u - static_cast<unsigned>(C));
+    BinOp.setOperand2(Negated);
+    EXPECT_EQ(Negated, get<Imm>(BinOp.operand2()));
+  }
+  auto &Call = get<CallInst>(
+      Builder->createCallInst(false, F, {X, std::numeric_limits<Imm>::min()}));
+  EXPECT_EQ(nullptr, Call.outRegister());
+  std::vector<Value> Arguments(std::begin(Call), std::end(Call));
+  ASSERT_EQ(2u, Arguments.size());
+  EXPECT_EQ(&X, &get<SymReg>(Arguments[0]));
+  EXPECT_EQ(std::numeric_limits<Imm>::min(), get<Imm>(Arguments[1]));
+  Builder.release();
+  TheModule.release();
+}
+
+TEST(MIRBuilder, InsertAndEraseAcrossSegments) {
+  auto[TheModule, Builder] = createInstContext();
+  auto &BB = *Builder->currentBasicBlock();
+  auto &First = Builder->createUnOpInst(UnOpKind::Assign, 0);
+  for (Imm I = 1; I < 100; ++I)
+    Builder->createUnOpInst(UnOpKind::Assign, I);
+  // Appending doesn't move instructions.
+  EXPECT_EQ(&First, &BB[0]);
+  auto OperandAt = [&BB](std::size_t Position) {
+    return get<Imm>(get<UnOpInst>(BB[Position]).operand());
+  };
+  Builder->setInsertPoint(BB, 1);
+  Builder->createUnOpInst(UnOpKind::Assign, -1);
+  Builder->eraseInstruction(BB, 50);
+  Builder->eraseInstructions(BB, {2, 3, 61, 99});
+  std::vector<Imm> Expected{0, -1};
+  for (Imm I = 3; I < 100; ++I)
+    if (I != 49 && I != 61 && I != 99)
+      Expected.push_back(I);
+  ASSERT_EQ(Expected.size(), BB.size());
+  for (std::size_t Position = 0; Position < BB.size(); ++Position)
+    EXPECT_EQ(Expected[Position], OperandAt(Position));
+  std::vector<Imm> Scanned;
+  for (auto &Inst : BB)
+    Scanned.push_back(get<Imm>(get<UnOpInst>(Inst).operand()));
+  EXPECT_EQ(Expected, Scanned);
+  EXPECT_EQ(&First, &BB[0]);
+  Builder.release();
+  TheModule.release();
+}
+
+TEST(MIRBuilder, PhiIncomingList) {
+  auto[TheModule, Builder] = createInstContext();
+  auto &BB = *Builder->currentBasicBlock();
+  auto &F = BB.parent();
+  auto &X = Builder->createRegister(F, "x");
+  auto &Phi = get<PhiInst>(Builder->createPhiInst(X));
+  std::vector<BasicBlock *> Preds;
+  for (Imm I = 0; I < 10; ++I) {
+    Preds.push_back(&Builder->createBasicBlock(F));
+    Phi.addIncoming(I, *Preds.back());
+  }
+  Phi.removeIncoming(0);
+  Phi.removeIncoming(8);
+  ASSERT_EQ(8u, Phi.size());
+  for (std::size_t I = 0; I < Phi.size(); ++I) {
+    EXPECT_EQ(static_cast<Imm>(I + 1), get<Imm>(Phi.incomingValue(I)));
+    EXPECT_EQ(Preds[I + 1], &Phi.incomingBlock(I));
+  }
+  Builder.release();
+  TheModule.release();
+}
+
+TEST(MIRBuilder, UseLists) {
+  auto[TheModule, Builder] = createInstContext();
+  auto &BB = *Builder->currentBasicBlock();
+  auto &F = BB.parent();
+  auto &X = get<ReceiveInst>(Builder->createReceiveInst("x")).outRegister();
+  auto &Y = Builder->createRegister(F, "y");
+  // Every user must be an instruction of BB reading the register.
+  auto CheckUsers = [&BB](const SymReg &Reg) {
+    std::size_t NumUsers{};
+    for (const Instruction &User : Reg.users()) {
+      auto It = std::find_if(
+          std::begin(BB), std::end(BB),
+          [&User](const Instruction &Inst) { return &Inst == &User; });
+      EXPECT_NE(std::end(BB), It);
+      bool Reads{};
+      forEachOperand(User, [&](Value V) { Reads |= get<SymReg>(&V) == &Reg; });
+      EXPECT_TRUE(Reads);
+      ++NumUsers;
+    }
+    return NumUsers;
+  };
+  Builder->createBinOpInst(BinOpKind::Add, X, X, Y);
+  Builder->createUnOpInst(UnOpKind::Neg, Y, "z");
+  Builder->createCallInst(false, F, {X, Y, 3});
+  EXPECT_EQ(3u, CheckUsers(X));
+  EXPECT_EQ(2u, CheckUsers(Y));
+  // Inserting moves the later instructions together with their uses.
+  Builder->setInsertPoint(BB, 1);
+  Builder->createRetInst(Y);
+  EXPECT_EQ(3u, CheckUsers(X));
+  EXPECT_EQ(3u, CheckUsers(Y));
+  Builder->eraseInstruction(BB, 2);
+  EXPECT_EQ(1u, CheckUsers(X));
+  EXPECT_EQ(3u, CheckUsers(Y));
+  get<CallInst>(BB[3]).setArgument(0, 5);
+  EXPECT_FALSE(X.hasUses());
+  Builder->eraseInstructions(BB, {1, 3});
+  EXPECT_EQ(1u, CheckUsers(Y));
+  Builder.release();
+  TheModule.release();
+}
+
+TEST(MIRBuilder, ReplaceAllUsesWith) {
+  auto[TheModule, Builder] = createInstContext();
+  auto &BB = *Builder->currentBasicBlock();
+  auto &F = BB.parent();
+  auto &X = get<ReceiveInst>(Builder->createReceiveInst("x")).outRegister();
+  auto &Y = get<ReceiveInst>(Builder->createReceiveInst("y")).outRegister();
+  auto &Phi =
+      get<PhiInst>(Builder->createPhiInst(Builder->createRegister(F, "p")));
+  // The incoming list grows twice and moves its uses along.
+  for (Imm I = 0; I < 5; ++I)
+    Phi.addIncoming(I % 2 ? Value{X} : Value{I}, Builder->createBasicBlock(F));
+  Phi.removeIncoming(0);
+  auto &Add = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Add, X, X));
+  auto &Ret = get<RetInst>(Builder->createRetInst(X));
+  auto RegisterOf = [](Value V) { return get<SymReg>(&V); };
+  replaceAllUsesWith(X, Y);
+  EXPECT_FALSE(X.hasUses());
+  EXPECT_EQ(5, std::distance(std::begin(Y.users()), std::end(Y.users())));
+  ASSERT_EQ(4u, Phi.size());
+  EXPECT_EQ(&Y, RegisterOf(Phi.incomingValue(0)));
+  EXPECT_EQ(2, get<Imm>(Phi.incomingValue(1)));
+  EXPECT_EQ(&Y, RegisterOf(Phi.incomingValue(2)));
+  EXPECT_EQ(&Y, RegisterOf(Add.operand1()));
+  EXPECT_EQ(&Y, RegisterOf(Add.operand2()));
+  replaceAllUsesWith(Y, 1 << 30);
+  EXPECT_FALSE(Y.hasUses());
+  EXPECT_EQ(1 << 30, get<Imm>(Ret.operand()));
+  EXPECT_EQ(1 << 30, get<Imm>(Phi.incomingValue(2)));
+  Builder.release();
+  TheModule.release();
+}
+
+TEST(MIRBuilder, UsesOfManyOperands) {
+  auto[TheModule, Builder] = createInstContext();
+  auto &BB = *Builder->currentBasicBlock();
+  auto &F = BB.parent();
+  auto &X = get<ReceiveInst>(Builder->createReceiveInst("x")).outRegister();
+  auto &Y = get<ReceiveInst>(Builder->createReceiveInst("y")).outRegister();
+  // Uses are allocated up to the last register operand, so the use of the
+  // second operand moves when the first one becomes a register.
+  auto &Sub = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Sub, 1, X));
+  Sub.setOperand1(Y);
+  // The uses of the arguments take several groups.
+  std::vector<Value> Arguments;
+  for (Imm I = 0; I < 20; ++I)
+    Arguments.push_back(I % 3 ? Value{I} : Value{X});
+  auto &Call =
+      get<CallInst>(Builder->createCallInst(false, F, std::move(Arguments)));
+  auto RegisterOf = [](Value V) { return get<SymReg>(&V); };
+  EXPECT_EQ(8, std::distance(std::begin(X.users()), std::end(X.users())));
+  replaceAllUsesWith(X, Y);
+  EXPECT_FALSE(X.hasUses());
+  EXPECT_EQ(9, std::distance(std::begin(Y.users()), std::end(Y.users())));
+  EXPECT_EQ(&Y, RegisterOf(Sub.operand1()));
+  EXPECT_EQ(&Y, RegisterOf(Sub.operand2()));
+  for (Imm I = 0; I < 20; ++I)
+    if (I % 3)
+      EXPECT_EQ(I, get<Imm>(Call.argument(I)));
+    else
+      EXPECT_EQ(&Y, RegisterOf(Call.argument(I)));
+  Builder->eraseInstruction(BB, 2);
+  EXPECT_EQ(7, std::distance(std::begin(Y.users()), std::end(Y.users())));
+  Builder.release();
+  TheModule.release();
+}
+
+TEST(MIRBuilder, ArenaKeepsNodesInPlace) {
+  for (int Round = 0; Round < 2; ++Round) {
+    // The second module may reuse the memory of the first one, so it must
+    // start without its symbols.
+    Module TheModule{"my_module"};
+    MIRBuilder Builder{TheModule};
+    auto *F = Builder.createFunction("func1");
+    ASSERT_TRUE(F);
+    auto &Entry = Builder.createBasicBlock(*F, "entry");
+    Builder.setBasicBlock(Entry);
+    auto &X = get<ReceiveInst>(Builder.createReceiveInst("x")).outRegister();
+    auto &First = Builder.createBinOpInst(BinOpKind::Add, X, 1);
+    for (int I = 0; I < 10000; ++I)
+      Builder.createBinOpInst(BinOpKind::Add, X, I);
+    Builder.createCallInst(true, *F, {X, 2});
+    EXPECT_EQ(&Entry, &(*F)[0]);
+    EXPECT_EQ(&First, &Entry[1]);
+    EXPECT_EQ(&X, &F->symbolicRegisters()[0]);
+    EXPECT_GT(F->arena().numChunks(), 1u);
+    EXPECT_GE(F->arena().reservedBytes(), F->arena().allocatedBytes());
+  }
+}
+
+std::vector<std::uint32_t> sorted(BlockIndexRange Indices) {
+  std::vector<std::uint32_t> Result{std::begin(Indices), std::end(Indices)};
+  std::sort(std::begin(Result), std::end(Result));
+  return Result;
+}
+
+using Indices = std::vector<std::uint32_t>;
+
+TEST(MIRBuilder, CachedSuccessorsAndPredecessors) {
+  Module TheModule{"my_module"};
+  MIRBuilder Builder{TheModule};
+  auto *F = Builder.createFunction("func1");
+  ASSERT_TRUE(F);
+  BasicBlock *Blocks[4];
+  for (auto *&BB : Blocks)
+    BB = &Builder.createBasicBlock(*F);
+  for (std::uint32_t I = 0; I < 4; ++I) {
+    EXPECT_EQ(I, Blocks[I]->index());
+    EXPECT_EQ(Blocks[I], F->blockAt(I));
+  }
+  Builder.setBasicBlock(*Blocks[0]);
+  auto &X = get<ReceiveInst>(Builder.createReceiveInst("x")).outRegister();
+  auto &Br = get<BrInst>(Builder.createBrInst(X, *Blocks[1], *Blocks[1]));
+  EXPECT_EQ((Indices{1, 1}), sorted(Blocks[0]->successorIndices()));
+  EXPECT_EQ((Indices{0, 0}), sorted(Blocks[1]->predecessorIndices()));
+  Br.setFalseSuccessor(*Blocks[2]);
+  EXPECT_EQ((Indices{1, 2}), sorted(Blocks[0]->successorIndices()));
+  EXPECT_EQ(Indices{0}, sorted(Blocks[1]->predecessorIndices()));
+  EXPECT_EQ(Indices{0}, sorted(Blocks[2]->predecessorIndices()));
+  Builder.setBasicBlock(*Blocks[1]);
+  auto &GoTo = get<GoToInst>(Builder.createGoToInst(*Blocks[3]));
+  Builder.setBasicBlock(*Blocks[2]);
+  Builder.createGoToInst(*Blocks[3]);
+  EXPECT_EQ((Indices{1, 2}), sorted(Blocks[3]->predecessorIndices()));
+  GoTo.setSuccessor(*Blocks[2]);
+  EXPECT_EQ((Indices{0, 1}), sorted(Blocks[2]->predecessorIndices()));
+  EXPECT_EQ(Indices{2}, sorted(Blocks[3]->predecessorIndices()));
+  // An instruction after the terminator takes the successors away.
+  Builder.createUnOpInst(UnOpKind::Assign, 1, "y");
+  EXPECT_TRUE(Blocks[2]->successorIndices().empty());
+  EXPECT_TRUE(Blocks[3]->predecessorIndices().empty());
+  Builder.eraseInstruction(*Blocks[2], Blocks[2]->size() - 1);
+  EXPECT_EQ(Indices{3}, sorted(Blocks[2]->successorIndices()));
+  // Replacing the branch with a jump.
+  Builder.eraseInstructions(*Blocks[0], {0, 1});
+  EXPECT_TRUE(Blocks[1]->predecessorIndices().empty());
+  EXPECT_EQ(Indices{1}, sorted(Blocks[2]->predecessorIndices()));
+  Builder.setBasicBlock(*Blocks[0]);
+  Builder.createGoToInst(*Blocks[2]);
+  EXPECT_EQ((Indices{0, 1}), sorted(Blocks[2]->predecessorIndices()));
+  // Erasing a block leaves a hole in the indices.
+  Builder.eraseBasicBlock(*Blocks[1]);
+  EXPECT_EQ(nullptr, F->blockAt(1));
+  EXPECT_EQ(4u, F->numBlockIndices());
+  EXPECT_EQ(Indices{0}, sorted(Blocks[2]->predecessorIndices()));
+  EXPECT_EQ(3u, Blocks[3]->index());
+}
+
+TEST(MIRBuilder, BlockNumbersAfterErasure) {
+  Module TheModule{"my_module"};
+  MIRBuilder Builder{TheModule};
+  auto *F = Builder.createFunction("func1");
+  ASSERT_TRUE(F);
+  Builder.createBasicBlock(*F);
+  auto &Erased = Builder.createBasicBlock(*F);
+  Builder.createBasicBlock(*F, "NamedBB");
+  auto &Last = Builder.createBasicBlock(*F);
+  Builder.setBasicBlock((*F)[0]);
+  Builder.createGoToInst(Last);
+  Builder.eraseBasicBlock(Erased);
+  Builder.createBasicBlock(*F);
+  std::stringstream Actual{};
+  Actual << *F;
+  EXPECT_EQ("function func1(...) {\n"
+            "BB1:\n"
+            "  goto BB2\n"
+            "NamedBB:\n"
+            "BB2:\n"
+            "BB3:\n"
+            "}\n",
+            Actual.str());
+}
+
+TEST(MIRBuilder, EraseBlocksAtOnce) {
+  Module TheModule{"my_module"};
+  MIRBuilder Builder{TheModule};
+  auto *F = Builder.createFunction("func1");
+  ASSERT_TRUE(F);
+  std::vector<BasicBlock *> Blocks;
+  for (int I = 0; I < 6; ++I)
+    Blocks.push_back(&Builder.createBasicBlock(*F, I == 2 ? "Dead" : ""));
+  // 1 and 2 branch to each other and to the kept blocks.
+  Builder.setBasicBlock(*Blocks[0]);
+  Builder.createGoToInst(*Blocks[3]);
+  Builder.setBasicBlock(*Blocks[1]);
+  Builder.createBrInst(1, *Blocks[2], *Blocks[3]);
+  Builder.setBasicBlock(*Blocks[2]);
+  Builder.createGoToInst(*Blocks[1]);
+  Builder.setBasicBlock(*Blocks[3]);
+  Builder.createGoToInst(*Blocks[5]);
+  Builder.setBasicBlock(*Blocks[4]);
+  Builder.createGoToInst(*Blocks[5]);
+  Builder.eraseBasicBlocks({Blocks[4], Blocks[1], Blocks[2]});
+  EXPECT_EQ(nullptr, F->blockAt(1));
+  EXPECT_EQ(nullptr, F->blockAt(2));
+  EXPECT_EQ(nullptr, F->blockAt(4));
+  EXPECT_EQ(nullptr, Builder.currentFuction());
+  EXPECT_EQ(Indices{0}, sorted(Blocks[3]->predecessorIndices()));
+  EXPECT_EQ(Indices{3}, sorted(Blocks[5]->predecessorIndices()));
+  std::stringstream Actual{};
+  Actual << *F;
+  EXPECT_EQ("function func1(...) {\n"
+            "BB1:\n"
+            "  goto BB2\n"
+            "BB2:\n"
+            "  goto BB3\n"
+            "BB3:\n"
+            "}\n",
+            Actual.str());
+  // New blocks continue the numbering.
+  Builder.createBasicBlock(*F);
+  EXPECT_EQ(4u, (*F)[F->size() - 1].number());
+}
 } // namespace
+
+TEST(MIR, EvaluateUnOp) {
+  const Imm Min = std::numeric_limits<Imm>::min();
+  EXPECT_EQ(7, evaluate(UnOpKind::Assign, 7));
+  EXPECT_EQ(-7, evaluate(UnOpKind::Neg, 7));
+  EXPECT_EQ(Min, evaluate(UnOpKind::Neg, Min));
+  EXPECT_EQ(-1, evaluate(UnOpKind::Not, 0));
+  EXPECT_EQ(~5, evaluate(UnOpKind::Not, 5));
+}
+
+TEST(MIR, EvaluateBinOp) {
+  const Imm Min = std::numeric_limits<Imm>::min();
+  const Imm Max = std::numeric_limits<Imm>::max();
+  auto Eval = [](BinOpKind Kind, Imm LHS, Imm RHS) {
+    auto Result = evaluate(Kind, LHS, RHS);
+    EXPECT_TRUE(Result);
+    return Result ? *Result : 0;
+  };
+  EXPECT_EQ(Min, Eval(BinOpKind::Add, Max, 1));
+  EXPECT_EQ(Max, Eval(BinOpKind::Sub, Min, 1));
+  EXPECT_EQ(-2, Eval(BinOpKind::Mul, Max, 2));
+  EXPECT_EQ(-3, Eval(BinOpKind::Div, -7, 2));
+  EXPECT_EQ(-1, Eval(BinOpKind::Mod, -7, 2));
+  EXPECT_EQ(1, Eval(BinOpKind::Mod, 7, -2));
+  EXPECT_FALSE(evaluate(BinOpKind::Div, 1, 0));
+  EXPECT_FALSE(evaluate(BinOpKind::Mod, 1, 0));
+  EXPECT_FALSE(evaluate(BinOpKind::Div, Min, -1));
+  EXPECT_FALSE(evaluate(BinOpKind::Mod, Min, -1));
+  EXPECT_EQ(-3, Eval(BinOpKind::Min, -3, 2));
+  EXPECT_EQ(2, Eval(BinOpKind::Max, -3, 2));
+  EXPECT_EQ(2, Eval(BinOpKind::Shl, 1, 33));
+  EXPECT_EQ(Min, Eval(BinOpKind::Shl, 1, 31));
+  EXPECT_EQ(15, Eval(BinOpKind::Shr, -1, 28));
+  EXPECT_EQ(-4, Eval(BinOpKind::Shra, -16, 2));
+  EXPECT_EQ(-1, Eval(BinOpKind::Shra, -1, 63));
+  EXPECT_EQ(4, Eval(BinOpKind::And, 6, 12));
+  EXPECT_EQ(14, Eval(BinOpKind::Or, 6, 12));
+  EXPECT_EQ(10, Eval(BinOpKind::Xor, 6, 12));
+  EXPECT_EQ(1, Eval(BinOpKind::Eq, 3, 3));
+  EXPECT_EQ(0, Eval(BinOpKind::Neq, 3, 3));
+  EXPECT_EQ(1, Eval(BinOpKind::Less, -1, 0));
+  EXPECT_EQ(1, Eval(BinOpKind::Leq, 0, 0));
+  EXPECT_EQ(0, Eval(BinOpKind::Greater, Min, Max));
+  EXPECT_EQ(1, Eval(BinOpKind::Geq, Max, Min));
+}
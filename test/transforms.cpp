@@ -0,0 +1,865 @@
+#include "Analysis/cfg.h"
+#include "Analysis/dominance.h"
+#include "Analysis/dominator_tree.h"
+#include "ExecutionEngine/interpreter.h"
+#include "MIR.h"
+#include "Transforms/adce.h"
+#include "Transforms/gvn.h"
+#include "Transforms/licm.h"
+#include "Transforms/pass_manager.h"
+#include "Transforms/sccp.h"
+#include "Transforms/ssa.h"
+#include "gtest/gtest.h"
+#include "utils.h"
+#include <thread>
+
+using namespace wyrm;
+using namespace wyrm::test;
+
+namespace {
+/// \brief Check that every register is defined once and every use in a
+/// reachable block is dominated by the definition.
+void checkSSA(Function &F) {
+  FunctionCFG CFG{F};
+  DominatorTree DT{immediateDominators(CFG.graph())};
+  struct Location {
+    CSRGraph::NodeId Node;
+    std::size_t Position;
+  };
+  std::unordered_map<const SymReg *, Location> Defs;
+  for (CSRGraph::NodeId Node = 0; Node < CFG.size(); ++Node) {
+    auto &BB = CFG.block(Node);
+    for (std::size_t Position = 0; Position < BB.size(); ++Position)
+      if (auto *Reg = definedRegister(BB[Position])) {
+        ASSERT_TRUE(Defs.emplace(Reg, Location{Node, Position}).second);
+      }
+  }
+  for (CSRGraph::NodeId Node = 0; Node < CFG.size(); ++Node) {
+    if (!DT.contains(Node))
+      continue;
+    auto &BB = CFG.block(Node);
+    for (std::size_t Position = 0; Position < BB.size(); ++Position) {
+      if (auto *Phi = get<PhiInst>(&BB[Position])) {
+        ASSERT_EQ(CFG.graph().predecessors(Node).size(), Phi->size());
+        for (std::size_t I = 0; I < Phi->size(); ++I) {
+          auto Incoming = Phi->incomingValue(I);
+          auto *Reg = get<SymReg>(&Incoming);
+          auto Pred = CFG.number(Phi->incomingBlock(I));
+          EXPECT_TRUE(CFG.graph().hasArc({Pred, Node}));
+          if (Reg && DT.contains(Pred)) {
+            EXPECT_TRUE(DT.dominates(Defs.at(Reg).Node, Pred));
+          }
+        }
+        continue;
+      }
+      forEachOperand(BB[Position], [&](Value V) {
+        auto *Reg = get<SymReg>(&V);
+        if (!Reg)
+          return;
+        auto Def = Defs.at(Reg);
+        EXPECT_TRUE(DT.dominates(Def.Node, Node));
+        if (Def.Node == Node) {
+          EXPECT_LT(Def.Position, Position);
+        }
+      });
+    }
+  }
+}
+
+std::size_t countPhis(Function &F) {
+  std::size_t Count{};
+  for (auto &BB : F)
+    for (auto &Inst : BB)
+      Count += get<PhiInst>(&Inst) != nullptr;
+  return Count;
+}
+
+/// \brief Check that \p Transform keeps the results of random functions and
+/// changes nothing when run again. Even tests run on SSA form, which must be
+/// kept, and odd ones on registers with several definitions.
+template <typename TransformFn>
+void checkKeepsResults(unsigned Seed, std::size_t NumTests,
+                       TransformFn Transform) {
+  std::mt19937 Seeds{Seed};
+  for (std::size_t Test = 0; Test < NumTests; ++Test) {
+    RandomFunctionPair Functions{Seeds(), 2 + Test % 30};
+    auto &Builder = Functions.Builder;
+    auto &F = Functions.F;
+    const bool IsSSA = Test % 2 == 0;
+    if (IsSSA)
+      constructSSA(Builder, F);
+    Transform(Builder, F);
+    if (IsSSA)
+      checkSSA(F);
+    EXPECT_FALSE(Transform(Builder, F)) << print(Functions.Reference);
+    Functions.expectSameResults(IsSSA ? "SSA" : "Non-SSA");
+  }
+}
+} // namespace
+
+TEST(SSA, Diamond) {
+  auto [TheModule, Builder, F] = createFunctionContext("diamond");
+  auto &Entry = Builder->createBasicBlock(*F);
+  auto &Then = Builder->createBasicBlock(*F);
+  auto &Else = Builder->createBasicBlock(*F);
+  auto &Join = Builder->createBasicBlock(*F);
+  Builder->setBasicBlock(Entry);
+  auto &X = get<ReceiveInst>(Builder->createReceiveInst("x")).outRegister();
+  Builder->createBrInst(X, Then, Else);
+  Builder->setBasicBlock(Then);
+  auto &Y = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, 1, "y"))
+                .outRegister();
+  Builder->createGoToInst(Join);
+  Builder->setBasicBlock(Else);
+  Builder->createUnOpInst(UnOpKind::Assign, 2, Y);
+  Builder->createGoToInst(Join);
+  Builder->setBasicBlock(Join);
+  Builder->createRetInst(Y);
+  constructSSA(*Builder, *F);
+  EXPECT_EQ("function diamond(...) {\n"
+            "BB1:\n"
+            "  %x = receive\n"
+            "  br %x, BB2, BB3\n"
+            "BB2:\n"
+            "  %y = 1\n"
+            "  goto BB4\n"
+            "BB3:\n"
+            "  %y.1 = 2\n"
+            "  goto BB4\n"
+            "BB4:\n"
+            "  %y.2 = phi [%y, BB2], [%y.1, BB3]\n"
+            "  ret %y.2\n"
+            "}\n",
+            print(*F));
+  checkSSA(*F);
+}
+
+TEST(SSA, Loop) {
+  auto [TheModule, Builder, F] = createFunctionContext("sum");
+  buildSumLoop(*Builder, *F);
+  constructSSA(*Builder, *F);
+  EXPECT_EQ("function sum(...) {\n"
+            "BB1:\n"
+            "  %n = receive\n"
+            "  %i = 0\n"
+            "  %s = 0\n"
+            "  goto BB2\n"
+            "BB2:\n"
+            "  %i.1 = phi [%i, BB1], [%i.2, BB3]\n"
+            "  %s.1 = phi [%s, BB1], [%s.2, BB3]\n"
+            "  %c = cmp lt %i.1, %n\n"
+            "  br %c, BB3, BB4\n"
+            "BB3:\n"
+            "  %s.2 = add %s.1, %i.1\n"
+            "  %i.2 = add %i.1, 1\n"
+            "  goto BB2\n"
+            "BB4:\n"
+            "  ret %s.1\n"
+            "}\n",
+            print(*F));
+  checkSSA(*F);
+  destructSSA(*Builder, *F);
+  EXPECT_EQ("function sum(...) {\n"
+            "BB1:\n"
+            "  %n = receive\n"
+            "  %i = 0\n"
+            "  %s = 0\n"
+            "  %i.1.1 = %i\n"
+            "  %s.1.1 = %s\n"
+            "  goto BB2\n"
+            "BB2:\n"
+            "  %i.1 = %i.1.1\n"
+            "  %s.1 = %s.1.1\n"
+            "  %c = cmp lt %i.1, %n\n"
+            "  br %c, BB3, BB4\n"
+            "BB3:\n"
+            "  %s.2 = add %s.1, %i.1\n"
+            "  %i.2 = add %i.1, 1\n"
+            "  %i.1.1 = %i.2\n"
+            "  %s.1.1 = %s.2\n"
+            "  goto BB2\n"
+            "BB4:\n"
+            "  ret %s.1\n"
+            "}\n",
+            print(*F));
+}
+
+TEST(SSA, UndefinedUseReadsZero) {
+  auto [TheModule, Builder, F] = createFunctionContext("undef");
+  auto &Entry = Builder->createBasicBlock(*F);
+  auto &Exit = Builder->createBasicBlock(*F);
+  auto &X = Builder->createRegister(*F, "x");
+  Builder->setBasicBlock(Entry);
+  Builder->createBinOpInst(BinOpKind::Add, X, 1, X);
+  Builder->createGoToInst(Exit);
+  Builder->setBasicBlock(Exit);
+  Builder->createRetInst(X);
+  constructSSA(*Builder, *F);
+  EXPECT_EQ("function undef(...) {\n"
+            "BB1:\n"
+            "  %x = add 0, 1\n"
+            "  goto BB2\n"
+            "BB2:\n"
+            "  ret %x\n"
+            "}\n",
+            print(*F));
+}
+
+TEST(SSA, RandomFunctions) {
+  std::mt19937 Gen{7};
+  for (std::size_t Test = 0; Test < 200; ++Test) {
+    auto [TheModule, Builder, F] =
+        createFunctionContext("random" + std::to_string(Test));
+    buildRandomFunction(Gen, *Builder, *F, 2 + Test % 30);
+    constructSSA(*Builder, *F);
+    checkSSA(*F);
+    destructSSA(*Builder, *F);
+    EXPECT_EQ(0u, countPhis(*F));
+  }
+}
+
+TEST(SCCP, ConstantGuardedBranch) {
+  auto [TheModule, Builder, F] = createFunctionContext("guarded");
+  auto &Entry = Builder->createBasicBlock(*F);
+  auto &Then = Builder->createBasicBlock(*F);
+  auto &Else = Builder->createBasicBlock(*F);
+  auto &Join = Builder->createBasicBlock(*F);
+  Builder->setBasicBlock(Entry);
+  auto &X = get<ReceiveInst>(Builder->createReceiveInst("x")).outRegister();
+  auto &C = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Less, 1, 2, "c"))
+                .outRegister();
+  Builder->createBrInst(C, Then, Else);
+  Builder->setBasicBlock(Then);
+  auto &Y = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Add, X, 1, "y"))
+                .outRegister();
+  Builder->createGoToInst(Join);
+  Builder->setBasicBlock(Else);
+  Builder->createBinOpInst(BinOpKind::Add, X, 2, Y);
+  Builder->createGoToInst(Join);
+  Builder->setBasicBlock(Join);
+  Builder->createRetInst(Y);
+  constructSSA(*Builder, *F);
+  EXPECT_TRUE(propagateConstants(*Builder, *F));
+  EXPECT_EQ("function guarded(...) {\n"
+            "BB1:\n"
+            "  %x = receive\n"
+            "  goto BB2\n"
+            "BB2:\n"
+            "  %y = add %x, 1\n"
+            "  goto BB3\n"
+            "BB3:\n"
+            "  %y.2 = phi [%y, BB2]\n"
+            "  ret %y.2\n"
+            "}\n",
+            print(*F));
+  EXPECT_FALSE(propagateConstants(*Builder, *F));
+}
+
+TEST(SCCP, ConstantThroughLoop) {
+  auto [TheModule, Builder, F] = createFunctionContext("loop");
+  auto &Entry = Builder->createBasicBlock(*F);
+  auto &Header = Builder->createBasicBlock(*F);
+  auto &Body = Builder->createBasicBlock(*F);
+  auto &Exit = Builder->createBasicBlock(*F);
+  Builder->setBasicBlock(Entry);
+  auto &N = get<ReceiveInst>(Builder->createReceiveInst("n")).outRegister();
+  auto &I = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, 1, "i"))
+                .outRegister();
+  auto &K = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, 0, "k"))
+                .outRegister();
+  Builder->createGoToInst(Header);
+  Builder->setBasicBlock(Header);
+  auto &C = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Less, K, N, "c"))
+                .outRegister();
+  Builder->createBrInst(C, Body, Exit);
+  Builder->setBasicBlock(Body);
+  // i stays 1 on every iteration, which only optimistic analysis can see.
+  Builder->createBinOpInst(BinOpKind::Mul, I, 1, I);
+  Builder->createBinOpInst(BinOpKind::Add, K, 1, K);
+  Builder->createGoToInst(Header);
+  Builder->setBasicBlock(Exit);
+  Builder->createRetInst(I);
+  constructSSA(*Builder, *F);
+  EXPECT_TRUE(propagateConstants(*Builder, *F));
+  EXPECT_EQ("function loop(...) {\n"
+            "BB1:\n"
+            "  %n = receive\n"
+            "  goto BB2\n"
+            "BB2:\n"
+            "  %k.1 = phi [0, BB1], [%k.2, BB3]\n"
+            "  %c = cmp lt %k.1, %n\n"
+            "  br %c, BB3, BB4\n"
+            "BB3:\n"
+            "  %k.2 = add %k.1, 1\n"
+            "  goto BB2\n"
+            "BB4:\n"
+            "  ret 1\n"
+            "}\n",
+            print(*F));
+}
+
+TEST(SCCP, TrappingOperationsAreKept) {
+  auto [TheModule, Builder, F] = createFunctionContext("trap");
+  Builder->setBasicBlock(Builder->createBasicBlock(*F));
+  auto &Q = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Div, 7, 2, "q"))
+                .outRegister();
+  auto &R = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Mod, Q, 0, "r"))
+                .outRegister();
+  Builder->createRetInst(R);
+  EXPECT_TRUE(propagateConstants(*Builder, *F));
+  EXPECT_EQ("function trap(...) {\n"
+            "BB1:\n"
+            "  %r = mod 3, 0\n"
+            "  ret %r\n"
+            "}\n",
+            print(*F));
+}
+
+TEST(SCCP, ReadBeforeDefinition) {
+  auto [TheModule, Builder, F] = createFunctionContext("early");
+  Builder->setBasicBlock(Builder->createBasicBlock(*F));
+  auto &X = Builder->createRegister(*F, "x");
+  auto &Y = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, X, "y"))
+                .outRegister();
+  Builder->createUnOpInst(UnOpKind::Assign, 5, X);
+  Builder->createRetInst(Y);
+  EXPECT_FALSE(propagateConstants(*Builder, *F));
+  Interpreter Engine{*TheModule};
+  auto Result = Engine.run(*F);
+  ASSERT_TRUE(Result.returned());
+  EXPECT_EQ(0, Result.ReturnValue);
+}
+
+TEST(SCCP, RandomFunctionsStayInSSA) {
+  std::mt19937 Gen{13};
+  for (std::size_t Test = 0; Test < 200; ++Test) {
+    auto [TheModule, Builder, F] =
+        createFunctionContext("random" + std::to_string(Test));
+    buildRandomFunction(Gen, *Builder, *F, 2 + Test % 30);
+    constructSSA(*Builder, *F);
+    propagateConstants(*Builder, *F);
+    checkSSA(*F);
+    EXPECT_FALSE(propagateConstants(*Builder, *F));
+  }
+}
+
+TEST(GVN, DominatingExpressions) {
+  auto [TheModule, Builder, F] = createFunctionContext("gvn");
+  auto &Entry = Builder->createBasicBlock(*F);
+  auto &Then = Builder->createBasicBlock(*F);
+  auto &Else = Builder->createBasicBlock(*F);
+  auto &Join = Builder->createBasicBlock(*F);
+  Builder->setBasicBlock(Entry);
+  auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+  auto &B = get<ReceiveInst>(Builder->createReceiveInst("b")).outRegister();
+  auto &X = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Add, A, B, "x"))
+                .outRegister();
+  Builder->createBrInst(X, Then, Else);
+  Builder->setBasicBlock(Then);
+  auto &C = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, B, "c"))
+                .outRegister();
+  auto &Y = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Add, C, A, "y"))
+                .outRegister();
+  Builder->createBinOpInst(BinOpKind::Less, A, Y, "p");
+  auto &Q =
+      get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Greater, X, A, "q"))
+          .outRegister();
+  Builder->createBinOpInst(BinOpKind::Mul, A, B, "m");
+  Builder->createBrInst(Q, Join, Join);
+  Builder->setBasicBlock(Else);
+  Builder->createBinOpInst(BinOpKind::Sub, A, B, "s");
+  auto &T = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Sub, B, A, "t"))
+                .outRegister();
+  Builder->createBinOpInst(BinOpKind::Mul, B, A, "n");
+  Builder->createGoToInst(Join);
+  Builder->setBasicBlock(Join);
+  auto &Phi = get<PhiInst>(Builder->createPhiInst(
+      Builder->createRegister(*F, "r")));
+  Phi.addIncoming(Y, Then);
+  Phi.addIncoming(T, Else);
+  auto &Z = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Mul, B, A, "z"))
+                .outRegister();
+  Builder->createRetInst(Z);
+  EXPECT_TRUE(eliminateRedundancies(*Builder, *F));
+  // Products in the branches don't dominate the join.
+  EXPECT_EQ("function gvn(...) {\n"
+            "BB1:\n"
+            "  %a = receive\n"
+            "  %b = receive\n"
+            "  %x = add %a, %b\n"
+            "  br %x, BB2, BB3\n"
+            "BB2:\n"
+            "  %p = cmp lt %a, %x\n"
+            "  %m = mul %a, %b\n"
+            "  br %p, BB4, BB4\n"
+            "BB3:\n"
+            "  %s = sub %a, %b\n"
+            "  %t = sub %b, %a\n"
+            "  %n = mul %b, %a\n"
+            "  goto BB4\n"
+            "BB4:\n"
+            "  %r = phi [%x, BB2], [%t, BB3]\n"
+            "  %z = mul %b, %a\n"
+            "  ret %z\n"
+            "}\n",
+            print(*F));
+  EXPECT_FALSE(eliminateRedundancies(*Builder, *F));
+}
+
+TEST(GVN, LongChains) {
+  auto [TheModule, Builder, F] = createFunctionContext("chains");
+  auto &Entry = Builder->createBasicBlock(*F);
+  Builder->setBasicBlock(Entry);
+  SymReg *Previous =
+      &get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+  SymReg *Twin = Previous;
+  // Two copies of a chain of 50000 dependent operations.
+  for (int I = 0; I < 50000; ++I) {
+    Previous = &get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Xor,
+                                                        *Previous, I % 7))
+                    .outRegister();
+    Twin = &get<BinOpInst>(
+                Builder->createBinOpInst(BinOpKind::Xor, I % 7, *Twin))
+                .outRegister();
+  }
+  Builder->createBinOpInst(BinOpKind::Sub, *Previous, *Twin, "d");
+  EXPECT_TRUE(eliminateRedundancies(*Builder, *F));
+  EXPECT_EQ(50002u, Entry.size());
+  auto &Last = get<BinOpInst>(Entry[Entry.size() - 1]);
+  auto LHS = Last.operand1(), RHS = Last.operand2();
+  EXPECT_EQ(get<SymReg>(&LHS), get<SymReg>(&RHS));
+}
+
+TEST(GVN, ReadBeforeDefinition) {
+  auto [TheModule, Builder, F] = createFunctionContext("early");
+  Builder->setBasicBlock(Builder->createBasicBlock(*F));
+  auto &N = get<ReceiveInst>(Builder->createReceiveInst("n")).outRegister();
+  auto &X = Builder->createRegister(*F, "x");
+  auto &Y = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, X, "y"))
+                .outRegister();
+  Builder->createUnOpInst(UnOpKind::Assign, N, X);
+  Builder->createRetInst(Y);
+  EXPECT_FALSE(eliminateRedundancies(*Builder, *F));
+  Interpreter Engine{*TheModule};
+  auto Result = Engine.run(*F, {3});
+  ASSERT_TRUE(Result.returned());
+  EXPECT_EQ(0, Result.ReturnValue);
+}
+
+TEST(GVN, RandomFunctionsStayInSSA) {
+  std::mt19937 Gen{17};
+  for (std::size_t Test = 0; Test < 200; ++Test) {
+    auto [TheModule, Builder, F] =
+        createFunctionContext("random" + std::to_string(Test));
+    buildRandomFunction(Gen, *Builder, *F, 2 + Test % 30);
+    constructSSA(*Builder, *F);
+    eliminateRedundancies(*Builder, *F);
+    checkSSA(*F);
+    EXPECT_FALSE(eliminateRedundancies(*Builder, *F));
+  }
+}
+
+TEST(LICM, NestedLoopsInsideOut) {
+  auto [TheModule, Builder, F] = createFunctionContext("nested");
+  auto &Entry = Builder->createBasicBlock(*F);
+  auto &Outer = Builder->createBasicBlock(*F);
+  auto &InnerEntry = Builder->createBasicBlock(*F);
+  auto &Inner = Builder->createBasicBlock(*F);
+  auto &Body = Builder->createBasicBlock(*F);
+  auto &Latch = Builder->createBasicBlock(*F);
+  auto &Exit = Builder->createBasicBlock(*F);
+  Builder->setBasicBlock(Entry);
+  auto &N = get<ReceiveInst>(Builder->createReceiveInst("n")).outRegister();
+  auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+  auto &I = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, 0, "i"))
+                .outRegister();
+  auto &S = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, 0, "s"))
+                .outRegister();
+  Builder->createGoToInst(Outer);
+  Builder->setBasicBlock(Outer);
+  auto &C = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Less, I, N, "c"))
+                .outRegister();
+  Builder->createBrInst(C, InnerEntry, Exit);
+  Builder->setBasicBlock(InnerEntry);
+  auto &J = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, 0, "j"))
+                .outRegister();
+  Builder->createGoToInst(Inner);
+  Builder->setBasicBlock(Inner);
+  auto &D = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Less, J, N, "d"))
+                .outRegister();
+  Builder->createBrInst(D, Body, Latch);
+  Builder->setBasicBlock(Body);
+  // t is invariant in both loops, u only in the inner one.
+  auto &T = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Mul, A, 3, "t"))
+                .outRegister();
+  auto &U = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Add, T, I, "u"))
+                .outRegister();
+  auto &V = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Xor, U, J, "v"))
+                .outRegister();
+  Builder->createBinOpInst(BinOpKind::Add, S, V, S);
+  Builder->createBinOpInst(BinOpKind::Add, J, 1, J);
+  Builder->createGoToInst(Inner);
+  Builder->setBasicBlock(Latch);
+  Builder->createBinOpInst(BinOpKind::Add, I, 1, I);
+  Builder->createGoToInst(Outer);
+  Builder->setBasicBlock(Exit);
+  Builder->createRetInst(S);
+
+  Interpreter Engine{*TheModule};
+  auto Expected = Engine.run(*F, {20, 5});
+  auto Executed = Engine.executedInstructions();
+  EXPECT_TRUE(hoistLoopInvariants(*Builder, *F));
+  EXPECT_EQ("function nested(...) {\n"
+            "BB1:\n"
+            "  %n = receive\n"
+            "  %a = receive\n"
+            "  %i = 0\n"
+            "  %s = 0\n"
+            "  %t = mul %a, 3\n"
+            "  goto BB2\n"
+            "BB2:\n"
+            "  %c = cmp lt %i, %n\n"
+            "  br %c, BB3, BB7\n"
+            "BB3:\n"
+            "  %j = 0\n"
+            "  %u = add %t, %i\n"
+            "  goto BB4\n"
+            "BB4:\n"
+            "  %d = cmp lt %j, %n\n"
+            "  br %d, BB5, BB6\n"
+            "BB5:\n"
+            "  %v = xor %u, %j\n"
+            "  %s = add %s, %v\n"
+            "  %j = add %j, 1\n"
+            "  goto BB4\n"
+            "BB6:\n"
+            "  %i = add %i, 1\n"
+            "  goto BB2\n"
+            "BB7:\n"
+            "  ret %s\n"
+            "}\n",
+            print(*F));
+  EXPECT_FALSE(hoistLoopInvariants(*Builder, *F));
+  Interpreter Optimized{*TheModule};
+  auto Actual = Optimized.run(*F, {20, 5});
+  EXPECT_EQ(Expected.ReturnValue, Actual.ReturnValue);
+  EXPECT_LT(Optimized.executedInstructions() + 20 * 20, Executed);
+}
+
+TEST(LICM, TrappingDivisionStaysGuarded) {
+  auto [TheModule, Builder, F] = createFunctionContext("div");
+  auto &Entry = Builder->createBasicBlock(*F);
+  auto &Left = Builder->createBasicBlock(*F);
+  auto &Right = Builder->createBasicBlock(*F);
+  auto &Header = Builder->createBasicBlock(*F);
+  auto &Body = Builder->createBasicBlock(*F);
+  auto &Exit = Builder->createBasicBlock(*F);
+  Builder->setBasicBlock(Entry);
+  auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+  auto &B = get<ReceiveInst>(Builder->createReceiveInst("b")).outRegister();
+  auto &N = get<ReceiveInst>(Builder->createReceiveInst("n")).outRegister();
+  auto &I = Builder->createRegister(*F, "i");
+  auto &S = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, 0, "s"))
+                .outRegister();
+  Builder->createBrInst(A, Left, Right);
+  Builder->setBasicBlock(Left);
+  Builder->createUnOpInst(UnOpKind::Assign, 0, I);
+  Builder->createGoToInst(Header);
+  Builder->setBasicBlock(Right);
+  Builder->createUnOpInst(UnOpKind::Assign, 1, I);
+  Builder->createGoToInst(Header);
+  Builder->setBasicBlock(Header);
+  // q runs whenever the loop is entered, r only if the body runs.
+  auto &Q = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Div, N, B, "q"))
+                .outRegister();
+  auto &C = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Less, I, N, "c"))
+                .outRegister();
+  Builder->createBrInst(C, Body, Exit);
+  Builder->setBasicBlock(Body);
+  auto &R = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Mod, B, A, "r"))
+                .outRegister();
+  auto &K = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Div, N, 3, "k"))
+                .outRegister();
+  Builder->createBinOpInst(BinOpKind::Add, S, Q, S);
+  Builder->createBinOpInst(BinOpKind::Add, S, R, S);
+  Builder->createBinOpInst(BinOpKind::Add, S, K, S);
+  Builder->createBinOpInst(BinOpKind::Add, I, 1, I);
+  Builder->createGoToInst(Header);
+  Builder->setBasicBlock(Exit);
+  Builder->createRetInst(S);
+
+  const std::vector<std::vector<Imm>> Inputs = {
+      {3, 7, 100}, {0, 7, 100}, {0, 1, 0}, {1, 0, 5}, {0, 0, 0}};
+  Interpreter Engine{*TheModule};
+  std::vector<ExecutionResult> Expected;
+  for (auto &Args : Inputs)
+    Expected.push_back(Engine.run(*F, Args));
+  constructSSA(*Builder, *F);
+  EXPECT_TRUE(hoistLoopInvariants(*Builder, *F));
+  checkSSA(*F);
+
+  AnalysisCache Analyses{*F};
+  const FunctionCFG &CFG = Analyses.cfg();
+  const LoopInfo &Loops = Analyses.loops();
+  ASSERT_EQ(1u, Loops.size());
+  // SSA construction renames the results, but not the divisors.
+  auto IsInLoop = [&](BinOpKind Kind, Value Divisor) {
+    for (auto &BB : *F)
+      for (auto &Inst : BB) {
+        auto *BinOp = get<BinOpInst>(&Inst);
+        if (!BinOp || BinOp->kind() != Kind)
+          continue;
+        Value RHS = BinOp->operand2();
+        if (get<SymReg>(&RHS) == get<SymReg>(&Divisor) &&
+            (get<SymReg>(&RHS) || *get<Imm>(&RHS) == *get<Imm>(&Divisor)))
+          return Loops.loopFor(CFG.number(BB)) != LoopInfo::NoLoop;
+      }
+    ADD_FAILURE() << "No such division";
+    return false;
+  };
+  EXPECT_FALSE(IsInLoop(BinOpKind::Div, B));
+  EXPECT_TRUE(IsInLoop(BinOpKind::Mod, A));
+  EXPECT_FALSE(IsInLoop(BinOpKind::Div, 3));
+  // The new preheader merges the values of i entering the loop.
+  auto Preds = CFG.graph().predecessors(Loops.header(0));
+  ASSERT_EQ(2u, Preds.size());
+  auto &Preheader =
+      CFG.block(Loops.contains(0, Preds[0]) ? Preds[1] : Preds[0]);
+  auto *Split = get<PhiInst>(&Preheader[0]);
+  ASSERT_TRUE(Split);
+  EXPECT_EQ(2u, Split->size());
+  EXPECT_FALSE(get<PhiInst>(&Preheader[1]));
+
+  Interpreter Optimized{*TheModule};
+  for (std::size_t Input = 0; Input < Inputs.size(); ++Input) {
+    auto Result = Optimized.run(*F, Inputs[Input]);
+    EXPECT_EQ(Expected[Input].Status, Result.Status);
+    EXPECT_EQ(Expected[Input].ReturnValue, Result.ReturnValue);
+  }
+}
+
+TEST(LICM, RandomFunctionsKeepResults) {
+  // Loop bodies guarding a trap which isn't reached are rare, so it takes
+  // many functions to meet some.
+  checkKeepsResults(23, 3000, [](MIRBuilder &Builder, Function &F) {
+    return hoistLoopInvariants(Builder, F);
+  });
+}
+
+TEST(ADCE, DeadComputationsAndBranches) {
+  auto [TheModule, Builder, F] = createFunctionContext("dead");
+  auto &Entry = Builder->createBasicBlock(*F);
+  auto &Then = Builder->createBasicBlock(*F);
+  auto &Else = Builder->createBasicBlock(*F);
+  auto &Join = Builder->createBasicBlock(*F);
+  Builder->setBasicBlock(Entry);
+  auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+  auto &X = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Add, A, 1, "x"))
+                .outRegister();
+  auto &C = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Less, A, 3, "c"))
+                .outRegister();
+  Builder->createBrInst(C, Then, Else);
+  Builder->setBasicBlock(Then);
+  Builder->createBinOpInst(BinOpKind::Mul, X, 2, "y");
+  Builder->createGoToInst(Join);
+  Builder->setBasicBlock(Else);
+  Builder->createUnOpInst(UnOpKind::Neg, X, "z");
+  Builder->createGoToInst(Join);
+  Builder->setBasicBlock(Join);
+  Builder->createRetInst(A);
+  EXPECT_TRUE(eliminateDeadCode(*Builder, *F));
+  EXPECT_EQ("function dead(...) {\n"
+            "BB1:\n"
+            "  %a = receive\n"
+            "  goto BB2\n"
+            "BB2:\n"
+            "  ret %a\n"
+            "}\n",
+            print(*F));
+  EXPECT_FALSE(eliminateDeadCode(*Builder, *F));
+}
+
+TEST(ADCE, DeadAccumulatorInLoop) {
+  auto [TheModule, Builder, F] = createFunctionContext("count");
+  auto &Entry = Builder->createBasicBlock(*F);
+  auto &Header = Builder->createBasicBlock(*F);
+  auto &Body = Builder->createBasicBlock(*F);
+  auto &Exit = Builder->createBasicBlock(*F);
+  Builder->setBasicBlock(Entry);
+  auto &N = get<ReceiveInst>(Builder->createReceiveInst("n")).outRegister();
+  auto &I = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, 0, "i"))
+                .outRegister();
+  auto &S = get<UnOpInst>(Builder->createUnOpInst(UnOpKind::Assign, 0, "s"))
+                .outRegister();
+  Builder->createGoToInst(Header);
+  Builder->setBasicBlock(Header);
+  auto &C = get<BinOpInst>(Builder->createBinOpInst(BinOpKind::Less, I, N, "c"))
+                .outRegister();
+  Builder->createBrInst(C, Body, Exit);
+  Builder->setBasicBlock(Body);
+  Builder->createBinOpInst(BinOpKind::Add, S, I, S);
+  Builder->createBinOpInst(BinOpKind::Add, I, 1, I);
+  Builder->createGoToInst(Header);
+  Builder->setBasicBlock(Exit);
+  Builder->createRetInst(I);
+  constructSSA(*Builder, *F);
+  EXPECT_EQ(2u, countPhis(*F));
+  EXPECT_TRUE(eliminateDeadCode(*Builder, *F));
+  checkSSA(*F);
+  EXPECT_EQ(1u, countPhis(*F));
+  for (auto &BB : *F)
+    for (auto &Inst : BB)
+      if (auto *Reg = definedRegister(Inst)) {
+        EXPECT_NE("s", Reg->name().substr(0, 1));
+      }
+  Interpreter Engine{*TheModule};
+  auto Result = Engine.run(*F, {7});
+  ASSERT_TRUE(Result.returned());
+  EXPECT_EQ(7, Result.ReturnValue);
+}
+
+TEST(ADCE, TrapsCallsAndGlobalsStay) {
+  auto [TheModule, Builder, F] = createFunctionContext("effects");
+  auto &Counter = Builder->createGlobalVariable("counter");
+  Builder->setBasicBlock(Builder->createBasicBlock(*F));
+  auto &A = get<ReceiveInst>(Builder->createReceiveInst("a")).outRegister();
+  Builder->createBinOpInst(BinOpKind::Div, 7, A, "q");
+  Builder->createBinOpInst(BinOpKind::Div, A, 2, "r");
+  Builder->createBinOpInst(BinOpKind::Add, Counter, A, Counter);
+  Builder->createCallInst(true, *F, {A}, "d");
+  Builder->createRetInst(0);
+  EXPECT_TRUE(eliminateDeadCode(*Builder, *F));
+  EXPECT_EQ("function effects(...) {\n"
+            "BB1:\n"
+            "  %a = receive\n"
+            "  %q = div 7, %a\n"
+            "  %counter = add %counter, %a\n"
+            "  %d = call effects(%a)\n"
+            "  ret 0\n"
+            "}\n",
+            print(*F));
+}
+
+TEST(ADCE, RandomFunctionsKeepResults) {
+  checkKeepsResults(31, 200, [](MIRBuilder &Builder, Function &F) {
+    return eliminateDeadCode(Builder, F);
+  });
+}
+
+/// \brief Build a module of random functions, optimize and print it.
+static std::string optimizeRandomModule(unsigned Seed) {
+  Module TheModule{"random"};
+  MIRBuilder Builder{TheModule};
+  std::mt19937 Gen{Seed};
+  for (std::size_t Size = 2; Size < 22; ++Size) {
+    auto &F = *Builder.createFunction("f" + std::to_string(Size));
+    buildRandomFunction(Gen, Builder, F, Size);
+    constructSSA(Builder, F);
+    propagateConstants(Builder, F);
+    eliminateRedundancies(Builder, F);
+    destructSSA(Builder, F);
+  }
+  std::stringstream Stream;
+  Stream << TheModule;
+  return Stream.str();
+}
+
+TEST(Pipeline, ModulesOnSeparateThreads) {
+  constexpr unsigned NumThreads = 4;
+  std::vector<std::string> Expected, Actual(NumThreads);
+  for (unsigned T = 0; T < NumThreads; ++T)
+    Expected.push_back(optimizeRandomModule(T));
+  std::vector<std::thread> Threads;
+  for (unsigned T = 0; T < NumThreads; ++T)
+    Threads.emplace_back([&Actual, T] { Actual[T] = optimizeRandomModule(T); });
+  for (auto &Thread : Threads)
+    Thread.join();
+  EXPECT_EQ(Expected, Actual);
+}
+
+/// \brief Build a module of random functions reading and writing global
+/// variable g.
+static void buildRandomModule(Module &TheModule) {
+  MIRBuilder Builder{TheModule};
+  auto &G = Builder.createGlobalVariable("g");
+  std::mt19937 Gen{7};
+  for (std::size_t Size = 2; Size < 66; ++Size) {
+    auto &F = *Builder.createFunction("f" + std::to_string(Size));
+    buildRandomFunction(Gen, Builder, F, Size);
+    Builder.setInsertPoint(F[0], 2);
+    Builder.createUnOpInst(UnOpKind::Assign, G, "c");
+    Builder.createBinOpInst(BinOpKind::Add, G, 1, G);
+  }
+}
+
+/// \brief Optimize a random module with \p NumWorkers workers and print it.
+static std::string optimizeInParallel(unsigned NumWorkers) {
+  Module TheModule{"random"};
+  buildRandomModule(TheModule);
+  PassManager Passes{NumWorkers};
+  EXPECT_EQ(NumWorkers, Passes.numWorkers());
+  Passes.addFunctionPass(
+      [](MIRBuilder &Builder, Function &F, AnalysisCache &Analyses) {
+        constructSSA(Builder, F, Analyses);
+        return true;
+      },
+      PreservedAnalyses::controlFlow());
+  // Phis don't change the CFG, so its analyses are reused.
+  Passes.addFunctionPass([](MIRBuilder &, Function &, AnalysisCache &Analyses) {
+    EXPECT_TRUE(Analyses.isCached(AnalysisKind::DominatorTree));
+    EXPECT_FALSE(Analyses.isCached(AnalysisKind::Liveness));
+    return false;
+  });
+  Passes.addFunctionPass(
+      [](MIRBuilder &Builder, Function &F, AnalysisCache &Analyses) {
+        return propagateConstants(Builder, F, Analyses);
+      });
+  Passes.addFunctionPass(
+      [](MIRBuilder &Builder, Function &F, AnalysisCache &Analyses) {
+        return eliminateRedundancies(Builder, F, Analyses);
+      },
+      PreservedAnalyses::controlFlow());
+  // The module pass sees every function in SSA form.
+  std::size_t NumPhis = 0;
+  Passes.addModulePass([&NumPhis](MIRBuilder &, Module &M) {
+    for (Function &F : M)
+      NumPhis += countPhis(F);
+    return false;
+  });
+  Passes.addFunctionPass([](MIRBuilder &Builder, Function &F, AnalysisCache &) {
+    destructSSA(Builder, F);
+    return true;
+  });
+  EXPECT_TRUE(Passes.run(TheModule));
+  EXPECT_GT(NumPhis, 0u);
+  // Functions changed the use list of g at the same time.
+  SymReg &G = *MIRBuilder{TheModule}.findGlobalVariable("g");
+  std::size_t NumReads = 0;
+  for (Function &F : TheModule)
+    for (BasicBlock &BB : F)
+      for (Instruction &Inst : BB)
+        forEachOperand(Inst, [&](Value V) {
+          NumReads += get<SymReg>(&V) == &G;
+        });
+  EXPECT_EQ(NumReads, static_cast<std::size_t>(std::distance(
+                          std::begin(G.users()), std::end(G.users()))));
+  std::stringstream Stream;
+  Stream << TheModule;
+  return Stream.str();
+}
+
+TEST(PassManager, SameResultForAnyNumberOfWorkers) {
+  Module TheModule{"random"};
+  buildRandomModule(TheModule);
+  MIRBuilder Builder{TheModule};
+  for (Function &F : TheModule) {
+    constructSSA(Builder, F);
+    propagateConstants(Builder, F);
+    eliminateRedundancies(Builder, F);
+    destructSSA(Builder, F);
+  }
+  std::stringstream Expected;
+  Expected << TheModule;
+  for (unsigned NumWorkers : {1, 2, 3, 8})
+    EXPECT_EQ(Expected.str(), optimizeInParallel(NumWorkers));
+}
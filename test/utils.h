@@ -0,0 +1,154 @@
+/// \file
+/// \brief Helpers for building MIR in tests.
+#ifndef TEST_UTILS_H
+#define TEST_UTILS_H
+#include "ExecutionEngine/interpreter.h"
+#include "MIR.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <random>
+#include <sstream>
+
+namespace wyrm {
+namespace test {
+
+/// \brief Module and builder for a test.
+/// The builder is destroyed before its module.
+struct FunctionContext {
+  std::unique_ptr<Module> TheModule;
+  std::unique_ptr<MIRBuilder> Builder;
+  Function *F;
+};
+
+inline FunctionContext createFunctionContext(std::string &&Name) {
+  auto TheModule = std::make_unique<Module>("my_module");
+  auto Builder = std::make_unique<MIRBuilder>(*TheModule);
+  auto *F = Builder->createFunction(std::move(Name));
+  assert(F);
+  return {std::move(TheModule), std::move(Builder), F};
+}
+
+inline std::string print(const Function &F) {
+  std::stringstream Stream;
+  Stream << F;
+  return Stream.str();
+}
+
+/// \brief Build a loop summing numbers from 0 to n - 1.
+inline void buildSumLoop(MIRBuilder &Builder, Function &F) {
+  auto &Entry = Builder.createBasicBlock(F);
+  auto &Header = Builder.createBasicBlock(F);
+  auto &Body = Builder.createBasicBlock(F);
+  auto &Exit = Builder.createBasicBlock(F);
+  Builder.setBasicBlock(Entry);
+  auto &N = get<ReceiveInst>(Builder.createReceiveInst("n")).outRegister();
+  auto &I = get<UnOpInst>(Builder.createUnOpInst(UnOpKind::Assign, 0, "i"))
+                .outRegister();
+  auto &S = get<UnOpInst>(Builder.createUnOpInst(UnOpKind::Assign, 0, "s"))
+                .outRegister();
+  Builder.createGoToInst(Header);
+  Builder.setBasicBlock(Header);
+  auto &C = get<BinOpInst>(Builder.createBinOpInst(BinOpKind::Less, I, N, "c"))
+                .outRegister();
+  Builder.createBrInst(C, Body, Exit);
+  Builder.setBasicBlock(Body);
+  Builder.createBinOpInst(BinOpKind::Add, S, I, "s");
+  Builder.createBinOpInst(BinOpKind::Add, I, 1, "i");
+  Builder.createGoToInst(Header);
+  Builder.setBasicBlock(Exit);
+  Builder.createRetInst(S);
+}
+
+/// \brief Build a function of random blocks assigning a few variables with
+/// binary operations of every kind, so some of them might trap.
+inline void buildRandomFunction(std::mt19937 &Gen, MIRBuilder &Builder,
+                                Function &F, std::size_t Size) {
+  std::vector<BasicBlock *> Blocks;
+  for (std::size_t I = 0; I < Size; ++I)
+    Blocks.push_back(&Builder.createBasicBlock(F));
+  // Only a and b are defined on entry, so some uses are undefined.
+  SymReg *Vars[] = {
+      &Builder.createRegister(F, "a"), &Builder.createRegister(F, "b"),
+      &Builder.createRegister(F, "c"), &Builder.createRegister(F, "d")};
+  std::uniform_int_distribution<std::size_t> Var(0, 3), Block(1, Size - 1),
+      Count(0, 3), Kind(0, 9),
+      Operation(0, static_cast<std::size_t>(BinOpKind::Geq));
+  auto Operand = [&](std::size_t Index) -> Value {
+    if (Kind(Gen) < 2)
+      return static_cast<Imm>(Kind(Gen));
+    return *Vars[Index];
+  };
+  Builder.setBasicBlock(*Blocks[0]);
+  Builder.createReceiveInst("a");
+  Builder.createReceiveInst("b");
+  for (auto *BB : Blocks) {
+    Builder.setBasicBlock(*BB);
+    for (std::size_t I = 0, E = Count(Gen); I < E; ++I) {
+      auto Op = static_cast<BinOpKind>(Operation(Gen));
+      Builder.createBinOpInst(Op, Operand(Var(Gen)), Operand(Var(Gen)),
+                              *Vars[Var(Gen)]);
+    }
+    auto Terminator = Kind(Gen);
+    if (Terminator < 1 && BB != Blocks[0])
+      Builder.createRetInst(Operand(Var(Gen)));
+    else if (Terminator < 4)
+      Builder.createGoToInst(*Blocks[Block(Gen)]);
+    else
+      Builder.createBrInst(Operand(Var(Gen)), *Blocks[Block(Gen)],
+                           *Blocks[Block(Gen)]);
+  }
+}
+
+/// \brief A random function built twice from one seed: the reference keeps
+/// the original code and the other copy is left to optimizations.
+struct RandomFunctionPair {
+  RandomFunctionPair(std::mt19937::result_type Seed, std::size_t Size)
+      : Reference{*OriginalBuilder.createFunction("f")},
+        F{*Builder.createFunction("f")} {
+    std::mt19937 Gen{Seed};
+    buildRandomFunction(Gen, OriginalBuilder, Reference, Size);
+    Gen.seed(Seed);
+    buildRandomFunction(Gen, Builder, F, Size);
+  }
+
+  /// \brief Expect the optimized copy to trap and return like the reference
+  /// on a few arguments. Only runs where the reference exceeds its
+  /// instruction limit are skipped.
+  /// \param Stage Optimizations applied so far, for failure messages.
+  /// \return The number of runs where the reference returned.
+  std::size_t expectSameResults(const std::string &Stage) const {
+    // Lowered code is cached, so every call gets new interpreters.
+    Interpreter Expected{Original}, Actual{Optimized};
+    Expected.setInstructionLimit(10000);
+    // Optimizations might run some operations more often than the original,
+    // e.g. hoisted ones run on every entry of their loops.
+    Actual.setInstructionLimit(100000);
+    std::size_t NumReturned{};
+    for (Imm A : {0, 1, 5, -1})
+      for (Imm B : {0, 2, -1}) {
+        auto Before = Expected.run(Reference, {A, B});
+        if (Before.Status == ExecutionResult::LimitExceeded)
+          continue;
+        auto After = Actual.run(F, {A, B});
+        EXPECT_EQ(Before.Status, After.Status)
+            << Stage << " on (" << A << ", " << B << ")\n"
+            << print(Reference);
+        if (Before.returned() && After.returned()) {
+          EXPECT_EQ(Before.ReturnValue, After.ReturnValue)
+              << Stage << " on (" << A << ", " << B << ")\n"
+              << print(Reference);
+          ++NumReturned;
+        }
+      }
+    return NumReturned;
+  }
+
+  Module Original{"original"}, Optimized{"optimized"};
+  MIRBuilder OriginalBuilder{Original}, Builder{Optimized};
+  Function &Reference, &F;
+};
+
+} // namespace test
+} // namespace wyrm
+
+#endif